@@ -109,6 +109,9 @@ lldpctl_atom_t* cmd_iterate_on_interfaces(struct lldpctl_conn_t *,
     struct cmd_env *);
 lldpctl_atom_t* cmd_iterate_on_ports(struct lldpctl_conn_t *,
     struct cmd_env *, const char **);
+lldpctl_atom_t* cmd_get_configuration(struct lldpctl_conn_t *);
+lldpctl_atom_t* cmd_get_port(struct lldpctl_conn_t *, lldpctl_atom_t *);
+void cmd_flush_cache(void);
 void cmd_restrict_ports(struct cmd_node *);
 void cmd_restrict_protocol(struct cmd_node *);
 
@@ -127,6 +130,7 @@ void display_interface(lldpctl_conn_t *, struct writer *, int,
 void display_local_chassis(lldpctl_conn_t *, struct writer *,
     struct cmd_env *, int);
 void display_configuration(lldpctl_conn_t *, struct writer *);
+void display_latency(lldpctl_conn_t *, struct writer *, struct cmd_env *);
 void display_interfaces_stats(lldpctl_conn_t *, struct writer *,
     struct cmd_env *);
 void display_interface_stats(lldpctl_conn_t *, struct writer *,
@@ -550,7 +550,9 @@ int
 commands_execute(struct lldpctl_conn_t *conn, struct writer *w,
     struct cmd_node *root, int argc, const char **argv, int privileged)
 {
-	return _commands_execute(conn, w, root, argc, argv, NULL, 0, privileged);
+	int rc = _commands_execute(conn, w, root, argc, argv, NULL, 0, privileged);
+	cmd_flush_cache();
+	return rc;
 }
 
 /**
@@ -766,6 +768,87 @@ cmd_iterate_on_ports(struct lldpctl_conn_t *conn, struct cmd_env *env, const cha
 	}
 }
 
+/* Answers from lldpd kept for the duration of a command. */
+static struct {
+	lldpctl_atom_t *config;		/* Global configuration */
+	lldpctl_atom_t *ports;		/* All local ports */
+	lldpctl_atom_iter_t *next;	/* Next port to look at in `ports` */
+	int prefetched;			/* Ports have been requested */
+} cache;
+
+/**
+ * Get the global configuration.
+ *
+ * The configuration is only requested once for each command.
+ *
+ * @param conn The connection.
+ * @return The configuration (a new reference) or @c NULL on error.
+ */
+lldpctl_atom_t*
+cmd_get_configuration(struct lldpctl_conn_t *conn)
+{
+	if (cache.config == NULL &&
+	    (cache.config = lldpctl_get_configuration(conn)) == NULL)
+		return NULL;
+	lldpctl_atom_inc_ref(cache.config);
+	return cache.config;
+}
+
+/**
+ * Get the local port associated to an interface.
+ *
+ * On first use, all local ports are requested at once. As they are usually
+ * looked up in the order of the list of interfaces, each lookup starts where
+ * the previous one stopped. If the port cannot be found this way, it is
+ * requested individually.
+ *
+ * @param conn  The connection.
+ * @param iface The interface.
+ * @return The port (a new reference) or @c NULL on error.
+ */
+lldpctl_atom_t*
+cmd_get_port(struct lldpctl_conn_t *conn, lldpctl_atom_t *iface)
+{
+	lldpctl_atom_iter_t *start;
+	lldpctl_atom_t *port;
+	const char *name = lldpctl_atom_get_str(iface, lldpctl_k_interface_name);
+	const char *pname;
+
+	if (!cache.prefetched) {
+		cache.prefetched = 1;
+		if ((cache.ports = lldpctl_get_ports(conn)) == NULL)
+			log_debug("lldpctl", "unable to get all ports at once. %s",
+			    lldpctl_last_strerror(conn));
+	}
+	if (cache.ports && name) {
+		start = cache.next;
+		do {
+			if (cache.next == NULL &&
+			    (cache.next = lldpctl_atom_iter(cache.ports)) == NULL)
+				break;
+			port = lldpctl_atom_iter_value(cache.ports, cache.next);
+			cache.next = lldpctl_atom_iter_next(cache.ports, cache.next);
+			if (port == NULL) break;
+			pname = lldpctl_atom_get_str(port, lldpctl_k_port_name);
+			if (pname && !strcmp(pname, name)) return port;
+			lldpctl_atom_dec_ref(port);
+		} while (cache.next != start);
+	}
+
+	return lldpctl_get_port(iface);
+}
+
+/**
+ * Release answers kept for the current command.
+ */
+void
+cmd_flush_cache(void)
+{
+	lldpctl_atom_dec_ref(cache.config);
+	lldpctl_atom_dec_ref(cache.ports);
+	memset(&cache, 0, sizeof(cache));
+}
+
 /**
  * Restrict the command to some ports.
  */
@@ -70,6 +70,32 @@ cmd_txhold(struct lldpctl_conn_t *conn, struct writer *w,
 	return 1;
 }
 
+static int
+cmd_notification_interval(struct lldpctl_conn_t *conn, struct writer *w,
+    struct cmd_env *env, void *arg)
+{
+	log_debug("lldpctl", "set SNMP notification interval");
+
+	lldpctl_atom_t *config = lldpctl_get_configuration(conn);
+	if (config == NULL) {
+		log_warnx("lldpctl", "unable to get configuration from lldpd. %s",
+		    lldpctl_last_strerror(conn));
+		return 0;
+	}
+	if (lldpctl_atom_set_str(config,
+		lldpctl_k_config_notification_interval,
+		cmdenv_get(env, "notification-interval")) == NULL) {
+		log_warnx("lldpctl", "unable to set SNMP notification interval. %s",
+		    lldpctl_last_strerror(conn));
+		lldpctl_atom_dec_ref(config);
+		return 0;
+	}
+	log_info("lldpctl", "SNMP notification interval set to new value %s",
+	    cmdenv_get(env, "notification-interval"));
+	lldpctl_atom_dec_ref(config);
+	return 1;
+}
+
 static int
 cmd_status(struct lldpctl_conn_t *conn, struct writer *w,
     struct cmd_env *env, void *arg)
@@ -536,6 +562,16 @@ register_commands_configure_lldp(struct cmd_node *configure,
 		NEWLINE, "Set LLDP transmit hold",
 		NULL, cmd_txhold, NULL);
 
+	commands_new(
+		commands_new(
+			commands_new(configure_lldp,
+			    "notification-interval", "Set SNMP notification interval",
+			    cmd_check_no_env, NULL, "ports"),
+			NULL, "SNMP notification interval in seconds (5-3600)",
+			NULL, cmd_store_env_value, "notification-interval"),
+		NEWLINE, "Set SNMP notification interval",
+		NULL, cmd_notification_interval, NULL);
+
 	struct cmd_node *status = commands_new(configure_lldp,
 	    "status", "Set administrative status",
 	    NULL, NULL, NULL);
@@ -103,6 +103,115 @@ cmd_iface_promisc(struct lldpctl_conn_t *conn, struct writer *w,
 	return 1;
 }
 
+static int
+cmd_snapshot(struct lldpctl_conn_t *conn, struct writer *w,
+    struct cmd_env *env, void *arg)
+{
+	lldpctl_atom_t *config = lldpctl_get_configuration(conn);
+	if (config == NULL) {
+		log_warnx("lldpctl", "unable to get configuration from lldpd. %s",
+		    lldpctl_last_strerror(conn));
+		return 0;
+	}
+	if (lldpctl_atom_set_int(config,
+		lldpctl_k_config_snapshot,
+		arg?1:0) == NULL) {
+		log_warnx("lldpctl", "unable to %s snapshot: %s",
+		    arg?"enable":"disable",
+		    lldpctl_last_strerror(conn));
+		lldpctl_atom_dec_ref(config);
+		return 0;
+	}
+	log_info("lldpctl", "snapshot %s",
+	    arg?"enabled":"disabled");
+	lldpctl_atom_dec_ref(config);
+	return 1;
+}
+
+static int
+cmd_warm_restart(struct lldpctl_conn_t *conn, struct writer *w,
+    struct cmd_env *env, void *arg)
+{
+	lldpctl_atom_t *config = lldpctl_get_configuration(conn);
+	if (config == NULL) {
+		log_warnx("lldpctl", "unable to get configuration from lldpd. %s",
+		    lldpctl_last_strerror(conn));
+		return 0;
+	}
+	if (lldpctl_atom_set_int(config,
+		lldpctl_k_config_warm_restart,
+		arg?1:0) == NULL) {
+		log_warnx("lldpctl", "unable to %s warm restart: %s",
+		    arg?"enable":"disable",
+		    lldpctl_last_strerror(conn));
+		lldpctl_atom_dec_ref(config);
+		return 0;
+	}
+	log_info("lldpctl", "warm restart %s",
+	    arg?"enabled":"disabled");
+	lldpctl_atom_dec_ref(config);
+	return 1;
+}
+
+static int
+cmd_metrics(struct lldpctl_conn_t *conn, struct writer *w,
+    struct cmd_env *env, void *arg)
+{
+	const char *port = cmdenv_get(env, "metrics-port");
+	lldpctl_atom_t *config = lldpctl_get_configuration(conn);
+	if (config == NULL) {
+		log_warnx("lldpctl", "unable to get configuration from lldpd. %s",
+		    lldpctl_last_strerror(conn));
+		return 0;
+	}
+	if ((arg && lldpctl_atom_set_str(config,
+		    lldpctl_k_config_metrics_port, port?port:"0") == NULL) ||
+	    lldpctl_atom_set_int(config,
+		lldpctl_k_config_metrics,
+		arg?1:0) == NULL) {
+		log_warnx("lldpctl", "unable to %s metrics: %s",
+		    arg?"enable":"disable",
+		    lldpctl_last_strerror(conn));
+		lldpctl_atom_dec_ref(config);
+		return 0;
+	}
+	if (!arg)
+		log_info("lldpctl", "metrics disabled");
+	else if (port)
+		log_info("lldpctl", "metrics exported on port %s", port);
+	else
+		log_info("lldpctl", "metrics exported on Unix socket");
+	lldpctl_atom_dec_ref(config);
+	return 1;
+}
+
+static int
+cmd_decode_workers(struct lldpctl_conn_t *conn, struct writer *w,
+    struct cmd_env *env, void *arg)
+{
+	const char *workers = arg?cmdenv_get(env, "decode-workers"):"0";
+	lldpctl_atom_t *config = lldpctl_get_configuration(conn);
+	if (config == NULL) {
+		log_warnx("lldpctl", "unable to get configuration from lldpd. %s",
+		    lldpctl_last_strerror(conn));
+		return 0;
+	}
+	if (lldpctl_atom_set_str(config,
+		lldpctl_k_config_decode_workers, workers) == NULL) {
+		log_warnx("lldpctl", "unable to set number of decoding threads: %s",
+		    lldpctl_last_strerror(conn));
+		lldpctl_atom_dec_ref(config);
+		return 0;
+	}
+	if (lldpctl_atom_get_int(config,
+		lldpctl_k_config_decode_workers) == 0)
+		log_info("lldpctl", "frames decoded in the main loop");
+	else
+		log_info("lldpctl", "frames decoded by %s threads", workers);
+	lldpctl_atom_dec_ref(config);
+	return 1;
+}
+
 static int
 cmd_system_description(struct lldpctl_conn_t *conn, struct writer *w,
     struct cmd_env *env, void *arg)
@@ -464,6 +573,71 @@ register_commands_configure_system(struct cmd_node *configure,
 		NEWLINE, "Don't override system name",
 		NULL, cmd_hostname, NULL);
 
+	commands_new(
+		commands_new(configure_system,
+		    "snapshot", "Publish ports and neighbors in a snapshot file",
+		    NULL, NULL, NULL),
+		NEWLINE, "Publish ports and neighbors in a snapshot file",
+		NULL, cmd_snapshot, "enable");
+	commands_new(
+		commands_new(unconfigure_system,
+		    "snapshot", "Don't publish ports and neighbors in a snapshot file",
+		    NULL, NULL, NULL),
+		NEWLINE, "Don't publish ports and neighbors in a snapshot file",
+		NULL, cmd_snapshot, NULL);
+
+	commands_new(
+		commands_new(configure_system,
+		    "warm-restart", "Keep neighbors across restarts",
+		    NULL, NULL, NULL),
+		NEWLINE, "Keep neighbors across restarts",
+		NULL, cmd_warm_restart, "enable");
+	commands_new(
+		commands_new(unconfigure_system,
+		    "warm-restart", "Don't keep neighbors across restarts",
+		    NULL, NULL, NULL),
+		NEWLINE, "Don't keep neighbors across restarts",
+		NULL, cmd_warm_restart, NULL);
+
+	struct cmd_node *configure_metrics = commands_new(
+		configure_system,
+		"metrics", "Export metrics in OpenMetrics format",
+		NULL, NULL, NULL);
+	commands_new(configure_metrics,
+	    NEWLINE, "Export metrics on a Unix socket",
+	    NULL, cmd_metrics, "enable");
+	commands_new(
+		commands_new(
+			commands_new(configure_metrics,
+			    "port", "Export metrics on a TCP port on loopback",
+			    NULL, NULL, NULL),
+			NULL, "TCP port",
+			NULL, cmd_store_env_value, "metrics-port"),
+		NEWLINE, "Export metrics on a TCP port on loopback",
+		NULL, cmd_metrics, "enable");
+	commands_new(
+		commands_new(unconfigure_system,
+		    "metrics", "Don't export metrics",
+		    NULL, NULL, NULL),
+		NEWLINE, "Don't export metrics",
+		NULL, cmd_metrics, NULL);
+
+	commands_new(
+		commands_new(
+			commands_new(configure_system,
+			    "decode-workers", "Decode received frames in threads",
+			    NULL, NULL, NULL),
+			NULL, "Number of threads",
+			NULL, cmd_store_env_value, "decode-workers"),
+		NEWLINE, "Decode received frames in threads",
+		NULL, cmd_decode_workers, "enable");
+	commands_new(
+		commands_new(unconfigure_system,
+		    "decode-workers", "Decode received frames in the main loop",
+		    NULL, NULL, NULL),
+		NEWLINE, "Decode received frames in the main loop",
+		NULL, cmd_decode_workers, NULL);
+
         commands_new(
 		commands_new(
 			commands_new(configure_system,
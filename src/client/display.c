@@ -485,7 +485,7 @@ display_local_ttl(struct writer *w, lldpctl_conn_t *conn, int details)
 	long int tx_interval;
 
 	lldpctl_atom_t *configuration;
-	configuration = lldpctl_get_configuration(conn);
+	configuration = cmd_get_configuration(conn);
 	if (!configuration) {
 		log_warnx("lldpctl", "not able to get configuration. %s",
 		    lldpctl_last_strerror(conn));
@@ -638,6 +638,9 @@ display_interface(lldpctl_conn_t *conn, struct writer *w, int hidden,
 	tag_start(w, "interface", "Interface");
 	tag_attr(w, "name", "",
 	    lldpctl_atom_get_str(iface, lldpctl_k_interface_name));
+	if (local && lldpctl_atom_get_str(port, lldpctl_k_port_netns))
+		tag_attr(w, "netns", "netns",
+		    lldpctl_atom_get_str(port, lldpctl_k_port_netns));
 	tag_attr(w, "via" , "via",
 	    lldpctl_atom_get_str(port, lldpctl_k_port_protocol));
 	if (details > DISPLAY_BRIEF) {
@@ -707,7 +710,7 @@ display_interfaces(lldpctl_conn_t *conn, struct writer *w,
 		lldpctl_atom_t *port;
 		lldpctl_atom_t *neighbors;
 		lldpctl_atom_t *neighbor;
-		port      = lldpctl_get_port(iface);
+		port      = cmd_get_port(conn, iface);
 		neighbors = lldpctl_atom_get(port, lldpctl_k_port_neighbors);
 		lldpctl_atom_foreach(neighbors, neighbor) {
 			display_interface(conn, w, hidden, iface, neighbor, details, protocol);
@@ -739,7 +742,7 @@ display_local_interfaces(lldpctl_conn_t *conn, struct writer *w,
 	tag_start(w, "lldp", "LLDP interfaces");
 	while ((iface = cmd_iterate_on_interfaces(conn, env))) {
 		lldpctl_atom_t *port;
-		port      = lldpctl_get_port(iface);
+		port      = cmd_get_port(conn, iface);
 		display_interface(conn, w, hidden, iface, port, details, protocol);
 		lldpctl_atom_dec_ref(port);
 	}
@@ -822,7 +825,7 @@ display_interfaces_stats(lldpctl_conn_t *conn, struct writer *w,
 		"LLDP statistics"));
 	while ((iface = cmd_iterate_on_interfaces(conn, env))) {
 		lldpctl_atom_t *port;
-		port      = lldpctl_get_port(iface);
+		port      = cmd_get_port(conn, iface);
 		if (!summary)
 			display_interface_stats(conn, w, port);
 		else {
@@ -864,12 +867,128 @@ display_interfaces_stats(lldpctl_conn_t *conn, struct writer *w,
 	tag_end(w);
 }
 
+/* Upper bound of the bucket holding the given percentile, but not more than
+ * the largest sample. */
+static long int
+latency_percentile(lldpctl_atom_t *buckets, long int count, long int max,
+    int percentile)
+{
+	lldpctl_atom_t *bucket;
+	long int rank = (count * percentile + 99) / 100, seen = 0, le = -1;
+
+	lldpctl_atom_foreach(buckets, bucket) {
+		seen += lldpctl_atom_get_int(bucket, lldpctl_k_latency_bucket_count);
+		if (seen >= rank) {
+			le = lldpctl_atom_get_int(bucket, lldpctl_k_latency_bucket_le);
+			lldpctl_atom_dec_ref(bucket);
+			break;
+		}
+	}
+	if (le == -1 || le > max) return max;
+	return le;
+}
+
+static void
+display_latency_value(struct writer *w, const char *tag, const char *descr,
+    double ns)
+{
+	char buf[32];
+	snprintf(buf, sizeof(buf), "%.1f", ns / 1000.);
+	tag_datatag(w, tag, descr, buf);
+}
+
+/**
+ * Display latency histograms of lldpd processing stages.
+ *
+ * @param conn       Connection to lldpd.
+ * @param w          Writer.
+ * @param env        Environment. "detailed" displays buckets, "reset" resets
+ *                   histograms after display.
+ */
+void
+display_latency(lldpctl_conn_t *conn, struct writer *w,
+    struct cmd_env *env)
+{
+	lldpctl_atom_t *latencies, *latency, *buckets, *bucket;
+	long int count, sum, max, le;
+	char buf[32];
+
+	latencies = lldpctl_get_latency(conn, !!cmdenv_get(env, "reset"));
+	if (!latencies) {
+		log_warnx("lldpctl", "not able to get latency histograms. %s",
+		    lldpctl_last_strerror(conn));
+		return;
+	}
+
+	tag_start(w, "latency", "Latency of lldpd processing stages");
+	lldpctl_atom_foreach(latencies, latency) {
+		count = lldpctl_atom_get_int(latency, lldpctl_k_latency_count);
+		sum = lldpctl_atom_get_int(latency, lldpctl_k_latency_sum);
+		max = lldpctl_atom_get_int(latency, lldpctl_k_latency_max);
+		buckets = lldpctl_atom_get(latency, lldpctl_k_latency_buckets);
+
+		tag_start(w, "stage", "Stage");
+		tag_attr(w, "name", "",
+		    lldpctl_atom_get_str(latency, lldpctl_k_latency_name));
+		snprintf(buf, sizeof(buf), "%ld", count);
+		tag_datatag(w, "count", "Samples", buf);
+		if (count > 0 && buckets) {
+			display_latency_value(w, "average", "Average (us)",
+			    (double)sum / count);
+			display_latency_value(w, "p50", "P50 (us)",
+			    latency_percentile(buckets, count, max, 50));
+			display_latency_value(w, "p90", "P90 (us)",
+			    latency_percentile(buckets, count, max, 90));
+			display_latency_value(w, "p99", "P99 (us)",
+			    latency_percentile(buckets, count, max, 99));
+			display_latency_value(w, "max", "Max (us)", max);
+		}
+		if (count > 0 && buckets && cmdenv_get(env, "detailed")) {
+			lldpctl_atom_foreach(buckets, bucket) {
+				count = lldpctl_atom_get_int(bucket,
+				    lldpctl_k_latency_bucket_count);
+				if (count == 0) continue;
+				le = lldpctl_atom_get_int(bucket,
+				    lldpctl_k_latency_bucket_le);
+				tag_start(w, "bucket", "Bucket");
+				if (le == -1)
+					tag_attr(w, "le", "Below (us)", "+Inf");
+				else {
+					snprintf(buf, sizeof(buf), "%.3f", le / 1000.);
+					tag_attr(w, "le", "Below (us)", buf);
+				}
+				snprintf(buf, sizeof(buf), "%ld", count);
+				tag_attr(w, "count", "Samples", buf);
+				tag_end(w);
+			}
+		}
+		lldpctl_atom_dec_ref(buckets);
+		tag_end(w);
+	}
+	tag_end(w);
+	lldpctl_atom_dec_ref(latencies);
+}
+
 static const char *
 N(const char *str) {
 	if (str == NULL || strlen(str) == 0) return "(none)";
 	return str;
 }
 
+static void
+display_startup_phase(struct writer *w, lldpctl_atom_t *configuration,
+    const char *tag, const char *descr, lldpctl_key_t key)
+{
+	long int ms = lldpctl_atom_get_int(configuration, key);
+	char buf[21];
+	if (ms <= 0) {
+		tag_datatag(w, tag, descr, "pending");
+		return;
+	}
+	snprintf(buf, sizeof(buf), "%ld", ms);
+	tag_datatag(w, tag, descr, buf);
+}
+
 void
 display_configuration(lldpctl_conn_t *conn, struct writer *w)
 {
@@ -891,6 +1010,8 @@ display_configuration(lldpctl_conn_t *conn, struct writer *w)
 	    lldpctl_atom_get_str(configuration, lldpctl_k_config_tx_hold));
 	tag_datatag(w, "max-neighbors", "Maximum number of neighbors",
 	    lldpctl_atom_get_str(configuration, lldpctl_k_config_max_neighbors));
+	tag_datatag(w, "notification-interval", "SNMP notification interval",
+	    lldpctl_atom_get_str(configuration, lldpctl_k_config_notification_interval));
 	tag_datatag(w, "rx-only", "Receive mode",
 	    lldpctl_atom_get_int(configuration, lldpctl_k_config_receiveonly)?
 	    "yes":"no");
@@ -919,6 +1040,27 @@ display_configuration(lldpctl_conn_t *conn, struct writer *w)
 	tag_datatag(w, "iface-promisc", "Promiscuous mode on managed interfaces",
 	    lldpctl_atom_get_int(configuration, lldpctl_k_config_iface_promisc)?
 	    "yes":"no");
+	tag_datatag(w, "snapshot", "Publish a snapshot file",
+	    lldpctl_atom_get_int(configuration, lldpctl_k_config_snapshot)?
+	    "yes":"no");
+	if (lldpctl_atom_get_int(configuration, lldpctl_k_config_metrics) &&
+	    lldpctl_atom_get_int(configuration, lldpctl_k_config_metrics_port) > 0) {
+		char port[32];
+		snprintf(port, sizeof(port), "127.0.0.1:%ld",
+		    lldpctl_atom_get_int(configuration,
+			lldpctl_k_config_metrics_port));
+		tag_datatag(w, "metrics", "Export metrics", port);
+	} else
+		tag_datatag(w, "metrics", "Export metrics",
+		    lldpctl_atom_get_int(configuration, lldpctl_k_config_metrics)?
+		    LLDPD_METRICS_SOCKET:"no");
+	tag_datatag(w, "decode-workers", "Decoding threads",
+	    lldpctl_atom_get_int(configuration, lldpctl_k_config_decode_workers)?
+	    lldpctl_atom_get_str(configuration, lldpctl_k_config_decode_workers):
+	    "no");
+	tag_datatag(w, "warm-restart", "Keep neighbors across restarts",
+	    lldpctl_atom_get_int(configuration, lldpctl_k_config_warm_restart)?
+	    "yes":"no");
 	tag_datatag(w, "lldpmed-no-inventory", "Disable LLDP-MED inventory",
 	    (lldpctl_atom_get_int(configuration, lldpctl_k_config_lldpmed_noinventory) == 0)?
 	    "no":"yes");
@@ -941,6 +1083,25 @@ display_configuration(lldpctl_conn_t *conn, struct writer *w)
 			lldpctl_k_config_lldp_agent_type));
 
 	tag_end(w);
+
+	tag_start(w, "startup", "Startup timeline (ms)");
+	display_startup_phase(w, configuration, "privsep",
+	    "Privilege separation ready",
+	    lldpctl_k_config_startup_privsep);
+	display_startup_phase(w, configuration, "interfaces",
+	    "Interfaces initialized",
+	    lldpctl_k_config_startup_interfaces);
+	display_startup_phase(w, configuration, "configured",
+	    "Configuration applied",
+	    lldpctl_k_config_startup_configured);
+	display_startup_phase(w, configuration, "first-pdu",
+	    "First PDU sent",
+	    lldpctl_k_config_startup_first_pdu);
+	display_startup_phase(w, configuration, "metadata",
+	    "Chassis metadata collected",
+	    lldpctl_k_config_startup_metadata);
+	tag_end(w);
+
 	tag_end(w);
 
 	lldpctl_atom_dec_ref(configuration);
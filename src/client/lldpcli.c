@@ -283,8 +283,11 @@ cmd_exec(lldpctl_conn_t *conn, const char *fmt, int argc, const char **argv)
 	}
 
 	/* Execute command */
+	unsigned long requests = lldpctl_get_requests(conn);
 	int rc = commands_execute(conn, w,
 	    root, argc, argv, is_privileged());
+	log_info("lldpctl", "command used %lu request(s) to lldpd",
+	    lldpctl_get_requests(conn) - requests);
 	if (rc != 0) {
 		log_info("lldpctl", "an error occurred while executing last command");
 		w->finish(w);
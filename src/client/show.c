@@ -124,6 +124,31 @@ cmd_show_interface_stats(struct lldpctl_conn_t *conn, struct writer *w,
 	return 1;
 }
 
+/**
+ * Show latency histograms.
+ *
+ * The environment will contain the following keys:
+ *  - C{detailed} to display histogram buckets
+ *  - C{reset} to reset histograms after displaying them
+ */
+static int
+cmd_show_latency(struct lldpctl_conn_t *conn, struct writer *w,
+    struct cmd_env *env, void *arg)
+{
+	log_debug("lldpctl", "show latency histograms%s",
+	    cmdenv_get(env, "reset")?" and reset them":"");
+	display_latency(conn, w, env);
+	return 1;
+}
+
+static int
+cmd_check_no_ports_nor_summary(struct cmd_env *env, void *arg)
+{
+	if (cmdenv_get(env, "ports")) return 0;
+	if (cmdenv_get(env, "summary")) return 0;
+	return 1;
+}
+
 static int
 cmd_check_no_detailed_nor_summary(struct cmd_env *env, void *arg)
 {
@@ -167,6 +192,12 @@ watchcb(lldpctl_conn_t *conn,
 	const char *proto_str;
 	int protocol = LLDPD_MODE_MAX;
 
+	if (type == lldpctl_c_resync) {
+		log_warnx("lldpctl", "some neighbor changes were lost, "
+		    "use `show neighbors` to get the current state");
+		return;
+	}
+
 	if (interfaces && !contains(interfaces, lldpctl_atom_get_str(interface,
 		    lldpctl_k_interface_name)))
 		return;
@@ -234,7 +265,8 @@ cmd_watch_neighbors(struct lldpctl_conn_t *conn, struct writer *w,
 	}
 
 	log_debug("lldpctl", "watch for neighbor changes");
-	if (lldpctl_watch_callback(conn, watchcb, &wa) < 0) {
+	if (lldpctl_watch_callback2(conn, watchcb, &wa,
+		LLDPCTL_WATCH_RESYNC) < 0) {
 		log_warnx("lldpctl", "unable to watch for neighbors. %s",
 		    lldpctl_last_strerror(conn));
 		return 0;
@@ -367,6 +399,24 @@ register_commands_show(struct cmd_node *root)
 	cmd_restrict_ports(stats);
 	register_summary_command(stats);
 
+	/* Latency histograms */
+	struct cmd_node *latency = commands_new(stats,
+	    "latency",
+	    "Show latency of lldpd processing stages",
+	    cmd_check_no_ports_nor_summary, NULL, NULL);
+	commands_new(latency,
+	    NEWLINE,
+	    "Show latency of lldpd processing stages",
+	    NULL, cmd_show_latency, NULL);
+	commands_new(latency,
+	    "details",
+	    "With histogram buckets",
+	    cmd_check_no_env, cmd_store_env_and_pop, "detailed");
+	commands_privileged(commands_new(latency,
+		"reset",
+		"Reset histograms after displaying them",
+		cmd_check_no_env, cmd_store_env_and_pop, "reset"));
+
 	/* Register "show configuration" and "show running-configuration" */
 	commands_new(
 		commands_new(show,
@@ -163,6 +163,7 @@ ctl_msg_send_unserialized(uint8_t **output_buffer, size_t *output_len,
 	struct hmsg_header hdr;
 	memset(&hdr, 0, sizeof(struct hmsg_header));
 	hdr.type = type;
+	hdr.version = HMSG_VERSION;
 	hdr.len = len;
 	memcpy(*output_buffer + *output_len, &hdr, sizeof(struct hmsg_header));
 	if (t)
@@ -189,7 +190,9 @@ ctl_msg_send_unserialized(uint8_t **output_buffer, size_t *output_len,
  * @param expected_type        The expected message type.
  * @param[out] t               Will contain a pointer to the unserialized structure.
  *                             Can be @c NULL if we don't want to store the
- *                             answer.
+ *                             answer. The structure and all its substructures
+ *                             are stored in a single buffer which should be
+ *                             released with @c marshal_release().
  * @param mi                   The appropriate marshal structure for unserialization.
  *
  * @return -1 in case of error, 0 in case of success and the number of bytes we
@@ -214,6 +217,15 @@ ctl_msg_recv_unserialized(uint8_t **input_buffer, size_t *input_len,
 
 	log_debug("control", "receive a message through control socket");
 	memcpy(&hdr, *input_buffer, sizeof(struct hmsg_header));
+	if (hdr.version != HMSG_VERSION) {
+		log_warnx("control", "incompatible message version (expected: %d, received: %d)",
+		    HMSG_VERSION, hdr.version);
+		/* We discard the whole buffer */
+		free(*input_buffer);
+		*input_buffer = NULL;
+		*input_len = 0;
+		return -1;
+	}
 	if (hdr.len > HMSG_MAX_SIZE) {
 		log_warnx("control", "message received is too large");
 		/* We discard the whole buffer */
@@ -238,10 +250,17 @@ ctl_msg_recv_unserialized(uint8_t **input_buffer, size_t *input_len,
 		goto end;
 	}
 	if (t) {
-		/* We have data to unserialize. */
-		if (marshal_unserialize_(mi, *input_buffer + sizeof(struct hmsg_header),
-			hdr.len, t, NULL, 0, 0) <= 0) {
+		/* We have data to unserialize. We keep a copy of the message and
+		 * use it in place. */
+		void *message = malloc(hdr.len);
+		if (message == NULL) {
+			log_warn("control", "no memory available");
+			goto end;
+		}
+		memcpy(message, *input_buffer + sizeof(struct hmsg_header), hdr.len);
+		if (marshal_unserialize_inplace_(mi, message, hdr.len, t) <= 0) {
 			log_warnx("control", "unable to deserialize received data");
+			free(message);
 			goto end;
 		}
 	}
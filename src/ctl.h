@@ -36,19 +36,61 @@ enum hmsg_type {
 	SET_PORT,		/* Set port-related information (location, power, policy) */
 	SUBSCRIBE,		/* Subscribe to neighbor changes */
 	NOTIFICATION,		/* Notification message (sent by lldpd!) */
+	GET_LATENCY,		/* Get latency histograms */
+	RESET_LATENCY,		/* Get and reset latency histograms */
+	GET_PORTS,		/* Get all local ports, in batches */
 };
 
 /** Header for the control protocol.
  *
  * The protocol is pretty simple. We send a single message containing the
  * provided message type with the message length, followed by the message
- * content.
+ * content. The version is bumped each time the serialization format changes.
  */
 struct hmsg_header {
 	enum hmsg_type type;
+	u_int32_t      version;
 	size_t         len;
 };
 #define HMSG_MAX_SIZE (1<<19)
+#define HMSG_VERSION  5
+
+/** Layout of the snapshot file.
+ *
+ * When enabled, lldpd publishes the state of each local port (with its
+ * neighbors and counters) into a memory-mapped file. The file starts with a
+ * header and contains two slots. lldpd rewrites the slot not currently in use
+ * and then switches to it. Each slot has a sequence number which is odd while
+ * the slot is written: a reader copies the current slot and retries if the
+ * sequence number was odd or has changed in the meantime.
+ *
+ * A slot is a list of records. Each record is a `struct snapshot_record`
+ * followed by a serialized `struct lldpd_hardware`, padded to 8 bytes.
+ */
+struct snapshot_slot {
+	u_int32_t sequence;	/* Odd while the slot is being written */
+	u_int32_t count;	/* Number of records */
+	u_int64_t offset;	/* Offset of the first record in the file */
+	u_int64_t size;		/* Space reserved for this slot */
+	u_int64_t len;		/* Space used by the records */
+};
+struct snapshot_header {
+	u_int32_t magic;
+	u_int32_t version;	/* HMSG_VERSION */
+	u_int32_t current;	/* Slot to be used by readers */
+	u_int32_t reserved;
+	struct snapshot_slot slots[2];
+};
+struct snapshot_record {
+	u_int64_t len;		/* Length of the serialized object */
+};
+#define SNAPSHOT_MAGIC		0x6c6c6470 /* lldp */
+#define SNAPSHOT_ALIGN(x)	(((x) + 7) & ~(size_t)7)
+
+/* Space used by the records of a batch of ports (GET_PORTS) before starting a
+ * new batch. It is kept well below HMSG_MAX_SIZE as the last port may overflow
+ * it. */
+#define PORTS_BATCH_SIZE	(HMSG_MAX_SIZE / 4)
 
 /* ctl.c */
 int	 ctl_create(const char *);
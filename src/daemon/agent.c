@@ -18,6 +18,7 @@
 #include "lldpd.h"
 
 #include <assert.h>
+#include <time.h>
 
 #include "agent.h"
 
@@ -60,15 +61,33 @@ lastchange(struct lldpd_port *port)
 /* -------------
   Helper functions to build header_*indexed_table() functions.
   Those functions keep an internal state. They are not reentrant!
+
+  Each table keeps a sorted array of its indexes. The array is rebuilt
+  when `g_generation` or `g_local_generation` has changed since the last
+  request. A GET or a GETNEXT is then a binary search in this array.
 */
+#define HEADER_INDEX_MAX_LEN (5 + 16)
+struct header_index_entry {
+	oid              index[HEADER_INDEX_MAX_LEN];
+	size_t           len;
+	size_t           seq;	/* Insertion order, for equal indexes */
+	void            *entity;
+};
+struct header_index_cache {
+	int              valid;
+	int              sorted;
+	unsigned int     generation;
+	unsigned int     local_generation;
+	size_t           count;
+	size_t           size;
+	struct header_index_entry *entries;
+};
 struct header_index {
 	struct variable *vp;
 	oid             *name;	 /* Requested/returned OID */
 	size_t          *length; /* Length of above OID */
 	int              exact;
-	oid              best[MAX_OID_LEN]; /* Best OID */
-	size_t           best_len;	    /* Best OID length */
-	void            *entity;	    /* Best entity */
+	struct header_index_cache *cache; /* Index of the current table */
 };
 static struct header_index header_idx;
 
@@ -97,46 +116,109 @@ header_index_init(struct variable *vp, oid *name, size_t *length,
 	header_idx.name = name;
 	header_idx.length = length;
 	header_idx.exact = exact;
-	header_idx.best_len = 0;
-	header_idx.entity = NULL;
+	header_idx.cache = NULL;
 	return 1;
 }
 
+/* Select the index of the table. Return 1 if the index is up-to-date. When 0
+ * is returned, the caller should feed the index with header_index_add(). */
 static int
-header_index_add(oid *index, size_t len, void *entity)
+header_index_fresh(struct header_index_cache *cache)
 {
-	int      result;
-	oid     *target;
-	size_t   target_len;
+	header_idx.cache = cache;
+	if (cache->valid && cache->generation == scfg->g_generation &&
+	    cache->local_generation == scfg->g_local_generation)
+		return 1;
+	cache->valid = 1;
+	cache->sorted = 0;
+	cache->generation = scfg->g_generation;
+	cache->local_generation = scfg->g_local_generation;
+	cache->count = 0;
+	return 0;
+}
 
-        target = header_idx.name + header_idx.vp->namelen;
-        target_len = *header_idx.length - header_idx.vp->namelen;
-	if ((result = snmp_oid_compare(index, len, target, target_len)) < 0)
-		return 0;	/* Too small. */
-	if (result == 0)
-		return header_idx.exact;
-	if (header_idx.best_len == 0 ||
-	    (snmp_oid_compare(index, len,
-			      header_idx.best,
-			      header_idx.best_len) < 0)) {
-		memcpy(header_idx.best, index, sizeof(oid) * len);
-		header_idx.best_len = len;
-		header_idx.entity = entity;
+static void
+header_index_add(oid *index, size_t len, void *entity)
+{
+	struct header_index_cache *cache = header_idx.cache;
+	struct header_index_entry *entry;
+
+	if (!cache->valid) return;
+	if (len > HEADER_INDEX_MAX_LEN) return;
+	if (cache->count == cache->size) {
+		size_t size = cache->size ? cache->size * 2 : 16;
+		struct header_index_entry *entries = realloc(cache->entries,
+		    size * sizeof(struct header_index_entry));
+		if (entries == NULL) {
+			log_warnx("snmp", "not enough memory to index table");
+			cache->valid = 0;
+			return;
+		}
+		cache->entries = entries;
+		cache->size = size;
 	}
-	return 0;		/* No best match yet. */	
+	entry = &cache->entries[cache->count];
+	memcpy(entry->index, index, sizeof(oid) * len);
+	entry->len = len;
+	entry->seq = cache->count++;
+	entry->entity = entity;
+}
+
+static int
+header_index_compare(const void *a, const void *b)
+{
+	const struct header_index_entry *ea = a, *eb = b;
+	int result = snmp_oid_compare(ea->index, ea->len,
+	    eb->index, eb->len);
+	if (result) return result;
+	return (ea->seq < eb->seq) ? -1 : (ea->seq > eb->seq);
 }
 
 void*
 header_index_best()
 {
-	if (header_idx.entity == NULL)
-		return NULL;
-	if (header_idx.exact)
+	struct header_index_cache *cache = header_idx.cache;
+	struct header_index_entry *entry;
+	oid     *target;
+	size_t   target_len;
+	size_t   low, high, middle;
+
+	if (!cache->valid) return NULL;
+	if (!cache->sorted) {
+		qsort(cache->entries, cache->count,
+		    sizeof(struct header_index_entry), header_index_compare);
+		cache->sorted = 1;
+	}
+
+	/* Search the first index greater than (or equal to when we want an
+	 * exact match) the requested one. */
+        target = header_idx.name + header_idx.vp->namelen;
+        target_len = *header_idx.length - header_idx.vp->namelen;
+	low = 0; high = cache->count;
+	while (low < high) {
+		int result;
+		middle = low + (high - low) / 2;
+		entry = &cache->entries[middle];
+		result = snmp_oid_compare(entry->index, entry->len,
+		    target, target_len);
+		if (result < 0 || (result == 0 && !header_idx.exact))
+			low = middle + 1;
+		else
+			high = middle;
+	}
+	if (low == cache->count)
 		return NULL;
+	entry = &cache->entries[low];
+	if (header_idx.exact) {
+		if (snmp_oid_compare(entry->index, entry->len,
+			target, target_len) != 0)
+			return NULL;
+		return entry->entity;
+	}
 	memcpy(header_idx.name + header_idx.vp->namelen,
-	       header_idx.best, sizeof(oid) * header_idx.best_len);
-	*header_idx.length = header_idx.vp->namelen + header_idx.best_len;
-	return header_idx.entity;
+	       entry->index, sizeof(oid) * entry->len);
+	*header_idx.length = header_idx.vp->namelen + entry->len;
+	return entry->entity;
 }
 /* ----------------------------- */
 
@@ -144,14 +226,14 @@ static struct lldpd_hardware*
 header_portindexed_table(struct variable *vp, oid *name, size_t *length,
     int exact, size_t *var_len, WriteMethod **write_method)
 {
+	static struct header_index_cache cache;
 	struct lldpd_hardware *hardware;
 
 	if (!header_index_init(vp, name, length, exact, var_len, write_method)) return NULL;
+	if (header_index_fresh(&cache)) return header_index_best();
 	TAILQ_FOREACH(hardware, &scfg->g_hardware, h_entries) {
 		oid index[1] = { hardware->h_ifindex };
-		if (header_index_add(index, 1,
-				     hardware))
-			return hardware;
+		header_index_add(index, 1, hardware);
 	}
 	return header_index_best();
 }
@@ -161,20 +243,21 @@ static struct lldpd_med_policy*
 header_pmedindexed_policy_table(struct variable *vp, oid *name, size_t *length,
     int exact, size_t *var_len, WriteMethod **write_method)
 {
+	static struct header_index_cache cache;
 	struct lldpd_hardware *hardware;
 	int i;
 	oid index[2];
 
 	if (!header_index_init(vp, name, length, exact, var_len, write_method)) return NULL;
+	if (header_index_fresh(&cache)) return header_index_best();
 	TAILQ_FOREACH(hardware, &scfg->g_hardware, h_entries) {
+		if (hardware->h_lport.p_med == NULL) continue;
 		for (i = 0; i < LLDP_MED_APPTYPE_LAST; i++) {
-			if (hardware->h_lport.p_med_policy[i].type != i+1)
+			if (hardware->h_lport.p_med->policy[i].type != i+1)
 				continue;
 			index[0] = hardware->h_ifindex;
 			index[1] = i + 1;
-			if (header_index_add(index, 2,
-					     &hardware->h_lport.p_med_policy[i]))
-				return &hardware->h_lport.p_med_policy[i];
+			header_index_add(index, 2, &hardware->h_lport.p_med->policy[i]);
 		}
 	}
 	return header_index_best();
@@ -184,20 +267,21 @@ static struct lldpd_med_loc*
 header_pmedindexed_location_table(struct variable *vp, oid *name, size_t *length,
     int exact, size_t *var_len, WriteMethod **write_method)
 {
+	static struct header_index_cache cache;
 	struct lldpd_hardware *hardware;
 	int i;
 	oid index[2];
 
 	if (!header_index_init(vp, name, length, exact, var_len, write_method)) return NULL;
+	if (header_index_fresh(&cache)) return header_index_best();
 	TAILQ_FOREACH(hardware, &scfg->g_hardware, h_entries) {
+		if (hardware->h_lport.p_med == NULL) continue;
 		for (i = 0; i < LLDP_MED_LOCFORMAT_LAST; i++) {
-			if (hardware->h_lport.p_med_location[i].format != i+1)
+			if (hardware->h_lport.p_med->location[i].format != i+1)
 				continue;
 			index[0] = hardware->h_ifindex;
 			index[1] = i + 2;
-			if (header_index_add(index, 2,
-					     &hardware->h_lport.p_med_location[i]))
-				return &hardware->h_lport.p_med_location[i];
+			header_index_add(index, 2, &hardware->h_lport.p_med->location[i]);
 		}
 	}
 	return header_index_best();
@@ -209,11 +293,13 @@ header_tprindexed_table(struct variable *vp, oid *name, size_t *length,
 			int exact, size_t *var_len, WriteMethod **write_method,
 			int withmed)
 {
+	static struct header_index_cache cache[2];
 	struct lldpd_hardware *hardware;
 	struct lldpd_port *port;
 	oid index[3];
 
 	if (!header_index_init(vp, name, length, exact, var_len, write_method)) return NULL;
+	if (header_index_fresh(&cache[withmed?1:0])) return header_index_best();
 	TAILQ_FOREACH(hardware, &scfg->g_hardware, h_entries) {
 		TAILQ_FOREACH(port, &hardware->h_rports, p_entries) {
 			if (SMART_HIDDEN(port)) continue;
@@ -223,9 +309,7 @@ header_tprindexed_table(struct variable *vp, oid *name, size_t *length,
 			index[0] = lastchange(port);
 			index[1] = hardware->h_ifindex;
 			index[2] = port->p_chassis->c_index;
-			if (header_index_add(index, 3,
-					     port))
-				return port;
+			header_index_add(index, 3, port);
 		}
 	}
 	return header_index_best();
@@ -235,11 +319,13 @@ static struct lldpd_mgmt*
 header_ipindexed_table(struct variable *vp, oid *name, size_t *length,
     int exact, size_t *var_len, WriteMethod **write_method)
 {
+	static struct header_index_cache cache;
 	struct lldpd_chassis *chassis = LOCAL_CHASSIS(scfg);
 	struct lldpd_mgmt *mgmt;
 	oid index[2 + 16];
 
 	if (!header_index_init(vp, name, length, exact, var_len, write_method)) return NULL;
+	if (header_index_fresh(&cache)) return header_index_best();
 	TAILQ_FOREACH(mgmt, &chassis->c_mgmt, m_entries) {
 		int i;
 		switch (mgmt->m_family) {
@@ -252,8 +338,7 @@ header_ipindexed_table(struct variable *vp, oid *name, size_t *length,
 			continue; /* Odd... */
 		for (i = 0; i < index[1]; i++)
 			index[i + 2] = mgmt->m_addr.octets[i];
-		if (header_index_add(index, 2 + index[1], mgmt))
-			return mgmt;
+		header_index_add(index, 2 + index[1], mgmt);
 	}
 
 	return header_index_best();
@@ -263,12 +348,14 @@ static struct lldpd_mgmt*
 header_tpripindexed_table(struct variable *vp, oid *name, size_t *length,
     int exact, size_t *var_len, WriteMethod **write_method)
 {
+	static struct header_index_cache cache;
 	struct lldpd_hardware *hardware;
 	struct lldpd_port *port;
 	struct lldpd_mgmt *mgmt;
 	oid index[5 + 16];
 
 	if (!header_index_init(vp, name, length, exact, var_len, write_method)) return NULL;
+	if (header_index_fresh(&cache)) return header_index_best();
 	TAILQ_FOREACH(hardware, &scfg->g_hardware, h_entries) {
 		TAILQ_FOREACH(port, &hardware->h_rports, p_entries) {
 			if (SMART_HIDDEN(port)) continue;
@@ -287,8 +374,7 @@ header_tpripindexed_table(struct variable *vp, oid *name, size_t *length,
 					continue; /* Odd... */
 				for (i = 0; i < index[4]; i++)
 					index[i + 5] = mgmt->m_addr.octets[i];
-				if (header_index_add(index, 5 + index[4], mgmt))
-					return mgmt;
+				header_index_add(index, 5 + index[4], mgmt);
 			}
 		}
 	}
@@ -300,6 +386,7 @@ static struct lldpd_custom*
 header_tprcustomindexed_table(struct variable *vp, oid *name, size_t *length,
     int exact, size_t *var_len, WriteMethod **write_method)
 {
+	static struct header_index_cache cache;
 	struct lldpd_hardware *hardware;
 	struct lldpd_port *port;
 	struct lldpd_custom *custom;
@@ -307,6 +394,7 @@ header_tprcustomindexed_table(struct variable *vp, oid *name, size_t *length,
 	oid idx;
 
 	if (!header_index_init(vp, name, length, exact, var_len, write_method)) return NULL;
+	if (header_index_fresh(&cache)) return header_index_best();
 	TAILQ_FOREACH(hardware, &scfg->g_hardware, h_entries) {
 		TAILQ_FOREACH(port, &hardware->h_rports, p_entries) {
 			if (SMART_HIDDEN(port)) continue;
@@ -320,8 +408,7 @@ header_tprcustomindexed_table(struct variable *vp, oid *name, size_t *length,
 				index[5] = custom->oui[2];
 				index[6] = custom->subtype;
 				index[7] = idx++;
-				if (header_index_add(index, 8, custom))
-					return custom;
+				header_index_add(index, 8, custom);
 			}
 		}
 	}
@@ -336,45 +423,44 @@ static void*
 header_tprmedindexed_table(struct variable *vp, oid *name, size_t *length,
     int exact, size_t *var_len, WriteMethod **write_method, int variant)
 {
+	static struct header_index_cache cache[2];
 	struct lldpd_hardware *hardware;
 	struct lldpd_port *port;
 	int j;
 	oid index[4];
 
 	if (!header_index_init(vp, name, length, exact, var_len, write_method)) return NULL;
+	if (header_index_fresh(&cache[(variant == TPR_VARIANT_MED_POLICY)?0:1])) return header_index_best();
 	TAILQ_FOREACH(hardware, &scfg->g_hardware, h_entries) {
 		TAILQ_FOREACH(port, &hardware->h_rports, p_entries) {
 			if (SMART_HIDDEN(port)) continue;
 			if (!port->p_chassis->c_med_cap_available) continue;
+			if (port->p_med == NULL) continue;
 			switch (variant) {
 			case TPR_VARIANT_MED_POLICY:
 				for (j = 0;
 				     j < LLDP_MED_APPTYPE_LAST;
 				     j++) {
-					if (port->p_med_policy[j].type != j+1)
+					if (port->p_med->policy[j].type != j+1)
 						continue;
 					index[0] = lastchange(port);
 					index[1] = hardware->h_ifindex;
 					index[2] = port->p_chassis->c_index;
 					index[3] = j+1;
-					if (header_index_add(index, 4,
-							     &port->p_med_policy[j]))
-						return &port->p_med_policy[j];
+					header_index_add(index, 4, &port->p_med->policy[j]);
 				}
 				break;
 			case TPR_VARIANT_MED_LOCATION:
 				for (j = 0;
 				     j < LLDP_MED_LOCFORMAT_LAST;
 				     j++) {
-					if (port->p_med_location[j].format != j+1)
+					if (port->p_med->location[j].format != j+1)
 						continue;
 					index[0] = lastchange(port);
 					index[1] = hardware->h_ifindex;
 					index[2] = port->p_chassis->c_index;
 					index[3] = j+2;
-					if (header_index_add(index, 4,
-							     &port->p_med_location[j]))
-						return &port->p_med_location[j];
+					header_index_add(index, 4, &port->p_med->location[j]);
 				}
 				break;
 			}
@@ -389,16 +475,17 @@ static struct lldpd_vlan*
 header_pvindexed_table(struct variable *vp, oid *name, size_t *length,
     int exact, size_t *var_len, WriteMethod **write_method)
 {
+	static struct header_index_cache cache;
 	struct lldpd_hardware *hardware;
         struct lldpd_vlan *vlan;
 
 	if (!header_index_init(vp, name, length, exact, var_len, write_method)) return NULL;
+	if (header_index_fresh(&cache)) return header_index_best();
 	TAILQ_FOREACH(hardware, &scfg->g_hardware, h_entries) {
 		TAILQ_FOREACH(vlan, &hardware->h_lport.p_vlans, v_entries) {
 			oid index[2] = { hardware->h_ifindex,
 					 vlan->v_vid };
-			if (header_index_add(index, 2, vlan))
-				return vlan;
+			header_index_add(index, 2, vlan);
 		}
 	}
 	return header_index_best();
@@ -408,11 +495,13 @@ static struct lldpd_vlan*
 header_tprvindexed_table(struct variable *vp, oid *name, size_t *length,
     int exact, size_t *var_len, WriteMethod **write_method)
 {
+	static struct header_index_cache cache;
 	struct lldpd_hardware *hardware;
 	struct lldpd_port *port;
         struct lldpd_vlan *vlan;
 
 	if (!header_index_init(vp, name, length, exact, var_len, write_method)) return NULL;
+	if (header_index_fresh(&cache)) return header_index_best();
 	TAILQ_FOREACH(hardware, &scfg->g_hardware, h_entries) {
 		TAILQ_FOREACH(port, &hardware->h_rports, p_entries) {
 			if (SMART_HIDDEN(port)) continue;
@@ -421,9 +510,7 @@ header_tprvindexed_table(struct variable *vp, oid *name, size_t *length,
 						 hardware->h_ifindex,
 						 port->p_chassis->c_index,
 						 vlan->v_vid };
-				if (header_index_add(index, 4,
-						     vlan))
-					return vlan;
+				header_index_add(index, 4, vlan);
 			}
 		}
 	}
@@ -434,17 +521,17 @@ static struct lldpd_ppvid*
 header_pppvidindexed_table(struct variable *vp, oid *name, size_t *length,
     int exact, size_t *var_len, WriteMethod **write_method)
 {
+	static struct header_index_cache cache;
 	struct lldpd_hardware *hardware;
         struct lldpd_ppvid *ppvid;
 
 	if (!header_index_init(vp, name, length, exact, var_len, write_method)) return NULL;
+	if (header_index_fresh(&cache)) return header_index_best();
 	TAILQ_FOREACH(hardware, &scfg->g_hardware, h_entries) {
 		TAILQ_FOREACH(ppvid, &hardware->h_lport.p_ppvids, p_entries) {
 			oid index[2] = { hardware->h_ifindex,
 					 ppvid->p_ppvid };
-			if (header_index_add(index, 2,
-					     ppvid))
-				return ppvid;
+			header_index_add(index, 2, ppvid);
 		}
 	}
 	return header_index_best();
@@ -454,11 +541,13 @@ static struct lldpd_ppvid*
 header_tprppvidindexed_table(struct variable *vp, oid *name, size_t *length,
     int exact, size_t *var_len, WriteMethod **write_method)
 {
+	static struct header_index_cache cache;
 	struct lldpd_hardware *hardware;
 	struct lldpd_port *port;
         struct lldpd_ppvid *ppvid;
 
 	if (!header_index_init(vp, name, length, exact, var_len, write_method)) return NULL;
+	if (header_index_fresh(&cache)) return header_index_best();
 	TAILQ_FOREACH(hardware, &scfg->g_hardware, h_entries) {
 		TAILQ_FOREACH(port, &hardware->h_rports, p_entries) {
 			if (SMART_HIDDEN(port)) continue;
@@ -467,9 +556,7 @@ header_tprppvidindexed_table(struct variable *vp, oid *name, size_t *length,
 						 hardware->h_ifindex,
 						 port->p_chassis->c_index,
 						 ppvid->p_ppvid };
-				if (header_index_add(index, 4,
-						     ppvid))
-					return ppvid;
+				header_index_add(index, 4, ppvid);
                         }
 		}
 	}
@@ -480,18 +567,18 @@ static struct lldpd_pi*
 header_ppiindexed_table(struct variable *vp, oid *name, size_t *length,
 			int exact, size_t *var_len, WriteMethod **write_method)
 {
+	static struct header_index_cache cache;
 	struct lldpd_hardware *hardware;
         struct lldpd_pi *pi;
 
 	if (!header_index_init(vp, name, length, exact, var_len, write_method)) return NULL;
+	if (header_index_fresh(&cache)) return header_index_best();
 	TAILQ_FOREACH(hardware, &scfg->g_hardware, h_entries) {
 		TAILQ_FOREACH(pi, &hardware->h_lport.p_pids, p_entries) {
 			oid index[2] = { hardware->h_ifindex,
 					 frame_checksum((const u_char*)pi->p_pi,
 					     pi->p_pi_len, 0) };
-			if (header_index_add(index, 2,
-					     pi))
-				return pi;
+			header_index_add(index, 2, pi);
 		}
 	}
 	return header_index_best();
@@ -501,11 +588,13 @@ static struct lldpd_pi*
 header_tprpiindexed_table(struct variable *vp, oid *name, size_t *length,
 			  int exact, size_t *var_len, WriteMethod **write_method)
 {
+	static struct header_index_cache cache;
 	struct lldpd_hardware *hardware;
 	struct lldpd_port *port;
         struct lldpd_pi *pi;
 
 	if (!header_index_init(vp, name, length, exact, var_len, write_method)) return NULL;
+	if (header_index_fresh(&cache)) return header_index_best();
 	TAILQ_FOREACH(hardware, &scfg->g_hardware, h_entries) {
 		TAILQ_FOREACH(port, &hardware->h_rports, p_entries) {
 			if (SMART_HIDDEN(port)) continue;
@@ -515,9 +604,7 @@ header_tprpiindexed_table(struct variable *vp, oid *name, size_t *length,
 						 port->p_chassis->c_index,
 						 frame_checksum((const u_char *)pi->p_pi,
 						     pi->p_pi_len, 0) };
-				if (header_index_add(index, 4,
-						     pi))
-					return pi;
+				header_index_add(index, 4, pi);
                         }
 		}
 	}
@@ -651,7 +738,7 @@ agent_h_scalars(struct variable *vp, oid *name, size_t *length,
 		long_ret = LLDPD_TX_MSGDELAY;
 		return (u_char *)&long_ret;
 	case LLDP_SNMP_NOTIFICATION:
-		long_ret = 5;
+		long_ret = scfg->g_config.c_notification_interval;
 		return (u_char *)&long_ret;
 	case LLDP_SNMP_LASTUPDATE:
 		long_ret = 0;
@@ -670,25 +757,16 @@ agent_h_scalars(struct variable *vp, oid *name, size_t *length,
 			long_ret = (long_ret - starttime.tv_sec) * 100;
 		return (u_char *)&long_ret;
 	case LLDP_SNMP_STATS_INSERTS:
-		/* We assume this is equal to valid frames received on all ports */
-		long_ret = 0;
-		TAILQ_FOREACH(hardware, &scfg->g_hardware, h_entries)
-		    long_ret += hardware->h_insert_cnt;
+		long_ret = scfg->g_insert_cnt;
 		return (u_char *)&long_ret;
 	case LLDP_SNMP_STATS_AGEOUTS:
-		long_ret = 0;
-		TAILQ_FOREACH(hardware, &scfg->g_hardware, h_entries)
-		    long_ret += hardware->h_ageout_cnt;
+		long_ret = scfg->g_ageout_cnt;
 		return (u_char *)&long_ret;
 	case LLDP_SNMP_STATS_DELETES:
-		long_ret = 0;
-		TAILQ_FOREACH(hardware, &scfg->g_hardware, h_entries)
-		    long_ret += hardware->h_delete_cnt;
+		long_ret = scfg->g_delete_cnt;
 		return (u_char *)&long_ret;
 	case LLDP_SNMP_STATS_DROPS:
-		long_ret = 0;
-		TAILQ_FOREACH(hardware, &scfg->g_hardware, h_entries)
-		    long_ret += hardware->h_drop_cnt;
+		long_ret = scfg->g_drop_cnt;
 		return (u_char *)&long_ret;
 	default:
 		break;
@@ -801,16 +879,17 @@ agent_h_local_med_power(struct variable *vp, oid *name, size_t *length,
 	   do our best. For device type, we decide on the number of
 	   PD/PSE ports. */
 	TAILQ_FOREACH(hardware, &scfg->g_hardware, h_entries) {
-		if (hardware->h_lport.p_med_power.devicetype ==
+		if (hardware->h_lport.p_med == NULL) continue;
+		if (hardware->h_lport.p_med->power.devicetype ==
 		    LLDP_MED_POW_TYPE_PSE) {
 			pse++;
 			if (pse == 1) /* Take this port as a reference */
-				power = &hardware->h_lport.p_med_power;
-		} else if (hardware->h_lport.p_med_power.devicetype ==
+				power = &hardware->h_lport.p_med->power;
+		} else if (hardware->h_lport.p_med->power.devicetype ==
 			   LLDP_MED_POW_TYPE_PD) {
 			pse--;
 			if (pse == -1) /* Take this one instead */
-				power = &hardware->h_lport.p_med_power;
+				power = &hardware->h_lport.p_med->power;
 		}
 	}
 	if (power) {
@@ -831,7 +910,8 @@ agent_h_remote_med_power(struct variable *vp, oid *name, size_t *length,
 					    exact, var_len, write_method, 1)) == NULL)
 		return NULL;
 
-	if ((a = agent_v_med_power(vp, var_len, &port->p_med_power)) != NULL)
+	if (port->p_med &&
+	    (a = agent_v_med_power(vp, var_len, &port->p_med->power)) != NULL)
 		return a;
 	TRYNEXT(agent_h_remote_med_power);
 }
@@ -1272,79 +1352,79 @@ agent_v_port(struct variable *vp, size_t *var_len, struct lldpd_port *port)
 		}
 		break;
 	case LLDP_SNMP_DOT3_POWER_DEVICETYPE:
-		if (port->p_power.devicetype) {
-			long_ret = (port->p_power.devicetype == LLDP_DOT3_POWER_PSE)?1:2;
+		if (port->p_power && port->p_power->devicetype) {
+			long_ret = (port->p_power->devicetype == LLDP_DOT3_POWER_PSE)?1:2;
 			return (u_char *)&long_ret;
 		}
 		break;
 	case LLDP_SNMP_DOT3_POWER_SUPPORT:
-		if (port->p_power.devicetype) {
-			long_ret = (port->p_power.supported)?1:2;
+		if (port->p_power && port->p_power->devicetype) {
+			long_ret = (port->p_power->supported)?1:2;
 			return (u_char *)&long_ret;
 		}
 		break;
 	case LLDP_SNMP_DOT3_POWER_ENABLED:
-		if (port->p_power.devicetype) {
-			long_ret = (port->p_power.enabled)?1:2;
+		if (port->p_power && port->p_power->devicetype) {
+			long_ret = (port->p_power->enabled)?1:2;
 			return (u_char *)&long_ret;
 		}
 		break;
 	case LLDP_SNMP_DOT3_POWER_PAIRCONTROL:
-		if (port->p_power.devicetype) {
-			long_ret = (port->p_power.paircontrol)?1:2;
+		if (port->p_power && port->p_power->devicetype) {
+			long_ret = (port->p_power->paircontrol)?1:2;
 			return (u_char *)&long_ret;
 		}
 		break;
 	case LLDP_SNMP_DOT3_POWER_PAIRS:
-		if (port->p_power.devicetype) {
-			long_ret = port->p_power.pairs;
+		if (port->p_power && port->p_power->devicetype) {
+			long_ret = port->p_power->pairs;
 			return (u_char *)&long_ret;
 		}
 		break;
 	case LLDP_SNMP_DOT3_POWER_CLASS:
-		if (port->p_power.devicetype && port->p_power.class) {
-			long_ret = port->p_power.class;
+		if (port->p_power && port->p_power->devicetype && port->p_power->class) {
+			long_ret = port->p_power->class;
 			return (u_char *)&long_ret;
 		}
 		break;
 	case LLDP_SNMP_DOT3_POWER_TYPE:
-		if (port->p_power.devicetype &&
-		    port->p_power.powertype != LLDP_DOT3_POWER_8023AT_OFF) {
+		if (port->p_power && port->p_power->devicetype &&
+		    port->p_power->powertype != LLDP_DOT3_POWER_8023AT_OFF) {
 			*var_len = 1;
-			bit = (((port->p_power.powertype ==
+			bit = (((port->p_power->powertype ==
 				    LLDP_DOT3_POWER_8023AT_TYPE1)?0:1) << 7) |
-			    (((port->p_power.devicetype ==
+			    (((port->p_power->devicetype ==
 				    LLDP_DOT3_POWER_PSE)?0:1) << 6);
 			return (u_char *)&bit;
 		}
 		break;
 	case LLDP_SNMP_DOT3_POWER_SOURCE:
-		if (port->p_power.devicetype &&
-		    port->p_power.powertype != LLDP_DOT3_POWER_8023AT_OFF) {
+		if (port->p_power && port->p_power->devicetype &&
+		    port->p_power->powertype != LLDP_DOT3_POWER_8023AT_OFF) {
 			*var_len = 1;
-			bit = swap_bits(port->p_power.source%(1<<2));
+			bit = swap_bits(port->p_power->source%(1<<2));
 			return (u_char *)&bit;
 		}
 		break;
 	case LLDP_SNMP_DOT3_POWER_PRIORITY:
-		if (port->p_power.devicetype &&
-		    port->p_power.powertype != LLDP_DOT3_POWER_8023AT_OFF) {
+		if (port->p_power && port->p_power->devicetype &&
+		    port->p_power->powertype != LLDP_DOT3_POWER_8023AT_OFF) {
 			/* See 30.12.2.1.16. This seems defined in reverse order... */
-			long_ret = 4 - port->p_power.priority;
+			long_ret = 4 - port->p_power->priority;
 			return (u_char *)&long_ret;
 		}
 		break;
 	case LLDP_SNMP_DOT3_POWER_REQUESTED:
-		if (port->p_power.devicetype &&
-		    port->p_power.powertype != LLDP_DOT3_POWER_8023AT_OFF) {
-			long_ret = port->p_power.requested;
+		if (port->p_power && port->p_power->devicetype &&
+		    port->p_power->powertype != LLDP_DOT3_POWER_8023AT_OFF) {
+			long_ret = port->p_power->requested;
 			return (u_char *)&long_ret;
 		}
 		break;
 	case LLDP_SNMP_DOT3_POWER_ALLOCATED:
-		if (port->p_power.devicetype &&
-		    port->p_power.powertype != LLDP_DOT3_POWER_8023AT_OFF) {
-			long_ret = port->p_power.allocated;
+		if (port->p_power && port->p_power->devicetype &&
+		    port->p_power->powertype != LLDP_DOT3_POWER_8023AT_OFF) {
+			long_ret = port->p_power->allocated;
 			return (u_char *)&long_ret;
 		}
 		break;
@@ -1747,19 +1827,12 @@ size_t agent_lldp_vars_size(void) {
 	return sizeof(agent_lldp_vars)/sizeof(struct variable8);
 }
 
-/**
- * Send a notification about a change in one remote neighbor.
- *
- * @param hardware Interface on which the change has happened.
- * @param type     Type of change (add, delete, update)
- * @param rport    Changed remote port
- */
-void
-agent_notify(struct lldpd_hardware *hardware, int type,
-    struct lldpd_port *rport)
+/* Send a lldpRemTablesChange notification. When `hardware` and `rport` are
+ * provided, some extra objects about the neighbor are added. */
+static void
+agent_send_notification(struct lldpd *cfg, struct lldpd_hardware *hardware,
+    int type, struct lldpd_port *rport)
 {
-	struct lldpd_hardware *h;
-
 	/* OID of the notification */
 	oid notification_oid[] = { LLDP_OID, 0, 0, 1 };
 	size_t notification_oid_len = OID_LENGTH(notification_oid);
@@ -1770,59 +1843,22 @@ agent_notify(struct lldpd_hardware *hardware, int type,
 	/* Other OID */
         oid inserts_oid[] = { LLDP_OID, 1, 2, 2 };
 	size_t inserts_oid_len = OID_LENGTH(inserts_oid);
-	unsigned long inserts = 0;
+	unsigned long inserts = cfg->g_insert_cnt;
 
         oid deletes_oid[] = { LLDP_OID, 1, 2, 3 };
 	size_t deletes_oid_len = OID_LENGTH(deletes_oid);
-	unsigned long deletes = 0;
+	unsigned long deletes = cfg->g_delete_cnt;
 
         oid drops_oid[] = { LLDP_OID, 1, 2, 4 };
 	size_t drops_oid_len = OID_LENGTH(drops_oid);
-	unsigned long drops = 0;
+	unsigned long drops = cfg->g_drop_cnt;
 
         oid ageouts_oid[] = { LLDP_OID, 1, 2, 5 };
 	size_t ageouts_oid_len = OID_LENGTH(ageouts_oid);
-	unsigned long ageouts = 0;
-
-	/* We also add some extra. Easy ones. */
-	oid locport_oid[] = { LLDP_OID, 1, 3, 7, 1, 4,
-			      hardware->h_ifindex };
-	size_t locport_oid_len = OID_LENGTH(locport_oid);
-	oid sysname_oid[] = { LLDP_OID, 1, 4, 1, 1, 9,
-			      lastchange(rport), hardware->h_ifindex,
-			      rport->p_chassis->c_index };
-	size_t sysname_oid_len = OID_LENGTH(sysname_oid);
-	oid portdescr_oid[] = { LLDP_OID, 1, 4, 1, 1, 8,
-			      lastchange(rport), hardware->h_ifindex,
-			      rport->p_chassis->c_index };
-	size_t portdescr_oid_len = OID_LENGTH(portdescr_oid);
+	unsigned long ageouts = cfg->g_ageout_cnt;
 
 	netsnmp_variable_list *notification_vars = NULL;
 
-	if (!hardware->h_cfg->g_snmp) return;
-
-	switch (type) {
-	case NEIGHBOR_CHANGE_DELETED:
-		log_debug("snmp", "send notification for neighbor deleted on %s",
-		    hardware->h_ifname);
-		break;
-	case NEIGHBOR_CHANGE_UPDATED:
-		log_debug("snmp", "send notification for neighbor updated on %s",
-		    hardware->h_ifname);
-		break;
-	case NEIGHBOR_CHANGE_ADDED:
-		log_debug("snmp", "send notification for neighbor added on %s",
-		    hardware->h_ifname);
-		break;
-	}
-
-	TAILQ_FOREACH(h, &hardware->h_cfg->g_hardware, h_entries) {
-		inserts += h->h_insert_cnt;
-		deletes += h->h_delete_cnt;
-		ageouts += h->h_ageout_cnt;
-		drops   += h->h_drop_cnt;
-	}
-
 	/* snmpTrapOID */
 	snmp_varlist_add_variable(&notification_vars,
 	    objid_snmptrap, objid_snmptrap_len,
@@ -1851,7 +1887,20 @@ agent_notify(struct lldpd_hardware *hardware, int type,
 	    (u_char *)&ageouts,
 	    sizeof(ageouts));
 
-	if (type != NEIGHBOR_CHANGE_DELETED) {
+	if (hardware && rport && type != NEIGHBOR_CHANGE_DELETED) {
+		/* We also add some extra. Easy ones. */
+		oid locport_oid[] = { LLDP_OID, 1, 3, 7, 1, 4,
+				      hardware->h_ifindex };
+		size_t locport_oid_len = OID_LENGTH(locport_oid);
+		oid sysname_oid[] = { LLDP_OID, 1, 4, 1, 1, 9,
+				      lastchange(rport), hardware->h_ifindex,
+				      rport->p_chassis->c_index };
+		size_t sysname_oid_len = OID_LENGTH(sysname_oid);
+		oid portdescr_oid[] = { LLDP_OID, 1, 4, 1, 1, 8,
+				      lastchange(rport), hardware->h_ifindex,
+				      rport->p_chassis->c_index };
+		size_t portdescr_oid_len = OID_LENGTH(portdescr_oid);
+
 		snmp_varlist_add_variable(&notification_vars,
 		    locport_oid, locport_oid_len,
 		    ASN_OCTET_STR,
@@ -1879,6 +1928,71 @@ agent_notify(struct lldpd_hardware *hardware, int type,
 	snmp_free_varbind(notification_vars);
 }
 
+/* As mandated by lldpNotificationInterval, no more than one notification is
+ * sent during an interval. Changes happening in the meantime are notified
+ * together at the end of the interval. */
+static time_t agent_notification_last = 0;
+static int agent_notification_pending = 0;
+
+/**
+ * Send a notification about a change in one remote neighbor.
+ *
+ * @param hardware Interface on which the change has happened.
+ * @param type     Type of change (add, delete, update)
+ * @param rport    Changed remote port
+ */
+void
+agent_notify(struct lldpd_hardware *hardware, int type,
+    struct lldpd_port *rport)
+{
+	struct lldpd *cfg = hardware->h_cfg;
+	time_t now = time(NULL);
+	time_t next = agent_notification_last +
+	    cfg->g_config.c_notification_interval;
+
+	if (!cfg->g_snmp) return;
+
+	switch (type) {
+	case NEIGHBOR_CHANGE_DELETED:
+		log_debug("snmp", "send notification for neighbor deleted on %s",
+		    hardware->h_ifname);
+		break;
+	case NEIGHBOR_CHANGE_UPDATED:
+		log_debug("snmp", "send notification for neighbor updated on %s",
+		    hardware->h_ifname);
+		break;
+	case NEIGHBOR_CHANGE_ADDED:
+		log_debug("snmp", "send notification for neighbor added on %s",
+		    hardware->h_ifname);
+		break;
+	}
+
+	if (agent_notification_pending || now < next) {
+		if (!agent_notification_pending)
+			levent_schedule_snmp_notification(cfg,
+			    (next > now)?(next - now):0);
+		agent_notification_pending++;
+		log_debug("snmp", "notification delayed, %d changes pending",
+		    agent_notification_pending);
+		return;
+	}
+
+	agent_notification_last = now;
+	agent_send_notification(cfg, hardware, type, rport);
+}
+
+/* Send a notification for all changes delayed during the last interval. */
+void
+agent_notify_pending(struct lldpd *cfg)
+{
+	if (!agent_notification_pending) return;
+	log_debug("snmp", "send one notification for %d changes",
+	    agent_notification_pending);
+	agent_notification_pending = 0;
+	agent_notification_last = time(NULL);
+	agent_send_notification(cfg, NULL, 0, NULL);
+}
+
 
 /* Logging NetSNMP messages */
 static int
@@ -55,6 +55,7 @@ client_handle_set_configuration(struct lldpd *cfg, enum hmsg_type *type,
     void *input, int input_len, void **output, int *subscribed)
 {
 	struct lldpd_config *config;
+	int failed = 0;
 
 	log_debug("rpc", "client request a change in configuration");
 	/* Get the proposed configuration. */
@@ -71,6 +72,7 @@ client_handle_set_configuration(struct lldpd *cfg, enum hmsg_type *type,
 	if (CHANGED(c_tx_interval) && config->c_tx_interval != 0) {
 		if (config->c_tx_interval < 0) {
 			log_debug("rpc", "client asked for immediate retransmission");
+			lldpd_hostname_check(cfg, 1);
 		} else {
 			log_debug("rpc", "client change transmit interval to %d",
 			    config->c_tx_interval);
@@ -87,6 +89,13 @@ client_handle_set_configuration(struct lldpd *cfg, enum hmsg_type *type,
 		cfg->g_config.c_ttl = cfg->g_config.c_tx_interval *
 		    cfg->g_config.c_tx_hold;
 	}
+	if (CHANGED(c_notification_interval) &&
+	    config->c_notification_interval >= LLDPD_NOTIFICATION_INTERVAL_MIN &&
+	    config->c_notification_interval <= LLDPD_NOTIFICATION_INTERVAL_MAX) {
+		log_debug("rpc", "client change notification interval to %d",
+		    config->c_notification_interval);
+		cfg->g_config.c_notification_interval = config->c_notification_interval;
+	}
 	if (CHANGED(c_max_neighbors) && config->c_max_neighbors > 0) {
 		log_debug("rpc", "client change maximum neighbors to %d",
 		    config->c_max_neighbors);
@@ -113,6 +122,8 @@ client_handle_set_configuration(struct lldpd *cfg, enum hmsg_type *type,
 		log_debug("rpc", "client asked to %s lldpd",
 		    config->c_paused?"pause":"resume");
 		cfg->g_config.c_paused = config->c_paused;
+		if (!cfg->g_config.c_paused)
+			lldpd_startup_mark(cfg, &cfg->g_config.c_startup_configured);
 		levent_send_now(cfg);
 	}
 
@@ -133,6 +144,7 @@ client_handle_set_configuration(struct lldpd *cfg, enum hmsg_type *type,
 		    config->c_iface_pattern?config->c_iface_pattern:"(NULL)");
 		free(cfg->g_config.c_iface_pattern);
 		cfg->g_config.c_iface_pattern = xstrdup(config->c_iface_pattern);
+		lldpd_compile_patterns(cfg);
 		levent_update_now(cfg);
 	}
 	if (CHANGED_STR(c_perm_ifaces)) {
@@ -140,6 +152,7 @@ client_handle_set_configuration(struct lldpd *cfg, enum hmsg_type *type,
 		    config->c_perm_ifaces?config->c_perm_ifaces:"(NULL)");
 		free(cfg->g_config.c_perm_ifaces);
 		cfg->g_config.c_perm_ifaces = xstrdup(config->c_perm_ifaces);
+		lldpd_compile_patterns(cfg);
 		levent_update_now(cfg);
 	}
 	if (CHANGED_STR(c_mgmt_pattern)) {
@@ -147,6 +160,7 @@ client_handle_set_configuration(struct lldpd *cfg, enum hmsg_type *type,
 		    config->c_mgmt_pattern?config->c_mgmt_pattern:"(NULL)");
 		free(cfg->g_config.c_mgmt_pattern);
 		cfg->g_config.c_mgmt_pattern = xstrdup(config->c_mgmt_pattern);
+		lldpd_compile_patterns(cfg);
 		levent_update_now(cfg);
 	}
 	if (CHANGED_STR(c_cid_string)) {
@@ -207,6 +221,57 @@ client_handle_set_configuration(struct lldpd *cfg, enum hmsg_type *type,
 		cfg->g_config.c_mgmt_advertise = config->c_mgmt_advertise;
 		levent_update_now(cfg);
 	}
+	if (CHANGED(c_snapshot)) {
+		log_debug("rpc", "%s snapshot publication",
+		    config->c_snapshot?"enable":"disable");
+		cfg->g_config.c_snapshot = config->c_snapshot;
+		if (config->c_snapshot)
+			snapshot_open(cfg);
+		else
+			snapshot_close(cfg);
+	}
+	if (CHANGED(c_metrics) || CHANGED(c_metrics_port)) {
+		if (config->c_metrics_port >= 0 && config->c_metrics_port <= 65535) {
+			log_debug("rpc", "%s metrics export",
+			    config->c_metrics?"enable":"disable");
+			metrics_close(cfg);
+			cfg->g_config.c_metrics = config->c_metrics;
+			cfg->g_config.c_metrics_port = config->c_metrics_port;
+			if (config->c_metrics)
+				metrics_open(cfg);
+		} else {
+			log_info("rpc", "invalid port for metrics: %d",
+			    config->c_metrics_port);
+		}
+	}
+	if (CHANGED(c_decode_workers)) {
+		if (config->c_decode_workers >= 0 &&
+		    config->c_decode_workers <= LLDPD_DECODE_MAX_WORKERS) {
+			log_debug("rpc", "decode frames with %d threads",
+			    config->c_decode_workers);
+			decode_stop(cfg);
+			cfg->g_config.c_decode_workers = config->c_decode_workers;
+			if (decode_start(cfg) == -1) {
+				cfg->g_config.c_decode_workers = 0;
+				failed = 1;
+			}
+		} else {
+			log_info("rpc", "invalid number of decoding threads: %d",
+			    config->c_decode_workers);
+		}
+	}
+	if (CHANGED(c_warm_restart)) {
+		log_debug("rpc", "%s warm restart",
+		    config->c_warm_restart?"enable":"disable");
+		cfg->g_config.c_warm_restart = config->c_warm_restart;
+		if (config->c_warm_restart) {
+			/* Neighbors are only restored while starting up */
+			if (!cfg->g_config.c_startup_configured)
+				state_restore(cfg);
+		} else
+			priv_save_state(NULL, 0);
+		levent_schedule_state(cfg, config->c_warm_restart);
+	}
 	if (CHANGED(c_bond_slave_src_mac_type)) {
 		if (config->c_bond_slave_src_mac_type >
 		    LLDP_BOND_SLAVE_SRC_MAC_TYPE_UNKNOWN &&
@@ -225,6 +290,8 @@ client_handle_set_configuration(struct lldpd *cfg, enum hmsg_type *type,
 	lldpd_config_cleanup(config);
 	free(config);
 
+	/* Let the client know something went wrong */
+	if (failed) *type = NONE;
 	return 0;
 }
 
@@ -249,7 +316,8 @@ client_handle_get_interfaces(struct lldpd *cfg, enum hmsg_type *type,
 		if ((iff = (struct lldpd_interface*)malloc(sizeof(
 			    struct lldpd_interface))) == NULL)
 			fatal("rpc", NULL);
-		iff->name = hardware->h_ifname;
+		if ((iff->name = strdup(lldpd_hardware_name(hardware))) == NULL)
+			fatal("rpc", NULL);
 		TAILQ_INSERT_TAIL(&ifs, iff, next);
 	}
 
@@ -265,12 +333,79 @@ client_handle_get_interfaces(struct lldpd *cfg, enum hmsg_type *type,
 	    iff = iff_next) {
 		iff_next = TAILQ_NEXT(iff, next);
 		TAILQ_REMOVE(&ifs, iff, next);
+		free(iff->name);
 		free(iff);
 	}
 
 	return output_len;
 }
 
+/* Return a batch of local ports.
+   Input:  index of the first port to return (lldpd_ports_batch).
+   Output: as many ports as fit in one message (lldpd_ports_batch).
+
+   Each port is serialized on its own: serializing the whole list of ports at
+   once is quadratic in the number of objects.
+*/
+static ssize_t
+client_handle_get_ports(struct lldpd *cfg, enum hmsg_type *type,
+    void *input, int input_len, void **output, int *subscribed)
+{
+	struct lldpd_ports_batch *request, batch = {};
+	struct lldpd_hardware *hardware;
+	struct snapshot_record record;
+	char *records;
+	void *blob;
+	ssize_t len, output_len;
+	size_t size;
+	int index = 0;
+
+	if (lldpd_ports_batch_unserialize(input, input_len, &request) <= 0) {
+		*type = NONE;
+		return 0;
+	}
+	batch.b_start = request->b_start;
+	free(request);
+
+	log_debug("rpc", "client request ports starting at %d", batch.b_start);
+	TAILQ_FOREACH(hardware, &cfg->g_hardware, h_entries) {
+		if (index < batch.b_start) {
+			index++;
+			continue;
+		}
+		if (batch.b_len >= PORTS_BATCH_SIZE) {
+			batch.b_next = index;
+			break;
+		}
+		if ((len = lldpd_hardware_serialize(hardware, &blob)) <= 0) {
+			log_warnx("rpc", "unable to serialize %s",
+			    lldpd_hardware_name(hardware));
+			free(batch.b_records);
+			*type = NONE;
+			return 0;
+		}
+		size = sizeof(record) + SNAPSHOT_ALIGN(len);
+		if ((records = realloc(batch.b_records, batch.b_len + size)) == NULL)
+			fatal("rpc", NULL);
+		memset(records + batch.b_len, 0, size);
+		record.len = len;
+		memcpy(records + batch.b_len, &record, sizeof(record));
+		memcpy(records + batch.b_len + sizeof(record), blob, len);
+		free(blob);
+		batch.b_records = records;
+		batch.b_len += size;
+		index++;
+	}
+
+	output_len = lldpd_ports_batch_serialize(&batch, output);
+	free(batch.b_records);
+	if (output_len <= 0) {
+		output_len = 0;
+		*type = NONE;
+	}
+	return output_len;
+}
+
 /* Return the local chassis.
    Input:  nothing.
    Output: local chassis (lldpd_chassis)
@@ -314,7 +449,7 @@ client_handle_get_interface(struct lldpd *cfg, enum hmsg_type *type,
 	/* Search appropriate hardware */
 	log_debug("rpc", "client request interface %s", name);
 	TAILQ_FOREACH(hardware, &cfg->g_hardware, h_entries)
-		if (!strcmp(hardware->h_ifname, name)) {
+		if (lldpd_hardware_match(hardware, name)) {
 			ssize_t output_len = lldpd_hardware_serialize(hardware, output);
 			free(name);
 			if (output_len <= 0) {
@@ -389,6 +524,12 @@ _client_handle_set_port(struct lldpd *cfg,
 		break;
 	}
 #ifdef ENABLE_LLDPMED
+	if (((set->med_policy && set->med_policy->type > 0) ||
+	    (set->med_location && set->med_location->format > 0) ||
+	    set->med_power) && LLDPD_PORT_EXT(port, p_med) == NULL) {
+		log_warn("rpc", "unable to allocate memory for MED information");
+		return -1;
+	}
 	if (set->med_policy && set->med_policy->type > 0) {
 		log_debug("rpc", "requested change to MED policy");
 		if (set->med_policy->type > LLDP_MED_APPTYPE_LAST) {
@@ -396,7 +537,7 @@ _client_handle_set_port(struct lldpd *cfg,
 			    set->med_policy->type);
 			return -1;
 		}
-		memcpy(&port->p_med_policy[set->med_policy->type - 1],
+		memcpy(&port->p_med->policy[set->med_policy->type - 1],
 		    set->med_policy, sizeof(struct lldpd_med_policy));
 		port->p_med_cap_enabled |= LLDP_MED_CAP_POLICY;
 	}
@@ -409,7 +550,7 @@ _client_handle_set_port(struct lldpd *cfg,
 			return -1;
 		}
 		loc = \
-		    &port->p_med_location[set->med_location->format - 1];
+		    &port->p_med->location[set->med_location->format - 1];
 		free(loc->data);
 		memcpy(loc, set->med_location, sizeof(struct lldpd_med_loc));
 		if (!loc->data || !(newdata = malloc(loc->data_len))) loc->data_len = 0;
@@ -419,7 +560,7 @@ _client_handle_set_port(struct lldpd *cfg,
 	}
 	if (set->med_power) {
 		log_debug("rpc", "requested change to MED power");
-		memcpy(&port->p_med_power, set->med_power,
+		memcpy(&port->p_med->power, set->med_power,
 		    sizeof(struct lldpd_med_power));
 		switch (set->med_power->devicetype) {
 		case LLDP_MED_POW_TYPE_PD:
@@ -436,12 +577,20 @@ _client_handle_set_port(struct lldpd *cfg,
 #ifdef ENABLE_DOT3
 	if (set->dot3_power) {
 		log_debug("rpc", "requested change to Dot3 power");
-		memcpy(&port->p_power, set->dot3_power,
+		if (LLDPD_PORT_EXT(port, p_power) == NULL) {
+			log_warn("rpc", "unable to allocate memory for Dot3 power");
+			return -1;
+		}
+		memcpy(port->p_power, set->dot3_power,
 		    sizeof(struct lldpd_dot3_power));
 	}
 	if (set->dot3_measurements) {
 		log_debug("rpc", "requested change to Dot3 measurements");
-		memcpy(&port->p_measurements, set->dot3_measurements,
+		if (LLDPD_PORT_EXT(port, p_measurements) == NULL) {
+			log_warn("rpc", "unable to allocate memory for Dot3 measurements");
+			return -1;
+		}
+		memcpy(port->p_measurements, set->dot3_measurements,
 		    sizeof(struct lldpd_dot3_measurements));
 	}
 #endif
@@ -508,7 +657,7 @@ client_handle_set_port(struct lldpd *cfg, enum hmsg_type *type,
 	} else {
 		log_debug("rpc", "client request change to port %s", set->ifname);
 		TAILQ_FOREACH(hardware, &cfg->g_hardware, h_entries) {
-		    if (!strcmp(hardware->h_ifname, set->ifname)) {
+		    if (lldpd_hardware_match(hardware, set->ifname)) {
 			    struct lldpd_port *port = &hardware->h_lport;
 			    if (_client_handle_set_port(cfg, port, set) == -1)
 				    goto set_port_finished;
@@ -520,8 +669,11 @@ client_handle_set_port(struct lldpd *cfg, enum hmsg_type *type,
 
 	if (ret == 0)
 		log_warn("rpc", "no interface %s found", set->ifname);
-	else
-	    levent_update_now(cfg);
+	else {
+		cfg->g_generation++;
+		levent_schedule_snapshot(cfg);
+		levent_update_now(cfg);
+	}
 
 set_port_finished:
 	if (!ret) *type = NONE;
@@ -558,6 +710,22 @@ client_handle_subscribe(struct lldpd *cfg, enum hmsg_type *type,
 	return 0;
 }
 
+/* Return latency histograms, resetting them if requested */
+static ssize_t
+client_handle_get_latency(struct lldpd *cfg, enum hmsg_type *type,
+    void *input, int input_len, void **output, int *subscribed)
+{
+	ssize_t output_len;
+	log_debug("rpc", "client requested latency histograms");
+	output_len = latency_serialize(cfg, output);
+	if (output_len <= 0) {
+		output_len = 0;
+		*type = NONE;
+	} else if (*type == RESET_LATENCY)
+		latency_reset(cfg);
+	return output_len;
+}
+
 struct client_handle {
 	enum hmsg_type type;
 	const char *name;
@@ -575,6 +743,9 @@ static struct client_handle client_handles[] = {
 	{ GET_CHASSIS,		"Get local chassis", client_handle_get_local_chassis },
 	{ SET_PORT,		"Set port",          client_handle_set_port },
 	{ SUBSCRIBE,		"Subscribe",         client_handle_subscribe },
+	{ GET_LATENCY,		"Get latency",       client_handle_get_latency },
+	{ RESET_LATENCY,	"Reset latency",     client_handle_get_latency },
+	{ GET_PORTS,		"Get ports",         client_handle_get_ports },
 	{ 0,			NULL } };
 
 int
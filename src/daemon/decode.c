@@ -0,0 +1,464 @@
+/* -*- mode: c; c-file-style: "openbsd" -*- */
+/*
+ * Copyright (c) 2019 Vincent Bernat <bernat@luffy.cx>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* Decode received frames in a pool of threads. Threads only turn a frame into
+ * a detached chassis and port. The main loop still does everything else:
+ * looking up the MSAP, merging with the existing neighbors and sending
+ * notifications.
+ *
+ * All frames of a port are decoded by the same thread and go through a single
+ * queue of decoded frames, so they are merged in the order they were
+ * received. Decoding threads never access the port itself: they work on a
+ * private copy of what the decoders need. When a port is removed, its pending
+ * frames are dropped when they come back to the main loop.
+ *
+ * EDP frames may update existing neighbors while being decoded. They go
+ * through the queues to keep the order but they are decoded by the main loop,
+ * when merged. */
+
+#include "lldpd.h"
+
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <fcntl.h>
+
+#ifdef HAVE_PTHREAD
+
+#include <pthread.h>
+#if defined(__clang__)
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wdocumentation"
+#endif
+#include <event2/event.h>
+#if defined(__clang__)
+#pragma clang diagnostic pop
+#endif
+
+#define DECODE_MAX_PENDING 4096	/* Maximum number of frames not merged yet */
+
+struct decode_job {
+	TAILQ_ENTRY(decode_job) next;
+	struct lldpd_hardware *hardware; /* NULL once the port is removed */
+	int protocol;			/* Index in the list of protocols */
+	char *frame;
+	int size;
+	int background;			/* Decoded by a thread */
+	char ifname[IFNAMSIZ];
+#ifdef ENABLE_DOT3
+	struct lldpd_dot3_power power;	/* Copy of the local power settings */
+	int has_power;
+#endif
+
+	/* Result of the decoding */
+	int rc;
+	u_int64_t unrecognized;
+	u_int64_t elapsed;		/* Time spent decoding, in ns */
+	struct lldpd_chassis *chassis;
+	struct lldpd_port *port;
+};
+TAILQ_HEAD(decode_jobs, decode_job);
+
+struct decode_worker {
+	struct lldpd_decode *pool;
+	pthread_t thread;
+	pthread_cond_t cond;
+	struct decode_jobs jobs;	/* Frames to decode */
+	struct decode_job *current;	/* Frame being decoded */
+	struct lldpd_hardware scratch;	/* What the decoders see of the port */
+};
+
+struct lldpd_decode {
+	struct lldpd *cfg;
+	pthread_mutex_t lock;		/* Protect everything below */
+	int stopping;
+	size_t pending;			/* Frames not merged yet */
+	struct decode_jobs done;	/* Frames to merge */
+	int count;
+	struct decode_worker *workers;
+	int wakeup[2];			/* Pipe to wake up the main loop */
+	struct event *ev;
+};
+
+static void
+decode_job_free(struct decode_job *job)
+{
+	if (job->chassis) {
+		lldpd_port_cleanup(job->port, 1);
+		lldpd_chassis_cleanup(job->chassis, 1);
+		lldpd_slab_free(LLDPD_SLAB_PORT, job->port);
+	}
+	free(job->frame);
+	free(job);
+}
+
+static void
+decode_run(struct lldpd *cfg, struct decode_worker *worker,
+    struct decode_job *job)
+{
+	struct lldpd_hardware *hardware = &worker->scratch;
+	struct timespec start;
+
+	strlcpy(hardware->h_ifname, job->ifname, sizeof(hardware->h_ifname));
+	hardware->h_rx_unrecognized_cnt = 0;
+#ifdef ENABLE_DOT3
+	hardware->h_lport.p_power = job->has_power?&job->power:NULL;
+#endif
+	log_debug("decode", "using decode function for %s protocol on %s",
+	    cfg->g_protocols[job->protocol].name, job->ifname);
+	latency_start(&start);
+	job->rc = cfg->g_protocols[job->protocol].decode(cfg,
+	    job->frame, job->size, hardware, &job->chassis, &job->port);
+	job->elapsed = latency_elapsed(&start);
+	if (job->rc == -1) {
+		job->chassis = NULL;
+		job->port = NULL;
+	}
+	job->unrecognized = hardware->h_rx_unrecognized_cnt;
+}
+
+static void *
+decode_worker(void *arg)
+{
+	struct decode_worker *worker = arg;
+	struct lldpd_decode *pool = worker->pool;
+	struct decode_job *job;
+	char one = 1;
+	int empty;
+
+	lldpd_alloc_detach();
+	pthread_mutex_lock(&pool->lock);
+	for (;;) {
+		while (TAILQ_EMPTY(&worker->jobs) && !pool->stopping)
+			pthread_cond_wait(&worker->cond, &pool->lock);
+		/* When stopping, the queue is drained first */
+		if ((job = TAILQ_FIRST(&worker->jobs)) == NULL) break;
+		TAILQ_REMOVE(&worker->jobs, job, next);
+		worker->current = job;
+		pthread_mutex_unlock(&pool->lock);
+
+		if (job->background)
+			decode_run(pool->cfg, worker, job);
+
+		pthread_mutex_lock(&pool->lock);
+		worker->current = NULL;
+		empty = TAILQ_EMPTY(&pool->done);
+		TAILQ_INSERT_TAIL(&pool->done, job, next);
+		if (empty && write(pool->wakeup[1], &one, 1) == -1 &&
+		    errno != EAGAIN)
+			log_warn("decode", "unable to wake up main loop");
+	}
+	pthread_mutex_unlock(&pool->lock);
+	return NULL;
+}
+
+/* Merge a frame coming back from the decoding threads. */
+static void
+decode_merge(struct lldpd *cfg, struct decode_job *job)
+{
+	struct lldpd_hardware *hardware = job->hardware;
+	struct protocol *proto = &cfg->g_protocols[job->protocol];
+	struct timespec start;
+	int changed;
+
+	/* Objects allocated by a worker are not accounted yet */
+	lldpd_slab_adopt_neighbor(job->chassis, job->port);
+	lldpd_slab_adopt(LLDPD_SLAB_PORT, job->port);
+	if (hardware == NULL) {
+		log_debug("decode", "port %s removed, drop decoded frame",
+		    job->ifname);
+		decode_job_free(job);
+		return;
+	}
+	if (!job->background) {
+		log_debug("decode", "using decode function for %s protocol",
+		    proto->name);
+		latency_start(&start);
+		job->rc = proto->decode(cfg, job->frame, job->size,
+		    hardware, &job->chassis, &job->port);
+		latency_record(cfg, LATENCY_DECODE, &start);
+	} else {
+		/* Latency cannot be recorded from the worker */
+		latency_add(cfg, LATENCY_DECODE, job->elapsed);
+		hardware->h_rx_unrecognized_cnt += job->unrecognized;
+	}
+	if (job->rc == -1) {
+		log_debug("decode", "function for %s protocol did not decode this frame",
+		    proto->name);
+		hardware->h_rx_discarded_cnt++;
+		job->chassis = NULL;
+		changed = 0;
+	} else {
+		changed = lldpd_decode_commit(cfg, hardware, job->protocol,
+		    job->frame, job->size, job->chassis, job->port);
+		job->chassis = NULL;	/* Now owned by the port */
+	}
+	lldpd_recv_complete(cfg, hardware, changed);
+	decode_job_free(job);
+}
+
+/* Merge all decoded frames. */
+static void
+decode_merge_all(struct lldpd_decode *pool)
+{
+	struct decode_jobs done;
+	struct decode_job *job;
+	size_t count = 0;
+
+	TAILQ_INIT(&done);
+	pthread_mutex_lock(&pool->lock);
+	while ((job = TAILQ_FIRST(&pool->done)) != NULL) {
+		TAILQ_REMOVE(&pool->done, job, next);
+		TAILQ_INSERT_TAIL(&done, job, next);
+		count++;
+	}
+	pool->pending -= count;
+	pthread_mutex_unlock(&pool->lock);
+
+	/* Nobody else touches the jobs now: decode_forget() is only called
+	 * from the main loop. */
+	while ((job = TAILQ_FIRST(&done)) != NULL) {
+		TAILQ_REMOVE(&done, job, next);
+		decode_merge(pool->cfg, job);
+	}
+}
+
+static void
+decode_wakeup(evutil_socket_t fd, short what, void *arg)
+{
+	struct lldpd_decode *pool = arg;
+	char buf[64];
+	while (read(fd, buf, sizeof(buf)) > 0);
+	decode_merge_all(pool);
+}
+
+/**
+ * Start the decoding threads. The number of threads is taken from the
+ * configuration.
+ *
+ * @return 0 on success, -1 otherwise.
+ */
+int
+decode_start(struct lldpd *cfg)
+{
+	struct lldpd_decode *pool;
+	sigset_t all, old;
+	int i, count = cfg->g_config.c_decode_workers;
+
+	if (cfg->g_decode != NULL || count <= 0) return 0;
+	log_debug("decode", "start %d decoding threads", count);
+	if ((pool = calloc(1, sizeof(struct lldpd_decode))) == NULL ||
+	    (pool->workers = calloc(count, sizeof(struct decode_worker))) == NULL) {
+		log_warn("decode", "unable to allocate decoding threads");
+		if (pool) free(pool);
+		return -1;
+	}
+	pool->cfg = cfg;
+	TAILQ_INIT(&pool->done);
+	pool->wakeup[0] = pool->wakeup[1] = -1;
+	if (pipe(pool->wakeup) == -1) {
+		log_warn("decode", "unable to create pipe for decoding threads");
+		goto error;
+	}
+	levent_make_socket_nonblocking(pool->wakeup[0]);
+	levent_make_socket_nonblocking(pool->wakeup[1]);
+	if ((pool->ev = event_new(cfg->g_base, pool->wakeup[0],
+		    EV_READ | EV_PERSIST, decode_wakeup, pool)) == NULL ||
+	    event_add(pool->ev, NULL) == -1) {
+		log_warnx("decode", "unable to watch decoding threads");
+		goto error;
+	}
+	pthread_mutex_init(&pool->lock, NULL);
+
+	/* Signals are handled by the main loop only */
+	sigfillset(&all);
+	pthread_sigmask(SIG_SETMASK, &all, &old);
+	for (i = 0; i < count; i++) {
+		struct decode_worker *worker = &pool->workers[i];
+		worker->pool = pool;
+		TAILQ_INIT(&worker->jobs);
+		TAILQ_INIT(&worker->scratch.h_rports);
+		pthread_cond_init(&worker->cond, NULL);
+		if ((errno = pthread_create(&worker->thread, NULL,
+			    decode_worker, worker)) != 0) {
+			log_warn("decode", "unable to start decoding thread");
+			pthread_cond_destroy(&worker->cond);
+			break;
+		}
+		pool->count++;
+	}
+	pthread_sigmask(SIG_SETMASK, &old, NULL);
+	cfg->g_decode = pool;
+	if (pool->count < count) {
+		decode_stop(cfg);
+		return -1;
+	}
+	return 0;
+
+error:
+	if (pool->ev) event_free(pool->ev);
+	if (pool->wakeup[0] != -1) close(pool->wakeup[0]);
+	if (pool->wakeup[1] != -1) close(pool->wakeup[1]);
+	free(pool->workers);
+	free(pool);
+	return -1;
+}
+
+/**
+ * Stop the decoding threads. Frames already received are decoded and merged
+ * before returning.
+ */
+void
+decode_stop(struct lldpd *cfg)
+{
+	struct lldpd_decode *pool = cfg->g_decode;
+	int i;
+
+	if (pool == NULL) return;
+	log_debug("decode", "stop decoding threads");
+	pthread_mutex_lock(&pool->lock);
+	pool->stopping = 1;
+	for (i = 0; i < pool->count; i++)
+		pthread_cond_signal(&pool->workers[i].cond);
+	pthread_mutex_unlock(&pool->lock);
+	for (i = 0; i < pool->count; i++) {
+		pthread_join(pool->workers[i].thread, NULL);
+		pthread_cond_destroy(&pool->workers[i].cond);
+	}
+	decode_merge_all(pool);
+
+	cfg->g_decode = NULL;
+	event_free(pool->ev);
+	close(pool->wakeup[0]);
+	close(pool->wakeup[1]);
+	pthread_mutex_destroy(&pool->lock);
+	free(pool->workers);
+	free(pool);
+}
+
+/**
+ * Hand a received frame to the decoding threads.
+ *
+ * @param cfg      Daemon configuration.
+ * @param hardware Port the frame was received on.
+ * @param protocol Index of the protocol to decode the frame with.
+ * @param frame    Frame to decode. On success, it is freed once decoded.
+ * @param s        Size of the frame.
+ * @return 0 if the frame was queued, -1 if it should be decoded by the caller.
+ */
+int
+decode_submit(struct lldpd *cfg, struct lldpd_hardware *hardware,
+    int protocol, char *frame, int s)
+{
+	struct lldpd_decode *pool = cfg->g_decode;
+	struct decode_worker *worker;
+	struct decode_job *job;
+
+	if (pool == NULL) return -1;
+	if ((job = calloc(1, sizeof(struct decode_job))) == NULL)
+		return -1;
+	job->hardware = hardware;
+	job->protocol = protocol;
+	job->frame = frame;
+	job->size = s;
+	job->background = (cfg->g_protocols[protocol].mode != LLDPD_MODE_EDP);
+	strlcpy(job->ifname, hardware->h_ifname, sizeof(job->ifname));
+#ifdef ENABLE_DOT3
+	if (hardware->h_lport.p_power) {
+		memcpy(&job->power, hardware->h_lport.p_power, sizeof(job->power));
+		job->has_power = 1;
+	}
+#endif
+
+	/* Frames of a port are always handled by the same thread */
+	worker = &pool->workers[(uintptr_t)hardware / sizeof(*hardware) % pool->count];
+	pthread_mutex_lock(&pool->lock);
+	if (pool->pending >= DECODE_MAX_PENDING) {
+		pthread_mutex_unlock(&pool->lock);
+		log_debug("decode", "too many frames waiting to be decoded, "
+		    "drop frame received on %s", hardware->h_ifname);
+		hardware->h_rx_discarded_cnt++;
+		free(job);
+		free(frame);
+		return 0;
+	}
+	pool->pending++;
+	TAILQ_INSERT_TAIL(&worker->jobs, job, next);
+	pthread_cond_signal(&worker->cond);
+	pthread_mutex_unlock(&pool->lock);
+	return 0;
+}
+
+static void
+decode_forget_jobs(struct decode_jobs *jobs, struct lldpd_hardware *hardware)
+{
+	struct decode_job *job;
+	TAILQ_FOREACH(job, jobs, next)
+		if (job->hardware == hardware) job->hardware = NULL;
+}
+
+/**
+ * Forget about a port being removed. Its frames still being decoded will be
+ * dropped.
+ */
+void
+decode_forget(struct lldpd *cfg, struct lldpd_hardware *hardware)
+{
+	struct lldpd_decode *pool = cfg->g_decode;
+	int i;
+
+	if (pool == NULL) return;
+	pthread_mutex_lock(&pool->lock);
+	for (i = 0; i < pool->count; i++) {
+		if (pool->workers[i].current &&
+		    pool->workers[i].current->hardware == hardware)
+			pool->workers[i].current->hardware = NULL;
+		decode_forget_jobs(&pool->workers[i].jobs, hardware);
+	}
+	decode_forget_jobs(&pool->done, hardware);
+	pthread_mutex_unlock(&pool->lock);
+}
+
+#else
+
+int
+decode_start(struct lldpd *cfg)
+{
+	if (cfg->g_config.c_decode_workers <= 0) return 0;
+	log_warnx("decode", "decoding threads are not supported on this platform");
+	return -1;
+}
+
+void
+decode_stop(struct lldpd *cfg)
+{
+}
+
+int
+decode_submit(struct lldpd *cfg, struct lldpd_hardware *hardware,
+    int protocol, char *frame, int s)
+{
+	return -1;
+}
+
+void
+decode_forget(struct lldpd *cfg, struct lldpd_hardware *hardware)
+{
+}
+
+#endif
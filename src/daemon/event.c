@@ -54,6 +54,7 @@ struct lldpd_events {
 TAILQ_HEAD(ev_l, lldpd_events);
 
 #define levent_snmp_fds(cfg)   ((struct ev_l*)(cfg)->g_snmp_fds)
+#define levent_iface_fds(cfg)  ((struct ev_l*)(cfg)->g_iface_fds)
 #define levent_hardware_fds(hardware) ((struct ev_l*)(hardware)->h_recv)
 
 #ifdef USE_SNMP
@@ -113,6 +114,21 @@ levent_snmp_timeout(evutil_socket_t fd, short what, void *arg)
 	levent_snmp_update(cfg);
 }
 
+/*
+ * Callback function for delayed SNMP notifications.
+ *
+ * Some notifications were held back to respect the notification
+ * interval. Send a single one for all of them.
+ */
+static void
+levent_snmp_notify(evutil_socket_t fd, short what, void *arg)
+{
+	struct lldpd *cfg = arg;
+	(void)what; (void)fd;
+	agent_notify_pending(cfg);
+	levent_snmp_update(cfg);
+}
+
 /*
  * Watch a new SNMP FD.
  *
@@ -164,8 +180,10 @@ levent_snmp_update(struct lldpd *cfg)
 {
 	int maxfd = 0;
 	int block = 1;
+	int active;
 	struct timeval timeout;
 	static int howmany = 0;
+	static int lastmaxfd = -1;
 	int added = 0, removed = 0, current = 0;
 	struct lldpd_events *snmpfd, *snmpfd_next;
 
@@ -181,7 +199,7 @@ levent_snmp_update(struct lldpd *cfg)
 	netsnmp_large_fd_set fdset;
 	netsnmp_large_fd_set_init(&fdset, FD_SETSIZE);
         NETSNMP_LARGE_FD_ZERO(&fdset);
-	snmp_select_info2(&maxfd, &fdset, &timeout, &block);
+	active = snmp_select_info2(&maxfd, &fdset, &timeout, &block);
 
 	/* We need to untrack any event whose FD is not in `fdset`
 	   anymore */
@@ -201,12 +219,20 @@ levent_snmp_update(struct lldpd *cfg)
 		}
 	}
 
-	/* Invariant: FD in `fdset` are not in list of FD */
-	for (int fd = 0; fd < maxfd; fd++) {
-		if (NETSNMP_LARGE_FD_ISSET(fd, &fdset)) {
-			levent_snmp_add_fd(cfg, fd);
-			added++;
+	/* snmp_select_info() returns the number of open sessions. Sessions
+	   are seldom opened or closed: if we already track that many FD and
+	   the highest FD did not move, there is no new FD to watch and we
+	   don't need to scan the whole set (which may be large when we have
+	   many raw sockets). */
+	if (active != current || maxfd != lastmaxfd) {
+		/* Invariant: FD in `fdset` are not in list of FD */
+		for (int fd = 0; fd < maxfd; fd++) {
+			if (NETSNMP_LARGE_FD_ISSET(fd, &fdset)) {
+				levent_snmp_add_fd(cfg, fd);
+				added++;
+			}
 		}
+		lastmaxfd = maxfd;
 	}
 	current += added;
 	if (howmany != current) {
@@ -221,21 +247,80 @@ levent_snmp_update(struct lldpd *cfg)
 
 	netsnmp_large_fd_set_cleanup(&fdset);
 }
+
+/*
+ * Schedule sending of delayed SNMP notifications.
+ *
+ * @param cfg   The global configuration.
+ * @param delay Number of seconds before sending them.
+ */
+void
+levent_schedule_snmp_notification(struct lldpd *cfg, int delay)
+{
+	struct timeval tv = { delay, 0 };
+	if (!cfg->g_snmp_notification ||
+	    evtimer_pending(cfg->g_snmp_notification, NULL)) return;
+	log_debug("event", "schedule SNMP notification in %d seconds", delay);
+	if (evtimer_add(cfg->g_snmp_notification, &tv) == -1)
+		log_warnx("event", "unable to schedule SNMP notification");
+}
 #endif /* USE_SNMP */
 
+/*
+ * Notifications are written directly to subscribed clients as long as their
+ * output buffer stays below LEVENT_CTL_HIGH_WATER. Past this mark, they are
+ * queued and updates for the same neighbor are merged together. If the
+ * amount of queued data exceeds LEVENT_CTL_HARD_CAP, the queue is dropped and
+ * the client will receive a resync notification once it has caught up.
+ */
+#define LEVENT_CTL_HIGH_WATER	(256*1024)
+#define LEVENT_CTL_HARD_CAP	(4*1024*1024)
+
+struct lldpd_one_notification {
+	TAILQ_ENTRY(lldpd_one_notification) next;
+	int	 state;
+	void	*key;		/* Interface name and MSAP */
+	size_t	 key_len;
+	void	*output;	/* Serialized notification */
+	size_t	 len;
+};
+TAILQ_HEAD(lldpd_notifications, lldpd_one_notification);
+
 struct lldpd_one_client {
 	TAILQ_ENTRY(lldpd_one_client) next;
 	struct lldpd *cfg;
 	struct bufferevent *bev;
 	int    subscribed;	/* Is this client subscribed to changes? */
+	int    resync;		/* Has this client lost notifications? */
+	struct lldpd_notifications pending;
+	size_t pending_len;	/* Size of pending notifications */
+	unsigned long coalesced; /* Number of notifications merged */
+	unsigned long dropped;	/* Number of notifications dropped */
 };
 TAILQ_HEAD(, lldpd_one_client) lldpd_clients;
 
+static void
+levent_ctl_free_notification(struct lldpd_one_client *client,
+    struct lldpd_one_notification *notification)
+{
+	TAILQ_REMOVE(&client->pending, notification, next);
+	client->pending_len -= notification->len;
+	free(notification->key);
+	free(notification->output);
+	free(notification);
+}
+
 static void
 levent_ctl_free_client(struct lldpd_one_client *client)
 {
 	if (client && client->bev) bufferevent_free(client->bev);
 	if (client) {
+		if (client->coalesced || client->dropped)
+			log_debug("control", "client had %lu notifications coalesced "
+			    "and %lu dropped", client->coalesced, client->dropped);
+		while (!TAILQ_EMPTY(&client->pending))
+			levent_ctl_free_notification(client,
+			    TAILQ_FIRST(&client->pending));
 		TAILQ_REMOVE(&lldpd_clients, client, next);
 		free(client);
 	}
@@ -257,7 +342,7 @@ static ssize_t
 levent_ctl_send(struct lldpd_one_client *client, int type, void *data, size_t len)
 {
 	struct bufferevent *bev = client->bev;
-	struct hmsg_header hdr = { .len = len, .type = type };
+	struct hmsg_header hdr = { .len = len, .type = type, .version = HMSG_VERSION };
 	bufferevent_disable(bev, EV_WRITE);
 	if (bufferevent_write(bev, &hdr, sizeof(struct hmsg_header)) == -1 ||
 	    (len > 0 && bufferevent_write(bev, data, len) == -1)) {
@@ -269,17 +354,233 @@ levent_ctl_send(struct lldpd_one_client *client, int type, void *data, size_t le
 	return len;
 }
 
-void
-levent_ctl_notify(char *ifname, int state, struct lldpd_port *neighbor)
+static void levent_ctl_flush(struct bufferevent *, void *);
+
+/* Serialize a neighbor change. */
+static ssize_t
+levent_ctl_notify_serialize(const char *ifname, int state,
+    struct lldpd_port *neighbor, void **output)
 {
-	struct lldpd_one_client *client, *client_next;
 	struct lldpd_neighbor_change neigh = {
-		.ifname = ifname,
+		.ifname = (char *)ifname,
 		.state  = state,
 		.neighbor = neighbor
 	};
+	TAILQ_ENTRY(lldpd_port) backup_p_entries;
+	ssize_t output_len;
+
+	/* Ugly hack: we don't want to transmit a list of
+	 * ports. We patch the port to avoid this. */
+	memcpy(&backup_p_entries, &neighbor->p_entries,
+	    sizeof(backup_p_entries));
+	memset(&neighbor->p_entries, 0,
+	    sizeof(backup_p_entries));
+	output_len = lldpd_neighbor_change_serialize(&neigh, output);
+	memcpy(&neighbor->p_entries, &backup_p_entries,
+	    sizeof(backup_p_entries));
+	return output_len;
+}
+
+static size_t
+levent_ctl_output_len(struct lldpd_one_client *client)
+{
+	return evbuffer_get_length(bufferevent_get_output(client->bev));
+}
+
+/*
+ * Drop all pending notifications of a client and ask it to resync once its
+ * output buffer has been drained.
+ */
+static void
+levent_ctl_overflow(struct lldpd_one_client *client)
+{
+	unsigned long dropped = 1;
+	while (!TAILQ_EMPTY(&client->pending)) {
+		levent_ctl_free_notification(client,
+		    TAILQ_FIRST(&client->pending));
+		dropped++;
+	}
+	log_info("control", "client is too slow, %lu notifications dropped",
+	    dropped);
+	client->dropped += dropped;
+	client->cfg->g_notif_dropped += dropped;
+	client->resync = 1;
+
+	/* The write callback won't be invoked if the buffer is already empty */
+	if (levent_ctl_output_len(client) <= LEVENT_CTL_HIGH_WATER / 2)
+		levent_ctl_flush(client->bev, client);
+}
+
+/*
+ * Queue a notification for a client whose output buffer is above the
+ * high-water mark. An update is merged into the last pending notification
+ * for the same neighbor, unless this one is a deletion. When merged into an
+ * addition, the neighbor is still announced as added.
+ */
+static void
+levent_ctl_queue(struct lldpd_one_client *client, const char *ifname,
+    int state, struct lldpd_port *neighbor,
+    void *key, size_t key_len, void *output, size_t len)
+{
+	struct lldpd_one_notification *notification;
+	void *copy = NULL;
+	ssize_t copy_len;
+
+	if (client->resync) {
+		client->dropped++;
+		client->cfg->g_notif_dropped++;
+		return;
+	}
+
+	if (state == NEIGHBOR_CHANGE_UPDATED) {
+		TAILQ_FOREACH_REVERSE(notification, &client->pending,
+		    lldpd_notifications, next) {
+			if (notification->key_len != key_len ||
+			    memcmp(notification->key, key, key_len))
+				continue;
+			if (notification->state == NEIGHBOR_CHANGE_DELETED)
+				break;
+			if (notification->state == NEIGHBOR_CHANGE_ADDED) {
+				copy_len = levent_ctl_notify_serialize(ifname,
+				    NEIGHBOR_CHANGE_ADDED, neighbor, &copy);
+				if (copy_len <= 0) {
+					free(copy);
+					break;
+				}
+			} else {
+				if ((copy = malloc(len)) == NULL) break;
+				memcpy(copy, output, len);
+				copy_len = len;
+			}
+			if (levent_ctl_output_len(client) + client->pending_len -
+			    notification->len + copy_len > LEVENT_CTL_HARD_CAP) {
+				free(copy);
+				levent_ctl_overflow(client);
+				return;
+			}
+			free(notification->output);
+			client->pending_len -= notification->len;
+			client->pending_len += copy_len;
+			notification->output = copy;
+			notification->len = copy_len;
+			client->coalesced++;
+			client->cfg->g_notif_coalesced++;
+			return;
+		}
+	}
+
+	if (levent_ctl_output_len(client) + client->pending_len + len >
+	    LEVENT_CTL_HARD_CAP) {
+		levent_ctl_overflow(client);
+		return;
+	}
+
+	if ((notification = calloc(1, sizeof(*notification))) == NULL ||
+	    (notification->key = malloc(key_len)) == NULL ||
+	    (notification->output = malloc(len)) == NULL) {
+		log_warnx("event", "not enough memory to queue notification");
+		if (notification) free(notification->key);
+		free(notification);
+		levent_ctl_overflow(client);
+		return;
+	}
+	notification->state = state;
+	memcpy(notification->key, key, key_len);
+	notification->key_len = key_len;
+	memcpy(notification->output, output, len);
+	notification->len = len;
+	TAILQ_INSERT_TAIL(&client->pending, notification, next);
+	client->pending_len += len;
+}
+
+/*
+ * Called when the output buffer of a client has been drained below the low
+ * watermark. Send queued notifications or a resync notification.
+ */
+static void
+levent_ctl_flush(struct bufferevent *bev, void *ptr)
+{
+	struct lldpd_one_client *client = ptr;
+	struct lldpd_one_notification *notification;
+	(void)bev;
+
+	if (client->resync) {
+		struct lldpd_neighbor_change neigh = {
+			.ifname = "",
+			.state = NEIGHBOR_CHANGE_RESYNC,
+			.neighbor = NULL
+		};
+		void *output = NULL;
+		ssize_t output_len;
+		log_debug("control", "ask client to resync");
+		output_len = lldpd_neighbor_change_serialize(&neigh, &output);
+		if (output_len <= 0) {
+			log_warnx("event", "unable to serialize resync notification");
+			levent_ctl_free_client(client);
+			return;
+		}
+		client->resync = 0;
+		if (levent_ctl_send(client, NOTIFICATION, output, output_len) == -1) {
+			free(output);
+			return;
+		}
+		free(output);
+	}
+
+	while ((notification = TAILQ_FIRST(&client->pending)) != NULL &&
+	    levent_ctl_output_len(client) < LEVENT_CTL_HIGH_WATER) {
+		if (levent_ctl_send(client, NOTIFICATION,
+			notification->output, notification->len) == -1)
+			return;
+		levent_ctl_free_notification(client, notification);
+	}
+}
+
+/*
+ * Build the key used to coalesce notifications: interface name followed by
+ * chassis ID and port ID of the neighbor.
+ */
+static ssize_t
+levent_ctl_notify_key(const char *ifname, struct lldpd_port *neighbor, void **key)
+{
+	struct lldpd_chassis *chassis = neighbor->p_chassis;
+	size_t ifname_len = strlen(ifname) + 1;
+	size_t len = ifname_len +
+	    2 + chassis->c_id_len + neighbor->p_id_len;
+	unsigned char *p;
+
+	if ((p = *key = malloc(len)) == NULL)
+		return -1;
+	memcpy(p, ifname, ifname_len); p += ifname_len;
+	*p++ = chassis->c_id_subtype;
+	memcpy(p, chassis->c_id, chassis->c_id_len); p += chassis->c_id_len;
+	*p++ = neighbor->p_id_subtype;
+	memcpy(p, neighbor->p_id, neighbor->p_id_len);
+	return len;
+}
+
+/* Number of control clients and of notifications waiting for them. */
+void
+levent_ctl_stats(size_t *clients, size_t *pending)
+{
+	struct lldpd_one_client *client;
+	struct lldpd_one_notification *notification;
+	*clients = *pending = 0;
+	TAILQ_FOREACH(client, &lldpd_clients, next) {
+		(*clients)++;
+		TAILQ_FOREACH(notification, &client->pending, next)
+			(*pending)++;
+	}
+}
+
+void
+levent_ctl_notify(const char *ifname, int state, struct lldpd_port *neighbor)
+{
+	struct lldpd_one_client *client, *client_next;
 	void *output = NULL;
 	ssize_t output_len = 0;
+	void *key = NULL;
+	ssize_t key_len = 0;
 
 	/* Don't use TAILQ_FOREACH, the client may be deleted in case of errors. */
 	log_debug("control", "notify clients of neighbor changes");
@@ -290,26 +591,33 @@ levent_ctl_notify(char *ifname, int state, struct lldpd_port *neighbor)
 		if (!client->subscribed) continue;
 
 		if (output == NULL) {
-			/* Ugly hack: we don't want to transmit a list of
-			 * ports. We patch the port to avoid this. */
-			TAILQ_ENTRY(lldpd_port) backup_p_entries;
-			memcpy(&backup_p_entries, &neighbor->p_entries,
-			    sizeof(backup_p_entries));
-			memset(&neighbor->p_entries, 0,
-			    sizeof(backup_p_entries));
-			output_len = lldpd_neighbor_change_serialize(&neigh, &output);
-			memcpy(&neighbor->p_entries, &backup_p_entries,
-			    sizeof(backup_p_entries));
-
+			output_len = levent_ctl_notify_serialize(ifname, state,
+			    neighbor, &output);
 			if (output_len <= 0) {
 				log_warnx("event", "unable to serialize changed neighbor");
 				return;
 			}
 		}
 
-		levent_ctl_send(client, NOTIFICATION, output, output_len);
+		if (!client->resync && TAILQ_EMPTY(&client->pending) &&
+		    levent_ctl_output_len(client) < LEVENT_CTL_HIGH_WATER) {
+			levent_ctl_send(client, NOTIFICATION, output, output_len);
+			continue;
+		}
+
+		/* Slow client, queue the notification */
+		if (key == NULL &&
+		    (key_len = levent_ctl_notify_key(ifname, neighbor, &key)) == -1) {
+			log_warnx("event", "not enough memory to queue notification");
+			key = NULL;
+			levent_ctl_overflow(client);
+			continue;
+		}
+		levent_ctl_queue(client, ifname, state, neighbor,
+		    key, key_len, output, output_len);
 	}
 
+	free(key);
 	free(output);
 }
 
@@ -337,6 +645,11 @@ levent_ctl_recv(struct bufferevent *bev, void *ptr)
 		log_warnx("event", "not able to read header");
 		return;
 	}
+	if (hdr.version != HMSG_VERSION) {
+		log_warnx("event", "incompatible message version (expected: %d, received: %d)",
+		    HMSG_VERSION, hdr.version);
+		goto recv_error;
+	}
 	if (hdr.len > HMSG_MAX_SIZE) {
 		log_warnx("event", "message received is too large");
 		goto recv_error;
@@ -400,6 +713,7 @@ levent_ctl_accept(evutil_socket_t fd, short what, void *arg)
 		goto accept_failed;
 	}
 	client->cfg = cfg;
+	TAILQ_INIT(&client->pending);
 	levent_make_socket_nonblocking(s);
 	TAILQ_INSERT_TAIL(&lldpd_clients, client, next);
 	if ((client->bev = bufferevent_socket_new(cfg->g_base, s,
@@ -409,8 +723,10 @@ levent_ctl_accept(evutil_socket_t fd, short what, void *arg)
 		goto accept_failed;
 	}
 	bufferevent_setcb(client->bev,
-	    levent_ctl_recv, NULL, levent_ctl_event,
+	    levent_ctl_recv, levent_ctl_flush, levent_ctl_event,
 	    client);
+	bufferevent_setwatermark(client->bev, EV_WRITE,
+	    LEVENT_CTL_HIGH_WATER / 2, 0);
 	bufferevent_enable(client->bev, EV_READ | EV_WRITE);
 	log_debug("event", "new client accepted");
 	/* coverity[leaked_handle]
@@ -463,6 +779,8 @@ levent_dump(evutil_socket_t fd, short what, void *arg)
 	(void)fd; (void)what;
 	log_debug("event", "dumping all events");
 	event_base_dump_events(base, stderr);
+	lldpd_slab_dump();
+	log_ring_dump();
 }
 static void
 levent_stop(evutil_socket_t fd, short what, void *arg)
@@ -472,6 +790,17 @@ levent_stop(evutil_socket_t fd, short what, void *arg)
 	event_base_loopbreak(base);
 }
 
+static struct event *lsb_release_event = NULL;
+static void
+levent_lsb_release(evutil_socket_t fd, short what, void *arg)
+{
+	struct lldpd *cfg = arg;
+	if (lldpd_read_lsb_release(cfg)) {
+		event_free(lsb_release_event);
+		lsb_release_event = NULL;
+	}
+}
+
 static void
 levent_update_and_send(evutil_socket_t fd, short what, void *arg)
 {
@@ -525,6 +854,11 @@ levent_init(struct lldpd *cfg)
 		    cfg);
 		if (!cfg->g_snmp_timeout)
 			fatalx("event", "unable to setup timeout function for SNMP");
+		cfg->g_snmp_notification = evtimer_new(cfg->g_base,
+		    levent_snmp_notify,
+		    cfg);
+		if (!cfg->g_snmp_notification)
+			fatalx("event", "unable to setup notification function for SNMP");
 		if ((cfg->g_snmp_fds =
 			malloc(sizeof(struct ev_l))) == NULL)
 			fatalx("event", "unable to allocate memory for SNMP events");
@@ -532,6 +866,17 @@ levent_init(struct lldpd *cfg)
 	}
 #endif
 
+	/* Read output of lsb_release when available */
+	if (cfg->g_lsb_release_fd != -1) {
+		log_debug("event", "register lsb_release output");
+		levent_make_socket_nonblocking(cfg->g_lsb_release_fd);
+		if ((lsb_release_event = event_new(cfg->g_base,
+			    cfg->g_lsb_release_fd, EV_READ|EV_PERSIST,
+			    levent_lsb_release, cfg)) == NULL ||
+		    event_add(lsb_release_event, NULL) == -1)
+			log_warnx("event", "unable to watch lsb_release output");
+	}
+
 	/* Setup loop that will run every X seconds. */
 	log_debug("event", "register loop timer");
 	if (!(cfg->g_main_loop = event_new(cfg->g_base, -1, 0,
@@ -593,6 +938,10 @@ levent_loop(struct lldpd *cfg)
 		event_free(cfg->g_iface_timer_event);
 
 #ifdef USE_SNMP
+	if (cfg->g_snmp_notification) {
+		event_free(cfg->g_snmp_notification);
+		cfg->g_snmp_notification = NULL;
+	}
 	if (cfg->g_snmp)
 		agent_shutdown();
 #endif /* USE_SNMP */
@@ -604,10 +953,28 @@ levent_loop(struct lldpd *cfg)
 void
 levent_shutdown(struct lldpd *cfg)
 {
+	struct lldpd_events *ev, *ev_next;
 	if (cfg->g_iface_event)
 		event_free(cfg->g_iface_event);
+	if (cfg->g_iface_fds) {
+		for (ev = TAILQ_FIRST(levent_iface_fds(cfg));
+		     ev;
+		     ev = ev_next) {
+			ev_next = TAILQ_NEXT(ev, next);
+			event_free(ev->ev);
+			free(ev);
+		}
+		free(levent_iface_fds(cfg));
+		cfg->g_iface_fds = NULL;
+	}
 	if (cfg->g_cleanup_timer)
 		event_free(cfg->g_cleanup_timer);
+	if (cfg->g_hostname_timer)
+		event_free(cfg->g_hostname_timer);
+	if (cfg->g_snapshot_timer)
+		event_free(cfg->g_snapshot_timer);
+	if (cfg->g_state_timer)
+		event_free(cfg->g_state_timer);
 	event_base_free(cfg->g_base);
 }
 
@@ -727,7 +1094,7 @@ levent_iface_recv(evutil_socket_t fd, short what, void *arg)
 			}
 		}
 	} else {
-		cfg->g_iface_cb(cfg);
+		cfg->g_iface_cb(cfg, fd);
 	}
 
 	/* Schedule local port update. We don't run it right away because we may
@@ -751,12 +1118,45 @@ levent_iface_recv(evutil_socket_t fd, short what, void *arg)
 	}
 }
 
+/*
+ * Subscribe to interface changes on the provided socket. The first socket is
+ * the main one. Additional sockets (for example, one for each additional
+ * network namespace) are kept in a list.
+ */
 int
 levent_iface_subscribe(struct lldpd *cfg, int socket)
 {
+	struct lldpd_events *ev;
 	log_debug("event", "subscribe to interface changes from socket %d",
 	    socket);
 	levent_make_socket_nonblocking(socket);
+	if (cfg->g_iface_event != NULL) {
+		if (cfg->g_iface_fds == NULL) {
+			if ((cfg->g_iface_fds =
+				malloc(sizeof(struct ev_l))) == NULL) {
+				log_warnx("event",
+				    "unable to allocate memory for interface changes events");
+				return -1;
+			}
+			TAILQ_INIT(levent_iface_fds(cfg));
+		}
+		if ((ev = calloc(1, sizeof(struct lldpd_events))) == NULL) {
+			log_warnx("event",
+			    "unable to allocate memory for interface changes event");
+			return -1;
+		}
+		if ((ev->ev = event_new(cfg->g_base, socket,
+			    EV_READ | EV_PERSIST, levent_iface_recv, cfg)) == NULL ||
+		    event_add(ev->ev, NULL) == -1) {
+			log_warnx("event",
+			    "unable to schedule new interface changes event");
+			if (ev->ev) event_free(ev->ev);
+			free(ev);
+			return -1;
+		}
+		TAILQ_INSERT_TAIL(levent_iface_fds(cfg), ev, next);
+		return 0;
+	}
 	cfg->g_iface_event = event_new(cfg->g_base, socket,
 	    EV_READ | EV_PERSIST, levent_iface_recv, cfg);
 	if (cfg->g_iface_event == NULL) {
@@ -774,6 +1174,132 @@ levent_iface_subscribe(struct lldpd *cfg, int socket)
 	return 0;
 }
 
+/*
+ * Stop listening to interface changes on an additional socket.
+ */
+void
+levent_iface_unsubscribe(struct lldpd *cfg, int socket)
+{
+	struct lldpd_events *ev;
+	if (cfg->g_iface_fds == NULL) return;
+	TAILQ_FOREACH(ev, levent_iface_fds(cfg), next) {
+		if (event_get_fd(ev->ev) != socket) continue;
+		log_debug("event", "unsubscribe from interface changes from socket %d",
+		    socket);
+		TAILQ_REMOVE(levent_iface_fds(cfg), ev, next);
+		event_free(ev->ev);
+		free(ev);
+		return;
+	}
+}
+
+static void
+levent_trigger_metadata(evutil_socket_t fd, short what, void *arg)
+{
+	struct lldpd *cfg = arg;
+	lldpd_update_metadata(cfg);
+}
+
+/* Collect slow chassis metadata in `delay` seconds. */
+void
+levent_schedule_metadata(struct lldpd *cfg, int delay)
+{
+	struct timeval tv = { delay, 0 };
+	if (event_base_once(cfg->g_base, -1, EV_TIMEOUT,
+		levent_trigger_metadata, cfg, &tv) == -1) {
+		log_warnx("event", "unable to schedule metadata collection");
+		lldpd_update_metadata(cfg);
+	}
+}
+
+static void
+levent_trigger_hostname(evutil_socket_t fd, short what, void *arg)
+{
+	struct lldpd *cfg = arg;
+	lldpd_hostname_check(cfg, 0);
+}
+
+/* Check again the system name in a short while. It is being resolved. */
+void
+levent_schedule_hostname(struct lldpd *cfg)
+{
+	struct timeval tv = { 1, 0 };
+	if (cfg->g_hostname_timer == NULL &&
+	    (cfg->g_hostname_timer = evtimer_new(cfg->g_base,
+		levent_trigger_hostname, cfg)) == NULL) {
+		log_warnx("event",
+		    "unable to allocate a new event for system name resolution");
+		return;
+	}
+	if (evtimer_pending(cfg->g_hostname_timer, NULL)) return;
+	if (event_add(cfg->g_hostname_timer, &tv) == -1)
+		log_warnx("event",
+		    "unable to schedule system name resolution check");
+}
+
+static void
+levent_trigger_snapshot(evutil_socket_t fd, short what, void *arg)
+{
+	struct lldpd *cfg = arg;
+	snapshot_update(cfg);
+}
+
+/* Publish a new snapshot. Changes happening in the next second are published
+ * together. */
+void
+levent_schedule_snapshot(struct lldpd *cfg)
+{
+	struct timeval tv = { 1, 0 };
+	if (cfg->g_snapshot == NULL) return;
+	if (cfg->g_snapshot_timer == NULL &&
+	    (cfg->g_snapshot_timer = evtimer_new(cfg->g_base,
+		levent_trigger_snapshot, cfg)) == NULL) {
+		log_warnx("event",
+		    "unable to allocate a new event for snapshots");
+		return;
+	}
+	if (evtimer_pending(cfg->g_snapshot_timer, NULL)) return;
+	if (event_add(cfg->g_snapshot_timer, &tv) == -1)
+		log_warnx("event", "unable to schedule snapshot");
+}
+
+static void
+levent_trigger_state(evutil_socket_t fd, short what, void *arg)
+{
+	struct lldpd *cfg = arg;
+	struct timeval tv = { LLDPD_STATE_INTERVAL, 0 };
+	if (cfg->g_state_generation != cfg->g_generation) {
+		state_save(cfg);
+		cfg->g_state_generation = cfg->g_generation;
+	}
+	if (event_add(cfg->g_state_timer, &tv) == -1)
+		log_warnx("event", "unable to schedule state save");
+}
+
+/* Periodically save neighbors to the state file, if they changed since the
+ * last save. A neighbor only refreshed by its peer does not bump
+ * `g_generation` and does not trigger a save. */
+void
+levent_schedule_state(struct lldpd *cfg, int enable)
+{
+	struct timeval tv = { LLDPD_STATE_INTERVAL, 0 };
+	if (!enable) {
+		if (cfg->g_state_timer)
+			event_del(cfg->g_state_timer);
+		return;
+	}
+	if (cfg->g_state_timer == NULL &&
+	    (cfg->g_state_timer = evtimer_new(cfg->g_base,
+		levent_trigger_state, cfg)) == NULL) {
+		log_warnx("event",
+		    "unable to allocate a new event for state save");
+		return;
+	}
+	cfg->g_state_generation = cfg->g_generation;
+	if (event_add(cfg->g_state_timer, &tv) == -1)
+		log_warnx("event", "unable to schedule state save");
+}
+
 static void
 levent_trigger_cleanup(evutil_socket_t fd, short what, void *arg)
 {
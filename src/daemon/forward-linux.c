@@ -22,15 +22,8 @@
 int
 interfaces_routing_enabled(struct lldpd *cfg) {
 	(void)cfg;
-	int f;
 	char status;
-	int rc;
-	if ((f = priv_open("/proc/sys/net/ipv4/ip_forward")) >= 0) {
-		if (read(f, &status, 1) == 1) {
-			rc = (status == '1');
-		} else rc = -1;
-		close(f);
-		return rc;
-	}
+	if (priv_read("/proc/sys/net/ipv4/ip_forward", &status, 1) == 1)
+		return (status == '1');
 	return -1;
 }
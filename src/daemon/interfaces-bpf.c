@@ -34,7 +34,7 @@ ifbpf_phys_init(struct lldpd *cfg,
 
 	log_debug("interfaces", "initialize ethernet device %s",
 	    hardware->h_ifname);
-	if ((fd = priv_iface_init(hardware->h_ifindex, hardware->h_ifname)) == -1)
+	if ((fd = priv_iface_init(hardware->h_ifindex, hardware->h_ifname, NULL)) == -1)
 		return -1;
 
 	/* Allocate receive buffer */
@@ -49,7 +49,7 @@ ifbpf_phys_init(struct lldpd *cfg,
 	buffer->len = ETHER_MAX_LEN + BPF_WORDALIGN(sizeof(struct bpf_hdr));
 
 	/* Setup multicast */
-	interfaces_setup_multicast(cfg, hardware->h_ifname, 0);
+	interfaces_setup_multicast(cfg, hardware->h_ifname, NULL, 0);
 
 	hardware->h_sendfd = fd; /* Send */
 
@@ -112,7 +112,7 @@ ifbpf_eth_close(struct lldpd *cfg, struct lldpd_hardware *hardware)
 {
 	log_debug("interfaces", "close ethernet device %s",
 	    hardware->h_ifname);
-	interfaces_setup_multicast(cfg, hardware->h_ifname, 1);
+	interfaces_setup_multicast(cfg, hardware->h_ifname, NULL, 1);
 	return 0;
 }
 
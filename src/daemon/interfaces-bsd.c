@@ -638,6 +638,7 @@ interfaces_update(struct lldpd *cfg)
 	struct interfaces_device_list *interfaces;
 	struct interfaces_address_list *addresses;
 	struct ifaddrs *ifaddrs = NULL, *ifaddr;
+	struct timespec start;
 
 	interfaces = malloc(sizeof(struct interfaces_device_list));
 	addresses = malloc(sizeof(struct interfaces_address_list));
@@ -647,6 +648,7 @@ interfaces_update(struct lldpd *cfg)
 	}
 	TAILQ_INIT(interfaces);
 	TAILQ_INIT(addresses);
+	latency_start(&start);
 	if (getifaddrs(&ifaddrs) < 0) {
 		log_warnx("interfaces", "unable to get list of interfaces");
 		goto end;
@@ -657,14 +659,18 @@ interfaces_update(struct lldpd *cfg)
 	     ifaddr = ifaddr->ifa_next) {
 		ifbsd_extract(cfg, interfaces, addresses, ifaddr);
 	}
+	latency_record(cfg, LATENCY_INTERFACES_FETCH, &start);
 	/* Link interfaces together if needed */
+	latency_start(&start);
 	TAILQ_FOREACH(iface, interfaces, next) {
 		ifbsd_check_bridge(cfg, interfaces, iface);
 		ifbsd_check_bond(cfg, interfaces, iface);
 		ifbsd_check_vlan(cfg, interfaces, iface);
 		ifbsd_check_physical(cfg, interfaces, iface);
 	}
+	latency_record(cfg, LATENCY_INTERFACES_CLASSIFY, &start);
 
+	latency_start(&start);
 	ifbsd_blacklist(cfg, interfaces);
 	interfaces_helper_whitelist(cfg, interfaces);
 	interfaces_helper_physical(cfg, interfaces,
@@ -674,13 +680,16 @@ interfaces_update(struct lldpd *cfg)
 #endif
 	interfaces_helper_mgmt(cfg, addresses);
 	interfaces_helper_chassis(cfg, interfaces);
+	latency_record(cfg, LATENCY_INTERFACES_APPLY, &start);
 
 	/* Mac/PHY */
+	latency_start(&start);
 	TAILQ_FOREACH(hardware, &cfg->g_hardware, h_entries) {
 		if (!hardware->h_flags) continue;
 		ifbsd_macphy(cfg, hardware);
 		interfaces_helper_promisc(cfg, hardware);
 	}
+	latency_record(cfg, LATENCY_INTERFACES_MACPHY, &start);
 
 	if (cfg->g_iface_event == NULL) {
 		int s;
@@ -48,11 +48,12 @@ iflinux_eth_init(struct lldpd *cfg, struct lldpd_hardware *hardware)
 
 	log_debug("interfaces", "initialize ethernet device %s",
 	    hardware->h_ifname);
-	if ((fd = priv_iface_init(hardware->h_ifindex, hardware->h_ifname)) == -1)
+	if ((fd = priv_iface_init(hardware->h_ifindex, hardware->h_ifname,
+		    hardware->h_netns)) == -1)
 		return -1;
 	hardware->h_sendfd = fd; /* Send */
 
-	interfaces_setup_multicast(cfg, hardware->h_ifname, 0);
+	interfaces_setup_multicast(cfg, hardware->h_ifname, hardware->h_netns, 0);
 
 	levent_hardware_add_fd(hardware, fd); /* Receive */
 	log_debug("interfaces", "interface %s initialized (fd=%d)", hardware->h_ifname,
@@ -125,7 +126,7 @@ iflinux_eth_close(struct lldpd *cfg, struct lldpd_hardware *hardware)
 {
 	log_debug("interfaces", "close ethernet device %s",
 	    hardware->h_ifname);
-	interfaces_setup_multicast(cfg, hardware->h_ifname, 1);
+	interfaces_setup_multicast(cfg, hardware->h_ifname, hardware->h_netns, 1);
 	return 0;
 }
 
@@ -143,15 +144,17 @@ iflinux_is_bridge(struct lldpd *cfg,
 #ifdef ENABLE_OLDIES
 	struct interfaces_device *port;
 	char path[SYSFS_PATH_MAX];
-	int f;
+	char c;
 
+	/* sysfs only shows the network namespace of lldpd */
+	if (LLDPD_IFINDEX_NETNS(iface->index) != 0)
+		return 0;
 	if ((snprintf(path, SYSFS_PATH_MAX,
 		    SYSFS_CLASS_NET "%s/" SYSFS_BRIDGE_FDB,
 		    iface->name)) >= SYSFS_PATH_MAX)
 		log_warnx("interfaces", "path truncated");
-	if ((f = priv_open(path)) < 0)
+	if (priv_read(path, &c, 1) == -1)
 		return 0;
-	close(f);
 
 	/* Also grab all ports */
 	TAILQ_FOREACH(port, interfaces, next) {
@@ -160,13 +163,12 @@ iflinux_is_bridge(struct lldpd *cfg,
 			SYSFS_CLASS_NET "%s/" SYSFS_BRIDGE_PORT_SUBDIR "/%s/port_no",
 			iface->name, port->name) >= SYSFS_PATH_MAX)
 			log_warnx("interfaces", "path truncated");
-		if ((f = priv_open(path)) < 0)
+		if (priv_read(path, &c, 1) == -1)
 			continue;
 		log_debug("interfaces",
 		    "port %s is bridged to %s",
 		    port->name, iface->name);
 		port->upper = iface;
-		close(f);
 	}
 
 	return 1;
@@ -182,9 +184,10 @@ iflinux_is_vlan(struct lldpd *cfg,
 {
 #ifdef ENABLE_OLDIES
 	struct vlan_ioctl_args ifv = {};
+	int s = netlink_ioctl_socket(cfg, iface->index);
 	ifv.cmd = GET_VLAN_REALDEV_NAME_CMD;
 	strlcpy(ifv.device1, iface->name, sizeof(ifv.device1));
-	if (ioctl(cfg->g_sock, SIOCGIFVLAN, &ifv) >= 0) {
+	if (ioctl(s, SIOCGIFVLAN, &ifv) >= 0) {
 		/* This is a VLAN, get the lower interface and the VID */
 		struct interfaces_device *lower =
 		    interfaces_nametointerface(interfaces, ifv.u.device2);
@@ -198,7 +201,7 @@ iflinux_is_vlan(struct lldpd *cfg,
 		memset(&ifv, 0, sizeof(ifv));
 		ifv.cmd = GET_VLAN_VID_CMD;
 		strlcpy(ifv.device1, iface->name, sizeof(ifv.device1));
-		if (ioctl(cfg->g_sock, SIOCGIFVLAN, &ifv) < 0) {
+		if (ioctl(s, SIOCGIFVLAN, &ifv) < 0) {
 			log_debug("interfaces",
 			    "unable to find VID for VLAN %s",
 			    iface->name);
@@ -227,9 +230,10 @@ iflinux_is_bond(struct lldpd *cfg,
 
 	struct ifreq ifr = {};
 	struct ifbond ifb = {};
+	int s = netlink_ioctl_socket(cfg, master->index);
 	strlcpy(ifr.ifr_name, master->name, sizeof(ifr.ifr_name));
 	ifr.ifr_data = (char *)&ifb;
-	if (ioctl(cfg->g_sock, SIOCBONDINFOQUERY, &ifr) >= 0) {
+	if (ioctl(s, SIOCBONDINFOQUERY, &ifr) >= 0) {
 		while (ifb.num_slaves--) {
 			struct ifslave ifs;
 			memset(&ifr, 0, sizeof(ifr));
@@ -237,7 +241,7 @@ iflinux_is_bond(struct lldpd *cfg,
 			strlcpy(ifr.ifr_name, master->name, sizeof(ifr.ifr_name));
 			ifr.ifr_data = (char *)&ifs;
 			ifs.slave_id = ifb.num_slaves;
-			if (ioctl(cfg->g_sock, SIOCBONDSLAVEINFOQUERY, &ifr) >= 0) {
+			if (ioctl(s, SIOCBONDSLAVEINFOQUERY, &ifr) >= 0) {
 				struct interfaces_device *slave =
 				    interfaces_nametointerface(interfaces,
 					ifs.slave_name);
@@ -274,7 +278,8 @@ iflinux_get_permanent_mac_ethtool(struct lldpd *cfg,
 	epaddr->cmd = ETHTOOL_GPERMADDR;
 	epaddr->size = ETHER_ADDR_LEN;
 	ifr.ifr_data = (caddr_t)epaddr;
-	if (ioctl(cfg->g_sock, SIOCETHTOOL, &ifr) == -1) {
+	if (ioctl(netlink_ioctl_socket(cfg, iface->index),
+		SIOCETHTOOL, &ifr) == -1) {
 		static int once = 0;
 		if (errno == EPERM && !once) {
 			log_warnx("interfaces",
@@ -304,6 +309,38 @@ iflinux_get_permanent_mac_ethtool(struct lldpd *cfg,
 	return ret;
 }
 
+/**
+ * Read a whole file with priv_read(). The buffer is grown until the content
+ * fits and is NUL-terminated.
+ *
+ * @return The content, to be freed by the caller, or NULL.
+ */
+static char *
+iflinux_read_file(char *path)
+{
+	char *buffer = NULL, *nbuffer;
+	size_t len = 8192;
+	ssize_t n;
+
+	for (;;) {
+		if ((nbuffer = realloc(buffer, len)) == NULL) {
+			log_warn("interfaces", "unable to allocate memory for %s",
+			    path);
+			free(buffer);
+			return NULL;
+		}
+		buffer = nbuffer;
+		if ((n = priv_read(path, buffer, len - 1)) == -1) {
+			free(buffer);
+			return NULL;
+		}
+		if ((size_t)n < len - 1) break;
+		len *= 2;
+	}
+	buffer[n] = '\0';
+	return buffer;
+}
+
 /**
  * Get permanent MAC address for a bond device.
  */
@@ -313,13 +350,13 @@ iflinux_get_permanent_mac_bond(struct lldpd *cfg,
     struct interfaces_device *iface)
 {
 	struct interfaces_device *master = iface->upper;
-	int f, state = 0;
-	FILE *netbond;
+	int state = 0;
 	const char *slaveif = "Slave Interface: ";
 	const char *hwaddr = "Permanent HW addr: ";
 	u_int8_t mac[ETHER_ADDR_LEN];
 	char path[SYSFS_PATH_MAX];
-	char line[100];
+	char *netbond;
+	char *line, *saveptr;
 
 	/* We have a bond, we need to query it to get real MAC addresses */
 	if (snprintf(path, SYSFS_PATH_MAX, "/proc/net/bonding/%s",
@@ -327,25 +364,20 @@ iflinux_get_permanent_mac_bond(struct lldpd *cfg,
 		log_warnx("interfaces", "path truncated");
 		return;
 	}
-	if ((f = priv_open(path)) < 0) {
+	if ((netbond = iflinux_read_file(path)) == NULL) {
 		if (snprintf(path, SYSFS_PATH_MAX, "/proc/self/net/bonding/%s",
 			master->name) >= SYSFS_PATH_MAX) {
 			log_warnx("interfaces", "path truncated");
 			return;
 		}
-		f = priv_open(path);
+		netbond = iflinux_read_file(path);
 	}
-	if (f < 0) {
+	if (netbond == NULL) {
 		log_warnx("interfaces",
 		    "unable to get permanent MAC address for %s",
 		    iface->name);
 		return;
 	}
-	if ((netbond = fdopen(f, "r")) == NULL) {
-		log_warn("interfaces", "unable to read stream from %s", path);
-		close(f);
-		return;
-	}
 	/* State 0:
 	   We parse the file to search "Slave Interface: ". If found, go to
 	   state 1.
@@ -353,12 +385,12 @@ iflinux_get_permanent_mac_bond(struct lldpd *cfg,
 	   We parse the file to search "Permanent HW addr: ". If found, we get
 	   the mac.
 	*/
-	while (fgets(line, sizeof(line), netbond)) {
+	for (line = strtok_r(netbond, "\n", &saveptr);
+	     line != NULL;
+	     line = strtok_r(NULL, "\n", &saveptr)) {
 		switch (state) {
 		case 0:
 			if (strncmp(line, slaveif, strlen(slaveif)) == 0) {
-				if (line[strlen(line)-1] == '\n')
-					line[strlen(line)-1] = '\0';
 				if (strcmp(iface->name,
 					line + strlen(slaveif)) == 0)
 					state++;
@@ -366,8 +398,6 @@ iflinux_get_permanent_mac_bond(struct lldpd *cfg,
 			break;
 		case 1:
 			if (strncmp(line, hwaddr, strlen(hwaddr)) == 0) {
-				if (line[strlen(line)-1] == '\n')
-					line[strlen(line)-1] = '\0';
 				if (sscanf(line + strlen(hwaddr),
 					"%02hhx:%02hhx:%02hhx:%02hhx:%02hhx:%02hhx",
 					&mac[0], &mac[1], &mac[2],
@@ -375,20 +405,19 @@ iflinux_get_permanent_mac_bond(struct lldpd *cfg,
 				    ETHER_ADDR_LEN) {
 					log_warn("interfaces", "unable to parse %s",
 					    line + strlen(hwaddr));
-					fclose(netbond);
-					return;
+					goto end;
 				}
 				memcpy(iface->address, mac,
 				    ETHER_ADDR_LEN);
-				fclose(netbond);
-				return;
+				goto end;
 			}
 			break;
 		}
 	}
 	log_warnx("interfaces", "unable to find real MAC address for enslaved %s",
 	    iface->name);
-	fclose(netbond);
+ end:
+	free(netbond);
 }
 
 /**
@@ -404,8 +433,10 @@ iflinux_get_permanent_mac(struct lldpd *cfg,
 	if (master == NULL || master->type != IFACE_BOND_T)
 		return;
 	if (iflinux_get_permanent_mac_ethtool(cfg, interfaces, iface) == -1 &&
-	    (master->driver == NULL || !strcmp(master->driver, "bonding")))
-		/* Fallback to old method for a bond */
+	    (master->driver == NULL || !strcmp(master->driver, "bonding")) &&
+	    LLDPD_IFINDEX_NETNS(iface->index) == 0)
+		/* Fallback to old method for a bond (only for the namespace of
+		 * lldpd as this is read from /proc) */
 		iflinux_get_permanent_mac_bond(cfg, interfaces, iface);
 }
 
@@ -451,7 +482,7 @@ iflinux_ethtool_link_mode_is_empty(const uint32_t *mask)
 }
 
 static int
-iflinux_ethtool_glink(struct lldpd *cfg, const char *ifname, struct ethtool_link_usettings *uset) {
+iflinux_ethtool_glink(struct lldpd *cfg, int s, const char *ifname, struct ethtool_link_usettings *uset) {
 	int rc;
 
 	/* Try with ETHTOOL_GLINKSETTINGS first */
@@ -468,7 +499,7 @@ iflinux_ethtool_glink(struct lldpd *cfg, const char *ifname, struct ethtool_link
 		memset(&ecmd, 0, sizeof(ecmd));
 		ecmd.req.cmd = ETHTOOL_GLINKSETTINGS;
 		ifr.ifr_data = (caddr_t)&ecmd;
-		rc = ioctl(cfg->g_sock, SIOCETHTOOL, &ifr);
+		rc = ioctl(s, SIOCETHTOOL, &ifr);
 		if (rc == 0) {
 			nwords = -ecmd.req.link_mode_masks_nwords;
 			log_debug("interfaces", "glinksettings nwords is %" PRId8, nwords);
@@ -489,7 +520,7 @@ iflinux_ethtool_glink(struct lldpd *cfg, const char *ifname, struct ethtool_link
 		ecmd.req.cmd = ETHTOOL_GLINKSETTINGS;
 		ecmd.req.link_mode_masks_nwords = nwords;
 		ifr.ifr_data = (caddr_t)&ecmd;
-		rc = ioctl(cfg->g_sock, SIOCETHTOOL, &ifr);
+		rc = ioctl(s, SIOCETHTOOL, &ifr);
 		if (rc == 0) {
 			log_debug("interfaces", "got ethtool results for %s with GLINKSETTINGS",
 			    ifname);
@@ -515,7 +546,7 @@ iflinux_ethtool_glink(struct lldpd *cfg, const char *ifname, struct ethtool_link
 	memset(&ethc, 0, sizeof(ethc));
 	ethc.cmd = ETHTOOL_GSET;
 	ifr.ifr_data = (caddr_t)&ethc;
-	rc = ioctl(cfg->g_sock, SIOCETHTOOL, &ifr);
+	rc = ioctl(s, SIOCETHTOOL, &ifr);
 	if (rc == 0) {
 		/* Do a partial copy (only what we need) */
 		log_debug("interfaces", "got ethtool results for %s with GSET",
@@ -565,7 +596,9 @@ iflinux_macphy(struct lldpd *cfg, struct lldpd_hardware *hardware)
 
 	log_debug("interfaces", "ask ethtool for the appropriate MAC/PHY for %s",
 	    hardware->h_ifname);
-	if (iflinux_ethtool_glink(cfg, hardware->h_ifname, &uset) == 0) {
+	if (iflinux_ethtool_glink(cfg,
+		netlink_ioctl_socket(cfg, hardware->h_ifindex),
+		hardware->h_ifname, &uset) == 0) {
 		port->p_macphy.autoneg_support = iflinux_ethtool_link_mode_test_bit(
 			ETHTOOL_LINK_MODE_Autoneg_BIT, uset.link_modes.supported);
 		port->p_macphy.autoneg_enabled = (uset.base.autoneg == AUTONEG_DISABLE) ? 0 : 1;
@@ -668,15 +701,16 @@ iface_bond_init(struct lldpd *cfg, struct lldpd_hardware *hardware)
 
 	/* First, we get a socket to the raw physical interface */
 	if ((fd = priv_iface_init(hardware->h_ifindex,
-			hardware->h_ifname)) == -1)
+			hardware->h_ifname, hardware->h_netns)) == -1)
 		return -1;
 	hardware->h_sendfd = fd;
-	interfaces_setup_multicast(cfg, hardware->h_ifname, 0);
+	interfaces_setup_multicast(cfg, hardware->h_ifname, hardware->h_netns, 0);
 
 	/* Then, we open a raw interface for the master */
 	log_debug("interfaces", "enslaved device %s has master %s(%d)",
 	    hardware->h_ifname, master->name, master->index);
-	if ((fd = priv_iface_init(master->index, master->name)) == -1) {
+	if ((fd = priv_iface_init(master->index, master->name,
+		    hardware->h_netns)) == -1) {
 		close(hardware->h_sendfd);
 		return -1;
 	}
@@ -690,7 +724,7 @@ iface_bond_init(struct lldpd *cfg, struct lldpd_hardware *hardware)
 		    "You will get inaccurate results",
 		    hardware->h_ifname);
 	}
-	interfaces_setup_multicast(cfg, master->name, 0);
+	interfaces_setup_multicast(cfg, master->name, hardware->h_netns, 0);
 
 	levent_hardware_add_fd(hardware, hardware->h_sendfd);
 	levent_hardware_add_fd(hardware, fd);
@@ -717,10 +751,10 @@ iface_bond_recv(struct lldpd *cfg, struct lldpd_hardware *hardware,
 		/* We received this on the physical interface. */
 		return n;
 	/* We received this on the bonding interface. Is it really for us? */
-	if (from.sll_ifindex == hardware->h_ifindex)
+	if (from.sll_ifindex == LLDPD_IFINDEX_LOCAL(hardware->h_ifindex))
 		/* This is for us */
 		return n;
-	if (from.sll_ifindex == master->index)
+	if (from.sll_ifindex == LLDPD_IFINDEX_LOCAL(master->index))
 		/* We don't know from which physical interface it comes (kernel
 		 * < 2.6.24). In doubt, this is for us. */
 		return n;
@@ -733,8 +767,8 @@ iface_bond_close(struct lldpd *cfg, struct lldpd_hardware *hardware)
 	struct bond_master *master = hardware->h_data;
 	log_debug("interfaces", "closing enslaved device %s",
 	    hardware->h_ifname);
-	interfaces_setup_multicast(cfg, hardware->h_ifname, 1);
-	interfaces_setup_multicast(cfg, master->name, 1);
+	interfaces_setup_multicast(cfg, hardware->h_ifname, hardware->h_netns, 1);
+	interfaces_setup_multicast(cfg, master->name, hardware->h_netns, 1);
 	free(hardware->h_data); hardware->h_data = NULL;
 	return 0;
 }
@@ -820,7 +854,7 @@ iflinux_handle_bond(struct lldpd *cfg, struct interfaces_device_list *interfaces
 
 		/* Fill additional info */
 #ifdef ENABLE_DOT3
-		hardware->h_lport.p_aggregid = master->index;
+		hardware->h_lport.p_aggregid = LLDPD_IFINDEX_LOCAL(master->index);
 #endif
 		hardware->h_mtu = iface->mtu ? iface->mtu : 1500;
 	}
@@ -843,7 +877,8 @@ iflinux_add_driver(struct lldpd *cfg,
 		if (iface->driver) continue;
 
 		strlcpy(ifr.ifr_name, iface->name, IFNAMSIZ);
-		if (ioctl(cfg->g_sock, SIOCETHTOOL, &ifr) == 0) {
+		if (ioctl(netlink_ioctl_socket(cfg, iface->index),
+			SIOCETHTOOL, &ifr) == 0) {
 			iface->driver = strdup(ethc.driver);
 			log_debug("interfaces", "driver for %s is `%s`",
 			    iface->name, iface->driver);
@@ -860,7 +895,8 @@ iflinux_add_wireless(struct lldpd *cfg,
 	TAILQ_FOREACH(iface, interfaces, next) {
 		struct iwreq iwr = {};
 		strlcpy(iwr.ifr_name, iface->name, IFNAMSIZ);
-		if (ioctl(cfg->g_sock, SIOCGIWNAME, &iwr) >= 0) {
+		if (ioctl(netlink_ioctl_socket(cfg, iface->index),
+			SIOCGIWNAME, &iwr) >= 0) {
 			log_debug("interfaces", "%s is wireless",
 			    iface->name);
 			iface->type |= IFACE_WIRELESS_T | IFACE_PHYSICAL_T;
@@ -993,14 +1029,18 @@ interfaces_update(struct lldpd *cfg)
 	struct lldpd_hardware *hardware;
 	struct interfaces_device_list *interfaces;
 	struct interfaces_address_list *addresses;
+	struct timespec start;
+	latency_start(&start);
 	interfaces = netlink_get_interfaces(cfg);
 	addresses = netlink_get_addresses(cfg);
+	latency_record(cfg, LATENCY_INTERFACES_FETCH, &start);
 	if (interfaces == NULL || addresses == NULL) {
 		log_warnx("interfaces", "cannot update the list of local interfaces");
 		return;
 	}
 
 	/* Add missing bits to list of interfaces */
+	latency_start(&start);
 	iflinux_add_driver(cfg, interfaces);
 	if (LOCAL_CHASSIS(cfg)->c_cap_available & LLDP_CAP_WLAN)
 		iflinux_add_wireless(cfg, interfaces);
@@ -1009,7 +1049,9 @@ interfaces_update(struct lldpd *cfg)
 	iflinux_add_bond(cfg, interfaces);
 	iflinux_add_vlan(cfg, interfaces);
 	iflinux_add_physical(cfg, interfaces);
+	latency_record(cfg, LATENCY_INTERFACES_CLASSIFY, &start);
 
+	latency_start(&start);
 	interfaces_helper_whitelist(cfg, interfaces);
 #ifdef ENABLE_OLDIES
 	iflinux_handle_bond(cfg, interfaces);
@@ -1022,13 +1064,16 @@ interfaces_update(struct lldpd *cfg)
 #endif
 	interfaces_helper_mgmt(cfg, addresses);
 	interfaces_helper_chassis(cfg, interfaces);
+	latency_record(cfg, LATENCY_INTERFACES_APPLY, &start);
 
 	/* Mac/PHY */
+	latency_start(&start);
 	TAILQ_FOREACH(hardware, &cfg->g_hardware, h_entries) {
 		if (!hardware->h_flags) continue;
 		iflinux_macphy(cfg, hardware);
 		interfaces_helper_promisc(cfg, hardware);
 	}
+	latency_record(cfg, LATENCY_INTERFACES_MACPHY, &start);
 }
 
 void
@@ -38,35 +38,45 @@ lldpd_af(int af)
 /* Generic ethernet interface initialization */
 /**
  * Enable multicast on the given interface.
+ *
+ * @param netns Network namespace of the interface (NULL or empty for the
+ *              namespace of lldpd)
  */
 void
 interfaces_setup_multicast(struct lldpd *cfg, const char *name,
-    int remove)
+    const char *netns, int remove)
 {
-	int rc;
+	int rc[PRIV_MULTICAST_MAX];
+	u_int8_t macs[PRIV_MULTICAST_MAX][ETHER_ADDR_LEN];
+	const char *protocols[PRIV_MULTICAST_MAX];
+	int n = 0, k;
 	size_t i, j;
 	const u_int8_t *mac;
 	const u_int8_t zero[ETHER_ADDR_LEN] = {};
 
+	/* Collect all addresses to request them at once */
 	for (i = 0; cfg->g_protocols[i].mode != 0; i++) {
 		if (!cfg->g_protocols[i].enabled) continue;
 		for (mac = cfg->g_protocols[i].mac1, j = 0;
-		     j < 3;
+		     j < 3 && n < PRIV_MULTICAST_MAX;
 		     mac += ETHER_ADDR_LEN,
 		     j++) {
 			if (memcmp(mac, zero, ETHER_ADDR_LEN) == 0) break;
-			if ((rc = priv_iface_multicast(name,
-				    mac, !remove)) != 0) {
-				errno = rc;
-				if (errno != ENOENT)
-					log_debug("interfaces",
-					    "unable to %s %s address to multicast filter for %s (%s)",
-					    (remove)?"delete":"add",
-					    cfg->g_protocols[i].name,
-					    name, strerror(rc));
-			}
+			memcpy(macs[n], mac, ETHER_ADDR_LEN);
+			protocols[n++] = cfg->g_protocols[i].name;
 		}
 	}
+	if (n == 0) return;
+
+	priv_iface_multicast(name, netns, (u_int8_t *)macs, n, !remove, rc);
+	for (k = 0; k < n; k++) {
+		if (rc[k] == 0 || rc[k] == ENOENT) continue;
+		log_debug("interfaces",
+		    "unable to %s %s address to multicast filter for %s (%s)",
+		    (remove)?"delete":"add",
+		    protocols[k],
+		    name, strerror(rc[k]));
+	}
 }
 
 /**
@@ -186,7 +196,8 @@ interfaces_helper_whitelist(struct lldpd *cfg,
 		return;
 
 	TAILQ_FOREACH(iface, interfaces, next) {
-		int m = pattern_match(iface->name, cfg->g_config.c_iface_pattern, 0);
+		int m = pattern_match_fast(cfg->g_iface_pattern,
+		    cfg->g_config.c_iface_pattern, iface->name, 0);
 		switch (m) {
 		case 0:
 			log_debug("interfaces", "blacklist %s", iface->name);
@@ -202,6 +213,92 @@ interfaces_helper_whitelist(struct lldpd *cfg,
 }
 
 #ifdef ENABLE_DOT1
+/* Local VLANs of a port: a bitmap of VLAN IDs and the name of each VLAN. Names
+ * are stored in chunks of 64 VLANs, only allocated when one of the VLANs of
+ * the chunk is present. Each update collects VLANs in a new map. The list of
+ * VLANs of the local port is only rebuilt when this map differs from the
+ * previous one. */
+#define VLAN_MAP_MAX   4096
+#define VLAN_MAP_CHUNK 64
+struct lldpd_vlan_map {
+	u_int32_t	  bitmap[VLAN_MAP_MAX / 32];
+	char		**names[VLAN_MAP_MAX / VLAN_MAP_CHUNK];
+};
+#define VLAN_MAP_ISSET(map, vid) ((map)->bitmap[(vid) / 32] & (1U << ((vid) % 32)))
+
+static void
+vlan_map_free(struct lldpd_vlan_map *map)
+{
+	int i, j;
+	if (map == NULL) return;
+	for (i = 0; i < VLAN_MAP_MAX / VLAN_MAP_CHUNK; i++) {
+		if (map->names[i] == NULL) continue;
+		for (j = 0; j < VLAN_MAP_CHUNK; j++)
+			free(map->names[i][j]);
+		free(map->names[i]);
+	}
+	free(map);
+}
+
+/* Two maps are equal if they have the same VLANs with the same names. */
+static int
+vlan_map_equal(struct lldpd_vlan_map *map1, struct lldpd_vlan_map *map2)
+{
+	int vid;
+	if (map1 == NULL || map2 == NULL)
+		return (map1 == map2);
+	if (memcmp(map1->bitmap, map2->bitmap, sizeof(map1->bitmap)))
+		return 0;
+	for (vid = 0; vid < VLAN_MAP_MAX; vid++) {
+		if (!VLAN_MAP_ISSET(map1, vid)) continue;
+		if (strcmp(map1->names[vid / VLAN_MAP_CHUNK][vid % VLAN_MAP_CHUNK],
+			map2->names[vid / VLAN_MAP_CHUNK][vid % VLAN_MAP_CHUNK]))
+			return 0;
+	}
+	return 1;
+}
+
+/* Rebuild the list of VLANs of the local port from the provided map, in
+ * VLAN ID order. On allocation failure, the list is left empty and -1 is
+ * returned. */
+static int
+vlan_map_apply(struct lldpd *cfg, struct lldpd_hardware *hardware,
+    struct lldpd_vlan_map *map)
+{
+	struct lldpd_port *port = &hardware->h_lport;
+	struct lldpd_vlan *v;
+	int vid;
+
+	lldpd_vlan_cleanup(port);
+	cfg->g_local_generation++;
+	cfg->g_generation++;
+	if (map == NULL) return 0;
+	for (vid = 0; vid < VLAN_MAP_MAX; vid++) {
+		if (!VLAN_MAP_ISSET(map, vid)) continue;
+		if ((v = lldpd_slab_alloc(LLDPD_SLAB_VLAN)) == NULL)
+			goto fail;
+		if ((v->v_name = strdup(
+			    map->names[vid / VLAN_MAP_CHUNK][vid % VLAN_MAP_CHUNK])) == NULL) {
+			lldpd_slab_free(LLDPD_SLAB_VLAN, v);
+			goto fail;
+		}
+		v->v_vid = vid;
+		TAILQ_INSERT_TAIL(&port->p_vlans, v, v_entries);
+	}
+	return 0;
+fail:
+	lldpd_vlan_cleanup(port);
+	return -1;
+}
+
+void
+interfaces_vlan_cleanup(struct lldpd_hardware *hardware)
+{
+	vlan_map_free(hardware->h_lvlans);
+	vlan_map_free(hardware->h_lvlans_next);
+	hardware->h_lvlans = hardware->h_lvlans_next = NULL;
+}
+
 static void
 iface_append_vlan(struct lldpd *cfg,
     struct interfaces_device *vlan,
@@ -209,8 +306,9 @@ iface_append_vlan(struct lldpd *cfg,
 {
 	struct lldpd_hardware *hardware =
 	    lldpd_get_hardware(cfg, lower->name, lower->index);
-	struct lldpd_port *port;
-	struct lldpd_vlan *v;
+	struct lldpd_vlan_map *map;
+	char ***chunk;
+	int vid = vlan->vlanid;
 
 	if (hardware == NULL) {
 		log_debug("interfaces",
@@ -218,24 +316,29 @@ iface_append_vlan(struct lldpd *cfg,
 		    lower->name, vlan->name);
 		return;
 	}
+	if (vid < 0 || vid >= VLAN_MAP_MAX) {
+		log_debug("interfaces",
+		    "invalid VLAN ID %d for VLAN %s", vid, vlan->name);
+		return;
+	}
 
 	/* Check if the VLAN is already here. */
-	port = &hardware->h_lport;
-	TAILQ_FOREACH(v, &port->p_vlans, v_entries)
-	    if (strncmp(vlan->name, v->v_name, IFNAMSIZ) == 0)
-		    return;
-	if ((v = (struct lldpd_vlan *)
-		calloc(1, sizeof(struct lldpd_vlan))) == NULL)
+	if ((map = hardware->h_lvlans_next) == NULL &&
+	    (map = hardware->h_lvlans_next =
+		calloc(1, sizeof(struct lldpd_vlan_map))) == NULL)
 		return;
-	if ((v->v_name = strdup(vlan->name)) == NULL) {
-		free(v);
+	if (VLAN_MAP_ISSET(map, vid))
 		return;
-	}
-	v->v_vid = vlan->vlanid;
+	chunk = &map->names[vid / VLAN_MAP_CHUNK];
+	if (*chunk == NULL &&
+	    (*chunk = calloc(VLAN_MAP_CHUNK, sizeof(char *))) == NULL)
+		return;
+	if (((*chunk)[vid % VLAN_MAP_CHUNK] = strdup(vlan->name)) == NULL)
+		return;
+	map->bitmap[vid / 32] |= 1U << (vid % 32);
 	log_debug("interfaces", "append VLAN %s for %s",
-	    v->v_name,
+	    vlan->name,
 	    hardware->h_ifname);
-	TAILQ_INSERT_TAIL(&port->p_vlans, v, v_entries);
 }
 
 /**
@@ -301,6 +404,7 @@ interfaces_helper_vlan(struct lldpd *cfg,
     struct interfaces_device_list *interfaces)
 {
 	struct interfaces_device *iface;
+	struct lldpd_hardware *hardware;
 
 	TAILQ_FOREACH(iface, interfaces, next) {
 		if (iface->ignore)
@@ -315,6 +419,29 @@ interfaces_helper_vlan(struct lldpd *cfg,
 		iface_append_vlan_to_lower(cfg, interfaces,
 		    iface, iface, 0);
 	}
+
+	TAILQ_FOREACH(hardware, &cfg->g_hardware, h_entries) {
+		if (vlan_map_equal(hardware->h_lvlans, hardware->h_lvlans_next)) {
+			vlan_map_free(hardware->h_lvlans_next);
+			hardware->h_lvlans_next = NULL;
+			continue;
+		}
+		log_debug("interfaces", "VLANs of %s have changed",
+		    hardware->h_ifname);
+		hardware->h_lvlans_changed = 1;
+		vlan_map_free(hardware->h_lvlans);
+		hardware->h_lvlans = NULL;
+		if (vlan_map_apply(cfg, hardware, hardware->h_lvlans_next) == -1) {
+			/* The list is now empty, as if there were no map:
+			 * the next update will see a difference and retry. */
+			log_warnx("interfaces",
+			    "unable to rebuild VLAN list of %s",
+			    hardware->h_ifname);
+			vlan_map_free(hardware->h_lvlans_next);
+		} else
+			hardware->h_lvlans = hardware->h_lvlans_next;
+		hardware->h_lvlans_next = NULL;
+	}
 }
 #endif
 
@@ -347,7 +474,8 @@ interfaces_helper_chassis(struct lldpd *cfg,
 	TAILQ_FOREACH(iface, interfaces, next) {
 		if (!(iface->type & IFACE_PHYSICAL_T)) continue;
 		if (cfg->g_config.c_cid_pattern &&
-		    !pattern_match(iface->name, cfg->g_config.c_cid_pattern, 0)) continue;
+		    !pattern_match_fast(cfg->g_cid_pattern,
+			cfg->g_config.c_cid_pattern, iface->name, 0)) continue;
 
 		if ((hardware = lldpd_get_hardware(cfg,
 			    iface->name,
@@ -438,7 +566,9 @@ interfaces_helper_mgmt_for_af(struct lldpd *cfg,
 			continue;
 		}
 		if (cfg->g_config.c_mgmt_pattern == NULL ||
-		    pattern_match(addrstrbuf, cfg->g_config.c_mgmt_pattern, allnegative)) {
+		    pattern_match_fast(cfg->g_mgmt_pattern,
+			cfg->g_config.c_mgmt_pattern, addrstrbuf,
+			allnegative)) {
 			mgmt = lldpd_alloc_mgmt(af, &in_addr, in_addr_size,
 			    addr->index);
 			if (mgmt == NULL) {
@@ -469,7 +599,9 @@ interfaces_helper_mgmt(struct lldpd *cfg,
 	int af;
 	const char *pattern = cfg->g_config.c_mgmt_pattern;
 
+	/* Entries of the local chassis are freed: invalidate SNMP indexes. */
 	lldpd_chassis_mgmt_cleanup(LOCAL_CHASSIS(cfg));
+	cfg->g_local_generation++;
 	if (!cfg->g_config.c_mgmt_advertise)
 		return;
 
@@ -611,6 +743,7 @@ interfaces_helper_add_hardware(struct lldpd *cfg,
 {
 	TRACE(LLDPD_INTERFACES_NEW(hardware->h_ifname));
 	TAILQ_INSERT_TAIL(&cfg->g_hardware, hardware, h_entries);
+	cfg->g_generation++;
 }
 
 void
@@ -688,7 +821,8 @@ interfaces_helper_physical(struct lldpd *cfg,
 
 #ifdef ENABLE_DOT3
 		if (iface->upper && iface->upper->type & IFACE_BOND_T)
-			hardware->h_lport.p_aggregid = iface->upper->index;
+			hardware->h_lport.p_aggregid =
+			    LLDPD_IFINDEX_LOCAL(iface->upper->index);
 		else
 			hardware->h_lport.p_aggregid = 0;
 #endif
@@ -700,7 +834,7 @@ interfaces_helper_promisc(struct lldpd *cfg,
     struct lldpd_hardware *hardware)
 {
 	if (!cfg->g_config.c_promisc) return;
-	if (priv_iface_promisc(hardware->h_ifname) != 0) {
+	if (priv_iface_promisc(hardware->h_ifname, hardware->h_netns) != 0) {
 		log_warnx("interfaces",
 		    "unable to enable promiscuous mode for %s",
 		    hardware->h_ifname);
@@ -0,0 +1,105 @@
+/* -*- mode: c; c-file-style: "openbsd" -*- */
+/*
+ * Copyright (c) 2019 Vincent Bernat <vincent@bernat.im>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* Latency histograms for the main processing stages. Recording a sample is
+ * two reads of the monotonic clock and a few additions. */
+
+#include "lldpd.h"
+
+#include <string.h>
+#include <time.h>
+
+static const char *latency_names[LATENCY_LAST] = {
+	[LATENCY_RECV]			= "receive",
+	[LATENCY_DECODE]		= "decode",
+	[LATENCY_HIDE]			= "smart-filter",
+	[LATENCY_NOTIFY]		= "notify",
+	[LATENCY_SEND]			= "send",
+	[LATENCY_INTERFACES]		= "interfaces",
+	[LATENCY_INTERFACES_FETCH]	= "interfaces-fetch",
+	[LATENCY_INTERFACES_CLASSIFY]	= "interfaces-classify",
+	[LATENCY_INTERFACES_APPLY]	= "interfaces-apply",
+	[LATENCY_INTERFACES_MACPHY]	= "interfaces-macphy",
+};
+
+void
+latency_start(struct timespec *start)
+{
+	clock_gettime(CLOCK_MONOTONIC, start);
+}
+
+/* Return the time elapsed since `start`, in ns. Unlike latency_record(), this
+ * can be used from any thread. */
+u_int64_t
+latency_elapsed(const struct timespec *start)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	if (now.tv_sec < start->tv_sec ||
+	    (now.tv_sec == start->tv_sec && now.tv_nsec < start->tv_nsec))
+		return 0;
+	return (u_int64_t)(now.tv_sec - start->tv_sec) * 1000000000ULL +
+	    now.tv_nsec - start->tv_nsec;
+}
+
+/* Record the time elapsed since `start` for the given stage. */
+void
+latency_record(struct lldpd *cfg, enum latency_stage stage,
+    const struct timespec *start)
+{
+	latency_add(cfg, stage, latency_elapsed(start));
+}
+
+/* Record a sample, in ns, for the given stage. */
+void
+latency_add(struct lldpd *cfg, enum latency_stage stage, u_int64_t elapsed)
+{
+	struct lldpd_latency *l = &cfg->g_latency[stage];
+	u_int64_t v;
+	int bucket;
+
+	for (bucket = 0, v = elapsed >> 10;
+	     v != 0 && bucket < LLDPD_LATENCY_BUCKETS - 1;
+	     v >>= 1, bucket++);
+	l->l_buckets[bucket]++;
+	l->l_count++;
+	l->l_sum += elapsed;
+	if (elapsed > l->l_max) l->l_max = elapsed;
+}
+
+/* Serialize all histograms, in stage order. */
+ssize_t
+latency_serialize(struct lldpd *cfg, void **output)
+{
+	struct lldpd_latency_list list;
+	int i;
+
+	TAILQ_INIT(&list);
+	for (i = 0; i < LATENCY_LAST; i++) {
+		cfg->g_latency[i].l_name = (char *)latency_names[i];
+		TAILQ_INSERT_TAIL(&list, &cfg->g_latency[i], l_entries);
+	}
+	return lldpd_latency_list_serialize(&list, output);
+}
+
+void
+latency_reset(struct lldpd *cfg)
+{
+	log_debug("latency", "reset latency histograms");
+	memset(cfg->g_latency, 0, sizeof(cfg->g_latency));
+}
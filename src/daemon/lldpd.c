@@ -77,6 +77,13 @@ static struct protocol protos[] =
 	  {0,0,0,0,0,0} }
 };
 
+/* Table of supported protocols, terminated by an entry with a null mode. */
+struct protocol *
+lldpd_protocols(void)
+{
+	return protos;
+}
+
 static char		**saved_argv;
 #ifdef HAVE___PROGNAME
 extern const char	*__progname;
@@ -93,6 +100,7 @@ usage(void)
 	fprintf(stderr, "\n");
 
 	fprintf(stderr, "-d       Do not daemonize.\n");
+	fprintf(stderr, "-T count Keep the last debug messages in memory (dumped on SIGUSR1).\n");
 	fprintf(stderr, "-r       Receive-only mode\n");
 	fprintf(stderr, "-i       Disable LLDP-MED inventory TLV transmission.\n");
 	fprintf(stderr, "-k       Disable advertising of kernel release, version, machine.\n");
@@ -105,6 +113,9 @@ usage(void)
 	fprintf(stderr, "-C iface Limit interfaces to use for computing chassis ID.\n");
 	fprintf(stderr, "-L path  Override path for lldpcli command.\n");
 	fprintf(stderr, "-O file  Override default configuration locations processed by lldpcli(8) at start.\n");
+#ifdef HOST_OS_LINUX
+	fprintf(stderr, "-N netns Also handle interfaces from these network namespaces.\n");
+#endif
 #ifdef ENABLE_LLDPMED
 	fprintf(stderr, "-M class Enable emission of LLDP-MED frame. 'class' should be one of:\n");
 	fprintf(stderr, "             1 Generic Endpoint (Class I)\n");
@@ -140,13 +151,64 @@ usage(void)
 	exit(1);
 }
 
+/**
+ * Get the name of the network namespace with the provided index. Interfaces
+ * from additional namespaces have the namespace encoded in their index.
+ *
+ * @return NULL for the namespace of lldpd
+ */
+const char *
+lldpd_netns_name(struct lldpd *cfg, int index)
+{
+#ifdef HOST_OS_LINUX
+	int id = LLDPD_IFINDEX_NETNS(index);
+	if (id == 0 || cfg->g_netns == NULL) return NULL;
+	return cfg->g_netns[id - 1];
+#else
+	return NULL;
+#endif
+}
+
+/**
+ * Get the name of a local port as displayed to the user. When the port is
+ * in another network namespace, the name is prefixed by the namespace.
+ */
+const char *
+lldpd_hardware_name(struct lldpd_hardware *hardware)
+{
+	static char name[LLDPD_NETNS_NAMESIZ + IFNAMSIZ + 1];
+	if (hardware->h_netns[0] == '\0')
+		return hardware->h_ifname;
+	snprintf(name, sizeof(name), "%s/%s",
+	    hardware->h_netns, hardware->h_ifname);
+	return name;
+}
+
+/**
+ * Check if a local port matches the provided name, as displayed to the user.
+ */
+int
+lldpd_hardware_match(struct lldpd_hardware *hardware, const char *name)
+{
+	size_t len = strlen(hardware->h_netns);
+	if (len == 0)
+		return (strcmp(hardware->h_ifname, name) == 0);
+	return (strncmp(hardware->h_netns, name, len) == 0 &&
+	    name[len] == '/' &&
+	    strcmp(hardware->h_ifname, name + len + 1) == 0);
+}
+
 struct lldpd_hardware *
 lldpd_get_hardware(struct lldpd *cfg, char *name, int index)
 {
 	struct lldpd_hardware *hardware;
 	TAILQ_FOREACH(hardware, &cfg->g_hardware, h_entries) {
-		if (strcmp(hardware->h_ifname, name) == 0) {
+		if (strcmp(hardware->h_ifname, name) == 0 &&
+		    LLDPD_IFINDEX_NETNS(hardware->h_ifindex) ==
+		    LLDPD_IFINDEX_NETNS(index)) {
 			if (hardware->h_flags == 0) {
+				if (hardware->h_ifindex != index)
+					cfg->g_generation++;
 				hardware->h_ifindex = index;
 				break;
 			}
@@ -232,6 +294,9 @@ lldpd_alloc_hardware(struct lldpd *cfg, char *name, int index)
 
 	hardware->h_cfg = cfg;
 	strlcpy(hardware->h_ifname, name, sizeof(hardware->h_ifname));
+	if (lldpd_netns_name(cfg, index) != NULL)
+		strlcpy(hardware->h_netns, lldpd_netns_name(cfg, index),
+		    sizeof(hardware->h_netns));
 	hardware->h_ifindex = index;
 	hardware->h_lport.p_chassis = LOCAL_CHASSIS(cfg);
 	hardware->h_lport.p_chassis->c_refcount++;
@@ -264,7 +329,7 @@ lldpd_alloc_mgmt(int family, void *addrptr, size_t addrsize, u_int32_t iface)
 		errno = EOVERFLOW;
 		return NULL;
 	}
-	mgmt = calloc(1, sizeof(struct lldpd_mgmt));
+	mgmt = lldpd_slab_alloc(LLDPD_SLAB_MGMT);
 	if (mgmt == NULL) {
 		errno = ENOMEM;
 		return NULL;
@@ -281,9 +346,14 @@ lldpd_hardware_cleanup(struct lldpd *cfg, struct lldpd_hardware *hardware)
 {
 	log_debug("alloc", "cleanup hardware port %s", hardware->h_ifname);
 
+	decode_forget(cfg, hardware);
+	metrics_forget(cfg, hardware);
 	free(hardware->h_lport_previous);
 	free(hardware->h_lchassis_previous_id);
 	free(hardware->h_lport_previous_id);
+#ifdef ENABLE_DOT1
+	interfaces_vlan_cleanup(hardware);
+#endif
 	lldpd_port_cleanup(&hardware->h_lport, 1);
 	if (hardware->h_ops && hardware->h_ops->cleanup)
 		hardware->h_ops->cleanup(cfg, hardware);
@@ -301,6 +371,8 @@ lldpd_display_neighbors(struct lldpd *cfg)
 		char *description;
 		const char *neighbor = NULL;
 		unsigned neighbors = 0;
+		/* Descriptions can only be set in our network namespace */
+		if (hardware->h_netns[0] != '\0') continue;
 		TAILQ_FOREACH(port, &hardware->h_rports, p_entries) {
 			if (SMART_HIDDEN(port)) continue;
 			neighbors++;
@@ -353,14 +425,35 @@ static void
 notify_clients_deletion(struct lldpd_hardware *hardware,
     struct lldpd_port *rport)
 {
+	struct timespec start;
 	TRACE(LLDPD_NEIGHBOR_DELETE(hardware->h_ifname,
 		rport->p_chassis->c_name,
 		rport->p_descr));
-	levent_ctl_notify(hardware->h_ifname, NEIGHBOR_CHANGE_DELETED,
+	latency_start(&start);
+	levent_ctl_notify(lldpd_hardware_name(hardware), NEIGHBOR_CHANGE_DELETED,
 	    rport);
 #ifdef USE_SNMP
 	agent_notify(hardware, NEIGHBOR_CHANGE_DELETED, rport);
 #endif
+	latency_record(hardware->h_cfg, LATENCY_NOTIFY, &start);
+}
+
+/* Remove expired (or all) neighbors of an interface and update global
+ * statistics accordingly. Return 1 if a neighbor was removed. */
+static int
+lldpd_expire_neighbors(struct lldpd *cfg, struct lldpd_hardware *hardware,
+    int all)
+{
+	u_int64_t deleted = hardware->h_delete_cnt;
+	u_int64_t aged = hardware->h_ageout_cnt;
+	lldpd_remote_cleanup(hardware, notify_clients_deletion, all);
+	cfg->g_delete_cnt += hardware->h_delete_cnt - deleted;
+	cfg->g_ageout_cnt += hardware->h_ageout_cnt - aged;
+	if (hardware->h_delete_cnt == deleted)
+		return 0;
+	if (!all)
+		lldpd_hide_hardware(cfg, hardware);
+	return 1;
 }
 
 static void
@@ -378,12 +471,28 @@ lldpd_reset_timer(struct lldpd *cfg)
 		u_int8_t *output = NULL;
 		ssize_t output_len;
 		char save[LLDPD_PORT_START_MARKER];
+#ifdef ENABLE_DOT1
+		char save_vlans[sizeof(port->p_vlans)];
+#endif
 		memcpy(save, port, sizeof(save));
 		/* coverity[suspicious_sizeof]
 		   We intentionally partially memset port */
 		memset(port, 0, sizeof(save));
+#ifdef ENABLE_DOT1
+		/* VLANs are compared by interfaces_helper_vlan() */
+		memcpy(save_vlans, &port->p_vlans, sizeof(save_vlans));
+		TAILQ_INIT(&port->p_vlans);
+#endif
 		output_len = lldpd_port_serialize(port, (void**)&output);
 		memcpy(port, save, sizeof(save));
+#ifdef ENABLE_DOT1
+		memcpy(&port->p_vlans, save_vlans, sizeof(save_vlans));
+		if (hardware->h_lvlans_changed) {
+			hardware->h_lvlans_changed = 0;
+			free(hardware->h_lport_previous);
+			hardware->h_lport_previous = NULL;
+		}
+#endif
 		if (output_len == -1) {
 			log_warnx("localchassis",
 			    "unable to serialize local port %s to check for differences",
@@ -432,6 +541,7 @@ void
 lldpd_cleanup(struct lldpd *cfg)
 {
 	struct lldpd_hardware *hardware, *hardware_next;
+	int changed = 0;
 
 	log_debug("localchassis", "cleanup all ports");
 
@@ -440,7 +550,8 @@ lldpd_cleanup(struct lldpd *cfg)
 		hardware_next = TAILQ_NEXT(hardware, h_entries);
 		if (!hardware->h_flags) {
 			int m = cfg->g_config.c_perm_ifaces?
-			    pattern_match(hardware->h_ifname, cfg->g_config.c_perm_ifaces, 0):
+			    pattern_match_fast(cfg->g_perm_ifaces,
+				cfg->g_config.c_perm_ifaces, hardware->h_ifname, 0):
 			    0;
 			switch (m) {
 			case 0:
@@ -448,8 +559,9 @@ lldpd_cleanup(struct lldpd *cfg)
 				    hardware->h_ifname);
 				TRACE(LLDPD_INTERFACES_DELETE(hardware->h_ifname));
 				TAILQ_REMOVE(&cfg->g_hardware, hardware, h_entries);
-				lldpd_remote_cleanup(hardware, notify_clients_deletion, 1);
+				lldpd_expire_neighbors(cfg, hardware, 1);
 				lldpd_hardware_cleanup(cfg, hardware);
+				changed = 1;
 				break;
 			case 1:
 			case 2:
@@ -457,15 +569,16 @@ lldpd_cleanup(struct lldpd *cfg)
 				    hardware->h_ifname);
 				break;
 			}
-		} else {
-			lldpd_remote_cleanup(hardware, notify_clients_deletion,
-			    !(hardware->h_flags & IFF_RUNNING));
-		}
+		} else if (lldpd_expire_neighbors(cfg, hardware,
+			!(hardware->h_flags & IFF_RUNNING)))
+			changed = 1;
 	}
 
 	levent_schedule_cleanup(cfg);
 	lldpd_all_chassis_cleanup(cfg);
 	lldpd_count_neighbors(cfg);
+	if (changed) cfg->g_generation++;
+	levent_schedule_snapshot(cfg);
 }
 
 /* Update chassis `ochassis' with values from `chassis'. The later one is not
@@ -505,7 +618,7 @@ lldpd_move_chassis(struct lldpd_chassis *ochassis,
 	memcpy(&ochassis->c_entries, &entries, sizeof(entries));
 
 	/* Get rid of the new chassis */
-	free(chassis);
+	lldpd_slab_free(LLDPD_SLAB_CHASSIS, chassis);
 }
 
 static int
@@ -536,13 +649,40 @@ lldpd_guess_type(struct lldpd *cfg, char *frame, int s)
 	return -1;
 }
 
-static void
+/* Check if the same frame was already received from a neighbor of the port.
+ * In this case, the neighbor is only refreshed. This is the only change
+ * detection: decoded strings are never compared, a different frame always
+ * replaces the neighbor. */
+static int
+lldpd_known_frame(struct lldpd_hardware *hardware, char *frame, int s)
+{
+	struct lldpd_port *oport;
+	TAILQ_FOREACH(oport, &hardware->h_rports, p_entries) {
+		if ((oport->p_lastframe != NULL) &&
+		    (oport->p_lastframe->size == s) &&
+		    (memcmp(oport->p_lastframe->frame, frame, s) == 0)) {
+			/* Already received the same frame */
+			log_debug("decode", "duplicate frame, no need to decode");
+			oport->p_lastupdate = time(NULL);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static int lldpd_decode_merge(struct lldpd *, struct lldpd_hardware *, int,
+    char *, int, struct lldpd_chassis *, struct lldpd_port *);
+
+/* Decode a frame and update neighbors accordingly. Return 1 if the list of
+ * neighbors of the port has changed. Return -1 if the frame was handed to the
+ * decoding threads: it does not belong to the caller anymore. */
+static int
 lldpd_decode(struct lldpd *cfg, char *frame, int s,
     struct lldpd_hardware *hardware)
 {
 	int i;
-	struct lldpd_chassis *chassis, *ochassis = NULL;
-	struct lldpd_port *port, *oport = NULL, *aport;
+	struct lldpd_chassis *chassis;
+	struct lldpd_port *port;
 	int guess = LLDPD_MODE_LLDP;
 
 	log_debug("decode", "decode a received frame on %s",
@@ -551,7 +691,7 @@ lldpd_decode(struct lldpd *cfg, char *frame, int s,
 	if (s < sizeof(struct ether_header) + 4) {
 		/* Too short, just discard it */
 		hardware->h_rx_discarded_cnt++;
-		return;
+		return 0;
 	}
 
 	/* Decapsulate VLAN frames */
@@ -564,48 +704,80 @@ lldpd_decode(struct lldpd *cfg, char *frame, int s,
 		s -= 4;
 	}
 
-	TAILQ_FOREACH(oport, &hardware->h_rports, p_entries) {
-		if ((oport->p_lastframe != NULL) &&
-		    (oport->p_lastframe->size == s) &&
-		    (memcmp(oport->p_lastframe->frame, frame, s) == 0)) {
-			/* Already received the same frame */
-			log_debug("decode", "duplicate frame, no need to decode");
-			oport->p_lastupdate = time(NULL);
-			return;
-		}
-	}
+	if (lldpd_known_frame(hardware, frame, s))
+		return 0;
 
 	guess = lldpd_guess_type(cfg, frame, s);
 	for (i=0; cfg->g_protocols[i].mode != 0; i++) {
 		if (!cfg->g_protocols[i].enabled)
 			continue;
-		if (cfg->g_protocols[i].mode == guess) {
-			log_debug("decode", "using decode function for %s protocol",
-			    cfg->g_protocols[i].name);
-			if (cfg->g_protocols[i].decode(cfg, frame,
-				s, hardware, &chassis, &port) == -1) {
-				log_debug("decode", "function for %s protocol did not decode this frame",
-				    cfg->g_protocols[i].name);
-				hardware->h_rx_discarded_cnt++;
-				return;
-			}
-			chassis->c_protocol = port->p_protocol =
-			    cfg->g_protocols[i].mode;
+		if (cfg->g_protocols[i].mode == guess)
 			break;
-			}
 	}
 	if (cfg->g_protocols[i].mode == 0) {
 		log_debug("decode", "unable to guess frame type on %s",
 		    hardware->h_ifname);
-		return;
+		return 0;
 	}
+	if (decode_submit(cfg, hardware, i, frame, s) == 0)
+		return -1;
+
+	log_debug("decode", "using decode function for %s protocol",
+	    cfg->g_protocols[i].name);
+	if (cfg->g_protocols[i].decode(cfg, frame,
+		s, hardware, &chassis, &port) == -1) {
+		log_debug("decode", "function for %s protocol did not decode this frame",
+		    cfg->g_protocols[i].name);
+		hardware->h_rx_discarded_cnt++;
+		return 0;
+	}
+	return lldpd_decode_merge(cfg, hardware, i, frame, s, chassis, port);
+}
+
+/**
+ * Merge a neighbor decoded by a decoding thread.
+ *
+ * The neighbor may have been received again while it was decoded. Strings are
+ * interned here as decoding threads do not use the pool.
+ *
+ * @return 1 if the list of neighbors of the port has changed.
+ */
+int
+lldpd_decode_commit(struct lldpd *cfg, struct lldpd_hardware *hardware,
+    int proto, char *frame, int s,
+    struct lldpd_chassis *chassis, struct lldpd_port *port)
+{
+	if (lldpd_known_frame(hardware, frame, s)) {
+		lldpd_port_cleanup(port, 1);
+		lldpd_chassis_cleanup(chassis, 1);
+		lldpd_slab_free(LLDPD_SLAB_PORT, port);
+		return 0;
+	}
+	lldpd_intern_neighbor(chassis, port);
+	return lldpd_decode_merge(cfg, hardware, proto, frame, s, chassis, port);
+}
+
+/* Merge a decoded neighbor with the list of neighbors of the port and notify
+ * about the change. Return 1 if the list of neighbors has changed. */
+static int
+lldpd_decode_merge(struct lldpd *cfg, struct lldpd_hardware *hardware,
+    int proto, char *frame, int s,
+    struct lldpd_chassis *chassis, struct lldpd_port *port)
+{
+	int i;
+	struct lldpd_chassis *ochassis = NULL;
+	struct lldpd_port *oport = NULL, *aport;
+	struct timespec start;
+
+	chassis->c_protocol = port->p_protocol = cfg->g_protocols[proto].mode;
 	TRACE(LLDPD_FRAME_DECODED(
 		    hardware->h_ifname,
-		    cfg->g_protocols[i].name,
+		    cfg->g_protocols[proto].name,
 		    chassis->c_name,
 		    port->p_descr));
 
-	/* Do we already have the same MSAP somewhere? */
+	/* Do we already have the same MSAP somewhere? Chassis and port IDs
+	 * are binary and are not interned: they are compared with memcmp(). */
 	int count = 0;
 	log_debug("decode", "search for the same MSAP");
 	TAILQ_FOREACH(oport, &hardware->h_rports, p_entries) {
@@ -636,10 +808,12 @@ lldpd_decode(struct lldpd *cfg, char *frame, int s,
 		log_debug("decode",
 		    "too many neighbors for port %s, drop this new one",
 		    hardware->h_ifname);
+		hardware->h_drop_cnt++;
+		cfg->g_drop_cnt++;
 		lldpd_port_cleanup(port, 1);
 		lldpd_chassis_cleanup(chassis, 1);
-		free(port);
-		return;
+		lldpd_slab_free(LLDPD_SLAB_PORT, port);
+		return 0;
 	    }
 	}
 	/* No, but do we already know the system? */
@@ -659,7 +833,7 @@ lldpd_decode(struct lldpd *cfg, char *frame, int s,
 		/* The port is known, remove it before adding it back */
 		TAILQ_REMOVE(&hardware->h_rports, oport, p_entries);
 		lldpd_port_cleanup(oport, 1);
-		free(oport);
+		lldpd_slab_free(LLDPD_SLAB_PORT, oport);
 	}
 	if (ochassis) {
 		lldpd_move_chassis(ochassis, chassis);
@@ -675,11 +849,8 @@ lldpd_decode(struct lldpd *cfg, char *frame, int s,
 	}
 	/* Add port */
 	port->p_lastchange = port->p_lastupdate = time(NULL);
-	if ((port->p_lastframe = (struct lldpd_frame *)malloc(s +
-		    sizeof(struct lldpd_frame))) != NULL) {
-		port->p_lastframe->size = s;
+	if ((port->p_lastframe = lldpd_frame_alloc(s)) != NULL)
 		memcpy(port->p_lastframe->frame, frame, s);
-	}
 	TAILQ_INSERT_TAIL(&hardware->h_rports, port, p_entries);
 	port->p_chassis = chassis;
 	port->p_chassis->c_refcount++;
@@ -703,17 +874,21 @@ lldpd_decode(struct lldpd *cfg, char *frame, int s,
 	log_debug("decode", "%d neighbors for %s", i,
 	    hardware->h_ifname);
 
-	if (!oport) hardware->h_insert_cnt++;
+	if (!oport) {
+		hardware->h_insert_cnt++;
+		cfg->g_insert_cnt++;
+	}
 
 	/* Notify */
 	log_debug("decode", "send notifications for changes on %s",
 	    hardware->h_ifname);
+	latency_start(&start);
 	if (oport) {
 		TRACE(LLDPD_NEIGHBOR_UPDATE(hardware->h_ifname,
 			chassis->c_name,
 			port->p_descr,
 			i));
-		levent_ctl_notify(hardware->h_ifname, NEIGHBOR_CHANGE_UPDATED, port);
+		levent_ctl_notify(lldpd_hardware_name(hardware), NEIGHBOR_CHANGE_UPDATED, port);
 #ifdef USE_SNMP
 		agent_notify(hardware, NEIGHBOR_CHANGE_UPDATED, port);
 #endif
@@ -722,11 +897,12 @@ lldpd_decode(struct lldpd *cfg, char *frame, int s,
 			chassis->c_name,
 			port->p_descr,
 			i));
-		levent_ctl_notify(hardware->h_ifname, NEIGHBOR_CHANGE_ADDED, port);
+		levent_ctl_notify(lldpd_hardware_name(hardware), NEIGHBOR_CHANGE_ADDED, port);
 #ifdef USE_SNMP
 		agent_notify(hardware, NEIGHBOR_CHANGE_ADDED, port);
 #endif
 	}
+	latency_record(cfg, LATENCY_NOTIFY, &start);
 
 #ifdef ENABLE_LLDPMED
 	if (!oport && port->p_chassis->c_med_type) {
@@ -742,85 +918,118 @@ lldpd_decode(struct lldpd *cfg, char *frame, int s,
 	}
 #endif
 
-	return;
+	return 1;
 }
 
-/* Get the output of lsb_release -s -d.  This is a slow function. It should be
-   called once. It return NULL if any problem happens. Otherwise, this is a
-   statically allocated buffer. The result includes the trailing \n  */
-static char *
-lldpd_get_lsb_release() {
-	static char release[1024];
+/* Spawn lsb_release -s -d. This is a slow command. Its output is read
+   asynchronously with lldpd_read_lsb_release() from the returned file
+   descriptor. As children are reaped by the monitor, lsb_release is run
+   from an intermediate process which appends its exit status to the
+   output. Return -1 if any problem happens. */
+static int
+lldpd_spawn_lsb_release(pid_t *pid) {
 	char *const command[] = { "lsb_release", "-s", "-d", NULL };
-	int pid, status, devnull, count;
+	int devnull, status;
 	int pipefd[2];
+	pid_t child;
 
 	log_debug("localchassis", "grab LSB release");
 
 	if (pipe(pipefd)) {
 		log_warn("localchassis", "unable to get a pair of pipes");
-		return NULL;
+		return -1;
 	}
 
-	pid = vfork();
-	switch (pid) {
+	*pid = fork();
+	switch (*pid) {
 	case -1:
 		log_warn("localchassis", "unable to fork");
-		return NULL;
+		close(pipefd[0]);
+		close(pipefd[1]);
+		return -1;
 	case 0:
-		/* Child, exec lsb_release */
+		/* Child, run lsb_release and report its exit status */
 		close(pipefd[0]);
-		if ((devnull = open("/dev/null", O_RDWR, 0)) != -1) {
-			dup2(devnull, STDIN_FILENO);
-			dup2(devnull, STDERR_FILENO);
-			dup2(pipefd[1], STDOUT_FILENO);
-			if (devnull > 2) close(devnull);
-			if (pipefd[1] > 2) close(pipefd[1]);
-			execvp("lsb_release", command);
+		status = 127 << 8;
+		if ((child = vfork()) == 0) {
+			if ((devnull = open("/dev/null", O_RDWR, 0)) != -1) {
+				dup2(devnull, STDIN_FILENO);
+				dup2(devnull, STDERR_FILENO);
+				dup2(pipefd[1], STDOUT_FILENO);
+				if (devnull > 2) close(devnull);
+				if (pipefd[1] > 2) close(pipefd[1]);
+				execvp("lsb_release", command);
+			}
+			_exit(127);
 		}
-		_exit(127);
+		if (child != -1)
+			while (waitpid(child, &status, 0) == -1 && errno == EINTR);
+		if (write(pipefd[1], &status, sizeof(status)) == -1)
+			_exit(1);
+		_exit(0);
 		break;
 	default:
-		/* Father, read the output from the children */
 		close(pipefd[1]);
-		count = 0;
-		do {
-			status = read(pipefd[0], release+count, sizeof(release)-count);
-			if ((status == -1) && (errno == EINTR)) continue;
-			if (status > 0)
-				count += status;
-		} while (count < sizeof(release) && (status > 0));
-		if (status < 0) {
-			log_info("localchassis", "unable to read from lsb_release");
-			close(pipefd[0]);
-			waitpid(pid, &status, 0);
-			return NULL;
-		}
-		close(pipefd[0]);
-		if (count >= sizeof(release)) {
-			log_info("localchassis", "output of lsb_release is too large");
-			waitpid(pid, &status, 0);
-			return NULL;
-		}
-		status = -1;
-		if (waitpid(pid, &status, 0) != pid)
-			return NULL;
-		if (!WIFEXITED(status) || (WEXITSTATUS(status) != 0)) {
-			log_info("localchassis", "lsb_release information not available");
-			return NULL;
-		}
-		if (!count) {
-			log_info("localchassis", "lsb_release returned an empty string");
-			return NULL;
-		}
-		release[count] = '\0';
-		return release;
+		return pipefd[0];
 	}
 	/* Should not be here */
-	return NULL;
+	return -1;
+}
+
+/* Read the output of lsb_release spawned by lldpd_spawn_lsb_release(). Return
+   0 while more output is expected. Once the output is complete, the local
+   chassis is updated with the result. The result includes the trailing \n
+   (removed when not advertising the system version). */
+int
+lldpd_read_lsb_release(struct lldpd *cfg)
+{
+	static char release[1024 + sizeof(int)];
+	static size_t count = 0;
+	ssize_t n;
+	int status;
+
+	n = read(cfg->g_lsb_release_fd, release + count,
+	    sizeof(release) - 1 - count);
+	if (n == -1 && (errno == EINTR || errno == EAGAIN))
+		return 0;
+	if (n > 0) {
+		count += n;
+		if (count < sizeof(release) - 1) return 0;
+		log_info("localchassis", "output of lsb_release is too large");
+		n = -1;
+		count = 0;
+	}
+
+	close(cfg->g_lsb_release_fd);
+	cfg->g_lsb_release_fd = -1;
+	/* With privilege separation, the intermediate process is reaped by the
+	   monitor */
+	waitpid(cfg->g_lsb_release_pid, NULL, 0);
+	if (n < 0 || count < sizeof(status)) {
+		log_info("localchassis", "unable to read from lsb_release");
+		return 1;
+	}
+	count -= sizeof(status);
+	memcpy(&status, release + count, sizeof(status));
+	if (!WIFEXITED(status) || (WEXITSTATUS(status) != 0)) {
+		log_info("localchassis", "lsb_release information not available");
+		return 1;
+	}
+	if (!count) {
+		log_info("localchassis", "lsb_release returned an empty string");
+		return 1;
+	}
+	release[count] = '\0';
+	if (!cfg->g_config.c_advertise_version &&
+	    release[count - 1] == '\n')
+		release[count - 1] = '\0';
+	log_debug("localchassis", "LSB release is %s", release);
+	cfg->g_lsb_release = release;
+	levent_update_now(cfg);
+	return 1;
 }
 
-/* Same like lldpd_get_lsb_release but reads /etc/os-release for PRETTY_NAME=. */
+/* Get OS release by reading /etc/os-release for PRETTY_NAME=. */
 static char *
 lldpd_get_os_release() {
 	static char release[1024];
@@ -956,8 +1165,21 @@ lldpd_hide_ports(struct lldpd *cfg, struct lldpd_hardware *hardware, int mask) {
 	    hardware->h_ifname, buffer[0]?buffer:"(none)");
 }
 
-/* Hide unwanted ports depending on smart mode set by the user */
-static void
+/* Hide unwanted ports of an interface depending on smart mode set by the
+ * user. Hidden flags of a port only depend on the other neighbors of the same
+ * interface: this should be called each time they change. */
+void
+lldpd_hide_hardware(struct lldpd *cfg, struct lldpd_hardware *hardware)
+{
+	if (cfg->g_config.c_smart & SMART_INCOMING_FILTER)
+		lldpd_hide_ports(cfg, hardware, SMART_INCOMING);
+	if (cfg->g_config.c_smart & SMART_OUTGOING_FILTER)
+		lldpd_hide_ports(cfg, hardware, SMART_OUTGOING);
+}
+
+/* Hide unwanted ports on all interfaces. Only needed when the smart mode
+ * changes or when neighbors are added by other means than lldpd_recv(). */
+void
 lldpd_hide_all(struct lldpd *cfg)
 {
 	struct lldpd_hardware *hardware;
@@ -965,12 +1187,8 @@ lldpd_hide_all(struct lldpd *cfg)
 	if (!cfg->g_config.c_smart)
 		return;
 	log_debug("smartfilter", "apply smart filter results on all ports");
-	TAILQ_FOREACH(hardware, &cfg->g_hardware, h_entries) {
-		if (cfg->g_config.c_smart & SMART_INCOMING_FILTER)
-			lldpd_hide_ports(cfg, hardware, SMART_INCOMING);
-		if (cfg->g_config.c_smart & SMART_OUTGOING_FILTER)
-			lldpd_hide_ports(cfg, hardware, SMART_OUTGOING);
-	}
+	TAILQ_FOREACH(hardware, &cfg->g_hardware, h_entries)
+		lldpd_hide_hardware(cfg, hardware);
 }
 
 /* If PD device and PSE allocated power, echo back this change. If we have
@@ -980,8 +1198,9 @@ lldpd_dot3_power_pd_pse(struct lldpd_hardware *hardware)
 {
 #ifdef ENABLE_DOT3
 	struct lldpd_port *port, *selected_port = NULL;
+	struct lldpd_dot3_power *power = hardware->h_lport.p_power;
 	/* Are we a PD device? */
-	if (hardware->h_lport.p_power.devicetype != LLDP_DOT3_POWER_PD)
+	if (power == NULL || power->devicetype != LLDP_DOT3_POWER_PD)
 		return;
 	TAILQ_FOREACH(port, &hardware->h_rports, p_entries) {
 		if (port->p_hidden_in)
@@ -990,23 +1209,26 @@ lldpd_dot3_power_pd_pse(struct lldpd_hardware *hardware)
 		if (port->p_protocol != LLDPD_MODE_LLDP && port->p_protocol != LLDPD_MODE_CDPV2)
 			continue;
 
-		if (port->p_power.devicetype != LLDP_DOT3_POWER_PSE)
+		if (port->p_power == NULL ||
+		    port->p_power->devicetype != LLDP_DOT3_POWER_PSE)
 			continue;
 		if (!selected_port || port->p_lastupdate > selected_port->p_lastupdate)
 			selected_port = port;
 	}
-	if (selected_port && selected_port->p_power.allocated != hardware->h_lport.p_power.allocated) {
+	if (selected_port && selected_port->p_power->allocated != power->allocated) {
 		log_info("receive", "for %s, PSE told us allocated is now %d instead of %d",
 		    hardware->h_ifname,
-		    selected_port->p_power.allocated,
-		    hardware->h_lport.p_power.allocated);
-		hardware->h_lport.p_power.allocated = selected_port->p_power.allocated;
+		    selected_port->p_power->allocated,
+		    power->allocated);
+		power->allocated = selected_port->p_power->allocated;
 		levent_schedule_pdu(hardware);
 	}
 
 #ifdef ENABLE_CDP
-	if (selected_port && selected_port->p_cdp_power.management_id != hardware->h_lport.p_cdp_power.management_id) {
-		hardware->h_lport.p_cdp_power.management_id = selected_port->p_cdp_power.management_id;
+	if (selected_port && selected_port->p_cdp_power &&
+	    LLDPD_PORT_EXT(&hardware->h_lport, p_cdp_power) != NULL &&
+	    selected_port->p_cdp_power->management_id != hardware->h_lport.p_cdp_power->management_id) {
+		hardware->h_lport.p_cdp_power->management_id = selected_port->p_cdp_power->management_id;
 	}
 #endif
 
@@ -1017,16 +1239,20 @@ void
 lldpd_recv(struct lldpd *cfg, struct lldpd_hardware *hardware, int fd)
 {
 	char *buffer = NULL;
-	int n;
+	struct timespec start;
+	int n, changed;
 	log_debug("receive", "receive a frame on %s",
 	    hardware->h_ifname);
 	if ((buffer = (char *)malloc(hardware->h_mtu)) == NULL) {
 		log_warn("receive", "failed to alloc reception buffer");
 		return;
 	}
-	if ((n = hardware->h_ops->recv(cfg, hardware,
-		    fd, buffer,
-		    hardware->h_mtu)) == -1) {
+	latency_start(&start);
+	n = hardware->h_ops->recv(cfg, hardware,
+	    fd, buffer,
+	    hardware->h_mtu);
+	latency_record(cfg, LATENCY_RECV, &start);
+	if (n == -1) {
 		log_debug("receive", "discard frame received on %s",
 		    hardware->h_ifname);
 		free(buffer);
@@ -1048,11 +1274,30 @@ lldpd_recv(struct lldpd *cfg, struct lldpd_hardware *hardware, int fd)
 	log_debug("receive", "decode received frame on %s",
 	    hardware->h_ifname);
 	TRACE(LLDPD_FRAME_RECEIVED(hardware->h_ifname, buffer, (size_t)n));
-	lldpd_decode(cfg, buffer, n, hardware);
-	lldpd_hide_all(cfg); /* Immediatly hide */
+	latency_start(&start);
+	changed = lldpd_decode(cfg, buffer, n, hardware);
+	if (changed == -1) return;	/* Decoded in the background */
+	latency_record(cfg, LATENCY_DECODE, &start);
+	lldpd_recv_complete(cfg, hardware, changed);
+	free(buffer);
+}
+
+/* Update the state of the daemon once a received frame has been decoded. */
+void
+lldpd_recv_complete(struct lldpd *cfg, struct lldpd_hardware *hardware,
+    int changed)
+{
+	struct timespec start;
+	if (changed && cfg->g_config.c_smart) {
+		/* Immediatly hide */
+		latency_start(&start);
+		lldpd_hide_hardware(cfg, hardware);
+		latency_record(cfg, LATENCY_HIDE, &start);
+	}
 	lldpd_dot3_power_pd_pse(hardware);
 	lldpd_count_neighbors(cfg);
-	free(buffer);
+	if (changed) cfg->g_generation++;
+	levent_schedule_snapshot(cfg);
 }
 
 static void
@@ -1076,6 +1321,7 @@ lldpd_send(struct lldpd_hardware *hardware)
 {
 	struct lldpd *cfg = hardware->h_cfg;
 	struct lldpd_port *port;
+	struct timespec start;
 	int i, sent;
 
 	if (cfg->g_config.c_receiveonly || cfg->g_config.c_paused) return;
@@ -1084,6 +1330,7 @@ lldpd_send(struct lldpd_hardware *hardware)
 		return;
 
 	log_debug("send", "send PDU on %s", hardware->h_ifname);
+	latency_start(&start);
 	sent = 0;
 	for (i=0; cfg->g_protocols[i].mode != 0; i++) {
 		if (!cfg->g_protocols[i].enabled)
@@ -1132,6 +1379,28 @@ lldpd_send(struct lldpd_hardware *hardware)
 		if (cfg->g_protocols[i].mode == 0)
 			log_warnx("send", "no protocol enabled, dunno what to send");
 	}
+	latency_record(cfg, LATENCY_SEND, &start);
+	levent_schedule_snapshot(cfg); /* Transmit counters */
+
+	if (lldpd_startup_mark(cfg, &cfg->g_config.c_startup_first_pdu)) {
+		log_debug("send", "first PDU sent after %d ms",
+		    cfg->g_config.c_startup_first_pdu);
+		levent_schedule_metadata(cfg, 0);
+	}
+}
+
+/* Record the time elapsed since start for a startup phase, unless it was
+ * already recorded. Return 1 if recorded. */
+int
+lldpd_startup_mark(struct lldpd *cfg, int *phase)
+{
+	struct timespec now;
+	if (*phase) return 0;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	*phase = (now.tv_sec - cfg->g_startup.tv_sec) * 1000 +
+	    (now.tv_nsec - cfg->g_startup.tv_nsec) / 1000000;
+	if (*phase <= 0) *phase = 1;
+	return 1;
 }
 
 #ifdef ENABLE_LLDPMED
@@ -1151,6 +1420,40 @@ lldpd_med(struct lldpd_chassis *chassis)
 }
 #endif
 
+/* Collect slow chassis metadata. To not delay the first PDU, this is done
+ * after it has been sent. */
+void
+lldpd_update_metadata(struct lldpd *cfg)
+{
+	if (cfg->g_config.c_startup_metadata) return;
+	log_debug("localchassis", "collect additional information for local chassis");
+#ifdef ENABLE_LLDPMED
+	lldpd_med(LOCAL_CHASSIS(cfg));
+#endif
+	lldpd_startup_mark(cfg, &cfg->g_config.c_startup_metadata);
+#ifdef ENABLE_LLDPMED
+	/* Don't wait for the next PDU to advertise inventory */
+	if (LOCAL_CHASSIS(cfg)->c_med_type && !cfg->g_config.c_noinventory)
+		levent_send_now(cfg);
+#endif
+}
+
+/* Compile interface and management address patterns. To be called each time
+ * one of them is changed. */
+void
+lldpd_compile_patterns(struct lldpd *cfg)
+{
+	log_debug("interfaces", "compile interface and address patterns");
+	pattern_free(cfg->g_iface_pattern);
+	pattern_free(cfg->g_perm_ifaces);
+	pattern_free(cfg->g_mgmt_pattern);
+	pattern_free(cfg->g_cid_pattern);
+	cfg->g_iface_pattern = pattern_compile(cfg->g_config.c_iface_pattern);
+	cfg->g_perm_ifaces = pattern_compile(cfg->g_config.c_perm_ifaces);
+	cfg->g_mgmt_pattern = pattern_compile(cfg->g_config.c_mgmt_pattern);
+	cfg->g_cid_pattern = pattern_compile(cfg->g_config.c_cid_pattern);
+}
+
 static int
 lldpd_routing_enabled(struct lldpd *cfg)
 {
@@ -1166,11 +1469,34 @@ lldpd_routing_enabled(struct lldpd *cfg)
 	return routing;
 }
 
+/* Check if the system name has changed. Resolution of the system name is
+ * done asynchronously. While it is not complete, we check again later. When
+ * `refresh` is set, cached resolution is not used. */
+void
+lldpd_hostname_check(struct lldpd *cfg, int refresh)
+{
+	int pending;
+	char *hp;
+
+	if (cfg->g_config.c_hostname) return;
+	hp = priv_gethostname(refresh, &pending);
+	if (pending) {
+		levent_schedule_hostname(cfg);
+		return;
+	}
+	if (LOCAL_CHASSIS(cfg)->c_name == NULL ||
+	    strcmp(hp, LOCAL_CHASSIS(cfg)->c_name)) {
+		log_debug("localchassis", "system name is now %s", hp);
+		levent_update_now(cfg);
+	}
+}
+
 void
 lldpd_update_localchassis(struct lldpd *cfg)
 {
 	struct utsname un;
 	char *hp;
+	int pending;
 
 	log_debug("localchassis", "update information for local chassis");
 	assert(LOCAL_CHASSIS(cfg) != NULL);
@@ -1182,8 +1508,9 @@ lldpd_update_localchassis(struct lldpd *cfg)
 		log_debug("localchassis", "use overridden system name `%s`", cfg->g_config.c_hostname);
 		hp = cfg->g_config.c_hostname;
 	} else {
-		if ((hp = priv_gethostname()) == NULL)
+		if ((hp = priv_gethostname(0, &pending)) == NULL)
 			fatal("localchassis", "failed to get system name");
+		if (pending) levent_schedule_hostname(cfg);
 	}
 	free(LOCAL_CHASSIS(cfg)->c_name);
 	free(LOCAL_CHASSIS(cfg)->c_descr);
@@ -1222,7 +1549,6 @@ lldpd_update_localchassis(struct lldpd *cfg)
 #ifdef ENABLE_LLDPMED
 	if (LOCAL_CHASSIS(cfg)->c_cap_available & LLDP_CAP_TELEPHONE)
 		LOCAL_CHASSIS(cfg)->c_cap_enabled |= LLDP_CAP_TELEPHONE;
-	lldpd_med(LOCAL_CHASSIS(cfg));
 	free(LOCAL_CHASSIS(cfg)->c_med_sw);
 	if (cfg->g_config.c_advertise_version)
 		LOCAL_CHASSIS(cfg)->c_med_sw = strdup(un.release);
@@ -1260,6 +1586,7 @@ void
 lldpd_update_localports(struct lldpd *cfg)
 {
 	struct lldpd_hardware *hardware;
+	struct timespec start;
 
 	log_debug("localchassis", "update information for local ports");
 
@@ -1270,7 +1597,9 @@ lldpd_update_localports(struct lldpd *cfg)
 	    hardware->h_flags = 0;
 
 	TRACE(LLDPD_INTERFACES_UPDATE());
+	latency_start(&start);
 	interfaces_update(cfg);
+	latency_record(cfg, LATENCY_INTERFACES, &start);
 	lldpd_cleanup(cfg);
 	lldpd_reset_timer(cfg);
 }
@@ -1289,22 +1618,84 @@ lldpd_loop(struct lldpd *cfg)
 	 * missed something. */
 	log_debug("loop", "update information for local ports");
 	lldpd_update_localports(cfg);
+	if (lldpd_startup_mark(cfg, &cfg->g_config.c_startup_interfaces)) {
+		log_debug("loop", "interfaces initialized after %d ms",
+		    cfg->g_config.c_startup_interfaces);
+		/* If no PDU is sent, collect metadata anyway */
+		levent_schedule_metadata(cfg, cfg->g_config.c_tx_interval);
+	}
 	log_debug("loop", "update information for local chassis");
 	lldpd_update_localchassis(cfg);
 	lldpd_count_neighbors(cfg);
+#ifdef HOST_OS_LINUX
+	/* Files read during this loop are kept open for the next one */
+	priv_read_expire();
+#endif
 }
 
+#ifdef HOST_OS_LINUX
+/**
+ * Parse a comma-separated list of network namespaces.
+ *
+ * @return a NULL-terminated array of names or NULL on error
+ */
+static char **
+lldpd_parse_netns(const char *list)
+{
+	char **netns = NULL, *names, *name, *saveptr = NULL;
+	int count = 0;
+
+	if ((names = strdup(list)) == NULL ||
+	    (netns = calloc(LLDPD_NETNS_MAX + 1, sizeof(char *))) == NULL)
+		fatal("main", NULL);
+	for (name = strtok_r(names, ",", &saveptr);
+	     name != NULL;
+	     name = strtok_r(NULL, ",", &saveptr)) {
+		if (strchr(name, '/') || !strcmp(name, ".") || !strcmp(name, "..") ||
+		    strlen(name) >= LLDPD_NETNS_NAMESIZ) {
+			fprintf(stderr, "invalid network namespace name: %s\n", name);
+			goto error;
+		}
+		if (count == LLDPD_NETNS_MAX) {
+			fprintf(stderr, "at most %d network namespaces can be used\n",
+			    LLDPD_NETNS_MAX);
+			goto error;
+		}
+		if ((netns[count++] = strdup(name)) == NULL)
+			fatal("main", NULL);
+	}
+	if (count == 0) {
+		fprintf(stderr, "-N requires at least one network namespace\n");
+		goto error;
+	}
+	free(names);
+	return netns;
+error:
+	while (count > 0) free(netns[--count]);
+	free(netns);
+	free(names);
+	return NULL;
+}
+#endif
+
 static void
 lldpd_exit(struct lldpd *cfg)
 {
 	struct lldpd_hardware *hardware, *hardware_next;
 	log_debug("main", "exit lldpd");
 
-	TAILQ_FOREACH(hardware, &cfg->g_hardware, h_entries)
-		lldpd_send_shutdown(hardware);
+	decode_stop(cfg);
+	if (cfg->g_config.c_warm_restart)
+		/* Neighbors will be restored, don't tell them we leave */
+		state_save(cfg);
+	else
+		TAILQ_FOREACH(hardware, &cfg->g_hardware, h_entries)
+			lldpd_send_shutdown(hardware);
 
 	close(cfg->g_ctl);
 	priv_ctl_cleanup(cfg->g_ctlname);
+	snapshot_close(cfg);
+	metrics_close(cfg);
 	log_debug("main", "cleanup hardware information");
 	for (hardware = TAILQ_FIRST(&cfg->g_hardware); hardware != NULL;
 	     hardware = hardware_next) {
@@ -1318,6 +1709,16 @@ lldpd_exit(struct lldpd *cfg)
 	lldpd_all_chassis_cleanup(cfg);
 	free(cfg->g_default_local_port);
 	free(cfg->g_config.c_platform);
+	pattern_free(cfg->g_iface_pattern);
+	pattern_free(cfg->g_perm_ifaces);
+	pattern_free(cfg->g_mgmt_pattern);
+	pattern_free(cfg->g_cid_pattern);
+#ifdef HOST_OS_LINUX
+	for (char **netns = cfg->g_netns; netns && *netns; netns++)
+		free(*netns);
+	free(cfg->g_netns);
+#endif
+	lldpd_slab_cleanup();
 	levent_shutdown(cfg);
 }
 
@@ -1527,7 +1928,7 @@ lldpd_main(int argc, char *argv[], char *envp[])
 	 * unless there is a very good reason. Most command-line options will
 	 * get deprecated at some point. */
 	char *popt, opts[] =
-	    "H:vhkrdD:p:xX:m:u:4:6:I:C:p:M:P:S:iL:O:@                    ";
+	    "H:vhkrdD:T:p:xX:m:u:4:6:I:C:p:M:P:S:iL:O:N:@                    ";
 	int i, found, advertise_version = 1;
 #ifdef ENABLE_LLDPMED
 	int lldpmed = 0, noinventory = 0;
@@ -1539,9 +1940,14 @@ lldpd_main(int argc, char *argv[], char *envp[])
 	const char *lldpcli = LLDPCLI_PATH;
 	const char *pidfile = LLDPD_PID_FILE;
 	int smart = 15;
+	int trace = 0;
 	int receiveonly = 0, version = 0;
 	int ctl;
 	const char *config_file = NULL;
+	char **netns = NULL;
+	struct timespec startup;
+	int lsb_release_fd = -1;
+	pid_t lsb_release_pid = -1;
 
 #ifdef ENABLE_PRIVSEP
 	/* Non privileged user */
@@ -1552,6 +1958,7 @@ lldpd_main(int argc, char *argv[], char *envp[])
 #endif
 
 	saved_argv = argv;
+	clock_gettime(CLOCK_MONOTONIC, &startup);
 
 #if HAVE_SETPROCTITLE_INIT
 	setproctitle_init(argc, argv, envp);
@@ -1586,6 +1993,13 @@ lldpd_main(int argc, char *argv[], char *envp[])
 		case 'D':
 			log_accept(optarg);
 			break;
+		case 'T':
+			trace = strtonum(optarg, 1, 1000000, &errstr);
+			if (errstr) {
+				fprintf(stderr, "-T requires a number between 1 and 1000000\n");
+				usage();
+			}
+			break;
 		case 'p':
 			pidfile = optarg;
 			break;
@@ -1687,6 +2101,19 @@ lldpd_main(int argc, char *argv[], char *envp[])
 				usage();
 			}
 			break;
+		case 'N':
+#ifdef HOST_OS_LINUX
+			if (netns) {
+				fprintf(stderr, "-N can only be used once\n");
+				usage();
+			}
+			if ((netns = lldpd_parse_netns(optarg)) == NULL)
+				usage();
+#else
+			fprintf(stderr, "network namespaces are only supported on Linux\n");
+			usage();
+#endif
+			break;
 		case 'O':
 			if (config_file) {
 				fprintf(stderr, "-O can only be used once\n");
@@ -1723,6 +2150,7 @@ lldpd_main(int argc, char *argv[], char *envp[])
 	smart = filters[i].b;
 
 	log_init(use_syslog, debug, __progname);
+	if (trace) log_ring_init(trace);
 	tzset();		/* Get timezone info before chroot */
 	if (use_syslog && daemonize) {
 		/* So, we use syslog and we daemonize (or we are started by
@@ -1824,18 +2252,20 @@ lldpd_main(int argc, char *argv[], char *envp[])
 	}
 
 	/* Try to read system information from /etc/os-release if possible.
-	   Fall back to lsb_release for compatibility. */
+	   Fall back to lsb_release for compatibility. As lsb_release is slow,
+	   it runs in the background and its output is read later. It has to
+	   be spawned before entering the chroot. */
 	log_debug("main", "get OS/LSB release information");
 	lsb_release = lldpd_get_os_release();
 	if (!lsb_release) {
-		lsb_release = lldpd_get_lsb_release();
+		lsb_release_fd = lldpd_spawn_lsb_release(&lsb_release_pid);
 	}
 
 	log_debug("main", "initialize privilege separation");
 #ifdef ENABLE_PRIVSEP
-	priv_init(PRIVSEP_CHROOT, ctl, uid, gid);
+	priv_init(PRIVSEP_CHROOT, ctl, uid, gid, netns);
 #else
-	priv_init(PRIVSEP_CHROOT, ctl, 0, 0);
+	priv_init(PRIVSEP_CHROOT, ctl, 0, 0, netns);
 #endif
 
 	/* Initialization of global configuration */
@@ -1843,12 +2273,23 @@ lldpd_main(int argc, char *argv[], char *envp[])
 	    calloc(1, sizeof(struct lldpd))) == NULL)
 		fatal("main", NULL);
 
+	cfg->g_startup = startup;
+	lldpd_startup_mark(cfg, &cfg->g_config.c_startup_privsep);
+	if (!lldpcli)
+		lldpd_startup_mark(cfg, &cfg->g_config.c_startup_configured);
+	cfg->g_lsb_release_fd = lsb_release_fd;
+	cfg->g_lsb_release_pid = lsb_release_pid;
+
 	lldpd_alloc_default_local_port(cfg);
 	cfg->g_ctlname = ctlname;
 	cfg->g_ctl = ctl;
+#ifdef HOST_OS_LINUX
+	cfg->g_netns = netns;
+#endif
 	cfg->g_config.c_mgmt_pattern = mgmtp;
 	cfg->g_config.c_cid_pattern = cidp;
 	cfg->g_config.c_iface_pattern = interfaces;
+	lldpd_compile_patterns(cfg);
 	cfg->g_config.c_smart = smart;
 	if (lldpcli)
 		cfg->g_config.c_paused = 1;
@@ -1857,6 +2298,7 @@ lldpd_main(int argc, char *argv[], char *envp[])
 	cfg->g_config.c_tx_hold = LLDPD_TX_HOLD;
 	cfg->g_config.c_ttl = cfg->g_config.c_tx_interval * cfg->g_config.c_tx_hold;
 	cfg->g_config.c_max_neighbors = LLDPD_MAX_NEIGHBORS;
+	cfg->g_config.c_notification_interval = LLDPD_NOTIFICATION_INTERVAL;
 #ifdef ENABLE_LLDPMED
 	cfg->g_config.c_enable_fast_start = enable_fast_start;
 	cfg->g_config.c_tx_fast_init = LLDPD_FAST_INIT;
@@ -1887,8 +2329,7 @@ lldpd_main(int argc, char *argv[], char *envp[])
 
 	/* Set system capabilities */
 	log_debug("main", "set system capabilities");
-	if ((lchassis = (struct lldpd_chassis*)
-		calloc(1, sizeof(struct lldpd_chassis))) == NULL)
+	if ((lchassis = lldpd_slab_alloc(LLDPD_SLAB_CHASSIS)) == NULL)
 		fatal("localchassis", NULL);
 	cfg->g_config.c_cap_advertise = 1;
 	lchassis->c_cap_available = LLDP_CAP_BRIDGE | LLDP_CAP_WLAN |
@@ -36,6 +36,7 @@
 #include <netinet/if_ether.h>
 #include <netinet/in.h>
 #include <sys/un.h>
+#include <time.h>
 
 #include "lldp-tlv.h"
 #if defined (ENABLE_CDP) || defined (ENABLE_FDP)
@@ -68,8 +69,23 @@ struct event_base;
 #define LLDPD_TTL              LLDPD_TX_INTERVAL * LLDPD_TX_HOLD
 #define LLDPD_TX_MSGDELAY	1
 #define LLDPD_MAX_NEIGHBORS	32
+#define LLDPD_NOTIFICATION_INTERVAL 5
+#define LLDPD_HOSTNAME_TTL	300  /* Cache canonical system name (seconds) */
+#define LLDPD_HOSTNAME_NEGATIVE_TTL 30 /* Retry delay when resolution fails */
+#define LLDPD_HOSTNAME_WAIT	100  /* Wait for a fast resolution (milliseconds) */
 #define LLDPD_FAST_TX_INTERVAL	1
 #define LLDPD_FAST_INIT	4
+#define LLDPD_STATE_INTERVAL	60   /* Save neighbors for warm restart (seconds) */
+#define LLDPD_NETNS_RUN		"/var/run/netns/" /* Named network namespaces */
+#define LLDPD_NETNS_MAX		64   /* Maximum number of additional namespaces */
+
+/* Interfaces from additional network namespaces (Linux only) have the number
+ * of their namespace in the upper bits of their index. The namespace lldpd
+ * runs in is number 0, so its interfaces keep their index. */
+#define LLDPD_NETNS_SHIFT	24
+#define LLDPD_IFINDEX(netns, index)	(((netns) << LLDPD_NETNS_SHIFT) | (index))
+#define LLDPD_IFINDEX_NETNS(index)	((index) >> LLDPD_NETNS_SHIFT)
+#define LLDPD_IFINDEX_LOCAL(index)	((index) & ((1 << LLDPD_NETNS_SHIFT) - 1))
 
 #define USING_AGENTX_SUBAGENT_MODULE 1
 
@@ -101,14 +117,70 @@ struct lldpd_hardware	*lldpd_get_hardware(struct lldpd *,
     char *, int);
 struct lldpd_hardware	*lldpd_alloc_hardware(struct lldpd *, char *, int);
 void	 lldpd_hardware_cleanup(struct lldpd*, struct lldpd_hardware *);
+const char *lldpd_hardware_name(struct lldpd_hardware *);
+int	 lldpd_hardware_match(struct lldpd_hardware *, const char *);
+const char *lldpd_netns_name(struct lldpd *, int);
 struct lldpd_mgmt *lldpd_alloc_mgmt(int family, void *addr, size_t addrsize, u_int32_t iface);
 void	 lldpd_recv(struct lldpd *, struct lldpd_hardware *, int);
+void	 lldpd_recv_complete(struct lldpd *, struct lldpd_hardware *, int);
+int	 lldpd_decode_commit(struct lldpd *, struct lldpd_hardware *, int,
+    char *, int, struct lldpd_chassis *, struct lldpd_port *);
+struct protocol *lldpd_protocols(void);
 void	 lldpd_send(struct lldpd_hardware *);
 void	 lldpd_loop(struct lldpd *);
 int	 lldpd_main(int, char **, char **);
 void	 lldpd_update_localports(struct lldpd *);
 void	 lldpd_update_localchassis(struct lldpd *);
+void	 lldpd_hostname_check(struct lldpd *, int);
+void	 lldpd_update_metadata(struct lldpd *);
+void	 lldpd_compile_patterns(struct lldpd *);
+int	 lldpd_read_lsb_release(struct lldpd *);
+int	 lldpd_startup_mark(struct lldpd *, int *);
 void	 lldpd_cleanup(struct lldpd *);
+void	 lldpd_hide_hardware(struct lldpd *, struct lldpd_hardware *);
+void	 lldpd_hide_all(struct lldpd *);
+
+/* snapshot.c */
+void	 snapshot_open(struct lldpd *);
+void	 snapshot_close(struct lldpd *);
+void	 snapshot_update(struct lldpd *);
+
+/* state.c */
+void	 state_save(struct lldpd *);
+void	 state_restore(struct lldpd *);
+
+/* metrics.c */
+void	 metrics_open(struct lldpd *);
+void	 metrics_close(struct lldpd *);
+void	 metrics_forget(struct lldpd *, struct lldpd_hardware *);
+
+/* decode.c */
+int	 decode_start(struct lldpd *);
+void	 decode_stop(struct lldpd *);
+int	 decode_submit(struct lldpd *, struct lldpd_hardware *, int, char *, int);
+void	 decode_forget(struct lldpd *, struct lldpd_hardware *);
+
+/* latency.c */
+enum latency_stage {
+	LATENCY_RECV,		/* Read a frame */
+	LATENCY_DECODE,		/* Decode a frame and update neighbors */
+	LATENCY_HIDE,		/* Smart filter */
+	LATENCY_NOTIFY,		/* Notify clients and SNMP agent */
+	LATENCY_SEND,		/* Build and send PDUs on a port */
+	LATENCY_INTERFACES,	/* Update local interfaces */
+	LATENCY_INTERFACES_FETCH,    /* Fetch interfaces and addresses */
+	LATENCY_INTERFACES_CLASSIFY, /* Find bridges, bonds, VLANs, ... */
+	LATENCY_INTERFACES_APPLY,    /* Update local ports and chassis */
+	LATENCY_INTERFACES_MACPHY,   /* Query MAC/PHY settings */
+	LATENCY_LAST
+};
+void	 latency_start(struct timespec *);
+void	 latency_record(struct lldpd *, enum latency_stage,
+    const struct timespec *);
+u_int64_t latency_elapsed(const struct timespec *);
+void	 latency_add(struct lldpd *, enum latency_stage, u_int64_t);
+ssize_t	 latency_serialize(struct lldpd *, void **);
+void	 latency_reset(struct lldpd *);
 
 /* frame.c */
 u_int16_t frame_checksum(const u_int8_t *, int, int);
@@ -119,12 +191,21 @@ void	 levent_shutdown(struct lldpd *);
 void	 levent_hardware_init(struct lldpd_hardware *);
 void	 levent_hardware_add_fd(struct lldpd_hardware *, int);
 void	 levent_hardware_release(struct lldpd_hardware *);
-void	 levent_ctl_notify(char *, int, struct lldpd_port *);
+void	 levent_ctl_notify(const char *, int, struct lldpd_port *);
+void	 levent_ctl_stats(size_t *, size_t *);
 void	 levent_send_now(struct lldpd *);
 void	 levent_update_now(struct lldpd *);
 int	 levent_iface_subscribe(struct lldpd *, int);
+void	 levent_iface_unsubscribe(struct lldpd *, int);
 void	 levent_schedule_pdu(struct lldpd_hardware *);
 void	 levent_schedule_cleanup(struct lldpd *);
+void	 levent_schedule_hostname(struct lldpd *);
+void	 levent_schedule_metadata(struct lldpd *, int);
+void	 levent_schedule_snapshot(struct lldpd *);
+void	 levent_schedule_state(struct lldpd *, int);
+#ifdef USE_SNMP
+void	 levent_schedule_snmp_notification(struct lldpd *, int);
+#endif
 int	 levent_make_socket_nonblocking(int);
 int	 levent_make_socket_blocking(int);
 #ifdef HOST_OS_LINUX
@@ -177,6 +258,7 @@ char	*dmi_asset(void);
 void		 agent_shutdown(void);
 void		 agent_init(struct lldpd *, const char *);
 void		 agent_notify(struct lldpd_hardware *, int, struct lldpd_port *);
+void		 agent_notify_pending(struct lldpd *);
 #endif
 
 #ifdef ENABLE_PRIVSEP
@@ -193,22 +275,37 @@ client_handle_client(struct lldpd *cfg,
     int*);
 
 /* priv.c */
-void	 priv_init(const char*, int, uid_t, gid_t);
+void	 priv_init(const char*, int, uid_t, gid_t, char **);
+int	 asroot_netns_allowed(const char *);
 void	 priv_wait(void);
 void	 priv_ctl_cleanup(const char *ctlname);
-char   	*priv_gethostname(void);
+char   	*priv_gethostname(int, int *);
 #ifdef HOST_OS_LINUX
 int    	 priv_open(char*);
+ssize_t	 priv_read(char *, char *, size_t);
+void	 priv_read_expire(void);
 void	 asroot_open(void);
+int	 priv_netns_socket(const char *, int, int, int);
+void	 asroot_netns(void);
+int	 priv_netns_stat(const char *, dev_t *, ino_t *);
+void	 asroot_netns_stat(void);
+int	 asroot_netns_socket(const char *, int, int, int);
 #endif
-int    	 priv_iface_init(int, char *);
-int	 asroot_iface_init_os(int, char *, int *);
-int	 priv_iface_multicast(const char *, const u_int8_t *, int);
+int    	 priv_iface_init(int, char *, const char *);
+int	 asroot_iface_init_os(int, char *, const char *, int *);
+#define PRIV_MULTICAST_MAX 32	/* Maximum addresses for priv_iface_multicast() */
+void	 priv_iface_multicast(const char *, const char *,
+    const u_int8_t *, int, int, int *);
 int	 priv_iface_description(const char *, const char *);
 int	 asroot_iface_description_os(const char *, const char *);
-int	 priv_iface_promisc(const char*);
-int	 asroot_iface_promisc_os(const char *);
+int	 priv_iface_promisc(const char *, const char *);
+int	 asroot_iface_promisc_os(const char *, const char *);
 int	 priv_snmp_socket(struct sockaddr_un *);
+int	 priv_snapshot(int);
+#define PRIV_STATE_MAX (16*1024*1024) /* Maximum size of the state file */
+int	 priv_save_state(const void *, size_t);
+void	*priv_load_state(size_t *);
+int	 priv_metrics(int);
 
 enum priv_cmd {
 	PRIV_PING,
@@ -220,11 +317,17 @@ enum priv_cmd {
 	PRIV_IFACE_DESCRIPTION,
 	PRIV_IFACE_PROMISC,
 	PRIV_SNMP_SOCKET,
+	PRIV_SNAPSHOT,
+	PRIV_SAVE_STATE,
+	PRIV_LOAD_STATE,
+	PRIV_METRICS,
+	PRIV_NETNS_SOCKET,
+	PRIV_NETNS_STAT,
 };
 
 /* priv-seccomp.c */
 #if defined USE_SECCOMP && defined ENABLE_PRIVSEP
-int priv_seccomp_init(int, int);
+int priv_seccomp_init(int, int, int);
 #endif
 
 /* privsep_io.c */
@@ -365,11 +468,12 @@ void interfaces_helper_mgmt(struct lldpd *,
 #ifdef ENABLE_DOT1
 void interfaces_helper_vlan(struct lldpd *,
     struct interfaces_device_list *);
+void interfaces_vlan_cleanup(struct lldpd_hardware *);
 #endif
 int interfaces_send_helper(struct lldpd *,
     struct lldpd_hardware *, char *, size_t);
 
-void interfaces_setup_multicast(struct lldpd *, const char *, int);
+void interfaces_setup_multicast(struct lldpd *, const char *, const char *, int);
 int interfaces_routing_enabled(struct lldpd *);
 void interfaces_cleanup(struct lldpd *);
 
@@ -377,6 +481,7 @@ void interfaces_cleanup(struct lldpd *);
 /* netlink.c */
 struct interfaces_device_list  *netlink_get_interfaces(struct lldpd *);
 struct interfaces_address_list *netlink_get_addresses(struct lldpd *);
+int netlink_ioctl_socket(struct lldpd *, int);
 void netlink_cleanup(struct lldpd *);
 struct lldpd_netlink;
 #endif
@@ -386,7 +491,12 @@ int ifbpf_phys_init(struct lldpd *, struct lldpd_hardware *);
 #endif
 
 /* pattern.c */
+struct pattern;
 int pattern_match(char *, char *, int);
+struct pattern *pattern_compile(const char *);
+int pattern_match_compiled(struct pattern *, const char *, int);
+int pattern_match_fast(struct pattern *, char *, char *, int);
+void pattern_free(struct pattern *);
 
 struct lldpd {
 	int			 g_sock;
@@ -395,14 +505,26 @@ struct lldpd {
 #endif
 
 	struct lldpd_config	 g_config;
+	/* Compiled patterns from configuration, see lldpd_compile_patterns() */
+	struct pattern		*g_iface_pattern;
+	struct pattern		*g_perm_ifaces;
+	struct pattern		*g_mgmt_pattern;
+	struct pattern		*g_cid_pattern;
 
 	struct protocol		*g_protocols;
 	int			 g_lastrid;
 	struct event		*g_main_loop;
 	struct event		*g_cleanup_timer;
+	struct event		*g_hostname_timer; /* Check system name resolution */
+	struct event		*g_snapshot_timer; /* Publish a new snapshot */
+	struct lldpd_snapshot	*g_snapshot;
+	struct event		*g_state_timer; /* Save neighbors */
+	unsigned int		 g_state_generation; /* Generation when last saved */
+	struct lldpd_metrics	*g_metrics;
 #ifdef USE_SNMP
 	int			 g_snmp;
 	struct event		*g_snmp_timeout;
+	struct event		*g_snmp_notification; /* Delayed SNMP notification */
 	void			*g_snmp_fds;
 	const char		*g_snmp_agentx;
 #endif /* USE_SNMP */
@@ -412,15 +534,32 @@ struct lldpd {
 	int			 g_ctl;
 	struct event		*g_iface_event; /* Triggered when there is an interface change */
 	struct event		*g_iface_timer_event; /* Triggered one second after last interface change */
-	void(*g_iface_cb)(struct lldpd *);	      /* Called when there is an interface change */
+	void			*g_iface_fds; /* Additional sockets for interface changes */
+	void(*g_iface_cb)(struct lldpd *, int);	      /* Called when there is an interface change */
+	u_int64_t		 g_notif_coalesced; /* Notifications merged for slow clients */
+	u_int64_t		 g_notif_dropped;   /* Notifications dropped for slow clients */
 
 	char			*g_lsb_release;
+	int			 g_lsb_release_fd; /* Output of lsb_release being read */
+	pid_t			 g_lsb_release_pid;
+	struct timespec		 g_startup; /* Start time (monotonic) */
 
 #ifdef HOST_OS_LINUX
 	struct lldpd_netlink	*g_netlink;
+	char			**g_netns; /* Additional network namespaces (NULL-terminated) */
 #endif
 
 	struct lldpd_port	*g_default_local_port;
+	unsigned int		 g_generation; /* Bumped when ports or neighbors change */
+	unsigned int		 g_local_generation; /* Bumped when local addresses or VLANs are rebuilt */
+	struct lldpd_decode	*g_decode;     /* Decoding threads */
+
+	/* Global statistics, kept when an interface is removed */
+	u_int64_t		 g_insert_cnt;
+	u_int64_t		 g_delete_cnt;
+	u_int64_t		 g_ageout_cnt;
+	u_int64_t		 g_drop_cnt;
+	struct lldpd_latency	 g_latency[LATENCY_LAST];
 #define LOCAL_CHASSIS(cfg) ((struct lldpd_chassis *)(TAILQ_FIRST(&cfg->g_chassis)))
 	TAILQ_HEAD(, lldpd_chassis) g_chassis;
 	TAILQ_HEAD(, lldpd_hardware) g_hardware;
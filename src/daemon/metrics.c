@@ -0,0 +1,539 @@
+/* -*- mode: c; c-file-style: "openbsd" -*- */
+/*
+ * Copyright (c) 2019 Vincent Bernat <vincent@bernat.im>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* Export counters and gauges over HTTP, using OpenMetrics text format or
+ * Prometheus text format, depending on what the scraper accepts. The listening
+ * socket is created by the monitor. The answer is rendered a few ports at a
+ * time, when the output buffer is drained. */
+
+#include "lldpd.h"
+
+#include <unistd.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <inttypes.h>
+#include <stddef.h>
+#if defined(__clang__)
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wdocumentation"
+#endif
+#include <event2/event.h>
+#include <event2/bufferevent.h>
+#include <event2/buffer.h>
+#if defined(__clang__)
+#pragma clang diagnostic pop
+#endif
+
+#define METRICS_MAX_REQUEST 8192 /* Maximum size of an HTTP request */
+#define METRICS_MAX_SCRAPES 16	/* Maximum number of simultaneous scrapes */
+#define METRICS_CHUNK 64	/* Number of samples rendered at once */
+#define METRICS_LOW_WATER 4096	/* Render more samples below this size */
+#define METRICS_TIMEOUT 10	/* Timeout for a scrape, in seconds */
+
+struct metrics_scrape {
+	TAILQ_ENTRY(metrics_scrape) next;
+	struct lldpd_metrics *metrics;
+	struct bufferevent *bev;
+	int openmetrics;	/* OpenMetrics format requested */
+	int metric;		/* Next metric to render, -1 until requested */
+	int position;		/* Index of the next port for this metric */
+	struct lldpd_hardware *hardware; /* Next port, NULL if unknown */
+	int done;		/* Everything has been rendered */
+};
+
+struct lldpd_metrics {
+	struct lldpd *cfg;
+	int fd;
+	struct event *listener;
+	struct event *probe;	/* Measure event loop lag */
+	struct timespec expected; /* When the probe should fire */
+	u_int64_t lag;		/* Last measured lag, in microseconds */
+	int count;		/* Number of scrapes */
+	TAILQ_HEAD(, metrics_scrape) scrapes;
+};
+
+static u_int64_t
+metrics_port_neighbors(struct lldpd_metrics *m, struct lldpd_hardware *hardware)
+{
+	struct lldpd_port *port;
+	u_int64_t neighbors = 0;
+	TAILQ_FOREACH(port, &hardware->h_rports, p_entries)
+		neighbors++;
+	return neighbors;
+}
+
+static u_int64_t
+metrics_neighbors(struct lldpd_metrics *m, struct lldpd_hardware *unused)
+{
+	struct lldpd_hardware *hardware;
+	u_int64_t neighbors = 0;
+	TAILQ_FOREACH(hardware, &m->cfg->g_hardware, h_entries)
+		neighbors += metrics_port_neighbors(m, hardware);
+	return neighbors;
+}
+
+static u_int64_t
+metrics_ports(struct lldpd_metrics *m, struct lldpd_hardware *unused)
+{
+	struct lldpd_hardware *hardware;
+	u_int64_t ports = 0;
+	TAILQ_FOREACH(hardware, &m->cfg->g_hardware, h_entries)
+		ports++;
+	return ports;
+}
+
+static u_int64_t
+metrics_chassis(struct lldpd_metrics *m, struct lldpd_hardware *unused)
+{
+	struct lldpd_chassis *chassis;
+	u_int64_t count = 0;
+	TAILQ_FOREACH(chassis, &m->cfg->g_chassis, c_entries)
+		count++;
+	return count - 1;	/* Local chassis */
+}
+
+static u_int64_t
+metrics_clients(struct lldpd_metrics *m, struct lldpd_hardware *unused)
+{
+	size_t clients, pending;
+	levent_ctl_stats(&clients, &pending);
+	return clients;
+}
+
+static u_int64_t
+metrics_pending(struct lldpd_metrics *m, struct lldpd_hardware *unused)
+{
+	size_t clients, pending;
+	levent_ctl_stats(&clients, &pending);
+	return pending;
+}
+
+static u_int64_t
+metrics_lag(struct lldpd_metrics *m, struct lldpd_hardware *unused)
+{
+	return m->lag;
+}
+
+#define GLOBAL_COUNTER(x)					\
+	static u_int64_t					\
+	metrics_##x(struct lldpd_metrics *m, struct lldpd_hardware *unused) \
+	{							\
+		return m->cfg->g_##x;				\
+	}
+GLOBAL_COUNTER(insert_cnt)
+GLOBAL_COUNTER(delete_cnt)
+GLOBAL_COUNTER(ageout_cnt)
+GLOBAL_COUNTER(drop_cnt)
+GLOBAL_COUNTER(notif_coalesced)
+GLOBAL_COUNTER(notif_dropped)
+
+#define PORT_COUNTER(x) 1, offsetof(struct lldpd_hardware, x), NULL
+#define PORT_GAUGE(f)   1, 0, f
+#define GLOBAL(f)       0, 0, f
+
+static struct metric {
+	const char *name;
+	const char *type;	/* "counter" or "gauge" */
+	const char *help;
+	int per_port;		/* One sample per port */
+	size_t offset;		/* Offset of the counter in struct lldpd_hardware */
+	u_int64_t(*value)(struct lldpd_metrics *, struct lldpd_hardware *);
+	int usec;		/* Value in microseconds, displayed in seconds */
+} metrics[] = {
+	{ "lldpd_ports", "gauge", "Number of local ports",
+	  GLOBAL(metrics_ports) },
+	{ "lldpd_neighbors", "gauge", "Number of neighbors",
+	  GLOBAL(metrics_neighbors) },
+	{ "lldpd_chassis", "gauge", "Number of remote chassis",
+	  GLOBAL(metrics_chassis) },
+	{ "lldpd_neighbors_inserted", "counter", "Neighbors inserted",
+	  GLOBAL(metrics_insert_cnt) },
+	{ "lldpd_neighbors_deleted", "counter", "Neighbors deleted",
+	  GLOBAL(metrics_delete_cnt) },
+	{ "lldpd_neighbors_aged_out", "counter", "Neighbors aged out",
+	  GLOBAL(metrics_ageout_cnt) },
+	{ "lldpd_neighbors_dropped", "counter",
+	  "Neighbors dropped because of a lack of resources",
+	  GLOBAL(metrics_drop_cnt) },
+	{ "lldpd_control_clients", "gauge", "Number of control clients",
+	  GLOBAL(metrics_clients) },
+	{ "lldpd_notifications_pending", "gauge",
+	  "Notifications waiting for slow control clients",
+	  GLOBAL(metrics_pending) },
+	{ "lldpd_notifications_coalesced", "counter",
+	  "Notifications merged for slow control clients",
+	  GLOBAL(metrics_notif_coalesced) },
+	{ "lldpd_notifications_dropped", "counter",
+	  "Notifications dropped for slow control clients",
+	  GLOBAL(metrics_notif_dropped) },
+	{ "lldpd_event_loop_lag_seconds", "gauge",
+	  "Delay of the last one-second timer of the event loop",
+	  GLOBAL(metrics_lag), 1 },
+	{ "lldpd_port_neighbors", "gauge", "Number of neighbors on a port",
+	  PORT_GAUGE(metrics_port_neighbors) },
+	{ "lldpd_port_tx_frames", "counter", "Frames transmitted on a port",
+	  PORT_COUNTER(h_tx_cnt) },
+	{ "lldpd_port_rx_frames", "counter", "Frames received on a port",
+	  PORT_COUNTER(h_rx_cnt) },
+	{ "lldpd_port_rx_discarded_frames", "counter",
+	  "Frames discarded on a port",
+	  PORT_COUNTER(h_rx_discarded_cnt) },
+	{ "lldpd_port_rx_unrecognized_frames", "counter",
+	  "Frames with unrecognized TLVs received on a port",
+	  PORT_COUNTER(h_rx_unrecognized_cnt) },
+	{ "lldpd_port_neighbors_aged_out", "counter",
+	  "Neighbors aged out on a port",
+	  PORT_COUNTER(h_ageout_cnt) },
+	{ "lldpd_port_neighbors_inserted", "counter",
+	  "Neighbors inserted on a port",
+	  PORT_COUNTER(h_insert_cnt) },
+	{ "lldpd_port_neighbors_deleted", "counter",
+	  "Neighbors deleted on a port",
+	  PORT_COUNTER(h_delete_cnt) },
+	{ "lldpd_port_neighbors_dropped", "counter",
+	  "Neighbors dropped on a port because of a lack of resources",
+	  PORT_COUNTER(h_drop_cnt) },
+	{ NULL }
+};
+
+static void
+metrics_free_scrape(struct metrics_scrape *scrape)
+{
+	TAILQ_REMOVE(&scrape->metrics->scrapes, scrape, next);
+	scrape->metrics->count--;
+	if (scrape->bev) bufferevent_free(scrape->bev);
+	free(scrape);
+}
+
+/* Render a sample. Label values are escaped as required. */
+static void
+metrics_render_sample(struct metrics_scrape *scrape, struct metric *metric,
+    struct lldpd_hardware *hardware)
+{
+	struct evbuffer *output = bufferevent_get_output(scrape->bev);
+	char label[(LLDPD_NETNS_NAMESIZ + IFNAMSIZ) * 2], *p = label;
+	const char *c;
+	u_int64_t value;
+
+	if (hardware) {
+		for (c = lldpd_hardware_name(hardware); *c; c++) {
+			if (*c == '\\' || *c == '"') *p++ = '\\';
+			if (*c == '\n') {
+				*p++ = '\\';
+				*p++ = 'n';
+			} else *p++ = *c;
+		}
+		*p = '\0';
+	}
+	if (metric->value)
+		value = metric->value(scrape->metrics, hardware);
+	else
+		value = *(u_int64_t *)((char *)hardware + metric->offset);
+	evbuffer_add_printf(output, "%s%s", metric->name,
+	    strcmp(metric->type, "counter")?"":"_total");
+	if (hardware)
+		evbuffer_add_printf(output, "{interface=\"%s\"}", label);
+	if (metric->usec)
+		evbuffer_add_printf(output, " %" PRIu64 ".%06" PRIu64 "\n",
+		    value / 1000000, value % 1000000);
+	else
+		evbuffer_add_printf(output, " %" PRIu64 "\n", value);
+}
+
+/* Render the next samples. */
+static void
+metrics_render(struct metrics_scrape *scrape)
+{
+	struct evbuffer *output = bufferevent_get_output(scrape->bev);
+	struct lldpd_hardware *hardware;
+	struct metric *metric;
+	int rendered = 0, i;
+
+	while (rendered < METRICS_CHUNK) {
+		metric = &metrics[scrape->metric];
+		if (metric->name == NULL) {
+			if (scrape->openmetrics)
+				evbuffer_add_printf(output, "# EOF\n");
+			scrape->done = 1;
+			/* Get notified when everything has been sent */
+			bufferevent_setwatermark(scrape->bev, EV_WRITE, 0, 0);
+			return;
+		}
+		if (scrape->position == 0) {
+			/* For OpenMetrics, the family of a counter does not
+			 * include the _total suffix. */
+			const char *suffix =
+			    (!scrape->openmetrics &&
+				!strcmp(metric->type, "counter"))?"_total":"";
+			evbuffer_add_printf(output,
+			    "# HELP %s%s %s.\n# TYPE %s%s %s\n",
+			    metric->name, suffix, metric->help,
+			    metric->name, suffix, metric->type);
+		}
+		if (!metric->per_port) {
+			metrics_render_sample(scrape, metric, NULL);
+			rendered++;
+			scrape->metric++;
+			continue;
+		}
+
+		/* Resume from the cursor. If the port it pointed to has been
+		 * removed since the last chunk, fall back to the index. In
+		 * this case, a port may be skipped or repeated. */
+		if (scrape->position == 0)
+			hardware = TAILQ_FIRST(&scrape->metrics->cfg->g_hardware);
+		else if ((hardware = scrape->hardware) == NULL) {
+			i = 0;
+			TAILQ_FOREACH(hardware, &scrape->metrics->cfg->g_hardware,
+			    h_entries)
+				if (i++ == scrape->position) break;
+		}
+		for (; hardware != NULL && rendered < METRICS_CHUNK;
+		     hardware = TAILQ_NEXT(hardware, h_entries)) {
+			metrics_render_sample(scrape, metric, hardware);
+			rendered++;
+			scrape->position++;
+		}
+		scrape->hardware = hardware;
+		if (hardware == NULL) {
+			scrape->metric++;
+			scrape->position = 0;
+		}
+	}
+}
+
+static void
+metrics_write(struct bufferevent *bev, void *ptr)
+{
+	struct metrics_scrape *scrape = ptr;
+	if (scrape->metric == -1) return;
+	if (scrape->done) {
+		if (evbuffer_get_length(bufferevent_get_output(bev)) == 0) {
+			log_debug("metrics", "scrape complete");
+			metrics_free_scrape(scrape);
+		}
+		return;
+	}
+	metrics_render(scrape);
+}
+
+static void
+metrics_read(struct bufferevent *bev, void *ptr)
+{
+	struct metrics_scrape *scrape = ptr;
+	struct evbuffer *input = bufferevent_get_input(bev);
+	struct evbuffer_ptr end;
+	char *line;
+	int get;
+
+	if ((end = evbuffer_search(input, "\r\n\r\n", 4, NULL)).pos == -1 &&
+	    (end = evbuffer_search(input, "\n\n", 2, NULL)).pos == -1) {
+		if (evbuffer_get_length(input) > METRICS_MAX_REQUEST) {
+			log_warnx("metrics", "request too large");
+			metrics_free_scrape(scrape);
+		}
+		return;
+	}
+
+	/* Request line, then headers */
+	if ((line = evbuffer_readln(input, NULL, EVBUFFER_EOL_CRLF)) == NULL) {
+		metrics_free_scrape(scrape);
+		return;
+	}
+	get = !strncmp(line, "GET ", 4);
+	free(line);
+	while ((line = evbuffer_readln(input, NULL, EVBUFFER_EOL_CRLF)) != NULL &&
+	    *line != '\0') {
+		if (!strncasecmp(line, "Accept:", 7) &&
+		    strstr(line, "application/openmetrics-text"))
+			scrape->openmetrics = 1;
+		free(line);
+	}
+	free(line);
+	bufferevent_disable(bev, EV_READ);
+
+	if (!get) {
+		log_debug("metrics", "unsupported request");
+		evbuffer_add_printf(bufferevent_get_output(bev),
+		    "HTTP/1.0 405 Method Not Allowed\r\n"
+		    "Allow: GET\r\n"
+		    "Connection: close\r\n\r\n");
+		scrape->metric = 0;
+		scrape->done = 1;
+		bufferevent_setwatermark(bev, EV_WRITE, 0, 0);
+		return;
+	}
+
+	log_debug("metrics", "render metrics in %s format",
+	    scrape->openmetrics?"OpenMetrics":"Prometheus");
+	evbuffer_add_printf(bufferevent_get_output(bev),
+	    "HTTP/1.0 200 OK\r\n"
+	    "Content-Type: %s\r\n"
+	    "Connection: close\r\n\r\n",
+	    scrape->openmetrics?
+	    "application/openmetrics-text; version=1.0.0; charset=utf-8":
+	    "text/plain; version=0.0.4; charset=utf-8");
+	scrape->metric = 0;
+	metrics_render(scrape);
+}
+
+static void
+metrics_event(struct bufferevent *bev, short events, void *ptr)
+{
+	struct metrics_scrape *scrape = ptr;
+	if (events & BEV_EVENT_TIMEOUT)
+		log_debug("metrics", "scrape timeout");
+	metrics_free_scrape(scrape);
+}
+
+static void
+metrics_accept(evutil_socket_t fd, short what, void *arg)
+{
+	struct lldpd_metrics *m = arg;
+	struct metrics_scrape *scrape;
+	struct timeval tv = { METRICS_TIMEOUT, 0 };
+	int s;
+
+	if ((s = accept(fd, NULL, NULL)) == -1) {
+		log_warn("metrics", "unable to accept connection");
+		return;
+	}
+	if (m->count >= METRICS_MAX_SCRAPES) {
+		log_warnx("metrics", "too many simultaneous scrapes");
+		close(s);
+		return;
+	}
+	if ((scrape = calloc(1, sizeof(struct metrics_scrape))) == NULL) {
+		log_warn("metrics", "unable to allocate memory for scrape");
+		close(s);
+		return;
+	}
+	scrape->metrics = m;
+	scrape->metric = -1;
+	TAILQ_INSERT_TAIL(&m->scrapes, scrape, next);
+	m->count++;
+	levent_make_socket_nonblocking(s);
+	if ((scrape->bev = bufferevent_socket_new(m->cfg->g_base, s,
+		    BEV_OPT_CLOSE_ON_FREE)) == NULL) {
+		log_warnx("metrics", "unable to allocate a new buffer event for scrape");
+		close(s);
+		metrics_free_scrape(scrape);
+		return;
+	}
+	bufferevent_setcb(scrape->bev,
+	    metrics_read, metrics_write, metrics_event,
+	    scrape);
+	bufferevent_setwatermark(scrape->bev, EV_WRITE, METRICS_LOW_WATER, 0);
+	bufferevent_set_timeouts(scrape->bev, &tv, &tv);
+	bufferevent_enable(scrape->bev, EV_READ | EV_WRITE);
+	log_debug("metrics", "new scrape accepted");
+}
+
+static void
+metrics_probe_schedule(struct lldpd_metrics *m)
+{
+	struct timeval tv = { 1, 0 };
+	clock_gettime(CLOCK_MONOTONIC, &m->expected);
+	m->expected.tv_sec++;
+	if (event_add(m->probe, &tv) == -1)
+		log_warnx("metrics", "unable to schedule event loop probe");
+}
+
+/* Measure how late a one-second timer fires. */
+static void
+metrics_probe(evutil_socket_t fd, short what, void *arg)
+{
+	struct lldpd_metrics *m = arg;
+	struct timespec now;
+	int64_t lag;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	lag = (now.tv_sec - m->expected.tv_sec) * 1000000 +
+	    (now.tv_nsec - m->expected.tv_nsec) / 1000;
+	m->lag = (lag > 0)?lag:0;
+	metrics_probe_schedule(m);
+}
+
+void
+metrics_open(struct lldpd *cfg)
+{
+	struct lldpd_metrics *m;
+	int fd;
+
+	if (cfg->g_metrics) return;
+	if (cfg->g_config.c_metrics_port)
+		log_debug("metrics", "export metrics on 127.0.0.1:%d",
+		    cfg->g_config.c_metrics_port);
+	else
+		log_debug("metrics", "export metrics on " LLDPD_METRICS_SOCKET);
+	if ((fd = priv_metrics(cfg->g_config.c_metrics_port)) == -1) {
+		log_warnx("metrics", "unable to create socket for metrics");
+		return;
+	}
+	if ((m = calloc(1, sizeof(struct lldpd_metrics))) == NULL) {
+		log_warn("metrics", "unable to allocate memory for metrics");
+		close(fd);
+		priv_metrics(-1);
+		return;
+	}
+	m->cfg = cfg;
+	m->fd = fd;
+	TAILQ_INIT(&m->scrapes);
+	levent_make_socket_nonblocking(fd);
+	if ((m->listener = event_new(cfg->g_base, fd, EV_READ | EV_PERSIST,
+		    metrics_accept, m)) == NULL ||
+	    event_add(m->listener, NULL) == -1 ||
+	    (m->probe = evtimer_new(cfg->g_base, metrics_probe, m)) == NULL) {
+		log_warnx("metrics", "unable to setup events for metrics");
+		cfg->g_metrics = m;
+		metrics_close(cfg);
+		return;
+	}
+	metrics_probe_schedule(m);
+	cfg->g_metrics = m;
+}
+
+/**
+ * Forget about a port being removed. Scrapes about to render it will
+ * locate their next port by its index instead.
+ */
+void
+metrics_forget(struct lldpd *cfg, struct lldpd_hardware *hardware)
+{
+	struct metrics_scrape *scrape;
+
+	if (!cfg->g_metrics) return;
+	TAILQ_FOREACH(scrape, &cfg->g_metrics->scrapes, next)
+		if (scrape->hardware == hardware) scrape->hardware = NULL;
+}
+
+void
+metrics_close(struct lldpd *cfg)
+{
+	struct lldpd_metrics *m = cfg->g_metrics;
+
+	if (!m) return;
+	log_debug("metrics", "stop exporting metrics");
+	while (!TAILQ_EMPTY(&m->scrapes))
+		metrics_free_scrape(TAILQ_FIRST(&m->scrapes));
+	if (m->listener) event_free(m->listener);
+	if (m->probe) event_free(m->probe);
+	close(m->fd);
+	free(m);
+	cfg->g_metrics = NULL;
+	priv_metrics(-1);
+}
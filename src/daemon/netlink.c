@@ -33,9 +33,21 @@ struct netlink_req {
 	struct rtgenmsg gen;
 };
 
-struct lldpd_netlink {
+/* One for each network namespace we are listening to. The first one is the
+ * namespace of lldpd. */
+struct lldpd_netlink_ns {
+	int id;			/* Encoded in interface indexes */
 	int nl_socket;
 	int nl_socket_recv_size;
+	int sock;		/* For ioctl() */
+	int warned;		/* Opening the namespace already failed */
+	dev_t dev;		/* Device and inode of the namespace when */
+	ino_t ino;		/* it was opened */
+};
+
+struct lldpd_netlink {
+	struct lldpd_netlink_ns ns[1 + LLDPD_NETNS_MAX];
+	int ns_count;
 	/* Cache */
 	struct interfaces_device_list *devices;
 	struct interfaces_address_list *addresses;
@@ -83,12 +95,14 @@ netlink_socket_set_buffer_size(int s, int optname, const char *optname_str, int
  *
  * Open a Netlink socket and connect to it.
  *
+ * @param ns       Network namespace to use
  * @param protocol Which protocol to use (eg NETLINK_ROUTE).
  * @param groups   Which groups we want to subscribe to
  * @return 0 on success, -1 otherwise
  */
 static int
-netlink_connect(struct lldpd *cfg, int protocol, unsigned groups)
+netlink_connect(struct lldpd *cfg, struct lldpd_netlink_ns *ns,
+    int protocol, unsigned groups)
 {
 	int s;
 	struct sockaddr_nl local = {
@@ -99,9 +113,14 @@ netlink_connect(struct lldpd *cfg, int protocol, unsigned groups)
 
 	/* Open Netlink socket */
 	log_debug("netlink", "opening netlink socket");
-	s = socket(AF_NETLINK, SOCK_RAW, protocol);
+	if (ns->id == 0)
+		s = socket(AF_NETLINK, SOCK_RAW, protocol);
+	else
+		s = priv_netns_socket(cfg->g_netns[ns->id - 1],
+		    AF_NETLINK, SOCK_RAW, protocol);
 	if (s == -1) {
-		log_warn("netlink", "unable to open netlink socket");
+		if (ns->id == 0 || !ns->warned)
+			log_warn("netlink", "unable to open netlink socket");
 		return -1;
 	}
 	if (NETLINK_SEND_BUFSIZE &&
@@ -113,15 +132,15 @@ netlink_connect(struct lldpd *cfg, int protocol, unsigned groups)
 	    SO_RCVBUF, "SO_RCVBUF", NETLINK_RECEIVE_BUFSIZE);
 	switch (rc) {
 	case -1: return -1;
-	case -2: cfg->g_netlink->nl_socket_recv_size = 0; break;
-	default: cfg->g_netlink->nl_socket_recv_size = rc; break;
+	case -2: ns->nl_socket_recv_size = 0; break;
+	default: ns->nl_socket_recv_size = rc; break;
 	}
 	if (groups && bind(s, (struct sockaddr *)&local, sizeof(struct sockaddr_nl)) < 0) {
 		log_warn("netlink", "unable to bind netlink socket");
 		close(s);
 		return -1;
 	}
-	cfg->g_netlink->nl_socket = s;
+	ns->nl_socket = s;
 	return 0;
 }
 
@@ -238,13 +257,14 @@ netlink_parse_linkinfo(struct interfaces_device *iff, struct rtattr *rta, int le
 /**
  * Parse a `link` netlink message.
  *
- * @param msg  message to be parsed
- * @param iff  where to put the result
+ * @param msg   message to be parsed
+ * @param iff   where to put the result
+ * @param netns identifier of the network namespace of the interface
  * return 0 if the interface is worth it, -1 otherwise
  */
 static int
 netlink_parse_link(struct nlmsghdr *msg,
-    struct interfaces_device *iff)
+    struct interfaces_device *iff, int netns)
 {
 	struct ifinfomsg *ifi;
 	struct rtattr *attribute;
@@ -333,6 +353,20 @@ netlink_parse_link(struct nlmsghdr *msg,
 		return -1;
 	}
 
+	if (netns != 0) {
+		/* Make the index unique across network namespaces */
+		if (iff->index >= (1 << LLDPD_NETNS_SHIFT)) {
+			log_info("netlink", "index of %s is too large, skip",
+			    iff->name);
+			return -1;
+		}
+		iff->index = LLDPD_IFINDEX(netns, iff->index);
+		if (iff->lower_idx != -1)
+			iff->lower_idx = LLDPD_IFINDEX(netns, iff->lower_idx);
+		if (iff->upper_idx != -1)
+			iff->upper_idx = LLDPD_IFINDEX(netns, iff->upper_idx);
+	}
+
 	log_debug("netlink", "parsed link %d (%s, flags: %d)",
 	    iff->index, iff->name, iff->flags);
 	return 0;
@@ -433,19 +467,21 @@ netlink_merge(struct interfaces_device *old, struct interfaces_device *new)
 /**
  * Receive netlink answer from the kernel.
  *
+ * @param ns   network namespace to receive from
  * @param ifs  list to store interface list or NULL if we don't
  * @param ifas list to store address list or NULL if we don't
  * @return     0 on success, -1 on error
  */
 static int
 netlink_recv(struct lldpd *cfg,
+    struct lldpd_netlink_ns *ns,
     struct interfaces_device_list *ifs,
     struct interfaces_address_list *ifas)
 {
 	int end = 0, ret = 0, flags, retry = 0;
 	struct iovec iov;
 	int link_update = 0;
-	int s = cfg->g_netlink->nl_socket;
+	int s = ns->nl_socket;
 
 	struct interfaces_device *ifdold;
 	struct interfaces_device *ifdnew;
@@ -483,7 +519,7 @@ retry:
 				ret = 0;
 				goto out;
 			}
-			int rsize = cfg->g_netlink->nl_socket_recv_size;
+			int rsize = ns->nl_socket_recv_size;
 			if (errno == ENOBUFS &&
 			    rsize > 0 && rsize < NETLINK_MAX_RECEIVE_BUFSIZE) {
 				/* Try to increase buffer size */
@@ -495,9 +531,9 @@ retry:
 				    SO_RCVBUF, "SO_RCVBUF",
 				    rsize);
 				if (rc < 0)
-					cfg->g_netlink->nl_socket_recv_size = 0;
+					ns->nl_socket_recv_size = 0;
 				else
-					cfg->g_netlink->nl_socket_recv_size = rsize;
+					ns->nl_socket_recv_size = rsize;
 				if (rc > 0 || rc == -2) {
 					log_info("netlink",
 					    "netlink receive buffer too small, retry with larger one (%d)",
@@ -559,7 +595,7 @@ retry:
 					log_warn("netlink", "not enough memory for another interface, give up what we have");
 					goto end;
 				}
-				if (netlink_parse_link(msg, ifdnew) == 0) {
+				if (netlink_parse_link(msg, ifdnew, ns->id) == 0) {
 					/* We need to find if we already have this interface */
 					TAILQ_FOREACH(ifdold, ifs, next) {
 						if (ifdold->index == ifdnew->index) break;
@@ -719,34 +755,150 @@ netlink_group_mask(int group)
 }
 
 /**
- * Subscribe to link changes.
+ * Subscribe to link changes. Address changes are only tracked for the
+ * namespace of lldpd.
  *
  * @return 0 on success, -1 otherwise
  */
 static int
-netlink_subscribe_changes(struct lldpd *cfg)
+netlink_subscribe_changes(struct lldpd *cfg, struct lldpd_netlink_ns *ns)
 {
 	unsigned int groups;
 
 	log_debug("netlink", "listening on interface changes");
 
-	groups = netlink_group_mask(RTNLGRP_LINK) |
-	    netlink_group_mask(RTNLGRP_IPV4_IFADDR) |
-	    netlink_group_mask(RTNLGRP_IPV6_IFADDR);
+	groups = netlink_group_mask(RTNLGRP_LINK);
+	if (ns->id == 0)
+		groups |= netlink_group_mask(RTNLGRP_IPV4_IFADDR) |
+		    netlink_group_mask(RTNLGRP_IPV6_IFADDR);
 
-	return netlink_connect(cfg, NETLINK_ROUTE, groups);
+	return netlink_connect(cfg, ns, NETLINK_ROUTE, groups);
 }
 
 /**
  * Receive changes from netlink */
 static void
-netlink_change_cb(struct lldpd *cfg)
+netlink_change_cb(struct lldpd *cfg, int fd)
 {
+	int i;
 	if (cfg->g_netlink == NULL)
 		return;
-	netlink_recv(cfg,
-	    cfg->g_netlink->devices,
-	    cfg->g_netlink->addresses);
+	for (i = 0; i < cfg->g_netlink->ns_count; i++) {
+		struct lldpd_netlink_ns *ns = &cfg->g_netlink->ns[i];
+		if (ns->nl_socket != fd) continue;
+		netlink_recv(cfg, ns,
+		    cfg->g_netlink->devices,
+		    (ns->id == 0)?cfg->g_netlink->addresses:NULL);
+		return;
+	}
+}
+
+/**
+ * Close the sockets of a network namespace.
+ */
+static void
+netlink_close_ns(struct lldpd_netlink_ns *ns)
+{
+	if (ns->nl_socket != -1)
+		close(ns->nl_socket);
+	if (ns->id != 0 && ns->sock != -1)
+		close(ns->sock);
+	ns->nl_socket = ns->sock = -1;
+}
+
+/**
+ * Stop listening to an additional network namespace. Its interfaces are
+ * removed from the cache, so its ports are removed on this update. This
+ * releases the sockets keeping the namespace alive.
+ */
+static void
+netlink_forget_ns(struct lldpd *cfg, struct lldpd_netlink_ns *ns)
+{
+	struct interfaces_device *iff, *iff_next;
+
+	if (ns->nl_socket != -1)
+		levent_iface_unsubscribe(cfg, ns->nl_socket);
+	netlink_close_ns(ns);
+	for (iff = TAILQ_FIRST(cfg->g_netlink->devices);
+	     iff != NULL;
+	     iff = iff_next) {
+		iff_next = TAILQ_NEXT(iff, next);
+		if (LLDPD_IFINDEX_NETNS(iff->index) != ns->id) continue;
+		TAILQ_REMOVE(cfg->g_netlink->devices, iff, next);
+		interfaces_free_device(iff);
+	}
+	ns->warned = 0;
+}
+
+/**
+ * Check an additional network namespace we listen to is still the one
+ * registered with its name. When it has been deleted or replaced, we stop
+ * listening to it. It is opened again on next update.
+ *
+ * @return 0 if the namespace is unchanged or not opened, -1 otherwise
+ */
+static int
+netlink_check_ns(struct lldpd *cfg, struct lldpd_netlink_ns *ns)
+{
+	const char *name = cfg->g_netns[ns->id - 1];
+	dev_t dev;
+	ino_t ino;
+
+	if (ns->nl_socket == -1) return 0;
+	if (priv_netns_stat(name, &dev, &ino) == 0 &&
+	    dev == ns->dev && ino == ns->ino)
+		return 0;
+	log_info("netlink", "network namespace %s has been removed or replaced",
+	    name);
+	netlink_forget_ns(cfg, ns);
+	return -1;
+}
+
+/**
+ * Start listening to an additional network namespace.
+ *
+ * When the namespace cannot be opened (for example, it does not exist yet), a
+ * warning is logged the first time and we will try again on next update.
+ *
+ * @return 0 on success, -1 otherwise
+ */
+static int
+netlink_initialize_ns(struct lldpd *cfg, struct lldpd_netlink_ns *ns)
+{
+	const char *name = cfg->g_netns[ns->id - 1];
+
+	if (ns->nl_socket != -1) return 0;
+	if (!ns->warned)
+		log_debug("netlink", "listen to interfaces from network namespace %s",
+		    name);
+	/* If the namespace is replaced after this point, the next check
+	 * notices it. */
+	if (priv_netns_stat(name, &ns->dev, &ns->ino) == -1 ||
+	    (ns->sock = priv_netns_socket(name, AF_INET, SOCK_DGRAM, 0)) == -1) {
+		if (!ns->warned)
+			log_warn("netlink", "unable to open network namespace %s",
+			    name);
+		goto end;
+	}
+	if (netlink_subscribe_changes(cfg, ns) == -1 ||
+	    netlink_send(ns->nl_socket, RTM_GETLINK, AF_PACKET, 2) == -1) {
+		if (!ns->warned)
+			log_warnx("netlink", "unable to get interfaces from network namespace %s",
+			    name);
+		goto end;
+	}
+	netlink_recv(cfg, ns, cfg->g_netlink->devices, NULL);
+	if (levent_iface_subscribe(cfg, ns->nl_socket) == -1)
+		goto end;
+	if (ns->warned)
+		log_info("netlink", "network namespace %s is now available",
+		    name);
+	ns->warned = 0;
+	return 0;
+end:
+	netlink_close_ns(ns);
+	ns->warned = 1;
+	return -1;
 }
 
 /**
@@ -766,10 +918,18 @@ netlink_initialize(struct lldpd *cfg)
 		log_warn("netlink", "unable to allocate memory for netlink subsystem");
 		goto end;
 	}
+	cfg->g_netlink->ns_count = 1;
+	for (char **netns = cfg->g_netns; netns && *netns; netns++)
+		cfg->g_netlink->ns_count++;
+	for (int i = 0; i < cfg->g_netlink->ns_count; i++) {
+		cfg->g_netlink->ns[i].id = i;
+		cfg->g_netlink->ns[i].nl_socket = -1;
+		cfg->g_netlink->ns[i].sock = (i == 0)?cfg->g_sock:-1;
+	}
 
 	/* Connect to netlink (by requesting to get notified on updates) and
 	 * request updated information right now */
-	if (netlink_subscribe_changes(cfg) == -1)
+	if (netlink_subscribe_changes(cfg, &cfg->g_netlink->ns[0]) == -1)
 		goto end;
 
 	struct interfaces_address_list *ifaddrs = cfg->g_netlink->addresses =
@@ -788,16 +948,16 @@ netlink_initialize(struct lldpd *cfg)
 	}
 	TAILQ_INIT(ifs);
 
-	if (netlink_send(cfg->g_netlink->nl_socket, RTM_GETADDR, AF_UNSPEC, 1) == -1)
+	if (netlink_send(cfg->g_netlink->ns[0].nl_socket, RTM_GETADDR, AF_UNSPEC, 1) == -1)
 		goto end;
-	netlink_recv(cfg, NULL, ifaddrs);
-	if (netlink_send(cfg->g_netlink->nl_socket, RTM_GETLINK, AF_PACKET, 2) == -1)
+	netlink_recv(cfg, &cfg->g_netlink->ns[0], NULL, ifaddrs);
+	if (netlink_send(cfg->g_netlink->ns[0].nl_socket, RTM_GETLINK, AF_PACKET, 2) == -1)
 		goto end;
-	netlink_recv(cfg, ifs, NULL);
+	netlink_recv(cfg, &cfg->g_netlink->ns[0], ifs, NULL);
 
 	/* Listen to any future change */
 	cfg->g_iface_cb = netlink_change_cb;
-	if (levent_iface_subscribe(cfg, cfg->g_netlink->nl_socket) == -1) {
+	if (levent_iface_subscribe(cfg, cfg->g_netlink->ns[0].nl_socket) == -1) {
 		goto end;
 	}
 
@@ -814,8 +974,8 @@ void
 netlink_cleanup(struct lldpd *cfg)
 {
 	if (cfg->g_netlink == NULL) return;
-	if (cfg->g_netlink->nl_socket != -1)
-		close(cfg->g_netlink->nl_socket);
+	for (int i = 0; i < cfg->g_netlink->ns_count; i++)
+		netlink_close_ns(&cfg->g_netlink->ns[i]);
 	interfaces_free_devices(cfg->g_netlink->devices);
 	interfaces_free_addresses(cfg->g_netlink->addresses);
 
@@ -832,6 +992,10 @@ struct interfaces_device_list*
 netlink_get_interfaces(struct lldpd *cfg)
 {
 	if (netlink_initialize(cfg) == -1) return NULL;
+	for (int i = 1; i < cfg->g_netlink->ns_count; i++) {
+		if (netlink_check_ns(cfg, &cfg->g_netlink->ns[i]) == 0)
+			netlink_initialize_ns(cfg, &cfg->g_netlink->ns[i]);
+	}
 	struct interfaces_device *ifd;
 	TAILQ_FOREACH(ifd, cfg->g_netlink->devices, next) {
 		ifd->ignore = 0;
@@ -839,6 +1003,20 @@ netlink_get_interfaces(struct lldpd *cfg)
 	return cfg->g_netlink->devices;
 }
 
+/**
+ * Get a socket suitable for ioctl() on the interface with the provided index.
+ *
+ * @return a socket in the network namespace of the interface
+ */
+int
+netlink_ioctl_socket(struct lldpd *cfg, int index)
+{
+	int id = LLDPD_IFINDEX_NETNS(index);
+	if (id == 0 || cfg->g_netlink == NULL || id >= cfg->g_netlink->ns_count)
+		return cfg->g_sock;
+	return cfg->g_netlink->ns[id].sock;
+}
+
 /**
  * Receive the list of addresses.
  *
@@ -78,3 +78,219 @@ pattern_match(char *string, char *patterns, int found)
 	free(patterns);
 	return found;
 }
+
+/* Compiled list of patterns. Patterns without any wildcard are put in a hash
+ * table, patterns with a single trailing `*` are matched as prefixes and the
+ * remaining ones are matched with `fnmatch()`. */
+
+enum {
+	PATTERN_EXACT,
+	PATTERN_PREFIX,
+	PATTERN_GLOB
+};
+
+struct pattern_element {
+	struct pattern_element *next;	/* Next element in the same bucket */
+	const char	*pattern;	/* Pattern without `!` or `!!` */
+	size_t		 len;		/* Length of the prefix */
+	u_int32_t	 hash;
+	int		 position;	/* Position in the original list */
+	int		 negated;	/* 1 for `!`, 2 for `!!` */
+};
+
+struct pattern {
+	char		 *buffer;	/* Copy of the patterns, split at commas */
+	struct pattern_element *elements;
+	int		  nwild;	/* Prefix and glob elements come first */
+	int		  nglobs;	/* Glob elements come last */
+	struct pattern_element **buckets; /* Exact elements */
+	u_int32_t	  nbuckets;
+};
+
+static u_int32_t
+pattern_hash(const char *str)
+{
+	u_int32_t hash = 2166136261U; /* FNV-1a */
+	while (*str) {
+		hash ^= (unsigned char)*str++;
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
+static int
+pattern_class(const char *pattern)
+{
+	size_t len = strcspn(pattern, "*?[\\");
+	if (pattern[len] == '\0') return PATTERN_EXACT;
+	if (pattern[len] == '*' && pattern[len + 1] == '\0') return PATTERN_PREFIX;
+	return PATTERN_GLOB;
+}
+
+/**
+ * Compile a list of patterns.
+ *
+ * @param patterns List of comma separated patterns, as accepted by
+ *                 `pattern_match()`.
+ * @return A matcher to be used with `pattern_match_compiled()` and to be
+ *         released with `pattern_free()` or NULL if `patterns` is NULL or on
+ *         memory allocation error.
+ */
+struct pattern *
+pattern_compile(const char *patterns)
+{
+	struct pattern *p;
+	struct pattern_element *e;
+	char *token;
+	int i, count, negated, position;
+	int nexact = 0, nprefix = 0, nprefix_seen = 0, nglobs_seen = 0;
+
+	if (patterns == NULL) return NULL;
+	if ((p = calloc(1, sizeof(struct pattern))) == NULL ||
+	    (p->buffer = strdup(patterns)) == NULL)
+		goto fail;
+
+	/* Split at commas. Empty patterns are ignored. */
+	for (count = 1, token = p->buffer; *token; token++)
+		if (*token == ',') {
+			*token = '\0';
+			count++;
+		}
+	for (i = 0, token = p->buffer; i < count; i++, token += strlen(token) + 1) {
+		if (*token == '\0') continue;
+		negated = (token[0] != '!')?0:(token[1] == '!')?2:1;
+		switch (pattern_class(token + negated)) {
+		case PATTERN_EXACT:  nexact++;   break;
+		case PATTERN_PREFIX: nprefix++;  break;
+		default:             p->nglobs++;
+		}
+	}
+	p->nwild = nprefix + p->nglobs;
+	if ((p->elements = calloc(p->nwild + nexact + 1,
+		    sizeof(struct pattern_element))) == NULL)
+		goto fail;
+	if (nexact > 0) {
+		for (p->nbuckets = 1; p->nbuckets < 2 * nexact; p->nbuckets <<= 1);
+		if ((p->buckets = calloc(p->nbuckets,
+			    sizeof(struct pattern_element *))) == NULL)
+			goto fail;
+	}
+
+	/* Prefix elements are put first, then glob elements and exact
+	 * elements in the hash table. */
+	for (i = 0, position = 0, token = p->buffer;
+	     i < count;
+	     i++, token += strlen(token) + 1) {
+		if (*token == '\0') continue;
+		negated = (token[0] != '!')?0:(token[1] == '!')?2:1;
+		switch (pattern_class(token + negated)) {
+		case PATTERN_EXACT:
+			e = &p->elements[p->nwild + --nexact];
+			e->hash = pattern_hash(token + negated);
+			e->next = p->buckets[e->hash & (p->nbuckets - 1)];
+			p->buckets[e->hash & (p->nbuckets - 1)] = e;
+			break;
+		case PATTERN_PREFIX:
+			e = &p->elements[nprefix_seen++];
+			e->len = strlen(token + negated) - 1;
+			break;
+		default:
+			e = &p->elements[nprefix + nglobs_seen++];
+		}
+		e->pattern = token + negated;
+		e->negated = negated;
+		e->position = position++;
+	}
+	return p;
+
+fail:
+	log_warnx("interfaces", "unable to allocate memory");
+	pattern_free(p);
+	return NULL;
+}
+
+void
+pattern_free(struct pattern *p)
+{
+	if (p == NULL) return;
+	free(p->buckets);
+	free(p->elements);
+	free(p->buffer);
+	free(p);
+}
+
+/**
+ * Match a compiled list of patterns.
+ *
+ * Return the same result as `pattern_match()` with the original list of
+ * patterns, except for strings starting with `!` which may match a negated
+ * pattern as a regular one with `pattern_match()`. A NULL matcher never
+ * matches.
+ */
+int
+pattern_match_compiled(struct pattern *p, const char *string, int found)
+{
+	struct pattern_element *e, *whitelisted = NULL;
+	int i, exact, blacklisted = 0;
+	found = !!found;
+
+	if (p == NULL) return 0;
+
+#define PATTERN_MATCHED(e, exact)	do {				\
+		switch ((e)->negated) {					\
+		case 2:							\
+			/* The first whitelisting pattern wins */	\
+			if (whitelisted == NULL ||			\
+			    (e)->position < whitelisted->position)	\
+				whitelisted = (e);			\
+			break;						\
+		case 1:							\
+			blacklisted = 1;				\
+			break;						\
+		default:						\
+			if (exact) found = 2;				\
+			else if (found < 2) found = 1;			\
+		}							\
+	} while (0)
+
+	for (i = 0; i < p->nwild; i++) {
+		e = &p->elements[i];
+		if (i < p->nwild - p->nglobs) {
+			if (strncmp(e->pattern, string, e->len)) continue;
+		} else if (fnmatch(e->pattern, string, 0)) continue;
+		exact = !strcmp(e->pattern, string);
+		PATTERN_MATCHED(e, exact);
+	}
+	if (p->nbuckets > 0) {
+		u_int32_t hash = pattern_hash(string);
+		for (e = p->buckets[hash & (p->nbuckets - 1)];
+		     e != NULL;
+		     e = e->next) {
+			if (e->hash != hash || strcmp(e->pattern, string)) continue;
+			PATTERN_MATCHED(e, 1);
+		}
+	}
+#undef PATTERN_MATCHED
+
+	if (whitelisted)
+		return strcmp(whitelisted->pattern, string)?1:2;
+	if (blacklisted)
+		return 0;
+	return found;
+}
+
+/**
+ * Match a list of patterns using its compiled form when available.
+ *
+ * @param p        Compiled form of `patterns`, NULL if compilation failed.
+ * @param patterns List of patterns, as accepted by `pattern_match()`.
+ *
+ * A failed compilation falls back to `pattern_match()` instead of
+ * considering that nothing matches.
+ */
+int
+pattern_match_fast(struct pattern *p, char *patterns, char *string, int found)
+{
+	if (p == NULL) return pattern_match(string, patterns, found);
+	return pattern_match_compiled(p, string, found);
+}
@@ -27,7 +27,7 @@
 #include <string.h>
 
 int
-asroot_iface_init_os(int ifindex, char *name, int *fd)
+asroot_iface_init_os(int ifindex, char *name, const char *netns, int *fd)
 {
 	int enable, required, rc;
 	struct bpf_insn filter[] = { LLDPD_FILTER_F };
@@ -210,7 +210,7 @@ asroot_iface_description_os(const char *name, const char *description)
 }
 
 int
-asroot_iface_promisc_os(const char *name)
+asroot_iface_promisc_os(const char *name, const char *netns)
 {
 	/* The promiscuous mode can be set when setting BPF
 	   (BIOCPROMISC). Unfortunately, the interface is locked down and we
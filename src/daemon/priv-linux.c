@@ -24,6 +24,7 @@
 #include <fcntl.h>
 #include <errno.h>
 #include <regex.h>
+#include <sched.h>
 #include <sys/ioctl.h>
 #include <netpacket/packet.h> /* For sockaddr_ll */
 #if defined(__clang__)
@@ -33,6 +34,7 @@
 #include <linux/filter.h>     /* For BPF filtering */
 #include <linux/sockios.h>
 #include <linux/if_ether.h>
+#include <linux/netlink.h>
 #if defined(__clang__)
 #pragma clang diagnostic pop
 #endif
@@ -54,6 +56,147 @@ priv_open(char *file)
 	return receive_fd(PRIV_UNPRIVILEGED);
 }
 
+/* Proxy to get a socket in another network namespace. Only netlink route
+ * sockets and sockets suitable for ioctl() are allowed. */
+int
+priv_netns_socket(const char *netns, int domain, int type, int protocol)
+{
+	int rc;
+	char name[LLDPD_NETNS_NAMESIZ] = {};
+	enum priv_cmd cmd = PRIV_NETNS_SOCKET;
+	strlcpy(name, netns, sizeof(name));
+	must_write(PRIV_UNPRIVILEGED, &cmd, sizeof(enum priv_cmd));
+	must_write(PRIV_UNPRIVILEGED, name, sizeof(name));
+	must_write(PRIV_UNPRIVILEGED, &domain, sizeof(int));
+	must_write(PRIV_UNPRIVILEGED, &type, sizeof(int));
+	must_write(PRIV_UNPRIVILEGED, &protocol, sizeof(int));
+	priv_wait();
+	must_read(PRIV_UNPRIVILEGED, &rc, sizeof(int));
+	if (rc != 0) {
+		errno = rc;
+		return -1;
+	}
+	return receive_fd(PRIV_UNPRIVILEGED);
+}
+
+/* Proxy to get the device and inode of a network namespace. They change
+ * when the namespace is deleted and created again. */
+int
+priv_netns_stat(const char *netns, dev_t *dev, ino_t *ino)
+{
+	int rc;
+	char name[LLDPD_NETNS_NAMESIZ] = {};
+	enum priv_cmd cmd = PRIV_NETNS_STAT;
+	strlcpy(name, netns, sizeof(name));
+	must_write(PRIV_UNPRIVILEGED, &cmd, sizeof(enum priv_cmd));
+	must_write(PRIV_UNPRIVILEGED, name, sizeof(name));
+	priv_wait();
+	must_read(PRIV_UNPRIVILEGED, &rc, sizeof(int));
+	if (rc != 0) {
+		errno = rc;
+		return -1;
+	}
+	must_read(PRIV_UNPRIVILEGED, dev, sizeof(dev_t));
+	must_read(PRIV_UNPRIVILEGED, ino, sizeof(ino_t));
+	return 0;
+}
+
+/* Files read on each update are kept open and read again from the start
+ * with pread(). Files not read since the last call to priv_read_expire() are
+ * closed. */
+struct priv_file {
+	TAILQ_ENTRY(priv_file) next;
+	int fd;
+	int used;
+	char path[];
+};
+static TAILQ_HEAD(, priv_file) priv_files = TAILQ_HEAD_INITIALIZER(priv_files);
+
+static ssize_t
+priv_read_fd(int fd, char *buffer, size_t len)
+{
+	ssize_t n;
+	size_t total = 0;
+	while (total < len) {
+		if ((n = pread(fd, buffer + total, len - total, total)) == -1) {
+			if (errno == EINTR) continue;
+			return -1;
+		}
+		if (n == 0) break;
+		total += n;
+	}
+	return total;
+}
+
+/**
+ * Read a file through a descriptor opened by the privileged process and kept
+ * open for the next calls.
+ *
+ * @param file   File to read, as for priv_open()
+ * @param buffer Buffer to store the content
+ * @param len    Size of the buffer
+ * @return Number of bytes read (the content is truncated if it is equal to
+ *         `len`) or -1 if the file cannot be opened or read.
+ */
+ssize_t
+priv_read(char *file, char *buffer, size_t len)
+{
+	struct priv_file *f;
+	ssize_t n;
+
+	TAILQ_FOREACH(f, &priv_files, next)
+		if (!strcmp(f->path, file)) break;
+	if (f != NULL) {
+		f->used = 1;
+		if ((n = priv_read_fd(f->fd, buffer, len)) != -1)
+			return n;
+		/* The file may have been removed and created again */
+		log_debug("privsep", "unable to read %s, open it again", file);
+		TAILQ_REMOVE(&priv_files, f, next);
+		close(f->fd);
+		free(f);
+	}
+
+	if ((f = calloc(1, sizeof(struct priv_file) + strlen(file) + 1)) == NULL) {
+		log_warn("privsep", "unable to allocate memory for %s", file);
+		return -1;
+	}
+	strcpy(f->path, file);
+	if ((f->fd = priv_open(file)) == -1) {
+		free(f);
+		return -1;
+	}
+	if (fcntl(f->fd, F_SETFD, FD_CLOEXEC) == -1)
+		log_warn("privsep", "unable to set close-on-exec flag for %s", file);
+	if ((n = priv_read_fd(f->fd, buffer, len)) == -1) {
+		log_debug("privsep", "unable to read %s", file);
+		close(f->fd);
+		free(f);
+		return -1;
+	}
+	f->used = 1;
+	TAILQ_INSERT_TAIL(&priv_files, f, next);
+	return n;
+}
+
+/* Close files not read since the last call. */
+void
+priv_read_expire(void)
+{
+	struct priv_file *f, *f_next;
+	for (f = TAILQ_FIRST(&priv_files); f != NULL; f = f_next) {
+		f_next = TAILQ_NEXT(f, next);
+		if (f->used) {
+			f->used = 0;
+			continue;
+		}
+		log_debug("privsep", "close %s, not read anymore", f->path);
+		TAILQ_REMOVE(&priv_files, f, next);
+		close(f->fd);
+		free(f);
+	}
+}
+
 void
 asroot_open()
 {
@@ -114,12 +257,124 @@ asroot_open()
 	close(fd);
 }
 
+/**
+ * Open a socket in a named network namespace.
+ *
+ * A socket stays attached to the namespace it was created in. Therefore, we
+ * only need to enter the namespace while creating the socket.
+ *
+ * @param netns Name of the namespace (in /var/run/netns). When NULL or empty,
+ *              the socket is created in the namespace of lldpd.
+ * @return the socket or -1 on error (errno is set)
+ */
+int
+asroot_netns_socket(const char *netns, int domain, int type, int protocol)
+{
+	static int self = -1;
+	char path[sizeof(LLDPD_NETNS_RUN) + LLDPD_NETNS_NAMESIZ];
+	int fd, s, serrno;
+
+	if (netns == NULL || netns[0] == '\0')
+		return socket(domain, type, protocol);
+	if (!asroot_netns_allowed(netns)) {
+		log_warnx("privsep", "network namespace %s was not allowed with -N",
+		    netns);
+		errno = EINVAL;
+		return -1;
+	}
+	if (self == -1 &&
+	    (self = open("/proc/self/ns/net", O_RDONLY | O_CLOEXEC)) == -1) {
+		serrno = errno;
+		log_warn("privsep", "unable to get current network namespace");
+		errno = serrno;
+		return -1;
+	}
+	snprintf(path, sizeof(path), LLDPD_NETNS_RUN "%s", netns);
+	if ((fd = open(path, O_RDONLY | O_CLOEXEC)) == -1) {
+		/* The namespace may appear later, the caller will tell */
+		serrno = errno;
+		log_debug("privsep", "unable to open network namespace %s", netns);
+		errno = serrno;
+		return -1;
+	}
+	if (setns(fd, CLONE_NEWNET) == -1) {
+		serrno = errno;
+		log_warn("privsep", "unable to enter network namespace %s", netns);
+		close(fd);
+		errno = serrno;
+		return -1;
+	}
+	close(fd);
+	s = socket(domain, type, protocol);
+	serrno = errno;
+	if (setns(self, CLONE_NEWNET) == -1)
+		fatal("privsep", "unable to come back to initial network namespace");
+	errno = serrno;
+	return s;
+}
+
+void
+asroot_netns()
+{
+	char netns[LLDPD_NETNS_NAMESIZ];
+	int domain, type, protocol, fd, rc;
+
+	must_read(PRIV_PRIVILEGED, netns, sizeof(netns));
+	netns[sizeof(netns) - 1] = '\0';
+	must_read(PRIV_PRIVILEGED, &domain, sizeof(int));
+	must_read(PRIV_PRIVILEGED, &type, sizeof(int));
+	must_read(PRIV_PRIVILEGED, &protocol, sizeof(int));
+
+	if (!(domain == AF_NETLINK && type == SOCK_RAW &&
+		protocol == NETLINK_ROUTE) &&
+	    !(domain == AF_INET && type == SOCK_DGRAM && protocol == 0)) {
+		log_warnx("privsep", "not authorized to open socket %d/%d/%d",
+		    domain, type, protocol);
+		rc = EPERM;
+		must_write(PRIV_PRIVILEGED, &rc, sizeof(int));
+		return;
+	}
+	if ((fd = asroot_netns_socket(netns, domain, type, protocol)) == -1) {
+		rc = errno;
+		must_write(PRIV_PRIVILEGED, &rc, sizeof(int));
+		return;
+	}
+	rc = 0;
+	must_write(PRIV_PRIVILEGED, &rc, sizeof(int));
+	send_fd(PRIV_PRIVILEGED, fd);
+	close(fd);
+}
+
+void
+asroot_netns_stat()
+{
+	char netns[LLDPD_NETNS_NAMESIZ];
+	char path[sizeof(LLDPD_NETNS_RUN) + LLDPD_NETNS_NAMESIZ];
+	struct stat st;
+	int rc = 0;
+
+	must_read(PRIV_PRIVILEGED, netns, sizeof(netns));
+	netns[sizeof(netns) - 1] = '\0';
+	if (!asroot_netns_allowed(netns)) {
+		log_warnx("privsep", "network namespace %s was not allowed with -N",
+		    netns);
+		rc = EPERM;
+	} else {
+		snprintf(path, sizeof(path), LLDPD_NETNS_RUN "%s", netns);
+		if (stat(path, &st) == -1) rc = errno;
+	}
+	must_write(PRIV_PRIVILEGED, &rc, sizeof(int));
+	if (rc != 0) return;
+	must_write(PRIV_PRIVILEGED, &st.st_dev, sizeof(dev_t));
+	must_write(PRIV_PRIVILEGED, &st.st_ino, sizeof(ino_t));
+}
+
 int
-asroot_iface_init_os(int ifindex, char *name, int *fd)
+asroot_iface_init_os(int ifindex, char *name, const char *netns, int *fd)
 {
 	int rc;
 	/* Open listening socket to receive/send frames */
-	if ((*fd = socket(PF_PACKET, SOCK_RAW,
+	if ((*fd = asroot_netns_socket(netns, PF_PACKET, SOCK_RAW,
 		    htons(ETH_P_ALL))) < 0) {
 		rc = errno;
 		return rc;
@@ -224,10 +479,10 @@ asroot_iface_description_os(const char *name, const char *description)
 }
 
 int
-asroot_iface_promisc_os(const char *name)
+asroot_iface_promisc_os(const char *name, const char *netns)
 {
 	int s, rc;
-	if ((s = socket(PF_PACKET, SOCK_RAW,
+	if ((s = asroot_netns_socket(netns, PF_PACKET, SOCK_RAW,
 		    htons(ETH_P_ALL))) < 0) {
 		rc = errno;
 		log_warn("privsep", "unable to open raw socket");
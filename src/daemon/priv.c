@@ -37,6 +37,8 @@
 #include <sys/utsname.h>
 #include <sys/ioctl.h>
 #include <netinet/if_ether.h>
+#include <poll.h>
+#include <time.h>
 
 #ifdef HAVE_LINUX_CAPABILITIES
 #include <sys/capability.h>
@@ -74,7 +76,9 @@ int res_init (void);
 
 #ifdef ENABLE_PRIVSEP
 static int monitored = -1;		/* Child */
+static gid_t monitored_gid = -1;	/* Group of the child */
 #endif
+static char **allowed_netns = NULL;	/* Network namespaces given with -N */
 
 /* Proxies */
 static void
@@ -101,15 +105,19 @@ priv_ctl_cleanup(const char *ctlname)
 	must_read(PRIV_UNPRIVILEGED, &rc, sizeof(int));
 }
 
-/* Proxy for gethostname */
+/* Proxy for gethostname. The name is resolved asynchronously: when `pending`
+ * is set, the returned name may change once the resolution is complete. When
+ * `refresh` is set, the cached name is not used. */
 char *
-priv_gethostname()
+priv_gethostname(int refresh, int *pending)
 {
 	static char *buf = NULL;
 	int rc;
 	enum priv_cmd cmd = PRIV_GET_HOSTNAME;
 	must_write(PRIV_UNPRIVILEGED, &cmd, sizeof(enum priv_cmd));
+	must_write(PRIV_UNPRIVILEGED, &refresh, sizeof(int));
 	priv_wait();
+	must_read(PRIV_UNPRIVILEGED, pending, sizeof(int));
 	must_read(PRIV_UNPRIVILEGED, &rc, sizeof(int));
 	if ((buf = (char*)realloc(buf, rc+1)) == NULL)
 		fatal("privsep", NULL);
@@ -119,34 +127,66 @@ priv_gethostname()
 }
 
 
+/* The network namespace of an interface is sent as a fixed-size name, empty
+ * for the namespace lldpd runs in. */
+static void
+priv_write_netns(const char *netns)
+{
+	char name[LLDPD_NETNS_NAMESIZ] = {};
+	if (netns) strlcpy(name, netns, sizeof(name));
+	must_write(PRIV_UNPRIVILEGED, name, sizeof(name));
+}
+
+static void
+asroot_read_netns(char *name)
+{
+	must_read(PRIV_PRIVILEGED, name, LLDPD_NETNS_NAMESIZ);
+	name[LLDPD_NETNS_NAMESIZ - 1] = '\0';
+}
+
+/* Only the network namespaces provided on the command line can be entered. */
+int
+asroot_netns_allowed(const char *netns)
+{
+	char **allowed;
+	for (allowed = allowed_netns; allowed && *allowed; allowed++)
+		if (!strcmp(*allowed, netns)) return 1;
+	return 0;
+}
+
 int
-priv_iface_init(int index, char *iface)
+priv_iface_init(int index, char *iface, const char *netns)
 {
 	int rc;
 	char dev[IFNAMSIZ] = {};
 	enum priv_cmd cmd = PRIV_IFACE_INIT;
+	index = LLDPD_IFINDEX_LOCAL(index);
 	must_write(PRIV_UNPRIVILEGED, &cmd, sizeof(enum priv_cmd));
 	must_write(PRIV_UNPRIVILEGED, &index, sizeof(int));
 	strlcpy(dev, iface, IFNAMSIZ);
 	must_write(PRIV_UNPRIVILEGED, dev, IFNAMSIZ);
+	priv_write_netns(netns);
 	priv_wait();
 	must_read(PRIV_UNPRIVILEGED, &rc, sizeof(int));
 	if (rc != 0) return -1;
 	return receive_fd(PRIV_UNPRIVILEGED);
 }
 
-int
-priv_iface_multicast(const char *name, const u_int8_t *mac, int add)
+/* Add or remove several multicast addresses with a single request. The result
+ * for each address is stored in `rc`. */
+void
+priv_iface_multicast(const char *name, const char *netns,
+    const u_int8_t *macs, int n, int add, int *rc)
 {
-	int rc;
 	enum priv_cmd cmd = PRIV_IFACE_MULTICAST;
 	must_write(PRIV_UNPRIVILEGED, &cmd, sizeof(enum priv_cmd));
 	must_write(PRIV_UNPRIVILEGED, name, IFNAMSIZ);
-	must_write(PRIV_UNPRIVILEGED, mac, ETHER_ADDR_LEN);
+	priv_write_netns(netns);
+	must_write(PRIV_UNPRIVILEGED, &n, sizeof(int));
+	must_write(PRIV_UNPRIVILEGED, macs, n * ETHER_ADDR_LEN);
 	must_write(PRIV_UNPRIVILEGED, &add, sizeof(int));
 	priv_wait();
-	must_read(PRIV_UNPRIVILEGED, &rc, sizeof(int));
-	return rc;
+	must_read(PRIV_UNPRIVILEGED, rc, n * sizeof(int));
 }
 
 int
@@ -165,12 +205,13 @@ priv_iface_description(const char *name, const char *description)
 
 /* Proxy to set interface in promiscuous mode */
 int
-priv_iface_promisc(const char *ifname)
+priv_iface_promisc(const char *ifname, const char *netns)
 {
 	int rc;
 	enum priv_cmd cmd = PRIV_IFACE_PROMISC;
 	must_write(PRIV_UNPRIVILEGED, &cmd, sizeof(enum priv_cmd));
 	must_write(PRIV_UNPRIVILEGED, ifname, IFNAMSIZ);
+	priv_write_netns(netns);
 	priv_wait();
 	must_read(PRIV_UNPRIVILEGED, &rc, sizeof(int));
 	return rc;
@@ -190,6 +231,75 @@ priv_snmp_socket(struct sockaddr_un *addr)
 	return receive_fd(PRIV_UNPRIVILEGED);
 }
 
+/* Proxy to open (when `create` is set) or remove the snapshot file. When the
+ * file is opened, a file descriptor is returned. */
+int
+priv_snapshot(int create)
+{
+	int rc;
+	enum priv_cmd cmd = PRIV_SNAPSHOT;
+	must_write(PRIV_UNPRIVILEGED, &cmd, sizeof(enum priv_cmd));
+	must_write(PRIV_UNPRIVILEGED, &create, sizeof(int));
+	priv_wait();
+	must_read(PRIV_UNPRIVILEGED, &rc, sizeof(int));
+	if (rc != 0 || !create)
+		return -1;
+	return receive_fd(PRIV_UNPRIVILEGED);
+}
+
+/* Proxy to save the state kept across restarts. When `len` is 0, the state is
+ * removed. */
+int
+priv_save_state(const void *state, size_t len)
+{
+	int rc;
+	enum priv_cmd cmd = PRIV_SAVE_STATE;
+	must_write(PRIV_UNPRIVILEGED, &cmd, sizeof(enum priv_cmd));
+	must_write(PRIV_UNPRIVILEGED, &len, sizeof(size_t));
+	if (len > 0)
+		must_write(PRIV_UNPRIVILEGED, state, len);
+	priv_wait();
+	must_read(PRIV_UNPRIVILEGED, &rc, sizeof(int));
+	return rc;
+}
+
+/* Proxy to load the state kept across restarts. The returned buffer should be
+ * freed. */
+void *
+priv_load_state(size_t *len)
+{
+	void *state;
+	enum priv_cmd cmd = PRIV_LOAD_STATE;
+	must_write(PRIV_UNPRIVILEGED, &cmd, sizeof(enum priv_cmd));
+	priv_wait();
+	must_read(PRIV_UNPRIVILEGED, len, sizeof(size_t));
+	if (*len == 0)
+		return NULL;
+	if (*len > PRIV_STATE_MAX)
+		fatalx("privsep", "state is too large");
+	if ((state = malloc(*len)) == NULL)
+		fatal("privsep", NULL);
+	must_read(PRIV_UNPRIVILEGED, state, *len);
+	return state;
+}
+
+/* Proxy to create (unless `port` is -1) or remove the listening socket used to
+ * export metrics. When `port` is 0, this is a Unix socket. Otherwise, this is a
+ * TCP socket bound to the loopback address. */
+int
+priv_metrics(int port)
+{
+	int rc;
+	enum priv_cmd cmd = PRIV_METRICS;
+	must_write(PRIV_UNPRIVILEGED, &cmd, sizeof(enum priv_cmd));
+	must_write(PRIV_UNPRIVILEGED, &port, sizeof(int));
+	priv_wait();
+	must_read(PRIV_UNPRIVILEGED, &rc, sizeof(int));
+	if (rc != 0 || port == -1)
+		return -1;
+	return receive_fd(PRIV_UNPRIVILEGED);
+}
+
 static void
 asroot_ping()
 {
@@ -218,31 +328,154 @@ asroot_ctl_cleanup()
 	must_write(PRIV_PRIVILEGED, &rc, sizeof(int));
 }
 
+/* Resolution of the system name. The canonical name is resolved in a child
+ * process to not block the monitor (and therefore the daemon) during DNS
+ * outages. The result is cached. */
+static struct {
+	char	 nodename[sizeof(((struct utsname *)0)->nodename)];
+	char	*name;		/* Last canonical name, NULL if none yet */
+	time_t	 expire;	/* When the cached result expires */
+	pid_t	 pid;		/* Resolver process, -1 if none */
+	int	 fd;		/* Pipe from the resolver process */
+} hostname = { .pid = -1, .fd = -1 };
+
+/* Resolve the provided name and write the result on `fd`. Run in a child. */
 static void
-asroot_gethostname()
+asroot_gethostname_resolve(const char *nodename, int fd)
 {
-	struct utsname un;
 	struct addrinfo hints = {
 		.ai_flags = AI_CANONNAME
 	};
 	struct addrinfo *res;
-	int len;
-	if (uname(&un) < 0)
-		fatal("privsep", "failed to get system information");
-	if (getaddrinfo(un.nodename, NULL, &hints, &res) != 0) {
+	char buf[sizeof(int) + 256];
+	int len = -1;
+	if (getaddrinfo(nodename, NULL, &hints, &res) == 0) {
+		len = strlen(res->ai_canonname);
+		if (len >= 256) len = -1;
+		else memcpy(buf + sizeof(int), res->ai_canonname, len);
+		freeaddrinfo(res);
+	}
+	/* A single write to be atomic */
+	memcpy(buf, &len, sizeof(int));
+	if (write(fd, buf, sizeof(int) + ((len > 0)?len:0)) == -1)
+		_exit(1);
+}
+
+/* Stop any running resolver process. */
+static void
+asroot_gethostname_stop()
+{
+	if (hostname.pid == -1) return;
+	close(hostname.fd);
+	kill(hostname.pid, SIGKILL);
+	waitpid(hostname.pid, NULL, 0);
+	hostname.pid = -1;
+	hostname.fd = -1;
+}
+
+/* Collect the result of the resolver process if available. Wait at most
+ * `timeout` milliseconds. */
+static void
+asroot_gethostname_collect(int timeout)
+{
+	struct pollfd pfd;
+	char *name = NULL;
+	int len, n;
+
+	if (hostname.pid == -1) return;
+	pfd.fd = hostname.fd;
+	pfd.events = POLLIN;
+	do {
+		n = poll(&pfd, 1, timeout);
+	} while (n == -1 && errno == EINTR);
+	if (n == 0) return;
+
+	if (n > 0 &&
+	    read(hostname.fd, &len, sizeof(int)) == sizeof(int) &&
+	    len >= 0 && len < 256 &&
+	    (name = calloc(1, len + 1)) != NULL &&
+	    read(hostname.fd, name, len) == len) {
+		log_debug("privsep", "system name resolved to %s", name);
+		free(hostname.name);
+		hostname.name = name;
+		hostname.expire = time(NULL) + LLDPD_HOSTNAME_TTL;
+	} else {
+		free(name);
 		log_info("privsep", "unable to get system name");
 #ifdef HAVE_RES_INIT
 		res_init();
 #endif
-                len = strlen(un.nodename);
-                must_write(PRIV_PRIVILEGED, &len, sizeof(int));
-                must_write(PRIV_PRIVILEGED, un.nodename, len);
-        } else {
-                len = strlen(res->ai_canonname);
-                must_write(PRIV_PRIVILEGED, &len, sizeof(int));
-                must_write(PRIV_PRIVILEGED, res->ai_canonname, len);
-		freeaddrinfo(res);
-        }
+		/* Keep the last good name, if any, and retry later */
+		hostname.expire = time(NULL) + LLDPD_HOSTNAME_NEGATIVE_TTL;
+	}
+	close(hostname.fd);
+	/* The process may already have been reaped by SIGCHLD handler */
+	waitpid(hostname.pid, NULL, 0);
+	hostname.pid = -1;
+	hostname.fd = -1;
+}
+
+/* Spawn a resolver process for the current nodename. */
+static void
+asroot_gethostname_spawn()
+{
+	int fds[2];
+	pid_t pid;
+	if (pipe(fds) == -1) {
+		log_warn("privsep", "unable to create pipe for name resolution");
+		return;
+	}
+	switch (pid = fork()) {
+	case -1:
+		log_warn("privsep", "unable to fork for name resolution");
+		close(fds[0]);
+		close(fds[1]);
+		return;
+	case 0:
+		close(fds[0]);
+		asroot_gethostname_resolve(hostname.nodename, fds[1]);
+		_exit(0);
+	default:
+		close(fds[1]);
+		hostname.pid = pid;
+		hostname.fd = fds[0];
+	}
+}
+
+static void
+asroot_gethostname()
+{
+	struct utsname un;
+	const char *name;
+	int len, refresh, pending;
+
+	must_read(PRIV_PRIVILEGED, &refresh, sizeof(int));
+	if (uname(&un) < 0)
+		fatal("privsep", "failed to get system information");
+
+	asroot_gethostname_collect(0);
+	if (strcmp(un.nodename, hostname.nodename)) {
+		/* Name has changed, cache is not valid anymore */
+		log_debug("privsep", "system name is now %s", un.nodename);
+		asroot_gethostname_stop();
+		strlcpy(hostname.nodename, un.nodename, sizeof(hostname.nodename));
+		free(hostname.name);
+		hostname.name = NULL;
+		hostname.expire = 0;
+	}
+	if (hostname.pid == -1 &&
+	    (refresh || time(NULL) >= hostname.expire)) {
+		asroot_gethostname_spawn();
+		/* Give a chance to fast resolutions */
+		asroot_gethostname_collect(LLDPD_HOSTNAME_WAIT);
+	}
+
+	pending = (hostname.pid != -1);
+	name = hostname.name ? hostname.name : hostname.nodename;
+	len = strlen(name);
+	must_write(PRIV_PRIVILEGED, &pending, sizeof(int));
+	must_write(PRIV_PRIVILEGED, &len, sizeof(int));
+	must_write(PRIV_PRIVILEGED, name, len);
 }
 
 static void
@@ -251,12 +484,14 @@ asroot_iface_init()
 	int rc = -1, fd = -1;
 	int ifindex;
 	char name[IFNAMSIZ];
+	char netns[LLDPD_NETNS_NAMESIZ];
 	must_read(PRIV_PRIVILEGED, &ifindex, sizeof(ifindex));
 	must_read(PRIV_PRIVILEGED, &name, sizeof(name));
 	name[sizeof(name) - 1] = '\0';
+	asroot_read_netns(netns);
 
 	TRACE(LLDPD_PRIV_INTERFACE_INIT(name));
-	rc = asroot_iface_init_os(ifindex, name, &fd);
+	rc = asroot_iface_init_os(ifindex, name, netns, &fd);
 	must_write(PRIV_PRIVILEGED, &rc, sizeof(rc));
 	if (rc == 0 && fd >=0) send_fd(PRIV_PRIVILEGED, fd);
 	if (fd >= 0) close(fd);
@@ -265,40 +500,60 @@ asroot_iface_init()
 static void
 asroot_iface_multicast()
 {
-	int sock = -1, add, rc = 0;
+	int sock = -1, add, n, i;
+	int rc[PRIV_MULTICAST_MAX];
+	u_int8_t macs[PRIV_MULTICAST_MAX][ETHER_ADDR_LEN];
+	char netns[LLDPD_NETNS_NAMESIZ];
 	struct ifreq ifr = { .ifr_name = {} };
 	must_read(PRIV_PRIVILEGED, ifr.ifr_name, IFNAMSIZ);
+	asroot_read_netns(netns);
+	must_read(PRIV_PRIVILEGED, &n, sizeof(int));
+	if (n < 0 || n > PRIV_MULTICAST_MAX)
+		fatalx("privsep", "too many multicast addresses");
+	must_read(PRIV_PRIVILEGED, macs, n * ETHER_ADDR_LEN);
+	must_read(PRIV_PRIVILEGED, &add, sizeof(int));
+
+#ifdef HOST_OS_LINUX
+	sock = asroot_netns_socket(netns, AF_INET, SOCK_DGRAM, 0);
+#else
+	sock = socket(AF_INET, SOCK_DGRAM, 0);
+#endif
+	if (sock == -1) {
+		for (i = 0; i < n; i++) rc[i] = errno;
+		must_write(PRIV_PRIVILEGED, rc, n * sizeof(int));
+		return;
+	}
+	for (i = 0; i < n; i++) {
 #if defined HOST_OS_LINUX
-	must_read(PRIV_PRIVILEGED, ifr.ifr_hwaddr.sa_data, ETHER_ADDR_LEN);
+		memcpy(ifr.ifr_hwaddr.sa_data, macs[i], ETHER_ADDR_LEN);
 #elif defined HOST_OS_FREEBSD || defined HOST_OS_OSX || defined HOST_OS_DRAGONFLY
-	/* Black magic from mtest.c */
-	struct sockaddr_dl *dlp = ALIGNED_CAST(struct sockaddr_dl *, &ifr.ifr_addr);
-	dlp->sdl_len = sizeof(struct sockaddr_dl);
-	dlp->sdl_family = AF_LINK;
-	dlp->sdl_index = 0;
-	dlp->sdl_nlen = 0;
-	dlp->sdl_alen = ETHER_ADDR_LEN;
-	dlp->sdl_slen = 0;
-	must_read(PRIV_PRIVILEGED, LLADDR(dlp), ETHER_ADDR_LEN);
+		/* Black magic from mtest.c */
+		struct sockaddr_dl *dlp = ALIGNED_CAST(struct sockaddr_dl *, &ifr.ifr_addr);
+		dlp->sdl_len = sizeof(struct sockaddr_dl);
+		dlp->sdl_family = AF_LINK;
+		dlp->sdl_index = 0;
+		dlp->sdl_nlen = 0;
+		dlp->sdl_alen = ETHER_ADDR_LEN;
+		dlp->sdl_slen = 0;
+		memcpy(LLADDR(dlp), macs[i], ETHER_ADDR_LEN);
 #elif defined HOST_OS_OPENBSD || defined HOST_OS_NETBSD || defined HOST_OS_SOLARIS
-	struct sockaddr *sap = (struct sockaddr *)&ifr.ifr_addr;
+		struct sockaddr *sap = (struct sockaddr *)&ifr.ifr_addr;
 #if ! defined HOST_OS_SOLARIS
-	sap->sa_len = sizeof(struct sockaddr);
+		sap->sa_len = sizeof(struct sockaddr);
 #endif
-	sap->sa_family = AF_UNSPEC;
-	must_read(PRIV_PRIVILEGED, sap->sa_data, ETHER_ADDR_LEN);
+		sap->sa_family = AF_UNSPEC;
+		memcpy(sap->sa_data, macs[i], ETHER_ADDR_LEN);
 #else
 #error Unsupported OS
 #endif
+		rc[i] = 0;
+		if ((ioctl(sock, (add)?SIOCADDMULTI:SIOCDELMULTI,
+			    &ifr) < 0) && (errno != EADDRINUSE))
+			rc[i] = errno;
+	}
 
-	must_read(PRIV_PRIVILEGED, &add, sizeof(int));
-	if (((sock = socket(AF_INET, SOCK_DGRAM, 0)) == -1) ||
-	    ((ioctl(sock, (add)?SIOCADDMULTI:SIOCDELMULTI,
-		    &ifr) < 0) && (errno != EADDRINUSE)))
-		rc = errno;
-
-	if (sock != -1) close(sock);
-	must_write(PRIV_PRIVILEGED, &rc, sizeof(rc));
+	close(sock);
+	must_write(PRIV_PRIVILEGED, rc, n * sizeof(int));
 }
 
 static void
@@ -325,10 +580,12 @@ static void
 asroot_iface_promisc()
 {
 	char name[IFNAMSIZ];
+	char netns[LLDPD_NETNS_NAMESIZ];
 	int rc;
 	must_read(PRIV_PRIVILEGED, &name, sizeof(name));
 	name[sizeof(name) - 1] = '\0';
-	rc = asroot_iface_promisc_os(name);
+	asroot_read_netns(netns);
+	rc = asroot_iface_promisc_os(name, netns);
 	must_write(PRIV_PRIVILEGED, &rc, sizeof(rc));
 }
 
@@ -382,6 +639,182 @@ asroot_snmp_socket()
 	close(sock);
 }
 
+static void
+asroot_snapshot()
+{
+	int create, fd, rc = 0;
+
+	must_read(PRIV_PRIVILEGED, &create, sizeof(int));
+
+	/* Readers may still have the previous file mapped. Never truncate it,
+	 * they would get SIGBUS. Create a new one instead. */
+	if (unlink(LLDPD_SNAPSHOT_FILE) == -1 && errno != ENOENT) {
+		log_warn("privsep", "unable to remove " LLDPD_SNAPSHOT_FILE);
+		rc = -1;
+	}
+	if (!create || rc == -1) {
+		must_write(PRIV_PRIVILEGED, &rc, sizeof(int));
+		return;
+	}
+
+	/* Neighbor information is only available to the same users as the
+	 * control socket. */
+	if ((fd = open(LLDPD_SNAPSHOT_FILE,
+		    O_RDWR | O_CREAT | O_EXCL | O_NOFOLLOW,
+		    S_IRUSR | S_IWUSR | S_IRGRP)) == -1) {
+		log_warn("privsep", "unable to create " LLDPD_SNAPSHOT_FILE);
+		rc = -1;
+		must_write(PRIV_PRIVILEGED, &rc, sizeof(int));
+		return;
+	}
+#ifdef ENABLE_PRIVSEP
+	if (fchown(fd, -1, monitored_gid) == -1)
+		log_warn("privsep", "unable to chown " LLDPD_SNAPSHOT_FILE);
+#endif
+	must_write(PRIV_PRIVILEGED, &rc, sizeof(int));
+	send_fd(PRIV_PRIVILEGED, fd);
+	close(fd);
+}
+
+static void
+asroot_save_state()
+{
+	size_t len, done;
+	ssize_t n;
+	char *state;
+	int fd, rc = -1;
+
+	must_read(PRIV_PRIVILEGED, &len, sizeof(size_t));
+	if (len == 0) {
+		if (unlink(LLDPD_STATE_FILE) == 0 || errno == ENOENT)
+			rc = 0;
+		else
+			log_warn("privsep", "unable to remove " LLDPD_STATE_FILE);
+		must_write(PRIV_PRIVILEGED, &rc, sizeof(int));
+		return;
+	}
+	if (len > PRIV_STATE_MAX)
+		fatalx("privsep", "someone is trying to trick me");
+	if ((state = malloc(len)) == NULL)
+		fatal("privsep", NULL);
+	must_read(PRIV_PRIVILEGED, state, len);
+
+	/* Write a temporary file, flush it to disk and rename it to not lose
+	 * the previous state on failure or on power loss. */
+	if ((fd = open(LLDPD_STATE_FILE ".tmp",
+		    O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW,
+		    S_IRUSR | S_IWUSR)) == -1)
+		log_warn("privsep", "unable to create " LLDPD_STATE_FILE ".tmp");
+	else {
+		for (done = 0, n = 0; done < len; done += n) {
+			n = write(fd, state + done, len - done);
+			if (n == -1 && errno == EINTR) n = 0;
+			else if (n <= 0) break;
+		}
+		if (done < len)
+			log_warn("privsep", "unable to write " LLDPD_STATE_FILE ".tmp");
+		else if (fsync(fd) == -1)
+			log_warn("privsep", "unable to sync " LLDPD_STATE_FILE ".tmp");
+		else if (rename(LLDPD_STATE_FILE ".tmp", LLDPD_STATE_FILE) == -1)
+			log_warn("privsep", "unable to rename " LLDPD_STATE_FILE ".tmp");
+		else
+			rc = 0;
+		close(fd);
+		if (rc == -1) unlink(LLDPD_STATE_FILE ".tmp");
+	}
+	free(state);
+	must_write(PRIV_PRIVILEGED, &rc, sizeof(int));
+}
+
+static void
+asroot_load_state()
+{
+	struct stat st;
+	size_t len = 0;
+	char *state = NULL;
+	ssize_t n;
+	int fd;
+
+	if ((fd = open(LLDPD_STATE_FILE, O_RDONLY | O_NOFOLLOW)) == -1) {
+		if (errno != ENOENT)
+			log_warn("privsep", "unable to open " LLDPD_STATE_FILE);
+	} else if (fstat(fd, &st) == -1 || !S_ISREG(st.st_mode) ||
+	    st.st_size == 0 || st.st_size > PRIV_STATE_MAX) {
+		log_warnx("privsep", "ignore invalid " LLDPD_STATE_FILE);
+	} else if ((state = malloc(st.st_size)) == NULL) {
+		log_warn("privsep", "unable to allocate memory for state");
+	} else if ((n = read(fd, state, st.st_size)) != st.st_size) {
+		log_warnx("privsep", "unable to read " LLDPD_STATE_FILE);
+	} else
+		len = n;
+	if (fd != -1) close(fd);
+
+	must_write(PRIV_PRIVILEGED, &len, sizeof(size_t));
+	if (len > 0)
+		must_write(PRIV_PRIVILEGED, state, len);
+	free(state);
+}
+
+static void
+asroot_metrics()
+{
+	struct sockaddr_in sin;
+	int port, fd = -1, rc = 0, one = 1;
+
+	must_read(PRIV_PRIVILEGED, &port, sizeof(int));
+	if (port < -1 || port > 65535) {
+		log_warnx("privsep", "invalid port for metrics: %d", port);
+		rc = -1;
+	}
+
+	if (unlink(LLDPD_METRICS_SOCKET) == -1 && errno != ENOENT) {
+		log_warn("privsep", "unable to remove " LLDPD_METRICS_SOCKET);
+		rc = -1;
+	}
+	if (port == -1 || rc == -1) {
+		must_write(PRIV_PRIVILEGED, &rc, sizeof(int));
+		return;
+	}
+
+	if (port == 0) {
+		if ((fd = ctl_create(LLDPD_METRICS_SOCKET)) == -1)
+			log_warn("privsep", "unable to create " LLDPD_METRICS_SOCKET);
+		else {
+			/* Same access rules as the control socket. */
+#ifdef ENABLE_PRIVSEP
+			if (chown(LLDPD_METRICS_SOCKET, -1, monitored_gid) == -1)
+				log_warn("privsep", "unable to chown " LLDPD_METRICS_SOCKET);
+#endif
+			if (chmod(LLDPD_METRICS_SOCKET,
+				S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP) == -1)
+				log_warn("privsep", "unable to chmod " LLDPD_METRICS_SOCKET);
+		}
+	} else {
+		memset(&sin, 0, sizeof(struct sockaddr_in));
+		sin.sin_family = AF_INET;
+		sin.sin_port = htons(port);
+		sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		if ((fd = socket(PF_INET, SOCK_STREAM, 0)) == -1 ||
+		    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR,
+			&one, sizeof(one)) == -1 ||
+		    bind(fd, (struct sockaddr *)&sin, sizeof(sin)) == -1 ||
+		    listen(fd, 5) == -1) {
+			log_warn("privsep", "unable to listen on port %d for metrics",
+			    port);
+			if (fd != -1) close(fd);
+			fd = -1;
+		}
+	}
+	if (fd == -1) {
+		rc = -1;
+		must_write(PRIV_PRIVILEGED, &rc, sizeof(int));
+		return;
+	}
+	must_write(PRIV_PRIVILEGED, &rc, sizeof(int));
+	send_fd(PRIV_PRIVILEGED, fd);
+	close(fd);
+}
+
 struct dispatch_actions {
 	enum priv_cmd msg;
 	void(*function)(void);
@@ -393,12 +826,18 @@ static struct dispatch_actions actions[] = {
 	{PRIV_GET_HOSTNAME, asroot_gethostname},
 #ifdef HOST_OS_LINUX
 	{PRIV_OPEN, asroot_open},
+	{PRIV_NETNS_SOCKET, asroot_netns},
+	{PRIV_NETNS_STAT, asroot_netns_stat},
 #endif
 	{PRIV_IFACE_INIT, asroot_iface_init},
 	{PRIV_IFACE_MULTICAST, asroot_iface_multicast},
 	{PRIV_IFACE_DESCRIPTION, asroot_iface_description},
 	{PRIV_IFACE_PROMISC, asroot_iface_promisc},
 	{PRIV_SNMP_SOCKET, asroot_snmp_socket},
+	{PRIV_SNAPSHOT, asroot_snapshot},
+	{PRIV_SAVE_STATE, asroot_save_state},
+	{PRIV_LOAD_STATE, asroot_load_state},
+	{PRIV_METRICS, asroot_metrics},
 	{-1, NULL}
 };
 
@@ -412,7 +851,8 @@ priv_loop(int privileged, int once)
 #ifdef ENABLE_PRIVSEP
 	setproctitle("monitor.");
 #ifdef USE_SECCOMP
-	if (priv_seccomp_init(privileged, monitored) != 0)
+	if (priv_seccomp_init(privileged, monitored,
+		allowed_netns != NULL) != 0)
 	   fatal("privsep", "cannot continue without seccomp setup");
 #endif
 #endif
@@ -648,15 +1088,23 @@ priv_drop(uid_t uid, gid_t gid)
 }
 
 void
-priv_caps(uid_t uid, gid_t gid)
+priv_caps(uid_t uid, gid_t gid, int netns)
 {
 #ifdef HAVE_LINUX_CAPABILITIES
 	cap_t caps;
-	const char *caps_strings[2] = {
+	const char **caps_strings;
+	const char *caps_default[2] = {
 		"cap_dac_override,cap_net_raw,cap_net_admin,cap_setuid,cap_setgid=pe",
 		"cap_dac_override,cap_net_raw,cap_net_admin=pe"
 	};
-	log_debug("privsep", "getting CAP_NET_RAW/ADMIN and CAP_DAC_OVERRIDE privilege");
+	/* Entering another network namespace requires CAP_SYS_ADMIN */
+	const char *caps_netns[2] = {
+		"cap_dac_override,cap_net_raw,cap_net_admin,cap_sys_admin,cap_setuid,cap_setgid=pe",
+		"cap_dac_override,cap_net_raw,cap_net_admin,cap_sys_admin=pe"
+	};
+	caps_strings = netns ? caps_netns : caps_default;
+	log_debug("privsep", "getting CAP_NET_RAW/ADMIN and CAP_DAC_OVERRIDE privilege%s",
+	    netns ? " (and CAP_SYS_ADMIN for network namespaces)" : "");
 	if (!(caps = cap_from_text(caps_strings[0])))
 		fatal("privsep", "unable to convert caps");
 	if (cap_set_proc(caps) == -1) {
@@ -682,7 +1130,7 @@ priv_caps(uid_t uid, gid_t gid)
 }
 
 void
-priv_init(const char *chrootdir, int ctl, uid_t uid, gid_t gid)
+priv_init(const char *chrootdir, int ctl, uid_t uid, gid_t gid, char **netns)
 {
 
 	int pair[2];
@@ -695,8 +1143,11 @@ priv_init(const char *chrootdir, int ctl, uid_t uid, gid_t gid)
 
 	priv_unprivileged_fd(pair[0]);
 	priv_privileged_fd(pair[1]);
+	allowed_netns = netns;
 
 #ifdef ENABLE_PRIVSEP
+	monitored_gid = gid;
+
 	/* Spawn off monitor */
 	if ((monitored = fork()) < 0)
 		fatal("privsep", "unable to fork monitor");
@@ -723,7 +1174,7 @@ priv_init(const char *chrootdir, int ctl, uid_t uid, gid_t gid)
 		if (atexit(priv_exit) != 0)
 			fatal("privsep", "unable to set exit function");
 
-		priv_caps(uid, gid);
+		priv_caps(uid, gid, netns != NULL);
 
 		/* Install signal handlers */
 		const struct sigaction pass_to_child = {
@@ -214,27 +214,29 @@ cdp_send(struct lldpd *global,
 
 #ifdef ENABLE_DOT3
 	if ((version >= 2) &&
-	    (port->p_power.powertype != LLDP_DOT3_POWER_8023AT_OFF) &&
-	    (port->p_power.devicetype == LLDP_DOT3_POWER_PD) &&
-	    (port->p_power.requested > 0) &&
-	    (port->p_power.requested <= 655)) {
+	    port->p_power &&
+	    (port->p_power->powertype != LLDP_DOT3_POWER_8023AT_OFF) &&
+	    (port->p_power->devicetype == LLDP_DOT3_POWER_PD) &&
+	    (port->p_power->requested > 0) &&
+	    (port->p_power->requested <= 655) &&
+	    LLDPD_PORT_EXT(port, p_cdp_power) != NULL) {
 		u_int16_t requested;
 		u_int16_t consumption;
 
-		if (port->p_power.requested != port->p_power.allocated) {
-			port->p_cdp_power.request_id++;
-			log_debug("cdp", "requested: %d, allocated:%d", port->p_power.requested, port->p_power.allocated);
+		if (port->p_power->requested != port->p_power->allocated) {
+			port->p_cdp_power->request_id++;
+			log_debug("cdp", "requested: %d, allocated:%d", port->p_power->requested, port->p_power->allocated);
 		}
-		consumption = port->p_power.allocated ? port->p_power.allocated : CDP_SWTICH_DEFAULT_POE_PD;
+		consumption = port->p_power->allocated ? port->p_power->allocated : CDP_SWTICH_DEFAULT_POE_PD;
 		if (consumption > 130) {
 			consumption += CDP_SWITCH_POE_CLASS_4_OFFSET;
 		} else {
 			consumption += CDP_SWITCH_POE_CLASS_3_OFFSET;
 		}
-		if (port->p_power.requested > 130) { /* Class 4 */
-			requested = port->p_power.requested + CDP_SWITCH_POE_CLASS_4_OFFSET;
+		if (port->p_power->requested > 130) { /* Class 4 */
+			requested = port->p_power->requested + CDP_SWITCH_POE_CLASS_4_OFFSET;
 		} else { /* Class 3 */
-			requested = port->p_power.requested + CDP_SWITCH_POE_CLASS_3_OFFSET;
+			requested = port->p_power->requested + CDP_SWITCH_POE_CLASS_3_OFFSET;
 		}
 		if (!(
 		      POKE_START_CDP_TLV(CDP_TLV_POWER_CONSUMPTION) &&
@@ -242,16 +244,16 @@ cdp_send(struct lldpd *global,
 		      POKE_END_CDP_TLV))
 			goto toobig;
 		/* Avoid request id 0 from overflow */
-		if (!port->p_cdp_power.request_id) {
-			port->p_cdp_power.request_id = 1;
+		if (!port->p_cdp_power->request_id) {
+			port->p_cdp_power->request_id = 1;
 		}
-		if (!port->p_cdp_power.management_id) {
-			port->p_cdp_power.management_id = 1;
+		if (!port->p_cdp_power->management_id) {
+			port->p_cdp_power->management_id = 1;
 		}
 		if (!(
 		      POKE_START_CDP_TLV(CDP_TLV_POWER_REQUESTED) &&
-		      POKE_UINT16(port->p_cdp_power.request_id) &&
-		      POKE_UINT16(port->p_cdp_power.management_id) &&
+		      POKE_UINT16(port->p_cdp_power->request_id) &&
+		      POKE_UINT16(port->p_cdp_power->management_id) &&
 		      POKE_UINT32(requested * 100) &&
 		      POKE_END_CDP_TLV))
 			goto toobig;
@@ -259,13 +261,13 @@ cdp_send(struct lldpd *global,
 #elif defined(ENABLE_LLDPMED)
 	/* Power use */
 	if ((version >= 2) &&
-	    port->p_med_cap_enabled &&
-	    (port->p_med_power.source != LLDP_MED_POW_SOURCE_LOCAL) &&
-	    (port->p_med_power.val > 0) &&
-	    (port->p_med_power.val <= 655)) {
+	    port->p_med_cap_enabled && port->p_med &&
+	    (port->p_med->power.source != LLDP_MED_POW_SOURCE_LOCAL) &&
+	    (port->p_med->power.val > 0) &&
+	    (port->p_med->power.val <= 655)) {
 		if (!(
 		      POKE_START_CDP_TLV(CDP_TLV_POWER_CONSUMPTION) &&
-		      POKE_UINT16(port->p_med_power.val * 100) &&
+		      POKE_UINT16(port->p_med->power.val * 100) &&
 		      POKE_END_CDP_TLV))
 			goto toobig;
 	}
@@ -327,19 +329,20 @@ cdp_decode(struct lldpd *cfg, char *frame, int s,
 	int length, len_eth, tlv_type, tlv_len, addresses_len, address_len;
 #ifdef ENABLE_DOT1
 	struct lldpd_vlan *vlan;
+	char vlan_name[sizeof("VLAN #65535")];
 #endif
 
 	log_debug("cdp", "decode CDP frame received on %s",
 	    hardware->h_ifname);
 
-	if ((chassis = calloc(1, sizeof(struct lldpd_chassis))) == NULL) {
+	if ((chassis = lldpd_slab_alloc(LLDPD_SLAB_CHASSIS)) == NULL) {
 		log_warn("cdp", "failed to allocate remote chassis");
 		return -1;
 	}
 	TAILQ_INIT(&chassis->c_mgmt);
-	if ((port = calloc(1, sizeof(struct lldpd_port))) == NULL) {
+	if ((port = lldpd_slab_alloc(LLDPD_SLAB_PORT)) == NULL) {
 		log_warn("cdp", "failed to allocate remote port");
-		free(chassis);
+		lldpd_slab_free(LLDPD_SLAB_CHASSIS, chassis);
 		return -1;
 	}
 #ifdef ENABLE_DOT1
@@ -440,17 +443,17 @@ cdp_decode(struct lldpd *cfg, char *frame, int s,
 		}
 		switch (tlv_type) {
 		case CDP_TLV_CHASSIS:
-			if ((chassis->c_name = (char *)calloc(1, tlv_len + 1)) == NULL) {
+			if ((chassis->c_name = lldpd_intern_len((char *)pos,
+				    tlv_len)) == NULL) {
 				log_warn("cdp", "unable to allocate memory for chassis name");
 				goto malformed;
 			}
-			PEEK_BYTES(chassis->c_name, tlv_len);
 			chassis->c_id_subtype = LLDP_CHASSISID_SUBTYPE_LOCAL;
 			if ((chassis->c_id =  (char *)malloc(tlv_len)) == NULL) {
 				log_warn("cdp", "unable to allocate memory for chassis ID");
 				goto malformed;
 			}
-			memcpy(chassis->c_id, chassis->c_name, tlv_len);
+			PEEK_BYTES(chassis->c_id, tlv_len);
 			chassis->c_id_len = tlv_len;
 			break;
 		case CDP_TLV_ADDRESSES:
@@ -514,17 +517,17 @@ cdp_decode(struct lldpd *cfg, char *frame, int s,
 				log_warn("cdp", "too short port description received");
 				goto malformed;
 			}
-			if ((port->p_descr = (char *)calloc(1, tlv_len + 1)) == NULL) {
+			if ((port->p_descr = lldpd_intern_len((char *)pos,
+				    tlv_len)) == NULL) {
 				log_warn("cdp", "unable to allocate memory for port description");
 				goto malformed;
 			}
-			PEEK_BYTES(port->p_descr, tlv_len);
 			port->p_id_subtype = LLDP_PORTID_SUBTYPE_IFNAME;
 			if ((port->p_id =  (char *)calloc(1, tlv_len)) == NULL) {
 				log_warn("cdp", "unable to allocate memory for port ID");
 				goto malformed;
 			}
-			memcpy(port->p_id, port->p_descr, tlv_len);
+			PEEK_BYTES(port->p_id, tlv_len);
 			port->p_id_len = tlv_len;
 			break;
 		case CDP_TLV_CAPABILITIES:
@@ -564,8 +567,7 @@ cdp_decode(struct lldpd *cfg, char *frame, int s,
 #ifdef ENABLE_DOT1
 		case CDP_TLV_NATIVEVLAN:
 			CHECK_TLV_SIZE(2, "Native VLAN");
-			if ((vlan = (struct lldpd_vlan *)calloc(1,
-				sizeof(struct lldpd_vlan))) == NULL) {
+			if ((vlan = lldpd_slab_alloc(LLDPD_SLAB_VLAN)) == NULL) {
 				log_warn("cdp", "unable to alloc vlan "
 					  "structure for "
 					  "tlv received on %s",
@@ -573,11 +575,12 @@ cdp_decode(struct lldpd *cfg, char *frame, int s,
 				goto malformed;
 			}
 			vlan->v_vid = port->p_pvid = PEEK_UINT16;
-			if (asprintf(&vlan->v_name, "VLAN #%d", vlan->v_vid) == -1) {
+			snprintf(vlan_name, sizeof(vlan_name), "VLAN #%d", vlan->v_vid);
+			if ((vlan->v_name = lldpd_intern(vlan_name)) == NULL) {
 				log_warn("cdp", "unable to alloc VLAN name for "
 					  "TLV received on %s",
 					  hardware->h_ifname);
-				free(vlan);
+				lldpd_slab_free(LLDPD_SLAB_VLAN, vlan);
 				goto malformed;
 			}
 			TAILQ_INSERT_TAIL(&port->p_vlans,
@@ -589,22 +592,28 @@ cdp_decode(struct lldpd *cfg, char *frame, int s,
 			CHECK_TLV_SIZE(12, "Power Available");
 			/* check if it is a respone to a request id */
 			if (PEEK_UINT16 > 0) {
-				port->p_cdp_power.management_id = PEEK_UINT16;
-				port->p_power.allocated = PEEK_UINT32;
-				port->p_power.allocated /= 100;
-				port->p_power.supported = 1;
-				port->p_power.enabled = 1;
-				port->p_power.devicetype = LLDP_DOT3_POWER_PSE;
-				port->p_power.powertype = LLDP_DOT3_POWER_8023AT_TYPE2;
-				log_debug("cdp", "Allocated power %d00", port->p_power.allocated);
-				if (port->p_power.allocated > CDP_CLASS_3_MAX_PSE_POE) {
-					port->p_power.allocated -= CDP_SWITCH_POE_CLASS_4_OFFSET;
-				} else if (port->p_power.allocated > CDP_SWITCH_POE_CLASS_3_OFFSET ) {
-					port->p_power.allocated -= CDP_SWITCH_POE_CLASS_3_OFFSET;
+				if (LLDPD_PORT_EXT(port, p_power) == NULL ||
+				    LLDPD_PORT_EXT(port, p_cdp_power) == NULL) {
+					log_warn("cdp", "unable to allocate memory for power information");
+					goto malformed;
+				}
+				port->p_cdp_power->management_id = PEEK_UINT16;
+				port->p_power->allocated = PEEK_UINT32;
+				port->p_power->allocated /= 100;
+				port->p_power->supported = 1;
+				port->p_power->enabled = 1;
+				port->p_power->devicetype = LLDP_DOT3_POWER_PSE;
+				port->p_power->powertype = LLDP_DOT3_POWER_8023AT_TYPE2;
+				log_debug("cdp", "Allocated power %d00", port->p_power->allocated);
+				if (port->p_power->allocated > CDP_CLASS_3_MAX_PSE_POE) {
+					port->p_power->allocated -= CDP_SWITCH_POE_CLASS_4_OFFSET;
+				} else if (port->p_power->allocated > CDP_SWITCH_POE_CLASS_3_OFFSET ) {
+					port->p_power->allocated -= CDP_SWITCH_POE_CLASS_3_OFFSET;
 				} else {
-					port->p_power.allocated = 0;
+					port->p_power->allocated = 0;
 				}
-				port->p_power.requested = hardware->h_lport.p_power.requested;
+				if (hardware->h_lport.p_power)
+					port->p_power->requested = hardware->h_lport.p_power->requested;
 			}
 			break;
 #endif
@@ -616,32 +625,37 @@ cdp_decode(struct lldpd *cfg, char *frame, int s,
 		PEEK_DISCARD(tlv + tlv_len - pos);
 	}
 	if (!software && platform) {
-		if ((chassis->c_descr = (char *)calloc(1,
-			    platform_len + 1)) == NULL) {
+		if ((chassis->c_descr = lldpd_intern_len((char *)platform,
+			    platform_len)) == NULL) {
 			log_warn("cdp", "unable to allocate memory for chassis description");
 			goto malformed;
 		}
-		memcpy(chassis->c_descr, platform, platform_len);
 	} else if (software && !platform) {
-		if ((chassis->c_descr = (char *)calloc(1,
-			    software_len + 1)) == NULL) {
+		if ((chassis->c_descr = lldpd_intern_len((char *)software,
+			    software_len)) == NULL) {
 			log_warn("cdp", "unable to allocate memory for chassis description");
 			goto malformed;
 		}
-		memcpy(chassis->c_descr, software, software_len);
 	} else if (software && platform) {
 #define CONCAT_PLATFORM " running on\n"
-		if ((chassis->c_descr = (char *)calloc(1,
+		char *descr;
+		if ((descr = (char *)calloc(1,
 			    software_len + platform_len +
 			    strlen(CONCAT_PLATFORM) + 1)) == NULL) {
 			log_warn("cdp", "unable to allocate memory for chassis description");
 			goto malformed;
 		}
-		memcpy(chassis->c_descr, platform, platform_len);
-		memcpy(chassis->c_descr + platform_len,
+		memcpy(descr, platform, platform_len);
+		memcpy(descr + platform_len,
 		    CONCAT_PLATFORM, strlen(CONCAT_PLATFORM));
-		memcpy(chassis->c_descr + platform_len + strlen(CONCAT_PLATFORM),
+		memcpy(descr + platform_len + strlen(CONCAT_PLATFORM),
 		    software, software_len);
+		chassis->c_descr = lldpd_intern(descr);
+		free(descr);
+		if (chassis->c_descr == NULL) {
+			log_warn("cdp", "unable to allocate memory for chassis description");
+			goto malformed;
+		}
 	}
 	if ((chassis->c_id == NULL) ||
 	    (port->p_id == NULL) ||
@@ -661,7 +675,7 @@ cdp_decode(struct lldpd *cfg, char *frame, int s,
 malformed:
 	lldpd_chassis_cleanup(chassis, 1);
 	lldpd_port_cleanup(port, 1);
-	free(port);
+	lldpd_slab_free(LLDPD_SLAB_PORT, port);
 	return -1;
 }
 
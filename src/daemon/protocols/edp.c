@@ -243,6 +243,7 @@ edp_decode(struct lldpd *cfg, char *frame, int s,
 	int edp_port, edp_slot;
 	u_int8_t *pos, *pos_edp, *tlv;
 	u_int8_t version[4];
+	char descr[sizeof("EDP enabled device, version 255.255.255.255")];
 #ifdef ENABLE_DOT1
 	struct in_addr address;
 	struct lldpd_port *oport;
@@ -251,14 +252,14 @@ edp_decode(struct lldpd *cfg, char *frame, int s,
 	log_debug("edp", "decode EDP frame on port %s",
 	    hardware->h_ifname);
 
-	if ((chassis = calloc(1, sizeof(struct lldpd_chassis))) == NULL) {
+	if ((chassis = lldpd_slab_alloc(LLDPD_SLAB_CHASSIS)) == NULL) {
 		log_warn("edp", "failed to allocate remote chassis");
 		return -1;
 	}
 	TAILQ_INIT(&chassis->c_mgmt);
-	if ((port = calloc(1, sizeof(struct lldpd_port))) == NULL) {
+	if ((port = lldpd_slab_alloc(LLDPD_SLAB_PORT)) == NULL) {
 		log_warn("edp", "failed to allocate remote port");
-		free(chassis);
+		lldpd_slab_free(LLDPD_SLAB_CHASSIS, chassis);
 		return -1;
 	}
 #ifdef ENABLE_DOT1
@@ -359,8 +360,9 @@ edp_decode(struct lldpd *cfg, char *frame, int s,
 				goto malformed;
 			}
 			port->p_id_len = strlen(port->p_id);
-			if (asprintf(&port->p_descr, "Slot %d / Port %d",
-				edp_slot + 1, edp_port + 1) == -1) {
+			snprintf(descr, sizeof(descr), "Slot %d / Port %d",
+			    edp_slot + 1, edp_port + 1);
+			if ((port->p_descr = lldpd_intern(descr)) == NULL) {
 				log_warn("edp", "unable to allocate memory for "
 				    "port description");
 				goto malformed;
@@ -368,23 +370,25 @@ edp_decode(struct lldpd *cfg, char *frame, int s,
 			PEEK_DISCARD_UINT16; /* vchassis */
 			PEEK_DISCARD(6);     /* Reserved */
 			PEEK_BYTES(version, 4);
-			if (asprintf(&chassis->c_descr,
-				"EDP enabled device, version %d.%d.%d.%d",
-				version[0], version[1],
-				version[2], version[3]) == -1) {
+			snprintf(descr, sizeof(descr),
+			    "EDP enabled device, version %d.%d.%d.%d",
+			    version[0], version[1],
+			    version[2], version[3]);
+			if ((chassis->c_descr = lldpd_intern(descr)) == NULL) {
 				log_warn("edp", "unable to allocate memory for "
 				    "chassis description");
 				goto malformed;
 			}
 			break;
 		case EDP_TLV_DISPLAY:
-			if ((chassis->c_name = (char *)calloc(1, tlv_len + 1)) == NULL) {
+			/* TLV display contains a lot of garbage */
+			if ((chassis->c_name = lldpd_intern_len((char *)pos,
+				    tlv_len)) == NULL) {
 				log_warn("edp", "unable to allocate memory for chassis "
 				    "name");
 				goto malformed;
 			}
-			/* TLV display contains a lot of garbage */
-			PEEK_BYTES(chassis->c_name, tlv_len);
+			PEEK_DISCARD(tlv_len);
 			break;
 		case EDP_TLV_NULL:
 			if (tlv_len != 0) {
@@ -401,8 +405,7 @@ edp_decode(struct lldpd *cfg, char *frame, int s,
 		case EDP_TLV_VLAN:
 #ifdef ENABLE_DOT1
 			CHECK_TLV_SIZE(12, "VLAN");
-			if ((lvlan = (struct lldpd_vlan *)calloc(1,
-				    sizeof(struct lldpd_vlan))) == NULL) {
+			if ((lvlan = lldpd_slab_alloc(LLDPD_SLAB_VLAN)) == NULL) {
 				log_warn("edp", "unable to allocate vlan");
 				goto malformed;
 			}
@@ -421,12 +424,12 @@ edp_decode(struct lldpd *cfg, char *frame, int s,
 				TAILQ_INSERT_TAIL(&chassis->c_mgmt, mgmt, m_entries);
 			}
 
-			if ((lvlan->v_name = (char *)calloc(1,
-				    tlv_len + 1 - 12)) == NULL) {
+			if ((lvlan->v_name = lldpd_intern_len((char *)pos,
+				    tlv_len - 12)) == NULL) {
 				log_warn("edp", "unable to allocate vlan name");
 				goto malformed;
 			}
-			PEEK_BYTES(lvlan->v_name, tlv_len - 12);
+			PEEK_DISCARD(tlv_len - 12);
 
 			TAILQ_INSERT_TAIL(&port->p_vlans,
 			    lvlan, v_entries);
@@ -502,11 +505,11 @@ edp_decode(struct lldpd *cfg, char *frame, int s,
 
 malformed:
 #ifdef ENABLE_DOT1
-	free(lvlan);
+	lldpd_slab_free(LLDPD_SLAB_VLAN, lvlan);
 #endif
 	lldpd_chassis_cleanup(chassis, 1);
 	lldpd_port_cleanup(port, 1);
-	free(port);
+	lldpd_slab_free(LLDPD_SLAB_PORT, port);
 	return -1;
 }
 
@@ -292,54 +292,54 @@ static int _lldp_send(struct lldpd *global,
 			goto toobig;
 	}
 	/* Power */
-	if (port->p_power.devicetype) {
+	if (port->p_power && port->p_power->devicetype) {
 		if (!(
 		      POKE_START_LLDP_TLV(LLDP_TLV_ORG) &&
 		      POKE_BYTES(dot3, sizeof(dot3)) &&
 		      POKE_UINT8(LLDP_TLV_DOT3_POWER) &&
 		      POKE_UINT8((
-				  (((2 - port->p_power.devicetype)    %(1<< 1))<<0) |
-				  (( port->p_power.supported          %(1<< 1))<<1) |
-				  (( port->p_power.enabled            %(1<< 1))<<2) |
-				  (( port->p_power.paircontrol        %(1<< 1))<<3))) &&
-		      POKE_UINT8(port->p_power.pairs) &&
-		      POKE_UINT8(port->p_power.class)))
+				  (((2 - port->p_power->devicetype)    %(1<< 1))<<0) |
+				  (( port->p_power->supported          %(1<< 1))<<1) |
+				  (( port->p_power->enabled            %(1<< 1))<<2) |
+				  (( port->p_power->paircontrol        %(1<< 1))<<3))) &&
+		      POKE_UINT8(port->p_power->pairs) &&
+		      POKE_UINT8(port->p_power->class)))
 			goto toobig;
 		/* 802.3at */
-		if (port->p_power.powertype != LLDP_DOT3_POWER_8023AT_OFF) {
+		if (port->p_power->powertype != LLDP_DOT3_POWER_8023AT_OFF) {
 			if (!(
 			      POKE_UINT8((
-					  (((port->p_power.powertype ==
+					  (((port->p_power->powertype ==
 					      LLDP_DOT3_POWER_8023AT_TYPE1)?1:0) << 7) |
-					   (((port->p_power.devicetype ==
+					   (((port->p_power->devicetype ==
 					      LLDP_DOT3_POWER_PSE)?0:1) << 6) |
-					   ((port->p_power.source   %(1<< 2))<<4) |
-					   (((port->p_power.pid4 ==
+					   ((port->p_power->source   %(1<< 2))<<4) |
+					   (((port->p_power->pid4 ==
 					      LLDP_DOT3_POWER_4PID_SUP)?1:0)<<2) |
-					   ((port->p_power.priority %(1<< 2))<<0))) &&
-			      POKE_UINT16(port->p_power.requested) &&
-			      POKE_UINT16(port->p_power.allocated)))
+					   ((port->p_power->priority %(1<< 2))<<0))) &&
+			      POKE_UINT16(port->p_power->requested) &&
+			      POKE_UINT16(port->p_power->allocated)))
 				goto toobig;
 		}
 		/* 802.3bt */
-		if(port->p_power.pid4) {
+		if(port->p_power->pid4) {
 			if(!(
-			     POKE_UINT16(port->p_power.requestedA) &&
-			     POKE_UINT16(port->p_power.requestedB) &&
-			     POKE_UINT16(port->p_power.allocatedA) &&
-			     POKE_UINT16(port->p_power.allocatedB) &&
-			     POKE_UINT16(port->p_power.powerStatus) &&
-			     POKE_UINT8(port->p_power.systemSetup) &&
-			     POKE_UINT16(port->p_power.pseMaxAvailPower) &&
-			     POKE_UINT8(port->p_power.autoClass) &&
+			     POKE_UINT16(port->p_power->requestedA) &&
+			     POKE_UINT16(port->p_power->requestedB) &&
+			     POKE_UINT16(port->p_power->allocatedA) &&
+			     POKE_UINT16(port->p_power->allocatedB) &&
+			     POKE_UINT16(port->p_power->powerStatus) &&
+			     POKE_UINT8(port->p_power->systemSetup) &&
+			     POKE_UINT16(port->p_power->pseMaxAvailPower) &&
+			     POKE_UINT8(port->p_power->autoClass) &&
 			     //TODO this is probably incorrect endianess, switch didn't read same shutdown time
 			/* power down is 3 octets long, might have issues with endianness */ 
-			     POKE_UINT8((port->p_power.powerDown>> 16) & 0xff) && 
-			     POKE_UINT8((port->p_power.powerDown>> 8) & 0xff) && 
-			     POKE_UINT8((port->p_power.powerDown>> 0) & 0xff))) 
+			     POKE_UINT8((port->p_power->powerDown>> 16) & 0xff) && 
+			     POKE_UINT8((port->p_power->powerDown>> 8) & 0xff) && 
+			     POKE_UINT8((port->p_power->powerDown>> 0) & 0xff))) 
 			/* Dealing with endianness:
 			# if __BYTE_ORDER == __BIG_ENDIAN
-			     POKE_BYTES(port->p_power.powerDown, LLDP_DOT3_POWER_POWERDOWN_LEN)
+			     POKE_BYTES(port->p_power->powerDown, LLDP_DOT3_POWER_POWERDOWN_LEN)
 			# else
 			# if __BYTE_ORDER == __LITTLE_ENDIAN
 			*/
@@ -351,21 +351,21 @@ static int _lldp_send(struct lldpd *global,
 	}
 	
 	/* Power Measurements (802.3bt) */
-	if (port->p_measurements.flags) { /* not sure what to be checking here? */
+	if (port->p_measurements && port->p_measurements->flags) { /* not sure what to be checking here? */
 		if(!(
 			POKE_START_LLDP_TLV(LLDP_TLV_ORG) &&
 			POKE_BYTES(dot3, sizeof(dot3)) &&
 			POKE_UINT8(LLDP_TLV_DOT3_MEASURE) &&
-			POKE_UINT32(port->p_measurements.energyMeas) &&
-			POKE_UINT16(port->p_measurements.powerMeas) &&
-			POKE_UINT16(port->p_measurements.currentMeas) &&
-			POKE_UINT16(port->p_measurements.voltMeas) &&
-			POKE_UINT16(port->p_measurements.energyUncertainty) &&
-			POKE_UINT16(port->p_measurements.powerUncertainty) &&
-			POKE_UINT16(port->p_measurements.currentUncertainty) &&
-			POKE_UINT16(port->p_measurements.voltUncertainty) &&
-			POKE_UINT16(port->p_measurements.flags) &&
-			POKE_UINT16(port->p_measurements.powerPriceIndex) &&
+			POKE_UINT32(port->p_measurements->energyMeas) &&
+			POKE_UINT16(port->p_measurements->powerMeas) &&
+			POKE_UINT16(port->p_measurements->currentMeas) &&
+			POKE_UINT16(port->p_measurements->voltMeas) &&
+			POKE_UINT16(port->p_measurements->energyUncertainty) &&
+			POKE_UINT16(port->p_measurements->powerUncertainty) &&
+			POKE_UINT16(port->p_measurements->currentUncertainty) &&
+			POKE_UINT16(port->p_measurements->voltUncertainty) &&
+			POKE_UINT16(port->p_measurements->flags) &&
+			POKE_UINT16(port->p_measurements->powerPriceIndex) &&
 			POKE_END_LLDP_TLV))
 				goto toobig;
 	}
@@ -418,14 +418,15 @@ static int _lldp_send(struct lldpd *global,
 
 		/* LLDP-MED location */
 		for (i = 0; i < LLDP_MED_LOCFORMAT_LAST; i++) {
-			if (port->p_med_location[i].format == i + 1) {
+			if (port->p_med &&
+			    port->p_med->location[i].format == i + 1) {
 				if (!(
 				      POKE_START_LLDP_TLV(LLDP_TLV_ORG) &&
 				      POKE_BYTES(med, sizeof(med)) &&
 				      POKE_UINT8(LLDP_TLV_MED_LOCATION) &&
-				      POKE_UINT8(port->p_med_location[i].format) &&
-				      POKE_BYTES(port->p_med_location[i].data,
-					  port->p_med_location[i].data_len) &&
+				      POKE_UINT8(port->p_med->location[i].format) &&
+				      POKE_BYTES(port->p_med->location[i].data,
+					  port->p_med->location[i].data_len) &&
 				      POKE_END_LLDP_TLV))
 					goto toobig;
 			}
@@ -433,37 +434,39 @@ static int _lldp_send(struct lldpd *global,
 
 		/* LLDP-MED network policy */
 		for (i = 0; i < LLDP_MED_APPTYPE_LAST; i++) {
-			if (port->p_med_policy[i].type == i + 1) {
+			if (port->p_med &&
+			    port->p_med->policy[i].type == i + 1) {
 				if (!(
 				      POKE_START_LLDP_TLV(LLDP_TLV_ORG) &&
 				      POKE_BYTES(med, sizeof(med)) &&
 				      POKE_UINT8(LLDP_TLV_MED_POLICY) &&
 				      POKE_UINT32((
-					((port->p_med_policy[i].type     %(1<< 8))<<24) |
-					((port->p_med_policy[i].unknown  %(1<< 1))<<23) |
-					((port->p_med_policy[i].tagged   %(1<< 1))<<22) |
+					((port->p_med->policy[i].type     %(1<< 8))<<24) |
+					((port->p_med->policy[i].unknown  %(1<< 1))<<23) |
+					((port->p_med->policy[i].tagged   %(1<< 1))<<22) |
 				      /*((0                              %(1<< 1))<<21) |*/
-					((port->p_med_policy[i].vid      %(1<<12))<< 9) |
-					((port->p_med_policy[i].priority %(1<< 3))<< 6) |
-					((port->p_med_policy[i].dscp     %(1<< 6))<< 0) )) &&
+					((port->p_med->policy[i].vid      %(1<<12))<< 9) |
+					((port->p_med->policy[i].priority %(1<< 3))<< 6) |
+					((port->p_med->policy[i].dscp     %(1<< 6))<< 0) )) &&
 				      POKE_END_LLDP_TLV))
 					goto toobig;
 			}
 		}
 
 		/* LLDP-MED POE-MDI */
-		if ((port->p_med_power.devicetype == LLDP_MED_POW_TYPE_PSE) ||
-		    (port->p_med_power.devicetype == LLDP_MED_POW_TYPE_PD)) {
+		if (port->p_med &&
+		    ((port->p_med->power.devicetype == LLDP_MED_POW_TYPE_PSE) ||
+		     (port->p_med->power.devicetype == LLDP_MED_POW_TYPE_PD))) {
 			int devicetype = 0, source = 0;
 			if (!(
 			      POKE_START_LLDP_TLV(LLDP_TLV_ORG) &&
 			      POKE_BYTES(med, sizeof(med)) &&
 			      POKE_UINT8(LLDP_TLV_MED_MDI)))
 				goto toobig;
-			switch (port->p_med_power.devicetype) {
+			switch (port->p_med->power.devicetype) {
 			case LLDP_MED_POW_TYPE_PSE:
 				devicetype = 0;
-				switch (port->p_med_power.source) {
+				switch (port->p_med->power.source) {
 				case LLDP_MED_POW_SOURCE_PRIMARY: source = 1; break;
 				case LLDP_MED_POW_SOURCE_BACKUP: source = 2; break;
 				case LLDP_MED_POW_SOURCE_RESERVED: source = 3; break;
@@ -472,7 +475,7 @@ static int _lldp_send(struct lldpd *global,
 				break;
 			case LLDP_MED_POW_TYPE_PD:
 				devicetype = 1;
-				switch (port->p_med_power.source) {
+				switch (port->p_med->power.source) {
 				case LLDP_MED_POW_SOURCE_PSE: source = 1; break;
 				case LLDP_MED_POW_SOURCE_LOCAL: source = 2; break;
 				case LLDP_MED_POW_SOURCE_BOTH: source = 3; break;
@@ -484,8 +487,8 @@ static int _lldp_send(struct lldpd *global,
 			      POKE_UINT8((
 				((devicetype                   %(1<< 2))<<6) |
 				((source                       %(1<< 2))<<4) |
-				((port->p_med_power.priority   %(1<< 4))<<0) )) &&
-			      POKE_UINT16(port->p_med_power.val) &&
+				((port->p_med->power.priority   %(1<< 4))<<0) )) &&
+			      POKE_UINT16(port->p_med->power.val) &&
 			      POKE_END_LLDP_TLV))
 				goto toobig;
 		}
@@ -522,18 +525,16 @@ end:
 	hardware->h_tx_cnt++;
 
 	/* We assume that LLDP frame is the reference */
-	if (!shutdown && (frame = (struct lldpd_frame*)malloc(
-			sizeof(int) + pos - packet)) != NULL) {
-		frame->size = pos - packet;
+	if (!shutdown && (frame = lldpd_frame_alloc(pos - packet)) != NULL) {
 		memcpy(&frame->frame, packet, frame->size);
 		if ((hardware->h_lport.p_lastframe == NULL) ||
 		    (hardware->h_lport.p_lastframe->size != frame->size) ||
 		    (memcmp(hardware->h_lport.p_lastframe->frame, frame->frame,
 			frame->size) != 0)) {
-			free(hardware->h_lport.p_lastframe);
+			lldpd_frame_free(hardware->h_lport.p_lastframe);
 			hardware->h_lport.p_lastframe = frame;
 			hardware->h_lport.p_lastchange = time(NULL);
-		} else free(frame);
+		} else lldpd_frame_free(frame);
 	}
 
 	free(packet);
@@ -659,14 +660,14 @@ lldp_decode(struct lldpd *cfg, char *frame, int s,
 	log_debug("lldp", "receive LLDP PDU on %s",
 	    hardware->h_ifname);
 
-	if ((chassis = calloc(1, sizeof(struct lldpd_chassis))) == NULL) {
+	if ((chassis = lldpd_slab_alloc(LLDPD_SLAB_CHASSIS)) == NULL) {
 		log_warn("lldp", "failed to allocate remote chassis");
 		return -1;
 	}
 	TAILQ_INIT(&chassis->c_mgmt);
-	if ((port = calloc(1, sizeof(struct lldpd_port))) == NULL) {
+	if ((port = lldpd_slab_alloc(LLDPD_SLAB_PORT)) == NULL) {
 		log_warn("lldp", "failed to allocate remote port");
-		free(chassis);
+		lldpd_slab_free(LLDPD_SLAB_CHASSIS, chassis);
 		return -1;
 	}
 #ifdef ENABLE_DOT1
@@ -766,13 +767,13 @@ lldp_decode(struct lldpd *cfg, char *frame, int s,
 				    hardware->h_ifname);
 				break;
 			}
-			if ((b = (char *)calloc(1, tlv_size + 1)) == NULL) {
+			if ((b = lldpd_intern_len((char *)pos, tlv_size)) == NULL) {
 				log_warn("lldp", "unable to allocate memory for string tlv "
 				    "received on %s",
 				    hardware->h_ifname);
 				goto malformed;
 			}
-			PEEK_BYTES(b, tlv_size);
+			PEEK_DISCARD(tlv_size);
 			if (tlv_type == LLDP_TLV_PORT_DESCR)
 				port->p_descr = b;
 			else if (tlv_type == LLDP_TLV_SYSTEM_NAME)
@@ -832,8 +833,7 @@ lldp_decode(struct lldpd *cfg, char *frame, int s,
 				switch (tlv_subtype) {
 				case LLDP_TLV_DOT1_VLANNAME:
 					CHECK_TLV_SIZE(7, "VLAN");
-					if ((vlan = (struct lldpd_vlan *)calloc(1,
-						    sizeof(struct lldpd_vlan))) == NULL) {
+					if ((vlan = lldpd_slab_alloc(LLDPD_SLAB_VLAN)) == NULL) {
 						log_warn("lldp", "unable to alloc vlan "
 						    "structure for "
 						    "tlv received on %s",
@@ -843,14 +843,14 @@ lldp_decode(struct lldpd *cfg, char *frame, int s,
 					vlan->v_vid = PEEK_UINT16;
 					vlan_len = PEEK_UINT8;
 					CHECK_TLV_SIZE(7 + vlan_len, "VLAN");
-					if ((vlan->v_name =
-						(char *)calloc(1, vlan_len + 1)) == NULL) {
+					if ((vlan->v_name = lldpd_intern_len((char *)pos,
+						    vlan_len)) == NULL) {
 						log_warn("lldp", "unable to alloc vlan name for "
 						    "tlv received on %s",
 						    hardware->h_ifname);
 						goto malformed;
 					}
-					PEEK_BYTES(vlan->v_name, vlan_len);
+					PEEK_DISCARD(vlan_len);
 					TAILQ_INSERT_TAIL(&port->p_vlans,
 					    vlan, v_entries);
 					vlan = NULL;
@@ -869,8 +869,7 @@ lldp_decode(struct lldpd *cfg, char *frame, int s,
 					   enabled bit is set - PPVID TLV is
 					   considered error  and discarded */
 					/* if PPVID > 4096 - bad and discard */
-					if ((ppvid = (struct lldpd_ppvid *)calloc(1,
-						    sizeof(struct lldpd_ppvid))) == NULL) {
+					if ((ppvid = lldpd_slab_alloc(LLDPD_SLAB_PPVID)) == NULL) {
 						log_warn("lldp", "unable to alloc ppvid "
 						    "structure for "
 						    "tlv received on %s",
@@ -888,8 +887,7 @@ lldp_decode(struct lldpd *cfg, char *frame, int s,
 					   one PI TLVs are received  - discard
 					   if duplicate ?? */
 					CHECK_TLV_SIZE(5, "PI");
-					if ((pi = (struct lldpd_pi *)calloc(1,
-						    sizeof(struct lldpd_pi))) == NULL) {
+					if ((pi = lldpd_slab_alloc(LLDPD_SLAB_PI)) == NULL) {
 						log_warn("lldp", "unable to alloc PI "
 						    "structure for "
 						    "tlv received on %s",
@@ -943,66 +941,80 @@ lldp_decode(struct lldpd *cfg, char *frame, int s,
 					break;
 				case LLDP_TLV_DOT3_POWER:
 					CHECK_TLV_SIZE(7, "Power");
-					port->p_power.devicetype = PEEK_UINT8;
-					port->p_power.supported =
-						(port->p_power.devicetype & 0x2) >> 1;
-					port->p_power.enabled =
-						(port->p_power.devicetype & 0x4) >> 2;
-					port->p_power.paircontrol =
-						(port->p_power.devicetype & 0x8) >> 3;
-					port->p_power.devicetype =
-						(port->p_power.devicetype & 0x1)?
+					if (LLDPD_PORT_EXT(port, p_power) == NULL) {
+						log_warn("lldp", "unable to allocate memory "
+						    "for Dot3 power for "
+						    "frame received on %s",
+						    hardware->h_ifname);
+						goto malformed;
+					}
+					port->p_power->devicetype = PEEK_UINT8;
+					port->p_power->supported =
+						(port->p_power->devicetype & 0x2) >> 1;
+					port->p_power->enabled =
+						(port->p_power->devicetype & 0x4) >> 2;
+					port->p_power->paircontrol =
+						(port->p_power->devicetype & 0x8) >> 3;
+					port->p_power->devicetype =
+						(port->p_power->devicetype & 0x1)?
 						LLDP_DOT3_POWER_PSE:LLDP_DOT3_POWER_PD;
-					port->p_power.pairs = PEEK_UINT8;
-					port->p_power.class = PEEK_UINT8;
+					port->p_power->pairs = PEEK_UINT8;
+					port->p_power->class = PEEK_UINT8;
 					/* 802.3at? */
 					if (tlv_size >= 12) {
-						port->p_power.powertype = PEEK_UINT8;
-						port->p_power.source =
-						    (port->p_power.powertype & (1<<5 | 1<<4)) >> 4;
-						port->p_power.pid4 =
-							(port->p_power.powertype & (1 << 2) >> 2);
-						port->p_power.priority =
-						    (port->p_power.powertype & (1<<1 | 1<<0));
-						port->p_power.powertype =
-						    (port->p_power.powertype & (1<<7))?
+						port->p_power->powertype = PEEK_UINT8;
+						port->p_power->source =
+						    (port->p_power->powertype & (1<<5 | 1<<4)) >> 4;
+						port->p_power->pid4 =
+							(port->p_power->powertype & (1 << 2) >> 2);
+						port->p_power->priority =
+						    (port->p_power->powertype & (1<<1 | 1<<0));
+						port->p_power->powertype =
+						    (port->p_power->powertype & (1<<7))?
 						    LLDP_DOT3_POWER_8023AT_TYPE1:
 						    LLDP_DOT3_POWER_8023AT_TYPE2;
-						port->p_power.requested = PEEK_UINT16;
-						port->p_power.allocated = PEEK_UINT16;
+						port->p_power->requested = PEEK_UINT16;
+						port->p_power->allocated = PEEK_UINT16;
 					} 
 					/* 802.3bt */
 					if (tlv_size >= 29) {
 						/* Is this logic covered by using unions? */
-						port->p_power.requestedA	= PEEK_UINT16;
-						port->p_power.requestedB 	= PEEK_UINT16;
-						port->p_power.allocatedA 	= PEEK_UINT16;
-						port->p_power.allocatedB 	= PEEK_UINT16;
-						port->p_power.powerStatus 	= PEEK_UINT16;
-						port->p_power.systemSetup	= PEEK_UINT8;	
-						port->p_power.pseMaxAvailPower	= PEEK_UINT16;
-						port->p_power.autoClass		= PEEK_UINT8;
+						port->p_power->requestedA	= PEEK_UINT16;
+						port->p_power->requestedB 	= PEEK_UINT16;
+						port->p_power->allocatedA 	= PEEK_UINT16;
+						port->p_power->allocatedB 	= PEEK_UINT16;
+						port->p_power->powerStatus 	= PEEK_UINT16;
+						port->p_power->systemSetup	= PEEK_UINT8;	
+						port->p_power->pseMaxAvailPower	= PEEK_UINT16;
+						port->p_power->autoClass		= PEEK_UINT8;
 						/*Power down is 3 octets long, possible endian bug here! */
-						port->p_power.powerDown		= PEEK_UINT8 << 16;
-						port->p_power.powerDown		|= (PEEK_UINT8 << 8);
-						port->p_power.powerDown		|= (PEEK_UINT8 << 0);
+						port->p_power->powerDown		= PEEK_UINT8 << 16;
+						port->p_power->powerDown		|= (PEEK_UINT8 << 8);
+						port->p_power->powerDown		|= (PEEK_UINT8 << 0);
 					} else
-						port->p_power.powertype =
+						port->p_power->powertype =
 						    LLDP_DOT3_POWER_8023AT_OFF;
 					break;
 				case LLDP_TLV_DOT3_MEASURE:
 					CHECK_TLV_SIZE(26, "Measurements");
+					if (LLDPD_PORT_EXT(port, p_measurements) == NULL) {
+						log_warn("lldp", "unable to allocate memory "
+						    "for Dot3 measurements for "
+						    "frame received on %s",
+						    hardware->h_ifname);
+						goto malformed;
+					}
 					/*could possibly PEEK whole power sturct using PEEK_BYTES */
-					port->p_measurements.energyMeas		= PEEK_UINT32;
-					port->p_measurements.powerMeas		= PEEK_UINT16;
-					port->p_measurements.currentMeas	= PEEK_UINT16;
-					port->p_measurements.voltMeas		= PEEK_UINT16;
-					port->p_measurements.energyUncertainty	= PEEK_UINT16;
-					port->p_measurements.powerUncertainty	= PEEK_UINT16;
-					port->p_measurements.currentUncertainty	= PEEK_UINT16;
-					port->p_measurements.voltUncertainty	= PEEK_UINT16;
-					port->p_measurements.flags		= PEEK_UINT16;
-					port->p_measurements.powerPriceIndex	= PEEK_UINT16;
+					port->p_measurements->energyMeas		= PEEK_UINT32;
+					port->p_measurements->powerMeas		= PEEK_UINT16;
+					port->p_measurements->currentMeas	= PEEK_UINT16;
+					port->p_measurements->voltMeas		= PEEK_UINT16;
+					port->p_measurements->energyUncertainty	= PEEK_UINT16;
+					port->p_measurements->powerUncertainty	= PEEK_UINT16;
+					port->p_measurements->currentUncertainty	= PEEK_UINT16;
+					port->p_measurements->voltUncertainty	= PEEK_UINT16;
+					port->p_measurements->flags		= PEEK_UINT16;
+					port->p_measurements->powerPriceIndex	= PEEK_UINT16;
 					break;
 				default:
 					/* Unknown Dot3 TLV, ignore it */
@@ -1037,17 +1049,24 @@ lldp_decode(struct lldpd *cfg, char *frame, int s,
 						    hardware->h_ifname);
 						break;
 					}
-					port->p_med_policy[(policy >> 24) - 1].type =
+					if (LLDPD_PORT_EXT(port, p_med) == NULL) {
+						log_warn("lldp", "unable to allocate memory "
+						    "for LLDP-MED policy for "
+						    "frame received on %s",
+						    hardware->h_ifname);
+						goto malformed;
+					}
+					port->p_med->policy[(policy >> 24) - 1].type =
 					    (policy >> 24);
-					port->p_med_policy[(policy >> 24) - 1].unknown =
+					port->p_med->policy[(policy >> 24) - 1].unknown =
 					    ((policy & 0x800000) != 0);
-					port->p_med_policy[(policy >> 24) - 1].tagged =
+					port->p_med->policy[(policy >> 24) - 1].tagged =
 					    ((policy & 0x400000) != 0);
-					port->p_med_policy[(policy >> 24) - 1].vid =
+					port->p_med->policy[(policy >> 24) - 1].vid =
 					    (policy & 0x001FFE00) >> 9;
-					port->p_med_policy[(policy >> 24) - 1].priority =
+					port->p_med->policy[(policy >> 24) - 1].priority =
 					    (policy & 0x1C0) >> 6;
-					port->p_med_policy[(policy >> 24) - 1].dscp =
+					port->p_med->policy[(policy >> 24) - 1].dscp =
 					    policy & 0x3F;
 					port->p_med_cap_enabled |=
 					    LLDP_MED_CAP_POLICY;
@@ -1062,7 +1081,14 @@ lldp_decode(struct lldpd *cfg, char *frame, int s,
 						    hardware->h_ifname);
 						break;
 					}
-					if ((port->p_med_location[loctype - 1].data =
+					if (LLDPD_PORT_EXT(port, p_med) == NULL) {
+						log_warn("lldp", "unable to allocate memory "
+						    "for LLDP-MED location for "
+						    "frame received on %s",
+						    hardware->h_ifname);
+						goto malformed;
+					}
+					if ((port->p_med->location[loctype - 1].data =
 						(char*)malloc(tlv_size - 5)) == NULL) {
 						log_warn("lldp", "unable to allocate memory "
 						    "for LLDP-MED location for "
@@ -1070,73 +1096,80 @@ lldp_decode(struct lldpd *cfg, char *frame, int s,
 						    hardware->h_ifname);
 						goto malformed;
 					}
-					PEEK_BYTES(port->p_med_location[loctype - 1].data,
+					PEEK_BYTES(port->p_med->location[loctype - 1].data,
 					    tlv_size - 5);
-					port->p_med_location[loctype - 1].data_len =
+					port->p_med->location[loctype - 1].data_len =
 					    tlv_size - 5;
-					port->p_med_location[loctype - 1].format = loctype;
+					port->p_med->location[loctype - 1].format = loctype;
 					port->p_med_cap_enabled |=
 					    LLDP_MED_CAP_LOCATION;
 					break;
 				case LLDP_TLV_MED_MDI:
 					CHECK_TLV_SIZE(7, "LLDP-MED PoE-MDI");
+					if (LLDPD_PORT_EXT(port, p_med) == NULL) {
+						log_warn("lldp", "unable to allocate memory "
+						    "for LLDP-MED PoE-MDI for "
+						    "frame received on %s",
+						    hardware->h_ifname);
+						goto malformed;
+					}
 					power = PEEK_UINT8;
 					switch (power & 0xC0) {
 					case 0x0:
-						port->p_med_power.devicetype = LLDP_MED_POW_TYPE_PSE;
+						port->p_med->power.devicetype = LLDP_MED_POW_TYPE_PSE;
 						port->p_med_cap_enabled |=
 						    LLDP_MED_CAP_MDI_PSE;
 						switch (power & 0x30) {
 						case 0x0:
-							port->p_med_power.source =
+							port->p_med->power.source =
 							    LLDP_MED_POW_SOURCE_UNKNOWN;
 							break;
 						case 0x10:
-							port->p_med_power.source =
+							port->p_med->power.source =
 							    LLDP_MED_POW_SOURCE_PRIMARY;
 							break;
 						case 0x20:
-							port->p_med_power.source =
+							port->p_med->power.source =
 							    LLDP_MED_POW_SOURCE_BACKUP;
 							break;
 						default:
-							port->p_med_power.source =
+							port->p_med->power.source =
 							    LLDP_MED_POW_SOURCE_RESERVED;
 						}
 						break;
 					case 0x40:
-						port->p_med_power.devicetype = LLDP_MED_POW_TYPE_PD;
+						port->p_med->power.devicetype = LLDP_MED_POW_TYPE_PD;
 						port->p_med_cap_enabled |=
 						    LLDP_MED_CAP_MDI_PD;
 						switch (power & 0x30) {
 						case 0x0:
-							port->p_med_power.source =
+							port->p_med->power.source =
 							    LLDP_MED_POW_SOURCE_UNKNOWN;
 							break;
 						case 0x10:
-							port->p_med_power.source =
+							port->p_med->power.source =
 							    LLDP_MED_POW_SOURCE_PSE;
 							break;
 						case 0x20:
-							port->p_med_power.source =
+							port->p_med->power.source =
 							    LLDP_MED_POW_SOURCE_LOCAL;
 							break;
 						default:
-							port->p_med_power.source =
+							port->p_med->power.source =
 							    LLDP_MED_POW_SOURCE_BOTH;
 						}
 						break;
 					default:
-						port->p_med_power.devicetype =
+						port->p_med->power.devicetype =
 						    LLDP_MED_POW_TYPE_RESERVED;
 					}
 					if ((power & 0x0F) > LLDP_MED_POW_PRIO_LOW)
-						port->p_med_power.priority =
+						port->p_med->power.priority =
 						    LLDP_MED_POW_PRIO_UNKNOWN;
 					else
-						port->p_med_power.priority =
+						port->p_med->power.priority =
 						    power & 0x0F;
-					port->p_med_power.val = PEEK_UINT16;
+					port->p_med->power.val = PEEK_UINT16;
 					break;
 				case LLDP_TLV_MED_IV_HW:
 				case LLDP_TLV_MED_IV_SW:
@@ -1148,8 +1181,8 @@ lldp_decode(struct lldpd *cfg, char *frame, int s,
 					if (tlv_size <= 4)
 						b = NULL;
 					else {
-						if ((b = (char*)malloc(tlv_size - 3)) ==
-						    NULL) {
+						if ((b = lldpd_intern_len((char *)pos,
+							    tlv_size - 4)) == NULL) {
 							log_warn("lldp", "unable to allocate "
 							    "memory for LLDP-MED "
 							    "inventory for frame "
@@ -1157,8 +1190,7 @@ lldp_decode(struct lldpd *cfg, char *frame, int s,
 							    hardware->h_ifname);
 							goto malformed;
 						}
-						PEEK_BYTES(b, tlv_size - 4);
-						b[tlv_size - 4] = '\0';
+						PEEK_DISCARD(tlv_size - 4);
 					}
 					switch (tlv_subtype) {
 					case LLDP_TLV_MED_IV_HW:
@@ -1201,7 +1233,7 @@ lldp_decode(struct lldpd *cfg, char *frame, int s,
 				    hardware->h_ifname);
 				hardware->h_rx_unrecognized_cnt++;
 #ifdef ENABLE_CUSTOM
-				custom = (struct lldpd_custom*)calloc(1, sizeof(struct lldpd_custom));
+				custom = lldpd_slab_alloc(LLDPD_SLAB_CUSTOM);
 				if (!custom) {
 					log_warn("lldp",
 					    "unable to allocate memory for custom TLV");
@@ -1251,14 +1283,14 @@ lldp_decode(struct lldpd *cfg, char *frame, int s,
 	return 1;
 malformed:
 #ifdef ENABLE_CUSTOM
-	free(custom);
+	lldpd_slab_free(LLDPD_SLAB_CUSTOM, custom);
 #endif
 #ifdef ENABLE_DOT1
-	free(vlan);
-	free(pi);
+	lldpd_slab_free(LLDPD_SLAB_VLAN, vlan);
+	lldpd_slab_free(LLDPD_SLAB_PI, pi);
 #endif
 	lldpd_chassis_cleanup(chassis, 1);
 	lldpd_port_cleanup(port, 1);
-	free(port);
+	lldpd_slab_free(LLDPD_SLAB_PORT, port);
 	return -1;
 }
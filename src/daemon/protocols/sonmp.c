@@ -291,18 +291,19 @@ sonmp_decode(struct lldpd *cfg, char *frame, int s,
 	u_int8_t *pos;
 	u_int8_t seg[3], rchassis;
 	struct in_addr address;
+	char descr[sizeof("port ff:ff:ff")];
 
 	log_debug("sonmp", "decode SONMP PDU from %s",
 	    hardware->h_ifname);
 
-	if ((chassis = calloc(1, sizeof(struct lldpd_chassis))) == NULL) {
+	if ((chassis = lldpd_slab_alloc(LLDPD_SLAB_CHASSIS)) == NULL) {
 		log_warn("sonmp", "failed to allocate remote chassis");
 		return -1;
 	}
 	TAILQ_INIT(&chassis->c_mgmt);
-	if ((port = calloc(1, sizeof(struct lldpd_port))) == NULL) {
+	if ((port = lldpd_slab_alloc(LLDPD_SLAB_PORT)) == NULL) {
 		log_warn("sonmp", "failed to allocate remote port");
-		free(chassis);
+		lldpd_slab_free(LLDPD_SLAB_CHASSIS, chassis);
 		return -1;
 	}
 #ifdef ENABLE_DOT1
@@ -349,8 +350,8 @@ sonmp_decode(struct lldpd *cfg, char *frame, int s,
 		if (sonmp_chassis_types[i].type == rchassis)
 			break;
 	}
-	if (asprintf(&chassis->c_descr, "%s",
-		sonmp_chassis_types[i].description) == -1) {
+	if ((chassis->c_descr = lldpd_intern(
+		    sonmp_chassis_types[i].description)) == NULL) {
 		log_warnx("sonmp", "unable to write chassis description for %s",
 		    hardware->h_ifname);
 		goto malformed;
@@ -378,27 +379,19 @@ sonmp_decode(struct lldpd *cfg, char *frame, int s,
 	port->p_id_len = strlen(port->p_id);
 
 	/* Port description depend on the number of segments */
-	if ((seg[0] == 0) && (seg[1] == 0)) {
-		if (asprintf(&port->p_descr, "port %d",
-			seg[2]) == -1) {
-			log_warnx("sonmp", "unable to write port description for %s",
-			    hardware->h_ifname);
-			goto malformed;
-		}
-	} else if (seg[0] == 0) {
-		if (asprintf(&port->p_descr, "port %d/%d",
-			seg[1], seg[2]) == -1) {
-			log_warnx("sonmp", "unable to write port description for %s",
-			    hardware->h_ifname);
-			goto malformed;
-		}
-	} else {
-		if (asprintf(&port->p_descr, "port %x:%x:%x",
-			seg[0], seg[1], seg[2]) == -1) {
-			log_warnx("sonmp", "unable to write port description for %s",
-			    hardware->h_ifname);
-			goto malformed;
-		}
+	if ((seg[0] == 0) && (seg[1] == 0))
+		snprintf(descr, sizeof(descr), "port %d",
+		    seg[2]);
+	else if (seg[0] == 0)
+		snprintf(descr, sizeof(descr), "port %d/%d",
+		    seg[1], seg[2]);
+	else
+		snprintf(descr, sizeof(descr), "port %x:%x:%x",
+		    seg[0], seg[1], seg[2]);
+	if ((port->p_descr = lldpd_intern(descr)) == NULL) {
+		log_warnx("sonmp", "unable to write port description for %s",
+		    hardware->h_ifname);
+		goto malformed;
 	}
 	*newchassis = chassis;
 	*newport = port;
@@ -407,7 +400,7 @@ sonmp_decode(struct lldpd *cfg, char *frame, int s,
 malformed:
 	lldpd_chassis_cleanup(chassis, 1);
 	lldpd_port_cleanup(port, 1);
-	free(port);
+	lldpd_slab_free(LLDPD_SLAB_PORT, port);
 	return -1;
 }
 
@@ -0,0 +1,190 @@
+/* -*- mode: c; c-file-style: "openbsd" -*- */
+/*
+ * Copyright (c) 2019 Vincent Bernat <vincent@bernat.im>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* Publish local ports, neighbors and counters into a memory-mapped file. The
+ * layout is described in ctl.h. Readers never talk to us: we only write the
+ * inactive slot and switch to it. */
+
+#include "lldpd.h"
+
+#include <unistd.h>
+#include <string.h>
+#include <sys/mman.h>
+
+struct lldpd_snapshot {
+	int fd;
+	unsigned char *map;
+	size_t size;		/* Size of the file (and of the mapping) */
+};
+
+static size_t
+snapshot_pagesize(void)
+{
+	long pagesize = sysconf(_SC_PAGESIZE);
+	return (pagesize > 0)?pagesize:4096;
+}
+
+/* Grow the file to `size` bytes and remap it. */
+static int
+snapshot_grow(struct lldpd_snapshot *s, size_t size)
+{
+	unsigned char *map;
+	if (ftruncate(s->fd, size) == -1) {
+		log_warn("snapshot", "unable to grow snapshot file to %zu bytes",
+		    size);
+		return -1;
+	}
+	if ((map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+		    s->fd, 0)) == MAP_FAILED) {
+		log_warn("snapshot", "unable to map snapshot file");
+		return -1;
+	}
+	if (s->map) munmap(s->map, s->size);
+	s->map = map;
+	s->size = size;
+	return 0;
+}
+
+void
+snapshot_open(struct lldpd *cfg)
+{
+	struct lldpd_snapshot *s;
+	struct snapshot_header *h;
+	int fd;
+
+	if (cfg->g_snapshot) return;
+	log_debug("snapshot", "publish snapshots to " LLDPD_SNAPSHOT_FILE);
+	if ((fd = priv_snapshot(1)) == -1) {
+		log_warnx("snapshot", "unable to create snapshot file");
+		return;
+	}
+	if ((s = calloc(1, sizeof(struct lldpd_snapshot))) == NULL) {
+		log_warn("snapshot", "unable to allocate memory for snapshot");
+		close(fd);
+		return;
+	}
+	s->fd = fd;
+	if (snapshot_grow(s, snapshot_pagesize()) == -1) {
+		close(fd);
+		free(s);
+		priv_snapshot(0);
+		return;
+	}
+	h = (struct snapshot_header *)s->map;
+	h->version = HMSG_VERSION;
+	__atomic_store_n(&h->magic, SNAPSHOT_MAGIC, __ATOMIC_RELEASE);
+	cfg->g_snapshot = s;
+	snapshot_update(cfg);
+}
+
+void
+snapshot_close(struct lldpd *cfg)
+{
+	struct lldpd_snapshot *s = cfg->g_snapshot;
+	struct snapshot_header *h;
+
+	if (!s) return;
+	log_debug("snapshot", "stop publishing snapshots");
+	h = (struct snapshot_header *)s->map;
+	__atomic_store_n(&h->magic, 0, __ATOMIC_RELEASE);
+	munmap(s->map, s->size);
+	close(s->fd);
+	free(s);
+	cfg->g_snapshot = NULL;
+	priv_snapshot(0);
+}
+
+/* Rewrite the inactive slot with the current state and switch to it. */
+void
+snapshot_update(struct lldpd *cfg)
+{
+	struct lldpd_snapshot *s = cfg->g_snapshot;
+	struct snapshot_header *h;
+	struct snapshot_slot *slot;
+	struct snapshot_record record;
+	struct lldpd_hardware *hardware;
+	void **blobs = NULL;
+	ssize_t *lens = NULL;
+	size_t count = 0, i, len = 0, offset, pagesize;
+	u_int32_t inactive, sequence;
+
+	if (!s) return;
+
+	TAILQ_FOREACH(hardware, &cfg->g_hardware, h_entries)
+		count++;
+	if (count > 0 &&
+	    ((blobs = calloc(count, sizeof(void *))) == NULL ||
+		(lens = calloc(count, sizeof(ssize_t))) == NULL)) {
+		log_warn("snapshot", "unable to allocate memory for snapshot");
+		goto end;
+	}
+	i = 0;
+	TAILQ_FOREACH(hardware, &cfg->g_hardware, h_entries) {
+		lens[i] = lldpd_hardware_serialize(hardware, &blobs[i]);
+		if (lens[i] <= 0) {
+			log_warnx("snapshot", "unable to serialize %s",
+			    hardware->h_ifname);
+			goto end;
+		}
+		len += sizeof(struct snapshot_record) + SNAPSHOT_ALIGN(lens[i]);
+		i++;
+	}
+
+	h = (struct snapshot_header *)s->map;
+	inactive = 1 - __atomic_load_n(&h->current, __ATOMIC_RELAXED);
+	slot = &h->slots[inactive];
+	if (slot->size < len) {
+		/* Allocate a new area at the end of the file. The active slot
+		 * is left untouched as readers may be copying it. */
+		pagesize = snapshot_pagesize();
+		offset = s->size;
+		if (snapshot_grow(s, offset +
+			(len * 2 + pagesize - 1) / pagesize * pagesize) == -1)
+			goto end;
+		h = (struct snapshot_header *)s->map;
+		slot = &h->slots[inactive];
+	} else
+		offset = slot->offset;
+
+	sequence = slot->sequence;
+	__atomic_store_n(&slot->sequence, sequence + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	if (slot->offset != offset) {
+		slot->size = s->size - offset;
+		slot->offset = offset;
+	}
+	slot->count = count;
+	slot->len = len;
+	for (i = 0; i < count; i++) {
+		record.len = lens[i];
+		memcpy(s->map + offset, &record, sizeof(record));
+		memcpy(s->map + offset + sizeof(record), blobs[i], lens[i]);
+		offset += sizeof(record) + SNAPSHOT_ALIGN(lens[i]);
+	}
+	__atomic_store_n(&slot->sequence, sequence + 2, __ATOMIC_RELEASE);
+	__atomic_store_n(&h->current, inactive, __ATOMIC_RELEASE);
+	log_debug("snapshot", "snapshot updated with %zu ports (%zu bytes)",
+	    count, len);
+
+end:
+	if (blobs) {
+		for (i = 0; i < count; i++)
+			free(blobs[i]);
+	}
+	free(blobs);
+	free(lens);
+}
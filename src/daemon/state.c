@@ -0,0 +1,296 @@
+/* -*- mode: c; c-file-style: "openbsd" -*- */
+/*
+ * Copyright (c) 2019 Vincent Bernat <vincent@bernat.im>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* Keep neighbors across restarts. Local ports with their neighbors are saved
+ * in a state file on exit and periodically. On start, neighbors are restored
+ * with their remaining TTL. As the last received frames are also saved, a
+ * neighbor announcing itself again with the same information is not seen as a
+ * change. */
+
+#include "lldpd.h"
+
+#include <unistd.h>
+#include <string.h>
+#include <time.h>
+
+struct state_header {
+	u_int32_t magic;
+	u_int32_t version;	/* HMSG_VERSION */
+};
+#define STATE_MAGIC 0x6c6c6473 /* llds */
+#define STATE_UNUSED ((u_int16_t)-1) /* Reference count of unused chassis */
+
+void
+state_save(struct lldpd *cfg)
+{
+	struct lldpd_state state;
+	struct lldpd_state_hardware *shardware, *shardware_next;
+	struct lldpd_state_frame *sframe, *sframe_next;
+	struct lldpd_hardware *hardware;
+	struct lldpd_port *port;
+	struct state_header header = {
+		.magic = STATE_MAGIC,
+		.version = HMSG_VERSION
+	};
+	void *serialized = NULL;
+	char *buffer;
+	ssize_t len;
+
+	log_debug("state", "save neighbors");
+	TAILQ_INIT(&state);
+	TAILQ_FOREACH(hardware, &cfg->g_hardware, h_entries) {
+		if (TAILQ_EMPTY(&hardware->h_rports)) continue;
+		if ((shardware = calloc(1,
+			    sizeof(struct lldpd_state_hardware))) == NULL) {
+			log_warn("state", "unable to allocate memory for state");
+			goto end;
+		}
+		shardware->s_hardware = hardware;
+		TAILQ_INIT(&shardware->s_frames);
+		TAILQ_INSERT_TAIL(&state, shardware, s_entries);
+		TAILQ_FOREACH(port, &hardware->h_rports, p_entries) {
+			if ((sframe = calloc(1,
+				    sizeof(struct lldpd_state_frame))) == NULL) {
+				log_warn("state", "unable to allocate memory for state");
+				goto end;
+			}
+			if (port->p_lastframe) {
+				sframe->s_len = port->p_lastframe->size;
+				sframe->s_frame = (char *)port->p_lastframe->frame;
+			}
+			TAILQ_INSERT_TAIL(&shardware->s_frames, sframe, s_entries);
+		}
+	}
+
+	if (TAILQ_EMPTY(&state)) {
+		priv_save_state(NULL, 0);
+		goto end;
+	}
+	if ((len = lldpd_state_serialize(&state, &serialized)) <= 0) {
+		log_warnx("state", "unable to serialize neighbors");
+		goto end;
+	}
+	if ((buffer = malloc(sizeof(header) + len)) == NULL) {
+		log_warn("state", "unable to allocate memory for state");
+		goto end;
+	}
+	memcpy(buffer, &header, sizeof(header));
+	memcpy(buffer + sizeof(header), serialized, len);
+	if (sizeof(header) + len > PRIV_STATE_MAX)
+		log_warnx("state", "too many neighbors to be saved");
+	else if (priv_save_state(buffer, sizeof(header) + len) == -1)
+		log_warnx("state", "unable to save neighbors");
+	free(buffer);
+
+end:
+	free(serialized);
+	for (shardware = TAILQ_FIRST(&state);
+	     shardware != NULL;
+	     shardware = shardware_next) {
+		shardware_next = TAILQ_NEXT(shardware, s_entries);
+		for (sframe = TAILQ_FIRST(&shardware->s_frames);
+		     sframe != NULL;
+		     sframe = sframe_next) {
+			sframe_next = TAILQ_NEXT(sframe, s_entries);
+			free(sframe);
+		}
+		free(shardware);
+	}
+}
+
+/* Is the MSAP of `port` already known on `hardware`? */
+static int
+state_known(struct lldpd_hardware *hardware, struct lldpd_port *port)
+{
+	struct lldpd_port *oport;
+	TAILQ_FOREACH(oport, &hardware->h_rports, p_entries) {
+		if (port->p_protocol == oport->p_protocol &&
+		    port->p_id_subtype == oport->p_id_subtype &&
+		    port->p_id_len == oport->p_id_len &&
+		    memcmp(port->p_id, oport->p_id, port->p_id_len) == 0 &&
+		    port->p_chassis->c_id_subtype == oport->p_chassis->c_id_subtype &&
+		    port->p_chassis->c_id_len == oport->p_chassis->c_id_len &&
+		    memcmp(port->p_chassis->c_id, oport->p_chassis->c_id,
+			port->p_chassis->c_id_len) == 0)
+			return 1;
+	}
+	return 0;
+}
+
+/* Attach a restored neighbor to the matching chassis, adding it if needed.
+ * Restored chassis not yet added have a reference count of STATE_UNUSED. */
+static void
+state_attach_chassis(struct lldpd *cfg, struct lldpd_port *port)
+{
+	struct lldpd_chassis *chassis = port->p_chassis, *ochassis;
+	TAILQ_FOREACH(ochassis, &cfg->g_chassis, c_entries) {
+		if (ochassis == LOCAL_CHASSIS(cfg)) continue;
+		if (chassis->c_protocol == ochassis->c_protocol &&
+		    chassis->c_id_subtype == ochassis->c_id_subtype &&
+		    chassis->c_id_len == ochassis->c_id_len &&
+		    memcmp(chassis->c_id, ochassis->c_id,
+			chassis->c_id_len) == 0)
+			break;
+	}
+	if (!ochassis) {
+		ochassis = chassis;
+		ochassis->c_index = ++cfg->g_lastrid;
+		ochassis->c_refcount = 0;
+		TAILQ_INSERT_TAIL(&cfg->g_chassis, ochassis, c_entries);
+	}
+	port->p_chassis = ochassis;
+	ochassis->c_refcount++;
+}
+
+void
+state_restore(struct lldpd *cfg)
+{
+	struct lldpd_state *state = NULL;
+	struct lldpd_state_hardware *shardware, *shardware_next;
+	struct lldpd_state_frame *sframe, *sframe_next;
+	struct lldpd_hardware *saved, *hardware;
+	struct lldpd_port *port, *port_next;
+	struct lldpd_chassis **chassis = NULL, **c;
+	struct state_header header;
+	size_t len, count = 0, i;
+	char *buffer;
+	time_t now = time(NULL);
+	int restored = 0;
+
+	if ((buffer = priv_load_state(&len)) == NULL) return;
+	memcpy(&header, buffer, (len < sizeof(header))?len:sizeof(header));
+	if (len < sizeof(header) ||
+	    header.magic != STATE_MAGIC || header.version != HMSG_VERSION) {
+		log_warnx("state", "ignore incompatible state file");
+		free(buffer);
+		return;
+	}
+	if (lldpd_state_unserialize(buffer + sizeof(header),
+		len - sizeof(header), &state) <= 0) {
+		log_warnx("state", "unable to unserialize state file");
+		free(buffer);
+		return;
+	}
+	free(buffer);
+
+	/* Chassis may be shared between neighbors. Collect them to know which
+	 * ones are not used in the end. */
+	TAILQ_FOREACH(shardware, state, s_entries) {
+		if ((saved = shardware->s_hardware) == NULL) continue;
+		TAILQ_FOREACH(port, &saved->h_rports, p_entries)
+			count++;
+		count++;	/* Local chassis */
+	}
+	if ((chassis = calloc(count, sizeof(struct lldpd_chassis *))) == NULL)
+		fatal("state", NULL);
+	/* Unserialized objects are released with lldpd_slab_free() */
+	count = 0;
+	TAILQ_FOREACH(shardware, state, s_entries) {
+		if ((saved = shardware->s_hardware) == NULL) continue;
+		chassis[count++] = saved->h_lport.p_chassis;
+		saved->h_lport.p_chassis = NULL;
+		lldpd_slab_adopt_neighbor(NULL, &saved->h_lport);
+		TAILQ_FOREACH(port, &saved->h_rports, p_entries) {
+			chassis[count++] = port->p_chassis;
+			lldpd_slab_adopt_neighbor(NULL, port);
+			lldpd_slab_adopt(LLDPD_SLAB_PORT, port);
+		}
+	}
+	for (i = 0; i < count; i++)
+		if (chassis[i]) chassis[i]->c_refcount = 0;
+	for (i = 0; i < count; i++) {
+		if (!chassis[i] || chassis[i]->c_refcount == STATE_UNUSED)
+			continue;
+		lldpd_slab_adopt_neighbor(chassis[i], NULL);
+		chassis[i]->c_refcount = STATE_UNUSED;
+	}
+
+	for (shardware = TAILQ_FIRST(state);
+	     shardware != NULL;
+	     shardware = shardware_next) {
+		shardware_next = TAILQ_NEXT(shardware, s_entries);
+		saved = shardware->s_hardware;
+		hardware = NULL;
+		if (saved)
+			TAILQ_FOREACH(hardware, &cfg->g_hardware, h_entries)
+				if (!strcmp(hardware->h_ifname,
+					saved->h_ifname) &&
+				    !strcmp(hardware->h_netns,
+					saved->h_netns)) break;
+		sframe = TAILQ_FIRST(&shardware->s_frames);
+		for (port = saved?TAILQ_FIRST(&saved->h_rports):NULL;
+		     port != NULL;
+		     port = port_next) {
+			port_next = TAILQ_NEXT(port, p_entries);
+			if (hardware && port->p_chassis &&
+			    now < port->p_lastupdate + port->p_ttl &&
+			    !state_known(hardware, port)) {
+				log_debug("state", "restore neighbor %s on %s",
+				    port->p_chassis->c_name?
+				    port->p_chassis->c_name:"(unknown)",
+				    hardware->h_ifname);
+				lldpd_intern_neighbor(port->p_chassis, port);
+				state_attach_chassis(cfg, port);
+				if (sframe && sframe->s_frame &&
+				    (port->p_lastframe =
+					lldpd_frame_alloc(sframe->s_len)) != NULL)
+					memcpy(port->p_lastframe->frame,
+					    sframe->s_frame, sframe->s_len);
+				TAILQ_INSERT_TAIL(&hardware->h_rports, port,
+				    p_entries);
+				restored++;
+			} else {
+				port->p_chassis = NULL;
+				lldpd_port_cleanup(port, 1);
+				lldpd_slab_free(LLDPD_SLAB_PORT, port);
+			}
+			if (sframe) {
+				sframe_next = TAILQ_NEXT(sframe, s_entries);
+				free(sframe->s_frame);
+				free(sframe);
+				sframe = sframe_next;
+			}
+		}
+		for (; sframe != NULL; sframe = sframe_next) {
+			sframe_next = TAILQ_NEXT(sframe, s_entries);
+			free(sframe->s_frame);
+			free(sframe);
+		}
+		if (saved) {
+			lldpd_port_cleanup(&saved->h_lport, 1);
+			free(saved);
+		}
+		free(shardware);
+	}
+	free(state);
+
+	/* Free chassis not attached to any restored neighbor */
+	for (i = 0; i < count; i++) {
+		if (!chassis[i] || chassis[i]->c_refcount != STATE_UNUSED) continue;
+		for (c = &chassis[i + 1]; c < &chassis[count]; c++)
+			if (*c == chassis[i]) *c = NULL;
+		lldpd_chassis_cleanup(chassis[i], 1);
+	}
+	free(chassis);
+
+	log_info("state", "%d neighbors restored", restored);
+	if (restored) {
+		cfg->g_generation++;
+		lldpd_hide_all(cfg);
+		lldpd_cleanup(cfg);
+	}
+}
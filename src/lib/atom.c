@@ -320,6 +320,7 @@ _lldpctl_do_something(lldpctl_conn_t *conn,
 		if (ctl_msg_send_unserialized(&conn->output_buffer, &conn->output_buffer_len,
 			type, to_send, mi_send) != 0)
 			return SET_ERROR(conn, LLDPCTL_ERR_SERIALIZATION);
+		conn->requests++;
 		conn->state = state_send;
 		if (state_data)
 			conn->state_data = strdup(state_data);
@@ -359,6 +360,15 @@ int
 lldpctl_watch_callback(lldpctl_conn_t *conn,
     lldpctl_change_callback cb,
     void *data)
+{
+	return lldpctl_watch_callback2(conn, cb, data, 0);
+}
+
+int
+lldpctl_watch_callback2(lldpctl_conn_t *conn,
+    lldpctl_change_callback cb,
+    void *data,
+    int flags)
 {
 	int rc;
 
@@ -370,6 +380,7 @@ lldpctl_watch_callback(lldpctl_conn_t *conn,
 	if (rc == 0) {
 		conn->watch_cb = cb;
 		conn->watch_data = data;
+		conn->watch_flags = flags;
 	}
 	return rc;
 }
@@ -481,7 +492,7 @@ lldpctl_get_port(lldpctl_atom_t *atom)
 	if (rc == 0) {
 		hardware = p;
 		return _lldpctl_new_atom(conn, atom_port, 1,
-		    hardware, &hardware->h_lport, NULL);
+		    hardware, &hardware->h_lport, NULL, hardware);
 	}
 	return NULL;
 }
@@ -501,7 +512,7 @@ lldpctl_get_default_port(lldpctl_conn_t *conn)
 	    &p, &MARSHAL_INFO(lldpd_port));
 	if (rc == 0) {
 		port = p;
-		return _lldpctl_new_atom(conn, atom_port, 1, NULL, port, NULL);
+		return _lldpctl_new_atom(conn, atom_port, 1, NULL, port, NULL, port);
 	}
 	return NULL;
 }
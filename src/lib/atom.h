@@ -54,18 +54,30 @@ struct lldpctl_conn_t {
 #define CONN_STATE_GET_CHASSIS_RECV	14
 #define CONN_STATE_GET_DEFAULT_PORT_SEND 15
 #define CONN_STATE_GET_DEFAULT_PORT_RECV 16
+#define CONN_STATE_GET_LATENCY_SEND	17
+#define CONN_STATE_GET_LATENCY_RECV	18
+#define CONN_STATE_GET_PORTS_SEND	19
+#define CONN_STATE_GET_PORTS_RECV	20
 	int state;		/* Current state */
 	char *state_data;	/* Data attached to the state. It is used to
 				 * check that we are using the same data as a
 				 * previous call until the state machine goes to
 				 * CONN_STATE_IDLE. */
 
+	/* Ports received so far by lldpctl_get_ports() */
+	unsigned char *ports;
+	size_t ports_len;
+	int ports_next;		/* Index of the next batch */
+
+	unsigned long requests;	/* Number of requests sent */
+
 	/* Error handling */
 	lldpctl_error_t error;	/* Last error */
 
 	/* Handling notifications */
 	lldpctl_change_callback watch_cb;
 	void *watch_data;
+	int watch_flags;	/* See lldpctl_watch_flags_t */
 	int watch_triggered;
 };
 
@@ -120,6 +132,11 @@ typedef enum {
 	atom_custom,
 #endif
 	atom_chassis,
+	atom_snapshot,
+	atom_latency_list,
+	atom_latency,
+	atom_latency_buckets_list,
+	atom_latency_bucket,
 } atom_t;
 
 void *_lldpctl_alloc_in_atom(lldpctl_atom_t *, size_t);
@@ -187,6 +204,40 @@ struct _lldpctl_atom_port_t {
 	struct lldpd_port     *port;	 /* Local and remote */
 	struct _lldpctl_atom_port_t *parent; /* Local port if we are a remote port */
 	lldpctl_atom_t *chassis; /* Internal atom for chassis */
+	void *answer;		 /* Answer holding the above structures (when we own it) */
+};
+
+/* Return an extension block of a port, allocating it when the port does not
+ * have one. The block is attached to the atom owning the answer (the local
+ * port for a neighbor). */
+#define _lldpctl_port_ext(p, field)					\
+	((p)->port->field ? (p)->port->field :				\
+	    ((p)->port->field = _lldpctl_alloc_in_atom(			\
+		(lldpctl_atom_t *)((p)->parent ? (p)->parent : (p)),	\
+		sizeof(*(p)->port->field))))
+
+struct _lldpctl_atom_snapshot_t {
+	lldpctl_atom_t base;
+	unsigned char *records;	/* Copy of the records of the current slot */
+	size_t len;
+};
+
+struct _lldpctl_atom_latency_list_t {
+	lldpctl_atom_t base;
+	struct lldpd_latency_list *latencies;
+};
+
+struct _lldpctl_atom_latency_t {
+	lldpctl_atom_t base;
+	lldpctl_atom_t *parent;
+	struct lldpd_latency *latency;
+};
+
+/* Used for both the list of buckets and a single bucket. */
+struct _lldpctl_atom_latency_bucket_t {
+	lldpctl_atom_t base;
+	struct _lldpctl_atom_latency_t *parent;
+	int index;
 };
 
 /* Can represent any simple list holding just a reference to a port. */
@@ -211,6 +262,7 @@ struct _lldpctl_atom_mgmt_t {
 struct _lldpctl_atom_dot3_power_t {
 	lldpctl_atom_t base;
 	struct _lldpctl_atom_port_t *parent;
+	struct lldpd_dot3_power *power;
 };
 #endif
 
@@ -264,6 +316,7 @@ struct _lldpctl_atom_med_caelement_t {
 struct _lldpctl_atom_med_power_t {
 	lldpctl_atom_t base;
 	struct _lldpctl_atom_port_t *parent;
+	struct lldpd_med_power *power;
 };
 #endif
 
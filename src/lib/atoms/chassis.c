@@ -68,7 +68,7 @@ _lldpctl_atom_free_chassis(lldpctl_atom_t *atom)
 	    (struct _lldpctl_atom_chassis_t *)atom;
 	/* When we have a parent, the chassis structure is in fact part of the
 	 * parent, just decrement the reference count of the parent. Otherwise,
-	 * we need to free the whole chassis. When embedded, we don't alter the
+	 * we need to free the whole chassis (a single buffer). When embedded, we don't alter the
 	 * reference count of the parent. Therefore, it's important to also not
 	 * increase the reference count of this atom. See
 	 * `_lldpctl_atom_get_atom_chassis' for how to handle that. */
@@ -76,7 +76,7 @@ _lldpctl_atom_free_chassis(lldpctl_atom_t *atom)
 		if (!p->embedded)
 			lldpctl_atom_dec_ref((lldpctl_atom_t*)p->parent);
 	} else
-		lldpd_chassis_cleanup(p->chassis, 1);
+		marshal_release(p->chassis);
 }
 
 static lldpctl_atom_t*
@@ -74,8 +74,7 @@ _lldpctl_atom_free_config(lldpctl_atom_t *atom)
 {
 	struct _lldpctl_atom_config_t *c =
 	    (struct _lldpctl_atom_config_t *)atom;
-	lldpd_config_cleanup(c->config);
-	free(c->config);
+	marshal_release(c->config);
 }
 
 static const char*
@@ -127,10 +126,8 @@ __lldpctl_atom_set_str_config(struct _lldpctl_atom_config_t *c,
 		aval = _lldpctl_alloc_in_atom((lldpctl_atom_t *)c, len);
 		if (!aval) return NULL;
 		memcpy(aval, value, len);
-		*local = aval;
-		free(*global); *global = strdup(aval);
+		*local = *global = aval;
 	} else {
-		free(*global);
 		*local = *global = NULL;
 	}
 	return c;
@@ -246,6 +243,28 @@ _lldpctl_atom_get_int_config(lldpctl_atom_t *atom, lldpctl_key_t key)
 		return c->config->c_tx_hold;
 	case lldpctl_k_config_max_neighbors:
 		return c->config->c_max_neighbors;
+	case lldpctl_k_config_notification_interval:
+		return c->config->c_notification_interval;
+	case lldpctl_k_config_startup_privsep:
+		return c->config->c_startup_privsep;
+	case lldpctl_k_config_startup_interfaces:
+		return c->config->c_startup_interfaces;
+	case lldpctl_k_config_startup_configured:
+		return c->config->c_startup_configured;
+	case lldpctl_k_config_startup_first_pdu:
+		return c->config->c_startup_first_pdu;
+	case lldpctl_k_config_startup_metadata:
+		return c->config->c_startup_metadata;
+	case lldpctl_k_config_snapshot:
+		return c->config->c_snapshot;
+	case lldpctl_k_config_warm_restart:
+		return c->config->c_warm_restart;
+	case lldpctl_k_config_metrics:
+		return c->config->c_metrics;
+	case lldpctl_k_config_metrics_port:
+		return c->config->c_metrics_port;
+	case lldpctl_k_config_decode_workers:
+		return c->config->c_decode_workers;
 	default:
 		return SET_ERROR(atom->conn, LLDPCTL_ERR_NOT_EXIST);
 	}
@@ -276,6 +295,29 @@ _lldpctl_atom_set_int_config(lldpctl_atom_t *atom, lldpctl_key_t key,
 	case lldpctl_k_config_iface_promisc:
 		config.c_promisc = c->config->c_promisc = value;
 		break;
+	case lldpctl_k_config_snapshot:
+		config.c_snapshot = c->config->c_snapshot = value;
+		break;
+	case lldpctl_k_config_warm_restart:
+		config.c_warm_restart = c->config->c_warm_restart = value;
+		break;
+	case lldpctl_k_config_metrics:
+		config.c_metrics = c->config->c_metrics = value;
+		break;
+	case lldpctl_k_config_metrics_port:
+		if (value < 0 || value > 65535) {
+			SET_ERROR(atom->conn, LLDPCTL_ERR_BAD_VALUE);
+			return NULL;
+		}
+		config.c_metrics_port = c->config->c_metrics_port = value;
+		break;
+	case lldpctl_k_config_decode_workers:
+		if (value < 0 || value > LLDPD_DECODE_MAX_WORKERS) {
+			SET_ERROR(atom->conn, LLDPCTL_ERR_BAD_VALUE);
+			return NULL;
+		}
+		config.c_decode_workers = c->config->c_decode_workers = value;
+		break;
 	case lldpctl_k_config_chassis_cap_advertise:
 		config.c_cap_advertise = c->config->c_cap_advertise = value;
 		break;
@@ -298,6 +340,15 @@ _lldpctl_atom_set_int_config(lldpctl_atom_t *atom, lldpctl_key_t key,
 		config.c_max_neighbors = value;
 		if (value > 0) c->config->c_max_neighbors = value;
 		break;
+	case lldpctl_k_config_notification_interval:
+		if (value < LLDPD_NOTIFICATION_INTERVAL_MIN ||
+		    value > LLDPD_NOTIFICATION_INTERVAL_MAX) {
+			SET_ERROR(atom->conn, LLDPCTL_ERR_BAD_VALUE);
+			return NULL;
+		}
+		config.c_notification_interval = value;
+		c->config->c_notification_interval = value;
+		break;
 	case lldpctl_k_config_bond_slave_src_mac_type:
 		config.c_bond_slave_src_mac_type = value;
 		c->config->c_bond_slave_src_mac_type = value;
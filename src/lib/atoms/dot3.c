@@ -234,6 +234,8 @@ _lldpctl_atom_new_dot3_power(lldpctl_atom_t *atom, va_list ap)
 	struct _lldpctl_atom_dot3_power_t *dpow =
 	    (struct _lldpctl_atom_dot3_power_t *)atom;
 	dpow->parent = va_arg(ap, struct _lldpctl_atom_port_t *);
+	if ((dpow->power = _lldpctl_port_ext(dpow->parent, p_power)) == NULL)
+		return 0;
 	lldpctl_atom_inc_ref((lldpctl_atom_t *)dpow->parent);
 	return 1;
 }
@@ -251,27 +253,27 @@ _lldpctl_atom_get_str_dot3_power(lldpctl_atom_t *atom, lldpctl_key_t key)
 {
 	struct _lldpctl_atom_dot3_power_t *dpow =
 	    (struct _lldpctl_atom_dot3_power_t *)atom;
-	struct lldpd_port     *port     = dpow->parent->port;
+	struct lldpd_dot3_power *power = dpow->power;
 
 	/* Local and remote port */
 	switch (key) {
 	case lldpctl_k_dot3_power_devicetype:
 		return map_lookup(port_dot3_power_devicetype_map,
-		    port->p_power.devicetype);
+		    power->devicetype);
 	case lldpctl_k_dot3_power_pairs:
 		return map_lookup(port_dot3_power_pairs_map.map,
-		    port->p_power.pairs);
+		    power->pairs);
 	case lldpctl_k_dot3_power_class:
 		return map_lookup(port_dot3_power_class_map.map,
-		    port->p_power.class);
+		    power->class);
 	case lldpctl_k_dot3_power_source:
-		return map_lookup((port->p_power.devicetype == LLDP_DOT3_POWER_PSE)?
+		return map_lookup((power->devicetype == LLDP_DOT3_POWER_PSE)?
 		    port_dot3_power_pse_source_map:
 		    port_dot3_power_pd_source_map,
-		    port->p_power.source);
+		    power->source);
 	case lldpctl_k_dot3_power_priority:
 		return map_lookup(port_dot3_power_priority_map.map,
-		    port->p_power.priority);
+		    power->priority);
 	default:
 		SET_ERROR(atom->conn, LLDPCTL_ERR_NOT_EXIST);
 		return NULL;
@@ -283,68 +285,68 @@ _lldpctl_atom_get_int_dot3_power(lldpctl_atom_t *atom, lldpctl_key_t key)
 {
 	struct _lldpctl_atom_dot3_power_t *dpow =
 	    (struct _lldpctl_atom_dot3_power_t *)atom;
-	struct lldpd_port     *port     = dpow->parent->port;
+	struct lldpd_dot3_power *power = dpow->power;
 
 	/* Local and remote port */
 	switch (key) {
 	case lldpctl_k_dot3_power_devicetype:
-		return port->p_power.devicetype;
+		return power->devicetype;
 	case lldpctl_k_dot3_power_supported:
-		return port->p_power.supported;
+		return power->supported;
 	case lldpctl_k_dot3_power_enabled:
-		return port->p_power.enabled;
+		return power->enabled;
 	case lldpctl_k_dot3_power_paircontrol:
-		return port->p_power.paircontrol;
+		return power->paircontrol;
 	case lldpctl_k_dot3_power_pairs:
-		return port->p_power.pairs;
+		return power->pairs;
 	case lldpctl_k_dot3_power_class:
-		return port->p_power.class;
+		return power->class;
 	case lldpctl_k_dot3_power_type:
-		return port->p_power.powertype;
+		return power->powertype;
 	case lldpctl_k_dot3_power_source:
-		return port->p_power.source;
+		return power->source;
 	case lldpctl_k_dot3_power_priority:
-		return port->p_power.priority;
+		return power->priority;
 	case lldpctl_k_dot3_power_requested:
-		return port->p_power.requested * 100;
+		return power->requested * 100;
 	case lldpctl_k_dot3_power_allocated:
-		return port->p_power.allocated * 100;
+		return power->allocated * 100;
 	case lldpctl_k_dot3_power_requestedA:
-		return port->p_power.requestedA * 100;
+		return power->requestedA * 100;
 	case lldpctl_k_dot3_power_requestedB:
-		return port->p_power.requestedB * 100;
+		return power->requestedB * 100;
 	case lldpctl_k_dot3_power_allocatedA:
-		return port->p_power.allocatedA * 100;
+		return power->allocatedA * 100;
 	case lldpctl_k_dot3_power_allocatedB:
-		return port->p_power.allocatedB * 100;
+		return power->allocatedB * 100;
 	case lldpctl_k_dot3_power_pseStatus:
-		return port->p_power.psePoweringStatus;
+		return power->psePoweringStatus;
 	case lldpctl_k_dot3_power_pdStatus:
-		return port->p_power.pdPoweredStatus;
+		return power->pdPoweredStatus;
 	case lldpctl_k_dot3_power_pairsExt:
-		return port->p_power.psePowerPairs;
+		return power->psePowerPairs;
 	case lldpctl_k_dot3_power_dualSigAClass:
-		return port->p_power.powerClassA;
+		return power->powerClassA;
 	case lldpctl_k_dot3_power_dualSigBClass:
-		return port->p_power.powerClassB;
+		return power->powerClassB;
 	case lldpctl_k_dot3_power_classExt:
-		return port->p_power.powerClassExt;
+		return power->powerClassExt;
 	case lldpctl_k_dot3_power_powerTypeExt:
-		return port->p_power.powerTypeExt;
+		return power->powerTypeExt;
 	case lldpctl_k_dot3_power_pdLoad:
-		return port->p_power.pdLoad;
+		return power->pdLoad;
 	case lldpctl_k_dot3_power_pseMaxPower:
-		return port->p_power.pseMaxAvailPower;
+		return power->pseMaxAvailPower;
 	case lldpctl_k_dot3_power_autoclassSupport:
-		return port->p_power.pseAutoclassSupport;
+		return power->pseAutoclassSupport;
 	case lldpctl_k_dot3_power_autoclassCompleted:
-		return port->p_power.autoClass_completed;
+		return power->autoClass_completed;
 	case lldpctl_k_dot3_power_autoclassRequest:
-		return port->p_power.autoClass_request;
+		return power->autoClass_request;
 	case lldpctl_k_dot3_power_powerDownRequest:
-		return port->p_power.powerdown_time;
+		return power->powerdown_time;
 	case lldpctl_k_dot3_power_powerDownTime:
-		return port->p_power.powerdown_request_pd;
+		return power->powerdown_request_pd;
 	default:
 		return SET_ERROR(atom->conn, LLDPCTL_ERR_NOT_EXIST);
 	}
@@ -356,7 +358,7 @@ _lldpctl_atom_set_int_dot3_power(lldpctl_atom_t *atom, lldpctl_key_t key,
 {
 	struct _lldpctl_atom_dot3_power_t *dpow =
 	    (struct _lldpctl_atom_dot3_power_t *)atom;
-	struct lldpd_port *port = dpow->parent->port;
+	struct lldpd_dot3_power *power = dpow->power;
 
 	/* Only local port can be modified */
 	if (!dpow->parent->local) {
@@ -370,7 +372,7 @@ _lldpctl_atom_set_int_dot3_power(lldpctl_atom_t *atom, lldpctl_key_t key,
 		case 0:		/* Disabling */
 		case LLDP_DOT3_POWER_PSE:
 		case LLDP_DOT3_POWER_PD:
-			port->p_power.devicetype = value;
+			power->devicetype = value;
 			return atom;
 		default: goto bad;
 		}
@@ -378,7 +380,7 @@ _lldpctl_atom_set_int_dot3_power(lldpctl_atom_t *atom, lldpctl_key_t key,
 		switch (value) {
 		case 0:
 		case 1:
-			port->p_power.supported = value;
+			power->supported = value;
 			return atom;
 		default: goto bad;
 		}
@@ -386,7 +388,7 @@ _lldpctl_atom_set_int_dot3_power(lldpctl_atom_t *atom, lldpctl_key_t key,
 		switch (value) {
 		case 0:
 		case 1:
-			port->p_power.enabled = value;
+			power->enabled = value;
 			return atom;
 		default: goto bad;
 		}
@@ -394,7 +396,7 @@ _lldpctl_atom_set_int_dot3_power(lldpctl_atom_t *atom, lldpctl_key_t key,
 		switch (value) {
 		case 0:
 		case 1:
-			port->p_power.paircontrol = value;
+			power->paircontrol = value;
 			return atom;
 		default: goto bad;
 		}
@@ -402,34 +404,34 @@ _lldpctl_atom_set_int_dot3_power(lldpctl_atom_t *atom, lldpctl_key_t key,
 		switch (value) {
 		case 1:
 		case 2:
-			port->p_power.pairs = value;
+			power->pairs = value;
 			return atom;
 		default: goto bad;
 		}
 	case lldpctl_k_dot3_power_class:
 		if (value < 0 || value > 5)
 			goto bad;
-		port->p_power.class = value;
+		power->class = value;
 		return atom;
 	case lldpctl_k_dot3_power_type:
 		switch (value) {
 		case LLDP_DOT3_POWER_8023AT_TYPE1:
 		case LLDP_DOT3_POWER_8023AT_TYPE2:
 		case LLDP_DOT3_POWER_8023AT_OFF:
-			port->p_power.powertype = value;
+			power->powertype = value;
 			return atom;
 		default: goto bad;
 		}
 	case lldpctl_k_dot3_power_source:
 		if (value < 0 || value > 3)
 			goto bad;
-		port->p_power.source = value;
+		power->source = value;
 		return atom;
 	case lldpctl_k_dot3_power_4pid:
 		switch(value) {
 		case LLDP_DOT3_POWER_4PID_SUP:
 		case LLDP_DOT3_POWER_4PID_UNSUP:
-			port->p_power.pid4 = value;
+			power->pid4 = value;
 			return atom;
 		default: goto bad;
 		}
@@ -439,40 +441,40 @@ _lldpctl_atom_set_int_dot3_power(lldpctl_atom_t *atom, lldpctl_key_t key,
 		case LLDP_DOT3_POWER_PRIO_CRITICAL:
 		case LLDP_DOT3_POWER_PRIO_HIGH:
 		case LLDP_DOT3_POWER_PRIO_LOW:
-			port->p_power.priority = value;
+			power->priority = value;
 			return atom;
 		default: goto bad;
 		}
 	case lldpctl_k_dot3_power_allocated:
 		if (value < 0 || value > 99900) goto bad;
-		port->p_power.allocated = value / 100;
+		power->allocated = value / 100;
 		return atom;
 	case lldpctl_k_dot3_power_requested:
 		if (value < 0 || value > 99900) goto bad;
-		port->p_power.requested = value / 100;
+		power->requested = value / 100;
 		return atom;
 	case lldpctl_k_dot3_power_requestedA:
 		if (value < 0 || value > 49900) goto bad;
-		port->p_power.requestedA = value / 100;
+		power->requestedA = value / 100;
 		return atom;
 	case lldpctl_k_dot3_power_requestedB:
 		if (value < 0 || value > 49900) goto bad;
-		port->p_power.requestedB = value / 100;
+		power->requestedB = value / 100;
 		return atom;
 	case lldpctl_k_dot3_power_allocatedA:
 		if (value < 0 || value > 49900) goto bad;
-		port->p_power.allocatedA = value / 100;
+		power->allocatedA = value / 100;
 		return atom;
 	case lldpctl_k_dot3_power_allocatedB:
 		if (value < 0 || value > 49900) goto bad;
-		port->p_power.allocatedB = value / 100;
+		power->allocatedB = value / 100;
 		return atom;
 	case lldpctl_k_dot3_power_pseStatus:
 		switch (value) {
 		case LLDP_DOT3_POWER_STATUS_PSE_2PAIR:
 		case LLDP_DOT3_POWER_STATUS_PSE_4PAIR_SINGLE_SIGNATURE:
 		case LLDP_DOT3_POWER_STATUS_PSE_4PAIR_DUAL_SIGNATURE:
-			port->p_power.psePoweringStatus = value;
+			power->psePoweringStatus = value;
 			return atom;
 		default: goto bad;
 		}
@@ -481,7 +483,7 @@ _lldpctl_atom_set_int_dot3_power(lldpctl_atom_t *atom, lldpctl_key_t key,
 		case LLDP_DOT3_POWER_STATUS_PD_POWERED_SINGLE_SIGNATURE:
 		case LLDP_DOT3_POWER_STATUS_PD_2PAIR_DUAL_SIGNATURE:
 		case LLDP_DOT3_POWER_STATUS_PD_4PAIR_DUAL_SIGNATURE:
-			port->p_power.pdPoweredStatus = value;
+			power->pdPoweredStatus = value;
 			return atom;
 		default: goto bad;
 		}
@@ -490,7 +492,7 @@ _lldpctl_atom_set_int_dot3_power(lldpctl_atom_t *atom, lldpctl_key_t key,
 		case LLDP_DOT3_POWERPAIRS_PSE_A:
 		case LLDP_DOT3_POWERPAIRS_PSE_B:
 		case LLDP_DOT3_POWERPAIRS_PSE_BOTH:
-			port->p_power.psePowerPairs = value;
+			power->psePowerPairs = value;
 			return atom;
 		default: goto bad;
 		}
@@ -502,7 +504,7 @@ _lldpctl_atom_set_int_dot3_power(lldpctl_atom_t *atom, lldpctl_key_t key,
 		case LLDP_DOT3_POWER_DUAL_SIGNATURE_A_CLASS_4:
 		case LLDP_DOT3_POWER_DUAL_SIGNATURE_A_CLASS_5:
 		case LLDP_DOT3_POWER_DUAL_SIGNATURE_A_CLASS_SINGLE_SIG_PD:
-			port->p_power.powerClassA = value;
+			power->powerClassA = value;
 			return atom;
 		default: goto bad;
 		}
@@ -514,7 +516,7 @@ _lldpctl_atom_set_int_dot3_power(lldpctl_atom_t *atom, lldpctl_key_t key,
 		case LLDP_DOT3_POWER_DUAL_SIGNATURE_B_CLASS_4:
 		case LLDP_DOT3_POWER_DUAL_SIGNATURE_B_CLASS_5:
 		case LLDP_DOT3_POWER_DUAL_SIGNATURE_B_CLASS_SINGLE_SIG_PD:
-			port->p_power.powerClassB = value;
+			power->powerClassB = value;
 			return atom;
 		default: goto bad;
 		}
@@ -529,7 +531,7 @@ _lldpctl_atom_set_int_dot3_power(lldpctl_atom_t *atom, lldpctl_key_t key,
 		case LLDP_DOT3_POWER_CLASS_7:
 		case LLDP_DOT3_POWER_CLASS_8:
 		case LLDP_DOT3_POWER_CLASS_DUAL_SIG_PD:
-			port->p_power.powerClassExt = value;
+			power->powerClassExt = value;
 			return atom;
 		default: goto bad;
 		}
@@ -541,7 +543,7 @@ _lldpctl_atom_set_int_dot3_power(lldpctl_atom_t *atom, lldpctl_key_t key,
 		case LLDP_DOT3_POWER_TYPE_3_PD_DUAL_SIG:
 		case LLDP_DOT3_POWER_TYPE_4_PD_SINGLE_SIG:
 		case LLDP_DOT3_POWER_TYPE_4_PD_DUAL_SIG:
-			port->p_power.powerTypeExt = value;
+			power->powerTypeExt = value;
 			return atom;
 		default: goto bad;
 		}
@@ -549,19 +551,19 @@ _lldpctl_atom_set_int_dot3_power(lldpctl_atom_t *atom, lldpctl_key_t key,
 		switch (value) {
 		case LLDP_DOT3_POWER_PD_LOAD_AB_ISOLATION_TRUE:
 		case LLDP_DOT3_POWER_PD_LOAD_AB_ISOLATION_FALSE:
-			port->p_power.pdLoad = value;
+			power->pdLoad = value;
 			return atom;
 		default: goto bad;
 		}
 	case lldpctl_k_dot3_power_pseMaxPower:
 		if(value < 100 || value > 99900) goto bad;
-		port->p_power.pseMaxAvailPower = value / 100;
+		power->pseMaxAvailPower = value / 100;
 		return atom;
 	case lldpctl_k_dot3_power_autoclassSupport:
 		switch (value) {
 		case LLDP_DOT3_POWER_AUTOCLASS_PSE_SUPPORT_TRUE:
 		case LLDP_DOT3_POWER_AUTOCLASS_PSE_SUPPORT_FALSE:
-			port->p_power.pseAutoclassSupport = value;
+			power->pseAutoclassSupport = value;
 			return atom;
 		default: goto bad;
 		}
@@ -569,7 +571,7 @@ _lldpctl_atom_set_int_dot3_power(lldpctl_atom_t *atom, lldpctl_key_t key,
 		switch (value) {
 		case LLDP_DOT3_POWER_AUTOCLASS_COMPLETED_TRUE:
 		case LLDP_DOT3_POWER_AUTOCLASS_COMPLETED_IDLE:
-			port->p_power.autoClass_completed = value;
+			power->autoClass_completed = value;
 			return atom;
 		default: goto bad;
 		}
@@ -577,17 +579,17 @@ _lldpctl_atom_set_int_dot3_power(lldpctl_atom_t *atom, lldpctl_key_t key,
 		switch (value) {
 		case LLDP_DOT3_POWER_AUTOCLASS_REQUEST_TRUE:
 		case LLDP_DOT3_POWER_AUTOCLASS_REQUEST_IDLE:
-			port->p_power.autoClass_request = value;
+			power->autoClass_request = value;
 			return atom;
 		default: goto bad;
 		}
 	case lldpctl_k_dot3_power_powerDownRequest:
 		/*All values are valid, only 0x1D will power it down, everything else ignored*/
-		port->p_power.powerdown_request_pd = value;
+		power->powerdown_request_pd = value;
 	case lldpctl_k_dot3_power_powerDownTime:
 		/*magic number is 2^18, the number of bits available for power down time */
 		if(value < 0 || value > 262143) goto bad;
-		port->p_power.powerdown_time = value;
+		power->powerdown_time = value;
 		return atom;
 	default:
 		SET_ERROR(atom->conn, LLDPCTL_ERR_NOT_EXIST);
@@ -39,16 +39,7 @@ _lldpctl_atom_free_interfaces_list(lldpctl_atom_t *atom)
 {
 	struct _lldpctl_atom_interfaces_list_t *iflist =
 	    (struct _lldpctl_atom_interfaces_list_t *)atom;
-	struct lldpd_interface *iface, *iface_next;
-	for (iface = TAILQ_FIRST(iflist->ifs);
-	     iface != NULL;
-	     iface = iface_next) {
-		/* Don't TAILQ_REMOVE, this is not a real list! */
-		iface_next = TAILQ_NEXT(iface, next);
-		free(iface->name);
-		free(iface);
-	}
-	free(iflist->ifs);
+	marshal_release(iflist->ifs);
 }
 
 static lldpctl_atom_iter_t*
@@ -0,0 +1,248 @@
+/* -*- mode: c; c-file-style: "openbsd" -*- */
+/*
+ * Copyright (c) 2019 Vincent Bernat <vincent@bernat.im>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include "lldpctl.h"
+#include "../log.h"
+#include "../ctl.h"
+#include "atom.h"
+#include "helpers.h"
+
+lldpctl_atom_t*
+lldpctl_get_latency(lldpctl_conn_t *conn, int reset)
+{
+	struct lldpd_latency_list *latencies;
+	void *p;
+	int rc;
+
+	RESET_ERROR(conn);
+
+	rc = _lldpctl_do_something(conn,
+	    CONN_STATE_GET_LATENCY_SEND, CONN_STATE_GET_LATENCY_RECV, NULL,
+	    reset?RESET_LATENCY:GET_LATENCY,
+	    NULL, NULL,
+	    &p, &MARSHAL_INFO(lldpd_latency_list));
+	if (rc == 0) {
+		latencies = p;
+		return _lldpctl_new_atom(conn, atom_latency_list, latencies);
+	}
+	return NULL;
+}
+
+static int
+_lldpctl_atom_new_latency_list(lldpctl_atom_t *atom, va_list ap)
+{
+	struct _lldpctl_atom_latency_list_t *llist =
+	    (struct _lldpctl_atom_latency_list_t *)atom;
+	llist->latencies = va_arg(ap, struct lldpd_latency_list *);
+	return 1;
+}
+
+static void
+_lldpctl_atom_free_latency_list(lldpctl_atom_t *atom)
+{
+	struct _lldpctl_atom_latency_list_t *llist =
+	    (struct _lldpctl_atom_latency_list_t *)atom;
+	marshal_release(llist->latencies);
+}
+
+static lldpctl_atom_iter_t*
+_lldpctl_atom_iter_latency_list(lldpctl_atom_t *atom)
+{
+	struct _lldpctl_atom_latency_list_t *llist =
+	    (struct _lldpctl_atom_latency_list_t *)atom;
+	return (lldpctl_atom_iter_t*)TAILQ_FIRST(llist->latencies);
+}
+
+static lldpctl_atom_iter_t*
+_lldpctl_atom_next_latency_list(lldpctl_atom_t *atom, lldpctl_atom_iter_t *iter)
+{
+	return (lldpctl_atom_iter_t*)TAILQ_NEXT((struct lldpd_latency *)iter, l_entries);
+}
+
+static lldpctl_atom_t*
+_lldpctl_atom_value_latency_list(lldpctl_atom_t *atom, lldpctl_atom_iter_t *iter)
+{
+	struct lldpd_latency *latency = (struct lldpd_latency *)iter;
+	return _lldpctl_new_atom(atom->conn, atom_latency, atom, latency);
+}
+
+static int
+_lldpctl_atom_new_latency(lldpctl_atom_t *atom, va_list ap)
+{
+	struct _lldpctl_atom_latency_t *l =
+	    (struct _lldpctl_atom_latency_t *)atom;
+	l->parent = va_arg(ap, lldpctl_atom_t *);
+	l->latency = va_arg(ap, struct lldpd_latency *);
+	lldpctl_atom_inc_ref(l->parent);
+	return 1;
+}
+
+static void
+_lldpctl_atom_free_latency(lldpctl_atom_t *atom)
+{
+	struct _lldpctl_atom_latency_t *l =
+	    (struct _lldpctl_atom_latency_t *)atom;
+	lldpctl_atom_dec_ref(l->parent);
+}
+
+static const char*
+_lldpctl_atom_get_str_latency(lldpctl_atom_t *atom, lldpctl_key_t key)
+{
+	struct _lldpctl_atom_latency_t *l =
+	    (struct _lldpctl_atom_latency_t *)atom;
+	switch (key) {
+	case lldpctl_k_latency_name:
+		return l->latency->l_name;
+	default:
+		SET_ERROR(atom->conn, LLDPCTL_ERR_NOT_EXIST);
+		return NULL;
+	}
+}
+
+static long int
+_lldpctl_atom_get_int_latency(lldpctl_atom_t *atom, lldpctl_key_t key)
+{
+	struct _lldpctl_atom_latency_t *l =
+	    (struct _lldpctl_atom_latency_t *)atom;
+	switch (key) {
+	case lldpctl_k_latency_count:
+		return l->latency->l_count;
+	case lldpctl_k_latency_sum:
+		return l->latency->l_sum;
+	case lldpctl_k_latency_max:
+		return l->latency->l_max;
+	default:
+		return SET_ERROR(atom->conn, LLDPCTL_ERR_NOT_EXIST);
+	}
+}
+
+static lldpctl_atom_t*
+_lldpctl_atom_get_atom_latency(lldpctl_atom_t *atom, lldpctl_key_t key)
+{
+	switch (key) {
+	case lldpctl_k_latency_buckets:
+		return _lldpctl_new_atom(atom->conn, atom_latency_buckets_list,
+		    atom, 0);
+	default:
+		SET_ERROR(atom->conn, LLDPCTL_ERR_NOT_EXIST);
+		return NULL;
+	}
+}
+
+static int
+_lldpctl_atom_new_latency_bucket(lldpctl_atom_t *atom, va_list ap)
+{
+	struct _lldpctl_atom_latency_bucket_t *b =
+	    (struct _lldpctl_atom_latency_bucket_t *)atom;
+	b->parent = va_arg(ap, struct _lldpctl_atom_latency_t *);
+	b->index = va_arg(ap, int);
+	lldpctl_atom_inc_ref((lldpctl_atom_t *)b->parent);
+	return 1;
+}
+
+static void
+_lldpctl_atom_free_latency_bucket(lldpctl_atom_t *atom)
+{
+	struct _lldpctl_atom_latency_bucket_t *b =
+	    (struct _lldpctl_atom_latency_bucket_t *)atom;
+	lldpctl_atom_dec_ref((lldpctl_atom_t *)b->parent);
+}
+
+/* Buckets are iterated with a pointer into the array of buckets. */
+static lldpctl_atom_iter_t*
+_lldpctl_atom_iter_latency_buckets_list(lldpctl_atom_t *atom)
+{
+	struct _lldpctl_atom_latency_bucket_t *b =
+	    (struct _lldpctl_atom_latency_bucket_t *)atom;
+	return (lldpctl_atom_iter_t*)&b->parent->latency->l_buckets[0];
+}
+
+static lldpctl_atom_iter_t*
+_lldpctl_atom_next_latency_buckets_list(lldpctl_atom_t *atom, lldpctl_atom_iter_t *iter)
+{
+	struct _lldpctl_atom_latency_bucket_t *b =
+	    (struct _lldpctl_atom_latency_bucket_t *)atom;
+	u_int64_t *bucket = (u_int64_t *)iter;
+	if (++bucket == &b->parent->latency->l_buckets[LLDPD_LATENCY_BUCKETS])
+		return NULL;
+	return (lldpctl_atom_iter_t*)bucket;
+}
+
+static lldpctl_atom_t*
+_lldpctl_atom_value_latency_buckets_list(lldpctl_atom_t *atom, lldpctl_atom_iter_t *iter)
+{
+	struct _lldpctl_atom_latency_bucket_t *b =
+	    (struct _lldpctl_atom_latency_bucket_t *)atom;
+	u_int64_t *bucket = (u_int64_t *)iter;
+	return _lldpctl_new_atom(atom->conn, atom_latency_bucket, b->parent,
+	    (int)(bucket - b->parent->latency->l_buckets));
+}
+
+static long int
+_lldpctl_atom_get_int_latency_bucket(lldpctl_atom_t *atom, lldpctl_key_t key)
+{
+	struct _lldpctl_atom_latency_bucket_t *b =
+	    (struct _lldpctl_atom_latency_bucket_t *)atom;
+	switch (key) {
+	case lldpctl_k_latency_bucket_le:
+		if (b->index == LLDPD_LATENCY_BUCKETS - 1) return -1;
+		return 1L << (10 + b->index);
+	case lldpctl_k_latency_bucket_count:
+		return b->parent->latency->l_buckets[b->index];
+	default:
+		return SET_ERROR(atom->conn, LLDPCTL_ERR_NOT_EXIST);
+	}
+}
+
+static struct atom_builder latency_list =
+	{ atom_latency_list, sizeof(struct _lldpctl_atom_latency_list_t),
+	  .init  = _lldpctl_atom_new_latency_list,
+	  .free  = _lldpctl_atom_free_latency_list,
+	  .iter  = _lldpctl_atom_iter_latency_list,
+	  .next  = _lldpctl_atom_next_latency_list,
+	  .value = _lldpctl_atom_value_latency_list };
+
+static struct atom_builder latency =
+	{ atom_latency, sizeof(struct _lldpctl_atom_latency_t),
+	  .init = _lldpctl_atom_new_latency,
+	  .free = _lldpctl_atom_free_latency,
+	  .get  = _lldpctl_atom_get_atom_latency,
+	  .get_str = _lldpctl_atom_get_str_latency,
+	  .get_int = _lldpctl_atom_get_int_latency };
+
+static struct atom_builder latency_buckets_list =
+	{ atom_latency_buckets_list, sizeof(struct _lldpctl_atom_latency_bucket_t),
+	  .init  = _lldpctl_atom_new_latency_bucket,
+	  .free  = _lldpctl_atom_free_latency_bucket,
+	  .iter  = _lldpctl_atom_iter_latency_buckets_list,
+	  .next  = _lldpctl_atom_next_latency_buckets_list,
+	  .value = _lldpctl_atom_value_latency_buckets_list };
+
+static struct atom_builder latency_bucket =
+	{ atom_latency_bucket, sizeof(struct _lldpctl_atom_latency_bucket_t),
+	  .init = _lldpctl_atom_new_latency_bucket,
+	  .free = _lldpctl_atom_free_latency_bucket,
+	  .get_int = _lldpctl_atom_get_int_latency_bucket };
+
+ATOM_BUILDER_REGISTER(latency_list,         25);
+ATOM_BUILDER_REGISTER(latency,              26);
+ATOM_BUILDER_REGISTER(latency_buckets_list, 27);
+ATOM_BUILDER_REGISTER(latency_bucket,       28);
@@ -152,9 +152,11 @@ _lldpctl_atom_iter_med_policies_list(lldpctl_atom_t *atom)
 	int i;
 	struct _lldpctl_atom_any_list_t *vlist =
 	    (struct _lldpctl_atom_any_list_t *)atom;
+	struct lldpd_port_med *med = _lldpctl_port_ext(vlist->parent, p_med);
+	if (med == NULL) return NULL;
 	for (i = 0; i < LLDP_MED_APPTYPE_LAST; i++)
-		vlist->parent->port->p_med_policy[i].index = i;
-	return (lldpctl_atom_iter_t*)&vlist->parent->port->p_med_policy[0];
+		med->policy[i].index = i;
+	return (lldpctl_atom_iter_t*)&med->policy[0];
 }
 
 static lldpctl_atom_iter_t*
@@ -313,9 +315,11 @@ _lldpctl_atom_iter_med_locations_list(lldpctl_atom_t *atom)
 	int i;
 	struct _lldpctl_atom_any_list_t *vlist =
 	    (struct _lldpctl_atom_any_list_t *)atom;
+	struct lldpd_port_med *med = _lldpctl_port_ext(vlist->parent, p_med);
+	if (med == NULL) return NULL;
 	for (i = 0; i < LLDP_MED_LOCFORMAT_LAST; i++)
-		vlist->parent->port->p_med_location[i].index = i;
-	return (lldpctl_atom_iter_t*)&vlist->parent->port->p_med_location[0];
+		med->location[i].index = i;
+	return (lldpctl_atom_iter_t*)&med->location[0];
 }
 
 static lldpctl_atom_iter_t*
@@ -410,22 +414,20 @@ _lldpctl_atom_set_int_med_location(lldpctl_atom_t *atom, lldpctl_key_t key,
 		case 0:		/* Disabling */
 		case LLDP_MED_LOCFORMAT_COORD:
 			mloc->location->format = value;
-			free(mloc->location->data);
-			mloc->location->data = calloc(1, 16);
+			mloc->location->data = _lldpctl_alloc_in_atom(
+				(lldpctl_atom_t *)mloc->parent, 16);
 			if (mloc->location->data == NULL) {
 				mloc->location->data_len = 0;
-				SET_ERROR(atom->conn, LLDPCTL_ERR_NOMEM);
 				return NULL;
 			}
 			mloc->location->data_len = 16;
 			return atom;
 		case LLDP_MED_LOCFORMAT_CIVIC:
 			mloc->location->format = value;
-			free(mloc->location->data);
-			mloc->location->data = calloc(1, 4);
+			mloc->location->data = _lldpctl_alloc_in_atom(
+				(lldpctl_atom_t *)mloc->parent, 4);
 			if (mloc->location->data == NULL) {
 				mloc->location->data_len = 0;
-				SET_ERROR(atom->conn, LLDPCTL_ERR_NOMEM);
 				return NULL;
 			}
 			mloc->location->data_len = 4;
@@ -436,7 +438,6 @@ _lldpctl_atom_set_int_med_location(lldpctl_atom_t *atom, lldpctl_key_t key,
 			return atom;
 		case LLDP_MED_LOCFORMAT_ELIN:
 			mloc->location->format = value;
-			free(mloc->location->data);
 			mloc->location->data = NULL;
 			mloc->location->data_len = 0;
 			return atom;
@@ -630,11 +631,10 @@ _lldpctl_atom_set_str_med_location(lldpctl_atom_t *atom, lldpctl_key_t key,
 	case lldpctl_k_med_location_elin:
 		if (!value) goto bad;
 		if (mloc->location->format != LLDP_MED_LOCFORMAT_ELIN) goto bad;
-		free(mloc->location->data);
-		mloc->location->data = calloc(1, strlen(value));
+		mloc->location->data = _lldpctl_alloc_in_atom(
+			(lldpctl_atom_t *)mloc->parent, strlen(value));
 		if (mloc->location->data == NULL) {
 			mloc->location->data_len = 0;
-			SET_ERROR(atom->conn, LLDPCTL_ERR_NOMEM);
 			return NULL;
 		}
 		mloc->location->data_len = strlen(value);
@@ -699,17 +699,15 @@ _lldpctl_atom_set_atom_med_location(lldpctl_atom_t *atom, lldpctl_key_t key,
 
 		/* We append this element. */
 		el = (struct _lldpctl_atom_med_caelement_t *)value;
-		new = malloc(m->location->data_len + 2 + el->len);
-		if (new == NULL) {
-			SET_ERROR(atom->conn, LLDPCTL_ERR_NOMEM);
+		new = _lldpctl_alloc_in_atom((lldpctl_atom_t *)m->parent,
+		    m->location->data_len + 2 + el->len);
+		if (new == NULL)
 			return NULL;
-		}
 		memcpy(new, m->location->data, m->location->data_len);
 		new[m->location->data_len] = el->type;
 		new[m->location->data_len + 1] = el->len;
 		memcpy(new + m->location->data_len + 2, el->value, el->len);
 		new[0] += 2 + el->len;
-		free(m->location->data);
 		m->location->data = (char*)new;
 		m->location->data_len += 2 + el->len;
 		return atom;
@@ -905,6 +903,9 @@ _lldpctl_atom_new_med_power(lldpctl_atom_t *atom, va_list ap)
 	struct _lldpctl_atom_med_power_t *mpow =
 	    (struct _lldpctl_atom_med_power_t *)atom;
 	mpow->parent = va_arg(ap, struct _lldpctl_atom_port_t *);
+	if (_lldpctl_port_ext(mpow->parent, p_med) == NULL)
+		return 0;
+	mpow->power = &mpow->parent->port->p_med->power;
 	lldpctl_atom_inc_ref((lldpctl_atom_t *)mpow->parent);
 	return 1;
 }
@@ -922,19 +923,19 @@ _lldpctl_atom_get_str_med_power(lldpctl_atom_t *atom, lldpctl_key_t key)
 {
 	struct _lldpctl_atom_med_power_t *mpow =
 	    (struct _lldpctl_atom_med_power_t *)atom;
-	struct lldpd_port *port = mpow->parent->port;
+	struct lldpd_med_power *power = mpow->power;
 
 	/* Local and remote port */
 	switch (key) {
 	case lldpctl_k_med_power_type:
 		return map_lookup(port_med_pow_devicetype_map,
-		    port->p_med_power.devicetype);
+		    power->devicetype);
 	case lldpctl_k_med_power_source:
 		return map_lookup(port_med_pow_source_map,
-		    port->p_med_power.source);
+		    power->source);
 	case lldpctl_k_med_power_priority:
 		return map_lookup(port_med_pow_priority_map.map,
-		    port->p_med_power.priority);
+		    power->priority);
 	default:
 		SET_ERROR(atom->conn, LLDPCTL_ERR_NOT_EXIST);
 		return NULL;
@@ -946,18 +947,18 @@ _lldpctl_atom_get_int_med_power(lldpctl_atom_t *atom, lldpctl_key_t key)
 {
 	struct _lldpctl_atom_med_power_t *dpow =
 	    (struct _lldpctl_atom_med_power_t *)atom;
-	struct lldpd_port     *port     = dpow->parent->port;
+	struct lldpd_med_power *power = dpow->power;
 
 	/* Local and remote port */
 	switch (key) {
 	case lldpctl_k_med_power_type:
-		return port->p_med_power.devicetype;
+		return power->devicetype;
 	case lldpctl_k_med_power_source:
-		return port->p_med_power.source;
+		return power->source;
 	case lldpctl_k_med_power_priority:
-		return port->p_med_power.priority;
+		return power->priority;
 	case lldpctl_k_med_power_val:
-		return port->p_med_power.val * 100;
+		return power->val * 100;
 	default:
 		return SET_ERROR(atom->conn, LLDPCTL_ERR_NOT_EXIST);
 	}
@@ -969,7 +970,7 @@ _lldpctl_atom_set_int_med_power(lldpctl_atom_t *atom, lldpctl_key_t key,
 {
 	struct _lldpctl_atom_med_power_t *dpow =
 	    (struct _lldpctl_atom_med_power_t *)atom;
-	struct lldpd_port *port = dpow->parent->port;
+	struct lldpd_med_power *power = dpow->power;
 
 	/* Only local port can be modified */
 	if (!dpow->parent->local) {
@@ -983,7 +984,7 @@ _lldpctl_atom_set_int_med_power(lldpctl_atom_t *atom, lldpctl_key_t key,
 		case 0:
 		case LLDP_MED_POW_TYPE_PSE:
 		case LLDP_MED_POW_TYPE_PD:
-			port->p_med_power.devicetype = value;
+			power->devicetype = value;
 			return atom;
 		default: goto bad;
 		}
@@ -991,29 +992,29 @@ _lldpctl_atom_set_int_med_power(lldpctl_atom_t *atom, lldpctl_key_t key,
 		switch (value) {
 		case LLDP_MED_POW_SOURCE_PRIMARY:
 		case LLDP_MED_POW_SOURCE_BACKUP:
-			if (port->p_med_power.devicetype != LLDP_MED_POW_TYPE_PSE)
+			if (power->devicetype != LLDP_MED_POW_TYPE_PSE)
 				goto bad;
-			port->p_med_power.source = value;
+			power->source = value;
 			return atom;
 		case LLDP_MED_POW_SOURCE_PSE:
 		case LLDP_MED_POW_SOURCE_LOCAL:
 		case LLDP_MED_POW_SOURCE_BOTH:
-			if (port->p_med_power.devicetype != LLDP_MED_POW_TYPE_PD)
+			if (power->devicetype != LLDP_MED_POW_TYPE_PD)
 				goto bad;
-			port->p_med_power.source = value;
+			power->source = value;
 			return atom;
 		case LLDP_MED_POW_SOURCE_UNKNOWN:
-			port->p_med_power.source = value;
+			power->source = value;
 			return atom;
 		default: goto bad;
 		}
 	case lldpctl_k_med_power_priority:
 		if (value < 0 || value > 3) goto bad;
-		port->p_med_power.priority = value;
+		power->priority = value;
 		return atom;
 	case lldpctl_k_med_power_val:
 		if (value < 0) goto bad;
-		port->p_med_power.val = value / 100;
+		power->val = value / 100;
 		return atom;
 	default:
 		SET_ERROR(atom->conn, LLDPCTL_ERR_NOT_EXIST);
@@ -168,7 +168,7 @@ _lldpctl_atom_value_ports_list(lldpctl_atom_t *atom, lldpctl_atom_iter_t *iter)
 {
 	struct lldpd_port *port = (struct lldpd_port *)iter;
 	return _lldpctl_new_atom(atom->conn, atom_port, 0, NULL, port,
-	    ((struct _lldpctl_atom_any_list_t *)atom)->parent);
+	    ((struct _lldpctl_atom_any_list_t *)atom)->parent, NULL);
 }
 
 static int
@@ -180,6 +180,7 @@ _lldpctl_atom_new_port(lldpctl_atom_t *atom, va_list ap)
 	port->hardware = va_arg(ap, struct lldpd_hardware*);
 	port->port = va_arg(ap, struct lldpd_port*);
 	port->parent = va_arg(ap, struct _lldpctl_atom_port_t*);
+	port->answer = va_arg(ap, void*);
 	if (port->parent)
 		lldpctl_atom_inc_ref((lldpctl_atom_t*)port->parent);
 
@@ -192,68 +193,21 @@ _lldpctl_atom_new_port(lldpctl_atom_t *atom, va_list ap)
 	return 1;
 }
 
-TAILQ_HEAD(chassis_list, lldpd_chassis);
-
-static void
-add_chassis(struct chassis_list *chassis_list,
-	struct lldpd_chassis *chassis)
-{
-	struct lldpd_chassis *one_chassis;
-	TAILQ_FOREACH(one_chassis, chassis_list, c_entries) {
-		if (one_chassis == chassis) return;
-	}
-	TAILQ_INSERT_TAIL(chassis_list,
-	    chassis, c_entries);
-}
-
 static void
 _lldpctl_atom_free_port(lldpctl_atom_t *atom)
 {
 	struct _lldpctl_atom_port_t *port =
 	    (struct _lldpctl_atom_port_t *)atom;
-	struct lldpd_hardware *hardware = port->hardware;
-	struct lldpd_chassis  *one_chassis, *one_chassis_next;
-	struct lldpd_port     *one_port;
 
 	/* Free internal chassis atom. Should be freed immediately since we
 	 * should have the only reference. */
 	lldpctl_atom_dec_ref((lldpctl_atom_t*)port->chassis);
 
-	/* We need to free the whole struct lldpd_hardware: local port, local
-	 * chassis and remote ports... The same chassis may be present several
-	 * times. We build a list of chassis (we don't use reference count). */
-	struct chassis_list chassis_list;
-	TAILQ_INIT(&chassis_list);
-
+	/* A remote port is part of its parent. Otherwise, the local port, the
+	 * local chassis, the remote ports and their chassis have been
+	 * unserialized in a single buffer. */
 	if (port->parent) lldpctl_atom_dec_ref((lldpctl_atom_t*)port->parent);
-	else if (!hardware && port->port) {
-		/* No parent, no hardware, we assume a single neighbor: one
-		 * port, one chassis. */
-		if (port->port->p_chassis) {
-			lldpd_chassis_cleanup(port->port->p_chassis, 1);
-			port->port->p_chassis = NULL;
-		}
-		lldpd_port_cleanup(port->port, 1);
-		free(port->port);
-	}
-	if (!hardware) return;
-
-	add_chassis(&chassis_list, port->port->p_chassis);
-	TAILQ_FOREACH(one_port, &hardware->h_rports, p_entries)
-		add_chassis(&chassis_list, one_port->p_chassis);
-
-	/* Free hardware port */
-	lldpd_remote_cleanup(hardware, NULL, 1);
-	lldpd_port_cleanup(port->port, 1);
-	free(port->hardware);
-
-	/* Free list of chassis */
-	for (one_chassis = TAILQ_FIRST(&chassis_list);
-	     one_chassis != NULL;
-	     one_chassis = one_chassis_next) {
-		one_chassis_next = TAILQ_NEXT(one_chassis, c_entries);
-		lldpd_chassis_cleanup(one_chassis, 1);
-	}
+	marshal_release(port->answer);
 }
 
 static lldpctl_atom_t*
@@ -321,6 +275,23 @@ _lldpctl_atom_get_atom_port(lldpctl_atom_t *atom, lldpctl_key_t key)
 	}
 }
 
+/* Name of a local port. When the port is in another network namespace, the name
+ * is prefixed by the namespace, like in the list of interfaces. */
+static const char*
+_lldpctl_atom_port_name(lldpctl_atom_t *atom, struct lldpd_hardware *hardware)
+{
+	char *name;
+	size_t len;
+
+	if (hardware->h_netns[0] == '\0')
+		return hardware->h_ifname;
+	len = strlen(hardware->h_netns) + 1 + strlen(hardware->h_ifname) + 1;
+	if ((name = _lldpctl_alloc_in_atom(atom, len)) == NULL)
+		return NULL;
+	snprintf(name, len, "%s/%s", hardware->h_netns, hardware->h_ifname);
+	return name;
+}
+
 static lldpctl_atom_t*
 _lldpctl_atom_set_atom_port(lldpctl_atom_t *atom, lldpctl_key_t key, lldpctl_atom_t *value)
 {
@@ -367,7 +338,7 @@ _lldpctl_atom_set_atom_port(lldpctl_atom_t *atom, lldpctl_key_t key, lldpctl_ato
 		}
 
 		dpow = (struct _lldpctl_atom_dot3_power_t *)value;
-		set.dot3_power = &dpow->parent->port->p_power;
+		set.dot3_power = dpow->power;
 		break;
 #endif
 #ifdef ENABLE_LLDPMED
@@ -378,7 +349,7 @@ _lldpctl_atom_set_atom_port(lldpctl_atom_t *atom, lldpctl_key_t key, lldpctl_ato
 		}
 
 		mpow = (struct _lldpctl_atom_med_power_t *)value;
-		set.med_power = &mpow->parent->port->p_med_power;
+		set.med_power = mpow->power;
 		break;
 	case lldpctl_k_port_med_policies:
 		if (value->type != atom_med_policy) {
@@ -416,7 +387,8 @@ _lldpctl_atom_set_atom_port(lldpctl_atom_t *atom, lldpctl_key_t key, lldpctl_ato
 		return NULL;
 	}
 
-	set.ifname = hardware ? hardware->h_ifname : "";
+	set.ifname = hardware ? (char *)_lldpctl_atom_port_name(atom, hardware) : "";
+	if (set.ifname == NULL) return NULL;
 
 	if (asprintf(&canary, "%d%p%s", key, value, set.ifname) == -1) {
 		SET_ERROR(atom->conn, LLDPCTL_ERR_NOMEM);
@@ -444,7 +416,11 @@ _lldpctl_atom_get_str_port(lldpctl_atom_t *atom, lldpctl_key_t key)
 	/* Local port only */
 	switch (key) {
 	case lldpctl_k_port_name:
-		if (hardware != NULL) return hardware->h_ifname;
+		if (hardware != NULL) return _lldpctl_atom_port_name(atom, hardware);
+		break;
+	case lldpctl_k_port_netns:
+		if (hardware != NULL && hardware->h_netns[0] != '\0')
+			return hardware->h_netns;
 		break;
 	case lldpctl_k_port_status:
 		if (p->local) return map_lookup(port_status_map.map,
@@ -554,13 +530,17 @@ _lldpctl_atom_set_str_port(lldpctl_atom_t *atom, lldpctl_key_t key,
 
 	switch (key) {
 	case lldpctl_k_port_id:
-		free(port->p_id);
-		port->p_id = strdup(value);
+		if ((port->p_id = _lldpctl_alloc_in_atom(atom,
+			    strlen(value) + 1)) == NULL)
+			return NULL;
+		memcpy(port->p_id, value, strlen(value));
 		port->p_id_len = strlen(value);
 		break;
 	case lldpctl_k_port_descr:
-		free(port->p_descr);
-		port->p_descr = strdup(value);
+		if ((port->p_descr = _lldpctl_alloc_in_atom(atom,
+			    strlen(value) + 1)) == NULL)
+			return NULL;
+		memcpy(port->p_descr, value, strlen(value));
 		break;
 	default:
 		SET_ERROR(atom->conn, LLDPCTL_ERR_NOT_EXIST);
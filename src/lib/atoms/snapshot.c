@@ -0,0 +1,275 @@
+/* -*- mode: c; c-file-style: "openbsd" -*- */
+/*
+ * Copyright (c) 2019 Vincent Bernat <vincent@bernat.im>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#include "lldpctl.h"
+#include "../log.h"
+#include "../ctl.h"
+#include "atom.h"
+#include "helpers.h"
+
+/* Number of attempts to get a consistent copy of the snapshot. */
+#define SNAPSHOT_MAX_TRIES 1000
+
+static int
+_lldpctl_atom_new_snapshot(lldpctl_atom_t *atom, va_list ap)
+{
+	struct _lldpctl_atom_snapshot_t *snapshot =
+	    (struct _lldpctl_atom_snapshot_t *)atom;
+	snapshot->records = va_arg(ap, unsigned char *);
+	snapshot->len = va_arg(ap, size_t);
+	return 1;
+}
+
+static void
+_lldpctl_atom_free_snapshot(lldpctl_atom_t *atom)
+{
+	struct _lldpctl_atom_snapshot_t *snapshot =
+	    (struct _lldpctl_atom_snapshot_t *)atom;
+	free(snapshot->records);
+}
+
+static lldpctl_atom_iter_t*
+_lldpctl_atom_iter_snapshot(lldpctl_atom_t *atom)
+{
+	struct _lldpctl_atom_snapshot_t *snapshot =
+	    (struct _lldpctl_atom_snapshot_t *)atom;
+	if (snapshot->len == 0) return NULL;
+	return (lldpctl_atom_iter_t*)snapshot->records;
+}
+
+static lldpctl_atom_iter_t*
+_lldpctl_atom_next_snapshot(lldpctl_atom_t *atom, lldpctl_atom_iter_t *iter)
+{
+	struct _lldpctl_atom_snapshot_t *snapshot =
+	    (struct _lldpctl_atom_snapshot_t *)atom;
+	struct snapshot_record *record = (struct snapshot_record *)iter;
+	unsigned char *next = (unsigned char *)iter +
+	    sizeof(struct snapshot_record) + SNAPSHOT_ALIGN(record->len);
+	if (next >= snapshot->records + snapshot->len) return NULL;
+	return (lldpctl_atom_iter_t*)next;
+}
+
+static lldpctl_atom_t*
+_lldpctl_atom_value_snapshot(lldpctl_atom_t *atom, lldpctl_atom_iter_t *iter)
+{
+	struct snapshot_record *record = (struct snapshot_record *)iter;
+	struct lldpd_hardware *hardware;
+	void *buffer, *p;
+
+	/* Each port gets its own copy as it is unserialized in place. */
+	if ((buffer = malloc(record->len)) == NULL) {
+		SET_ERROR(atom->conn, LLDPCTL_ERR_NOMEM);
+		return NULL;
+	}
+	memcpy(buffer, record + 1, record->len);
+	if (marshal_unserialize_inplace_(&MARSHAL_INFO(lldpd_hardware),
+		buffer, record->len, &p) <= 0) {
+		free(buffer);
+		SET_ERROR(atom->conn, LLDPCTL_ERR_SERIALIZATION);
+		return NULL;
+	}
+	hardware = p;
+	return _lldpctl_new_atom(atom->conn, atom_port, 1,
+	    hardware, &hardware->h_lport, NULL, hardware);
+}
+
+/* Check that all records fit in the provided buffer. Return the number of
+ * records or -1. */
+static int
+_lldpctl_snapshot_check(unsigned char *records, size_t len)
+{
+	struct snapshot_record *record;
+	size_t offset = 0;
+	int count = 0;
+	while (offset < len) {
+		if (len - offset < sizeof(struct snapshot_record)) return -1;
+		record = (struct snapshot_record *)(records + offset);
+		if (record->len == 0 ||
+		    record->len > len - offset - sizeof(struct snapshot_record))
+			return -1;
+		offset += sizeof(struct snapshot_record) +
+		    SNAPSHOT_ALIGN(record->len);
+		count++;
+	}
+	return count;
+}
+
+lldpctl_atom_t*
+lldpctl_get_snapshot(lldpctl_conn_t *conn, const char *path)
+{
+	struct snapshot_header *h;
+	struct snapshot_slot *slot;
+	struct stat st;
+	lldpctl_atom_t *atom;
+	unsigned char *map = NULL, *records = NULL, *r;
+	size_t size = 0;
+	u_int64_t offset, len = 0;
+	u_int32_t sequence, count = 0;
+	int fd, tries, rc = LLDPCTL_ERR_WOULDBLOCK;
+
+	RESET_ERROR(conn);
+
+	if ((fd = open(path?path:LLDPD_SNAPSHOT_FILE, O_RDONLY)) == -1) {
+		SET_ERROR(conn, LLDPCTL_ERR_NOT_EXIST);
+		return NULL;
+	}
+	for (tries = 0; tries < SNAPSHOT_MAX_TRIES; tries++) {
+		if (tries > 0) sched_yield();
+
+		/* The file only grows */
+		if (fstat(fd, &st) == -1) {
+			rc = LLDPCTL_ERR_FATAL;
+			break;
+		}
+		if ((size_t)st.st_size > size) {
+			if (map) munmap(map, size);
+			size = st.st_size;
+			if ((map = mmap(NULL, size, PROT_READ, MAP_SHARED,
+				    fd, 0)) == MAP_FAILED) {
+				map = NULL;
+				rc = LLDPCTL_ERR_FATAL;
+				break;
+			}
+		}
+		h = (struct snapshot_header *)map;
+		if (size < sizeof(struct snapshot_header) ||
+		    __atomic_load_n(&h->magic, __ATOMIC_ACQUIRE) != SNAPSHOT_MAGIC) {
+			rc = LLDPCTL_ERR_NOT_EXIST;
+			break;
+		}
+		if (h->version != HMSG_VERSION) {
+			rc = LLDPCTL_ERR_SERIALIZATION;
+			break;
+		}
+
+		slot = &h->slots[__atomic_load_n(&h->current, __ATOMIC_ACQUIRE) & 1];
+		sequence = __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+		if (sequence & 1) continue;
+		offset = slot->offset;
+		len = slot->len;
+		count = slot->count;
+		if (offset > size || len > size - offset) {
+			/* Either the file was grown after our fstat() or the
+			 * slot is being rewritten. */
+			continue;
+		}
+		if ((r = realloc(records, len?len:1)) == NULL) {
+			rc = LLDPCTL_ERR_NOMEM;
+			break;
+		}
+		records = r;
+		memcpy(records, map + offset, len);
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if (__atomic_load_n(&slot->sequence, __ATOMIC_RELAXED) != sequence)
+			continue;
+		rc = (_lldpctl_snapshot_check(records, len) == (int)count)?
+		    0:LLDPCTL_ERR_SERIALIZATION;
+		break;
+	}
+	if (map) munmap(map, size);
+	close(fd);
+
+	if (rc != 0) {
+		free(records);
+		SET_ERROR(conn, rc);
+		return NULL;
+	}
+	if ((atom = _lldpctl_new_atom(conn, atom_snapshot,
+		    records, (size_t)len)) == NULL)
+		free(records);
+	return atom;
+}
+
+lldpctl_atom_t*
+lldpctl_get_ports(lldpctl_conn_t *conn)
+{
+	struct lldpd_ports_batch request = {}, *batch;
+	lldpctl_atom_t *atom;
+	unsigned char *records;
+	void *p;
+	int rc;
+
+	RESET_ERROR(conn);
+
+	/* Batches are accumulated into the connection until the last one has
+	 * been received. */
+	do {
+		request.b_start = conn->ports_next;
+		rc = _lldpctl_do_something(conn,
+		    CONN_STATE_GET_PORTS_SEND, CONN_STATE_GET_PORTS_RECV, NULL,
+		    GET_PORTS,
+		    &request, &MARSHAL_INFO(lldpd_ports_batch),
+		    &p, &MARSHAL_INFO(lldpd_ports_batch));
+		if (rc == LLDPCTL_ERR_WOULDBLOCK) return NULL;
+		if (rc != 0) goto error;
+		batch = p;
+		if (_lldpctl_snapshot_check((unsigned char *)batch->b_records,
+			batch->b_len) == -1 ||
+		    (batch->b_next != 0 && batch->b_next <= conn->ports_next)) {
+			marshal_release(batch);
+			SET_ERROR(conn, LLDPCTL_ERR_SERIALIZATION);
+			goto error;
+		}
+		if (batch->b_len > 0) {
+			if ((records = realloc(conn->ports,
+				    conn->ports_len + batch->b_len)) == NULL) {
+				marshal_release(batch);
+				SET_ERROR(conn, LLDPCTL_ERR_NOMEM);
+				goto error;
+			}
+			memcpy(records + conn->ports_len,
+			    batch->b_records, batch->b_len);
+			conn->ports = records;
+			conn->ports_len += batch->b_len;
+		}
+		conn->ports_next = batch->b_next;
+		marshal_release(batch);
+	} while (conn->ports_next != 0);
+
+	atom = _lldpctl_new_atom(conn, atom_snapshot,
+	    conn->ports, conn->ports_len);
+	if (atom == NULL) free(conn->ports);
+	conn->ports = NULL;
+	conn->ports_len = 0;
+	return atom;
+
+error:
+	free(conn->ports);
+	conn->ports = NULL;
+	conn->ports_len = 0;
+	conn->ports_next = 0;
+	return NULL;
+}
+
+static struct atom_builder snapshot =
+	{ atom_snapshot, sizeof(struct _lldpctl_atom_snapshot_t),
+	  .init  = _lldpctl_atom_new_snapshot,
+	  .free  = _lldpctl_atom_free_snapshot,
+	  .iter  = _lldpctl_atom_iter_snapshot,
+	  .next  = _lldpctl_atom_next_snapshot,
+	  .value = _lldpctl_atom_value_snapshot };
+
+ATOM_BUILDER_REGISTER(snapshot, 24);
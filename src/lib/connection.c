@@ -143,10 +143,17 @@ lldpctl_release(lldpctl_conn_t *conn)
 	}
 	free(conn->input_buffer);
 	free(conn->output_buffer);
+	free(conn->ports);
 	free(conn);
 	return 0;
 }
 
+unsigned long
+lldpctl_get_requests(lldpctl_conn_t *conn)
+{
+	return conn->requests;
+}
+
 /**
  * Request some bytes if they are not already here.
  *
@@ -201,6 +208,14 @@ check_for_notification(lldpctl_conn_t *conn)
 		case NEIGHBOR_CHANGE_DELETED: type = lldpctl_c_deleted; break;
 		case NEIGHBOR_CHANGE_ADDED: type = lldpctl_c_added; break;
 		case NEIGHBOR_CHANGE_UPDATED: type = lldpctl_c_updated; break;
+		case NEIGHBOR_CHANGE_RESYNC:
+			/* Some notifications were lost, no neighbor attached */
+			if (!(conn->watch_flags & LLDPCTL_WATCH_RESYNC))
+				goto end;
+			conn->watch_cb(conn, lldpctl_c_resync, NULL, NULL,
+			    conn->watch_data);
+			conn->watch_triggered = 1;
+			goto end;
 		default:
 			log_warnx("control", "unknown notification type (%d)",
 			    change->state);
@@ -209,8 +224,9 @@ check_for_notification(lldpctl_conn_t *conn)
 		interface = _lldpctl_new_atom(conn, atom_interface,
 		    change->ifname);
 		if (interface == NULL) goto end;
+		/* The neighbor atom now owns the notification */
 		neighbor = _lldpctl_new_atom(conn, atom_port, 0,
-		    NULL, change->neighbor, NULL);
+		    NULL, change->neighbor, NULL, change);
 		if (neighbor == NULL) goto end;
 		conn->watch_cb(conn, type, interface, neighbor, conn->watch_data);
 		conn->watch_triggered = 1;
@@ -220,13 +236,7 @@ check_for_notification(lldpctl_conn_t *conn)
 end:
 	if (interface) lldpctl_atom_dec_ref(interface);
 	if (neighbor) lldpctl_atom_dec_ref(neighbor);
-	else {
-		lldpd_chassis_cleanup(change->neighbor->p_chassis, 1);
-		lldpd_port_cleanup(change->neighbor, 1);
-		free(change->neighbor);
-	}
-	free(change->ifname);
-	free(change);
+	else marshal_release(change);
 
 	/* Indicate if more data remains in the buffer for processing */
 	return (rc);
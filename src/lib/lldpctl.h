@@ -217,6 +217,17 @@ lldpctl_conn_t *lldpctl_new_name(const char *ctlname, lldpctl_send_callback send
  * @see lldpctl_new()
  */
 int lldpctl_release(lldpctl_conn_t *conn);
+
+/**
+ * Get the number of requests sent to lldpd.
+ *
+ * Each request is a round-trip with lldpd. This may be used to check how many
+ * of them are needed for a given task.
+ *
+ * @param   conn Previously allocated handler to a connection to lldpd.
+ * @return  The number of requests sent since the handler was allocated.
+ */
+unsigned long lldpctl_get_requests(lldpctl_conn_t *conn);
 /**@}*/
 
 /**
@@ -260,8 +271,9 @@ void lldpctl_log_callback(void (*cb)(int severity, const char *msg));
  * Setup log level.
  *
  * By default, liblldpctl will only log warnings. The following function allows
- * to increase verbosity. This function has no effect if callbacks are
- * registered with the previous function.
+ * to increase verbosity. When a callback is registered with the previous
+ * function, it receives warnings and informational messages and debug
+ * messages are only passed to it when the level is 3.
  *
  * @param level    Level of verbosity (1 = warnings, 2 = info, 3 = debug).
  */
@@ -455,6 +467,10 @@ typedef enum {
 	lldpctl_c_deleted,	/**< The neighbor has been deleted */
 	lldpctl_c_updated,	/**< The neighbor has been updated */
 	lldpctl_c_added,	/**< This is a new neighbor */
+	lldpctl_c_resync,	/**< Some changes were lost, neighbors should be
+				 * fetched again. Interface and neighbor are @c
+				 * NULL. Only sent to callbacks registered with
+				 * @c LLDPCTL_WATCH_RESYNC. */
 } lldpctl_change_t;
 
 /**
@@ -462,8 +478,9 @@ typedef enum {
  *
  * @param conn      Connection with lldpd.
  * @param type      Type of change detected.
- * @param interface Physical interface on which the change has happened.
- * @param neighbor  Changed neighbor.
+ * @param interface Physical interface on which the change has happened. @c
+ *                  NULL for @c lldpctl_c_resync.
+ * @param neighbor  Changed neighbor. @c NULL for @c lldpctl_c_resync.
  * @param data      Data provided when registering the callback.
  *
  * The provided interface and neighbor atoms are stolen by the callback: their
@@ -497,6 +514,32 @@ int lldpctl_watch_callback(lldpctl_conn_t *conn,
     lldpctl_change_callback cb,
     void *data);
 
+/**
+ * Flags for @ref lldpctl_watch_callback2().
+ */
+typedef enum {
+	LLDPCTL_WATCH_RESYNC = 1 << 0,	/**< Also get @c lldpctl_c_resync
+					 * changes, with @c NULL atoms. */
+} lldpctl_watch_flags_t;
+
+/**
+ * Register a callback to be called on changes, with flags.
+ *
+ * @param conn  Connection with lldpd.
+ * @param cb    Replace the current callback with the provided one.
+ * @param data  Data that will be passed to the callback.
+ * @param flags Bitmask of @c lldpctl_watch_flags_t.
+ * @return 0 in case of success or -1 in case of errors.
+ *
+ * This is the same as @ref lldpctl_watch_callback(), which uses no flag.
+ * Without @c LLDPCTL_WATCH_RESYNC, the callback is never invoked with @c NULL
+ * atoms but it is not told when changes were lost.
+ */
+int lldpctl_watch_callback2(lldpctl_conn_t *conn,
+    lldpctl_change_callback cb,
+    void *data,
+    int flags);
+
 /**
  * Wait for the next change.
  *
@@ -597,6 +640,56 @@ lldpctl_atom_t *lldpctl_get_port(lldpctl_atom_t *port);
  */
 lldpctl_atom_t *lldpctl_get_default_port(lldpctl_conn_t *conn);
 
+/**
+ * Retrieve all local ports from the snapshot published by lldpd.
+ *
+ * lldpd publishes a snapshot of its local ports (with their neighbors and
+ * counters) when configured to do so (see @c lldpctl_k_config_snapshot). Unlike
+ * @c lldpctl_get_port(), reading the snapshot does not involve lldpd at all
+ * and never blocks.
+ *
+ * @param conn Previously allocated handler to a connection to lldpd. The
+ *             connection is only used to report errors.
+ * @param path Path to the snapshot file or @c NULL to use the default one.
+ * @return Iterable atom of local ports, each of them usable like an atom
+ *         returned by @c lldpctl_get_port(). On error, @c NULL is returned. If
+ *         the last error is @c LLDPCTL_ERR_NOT_EXIST, no snapshot is
+ *         available. If it is @c LLDPCTL_ERR_WOULDBLOCK, lldpd was too busy
+ *         updating the snapshot and you should try again later.
+ */
+lldpctl_atom_t *lldpctl_get_snapshot(lldpctl_conn_t *conn, const char *path);
+
+/**
+ * Retrieve all local ports from lldpd.
+ *
+ * This is equivalent to calling @c lldpctl_get_port() on each interface
+ * returned by @c lldpctl_get_interfaces() but ports are retrieved in batches:
+ * the number of requests depends on the amount of data, not on the number of
+ * ports.
+ *
+ * @param conn Previously allocated handler to a connection to lldpd.
+ * @return Iterable atom of local ports, each of them usable like an atom
+ *         returned by @c lldpctl_get_port(), or @c NULL if an error happened.
+ *
+ * This function may have to do IO. If @c NULL is returned and the last error
+ * is @c LLDPCTL_ERR_WOULDBLOCK, try again later: batches already received are
+ * kept until the function completes.
+ */
+lldpctl_atom_t *lldpctl_get_ports(lldpctl_conn_t *conn);
+
+/**
+ * Retrieve latency histograms of the main processing stages of lldpd.
+ *
+ * @param conn  Previously allocated handler to a connection to lldpd.
+ * @param reset If not 0, histograms are reset by lldpd after being retrieved.
+ * @return Iterable atom of stages, see @c lldpctl_k_latency_name and the
+ *         following keys, or @c NULL if an error happened.
+ *
+ * This function may have to do IO. If @c NULL is returned and the last error
+ * is @c LLDPCTL_ERR_WOULDBLOCK, try again later.
+ */
+lldpctl_atom_t *lldpctl_get_latency(lldpctl_conn_t *conn, int reset);
+
 /**@}*/
 
 /**
@@ -675,6 +768,7 @@ typedef enum {
 
 	lldpctl_k_port_name = 1100,	/**< `(S)` The port name. Only works for a local port. */
 	lldpctl_k_port_index,	/**< `(I)` The port index. Only works for a local port. */
+	lldpctl_k_port_netns,	/**< `(S)` The network namespace of the port, if not the one of lldpd. Only works for a local port. */
 	/**
 	 * `(AL)` The list of known neighbors for this port.
 	 *
@@ -839,6 +933,17 @@ typedef enum {
 	lldpctl_k_config_lldp_portid_type, /**< `(I,WO)` LLDP PortID TLV Subtype */
 	lldpctl_k_config_lldp_agent_type, /**< `(I,WO)` LLDP agent type */
 	lldpctl_k_config_max_neighbors, /**< `(I,WO)`Maximum number of neighbors per port. */
+	lldpctl_k_config_notification_interval, /**< `(I,WO)` Minimum interval between two SNMP notifications. */
+	lldpctl_k_config_startup_privsep, /**< `(I)` Milliseconds since start when privilege separation was ready. */
+	lldpctl_k_config_startup_interfaces, /**< `(I)` Milliseconds since start when interfaces were initialized. */
+	lldpctl_k_config_startup_configured, /**< `(I)` Milliseconds since start when configuration was applied. */
+	lldpctl_k_config_startup_first_pdu, /**< `(I)` Milliseconds since start when the first PDU was sent. */
+	lldpctl_k_config_startup_metadata, /**< `(I)` Milliseconds since start when chassis metadata was collected. */
+	lldpctl_k_config_snapshot, /**< `(I,WO)` Publish ports and neighbors in a snapshot file. */
+	lldpctl_k_config_warm_restart, /**< `(I,WO)` Keep neighbors across restarts. */
+	lldpctl_k_config_metrics, /**< `(I,WO)` Export metrics in OpenMetrics format. */
+	lldpctl_k_config_metrics_port, /**< `(I,WO)` TCP port on loopback to export metrics, 0 for a Unix socket. */
+	lldpctl_k_config_decode_workers, /**< `(I,WO)` Number of threads decoding received frames, 0 to decode them in the main loop. */
 
 	lldpctl_k_custom_tlvs = 5000,		/**< `(AL)` custom TLVs */
 	lldpctl_k_custom_tlvs_clear,		/** `(I,WO)` clear list of custom TLVs */
@@ -848,6 +953,14 @@ typedef enum {
 	lldpctl_k_custom_tlv_oui_info_string,	/**< `(I,WO)` custom TLV Organizationally Unique Identifier Information String (up to 507 bytes) */
 	lldpctl_k_custom_tlv_op,		/**< `(I,WO)` custom TLV operation */
 
+	lldpctl_k_latency_name = 6000,	/**< `(S)` Name of the processing stage */
+	lldpctl_k_latency_count,	/**< `(I)` Number of samples */
+	lldpctl_k_latency_sum,		/**< `(I)` Sum of all samples in nanoseconds */
+	lldpctl_k_latency_max,		/**< `(I)` Largest sample in nanoseconds */
+	lldpctl_k_latency_buckets,	/**< `(AL)` Histogram buckets */
+	lldpctl_k_latency_bucket_le,	/**< `(I)` Upper bound of a bucket in nanoseconds, -1 for the last one */
+	lldpctl_k_latency_bucket_count,	/**< `(I)` Number of samples in a bucket (not cumulative) */
+
 } lldpctl_key_t;
 
 /**
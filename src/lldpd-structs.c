@@ -17,10 +17,439 @@
 
 #include <stdlib.h>
 #include <unistd.h>
+#include <string.h>
 #include <time.h>
 #include "lldpd-structs.h"
 #include "log.h"
 
+#ifdef HAVE_VALGRIND_VALGRIND_H
+# include <valgrind/valgrind.h>
+#else
+# define RUNNING_ON_VALGRIND 0
+#endif
+
+#ifdef HAVE_PTHREAD
+/* Threads decoding frames outside of the main loop cannot use the pool of
+ * interned strings nor the free lists below. Once detached with
+ * lldpd_alloc_detach(), a thread only gets plain copies of strings and plain
+ * malloc() blocks. Those are still valid for the main thread: strings can be
+ * interned later with lldpd_intern_neighbor(). */
+static __thread int detached = 0;
+
+void
+lldpd_alloc_detach(void)
+{
+	detached = 1;
+}
+#else
+# define detached 0
+#endif
+
+/* Pool of interned strings. Many neighbors share the same descriptions,
+ * names or inventory strings: they share a single reference-counted copy.
+ * Interned strings are plain C strings, so marshal and readers do not need to
+ * know about them. The only requirement is to release them with
+ * lldpd_intern_release(), which also frees strings that were not interned.
+ * Two interned strings are equal if and only if their pointers are equal. */
+struct intern {
+	struct intern	*next;
+	u_int32_t	 hash;
+	u_int32_t	 refcount;
+	char		 str[];
+};
+static struct intern **intern_buckets = NULL;
+static size_t intern_size = 0;	/* Number of buckets, a power of two */
+static size_t intern_count = 0;	/* Number of strings */
+#define INTERN_INITIAL_SIZE 256
+
+static u_int32_t
+intern_hash(const char *str, size_t len)
+{
+	u_int32_t hash = 2166136261U; /* FNV-1a */
+	while (len--) {
+		hash ^= (unsigned char)*str++;
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
+static void
+intern_grow(void)
+{
+	struct intern **buckets, *e, *e_next;
+	size_t size = intern_size?intern_size * 2:INTERN_INITIAL_SIZE, i;
+
+	if ((buckets = calloc(size, sizeof(struct intern *))) == NULL)
+		return;		/* Keep longer chains */
+	for (i = 0; i < intern_size; i++) {
+		for (e = intern_buckets[i]; e != NULL; e = e_next) {
+			e_next = e->next;
+			e->next = buckets[e->hash & (size - 1)];
+			buckets[e->hash & (size - 1)] = e;
+		}
+	}
+	free(intern_buckets);
+	intern_buckets = buckets;
+	intern_size = size;
+}
+
+/**
+ * Get an interned copy of the first `len` bytes of a string, stopping at the
+ * first NUL byte.
+ *
+ * @return The interned string or NULL if we run out of memory.
+ */
+char *
+lldpd_intern_len(const char *str, size_t len)
+{
+	struct intern *e;
+	u_int32_t hash;
+	char *copy;
+
+	len = strnlen(str, len);
+	if (detached) {
+		if ((copy = malloc(len + 1)) == NULL) return NULL;
+		memcpy(copy, str, len);
+		copy[len] = '\0';
+		return copy;
+	}
+	hash = intern_hash(str, len);
+	if (intern_size) {
+		for (e = intern_buckets[hash & (intern_size - 1)];
+		     e != NULL;
+		     e = e->next) {
+			if (e->hash == hash && strncmp(e->str, str, len) == 0 &&
+			    e->str[len] == '\0') {
+				e->refcount++;
+				return e->str;
+			}
+		}
+	}
+
+	if (intern_count >= intern_size) intern_grow();
+	if (intern_size == 0 ||
+	    (e = malloc(sizeof(struct intern) + len + 1)) == NULL)
+		return NULL;
+	memcpy(e->str, str, len);
+	e->str[len] = '\0';
+	e->hash = hash;
+	e->refcount = 1;
+	e->next = intern_buckets[hash & (intern_size - 1)];
+	intern_buckets[hash & (intern_size - 1)] = e;
+	intern_count++;
+	return e->str;
+}
+
+char *
+lldpd_intern(const char *str)
+{
+	return lldpd_intern_len(str, strlen(str));
+}
+
+/**
+ * Release a string. If the string was not interned, it is just freed.
+ */
+void
+lldpd_intern_release(char *str)
+{
+	struct intern *e, **prev;
+	size_t len;
+	u_int32_t hash;
+
+	if (str == NULL) return;
+	if (intern_count > 0 && !detached) {
+		len = strlen(str);
+		hash = intern_hash(str, len);
+		for (prev = &intern_buckets[hash & (intern_size - 1)];
+		     (e = *prev) != NULL;
+		     prev = &e->next) {
+			if (e->str != str) continue;
+			if (--e->refcount == 0) {
+				*prev = e->next;
+				intern_count--;
+				free(e);
+			}
+			return;
+		}
+	}
+	free(str);
+}
+
+/* Replace a string by its interned version. */
+static void
+intern_replace(char **str)
+{
+	char *interned;
+	if (*str == NULL) return;
+	if ((interned = lldpd_intern(*str)) == NULL) return;
+	lldpd_intern_release(*str);
+	*str = interned;
+}
+
+/**
+ * Intern strings of a chassis and of a port built by other means than a
+ * decoder, for example unserialized.
+ */
+void
+lldpd_intern_neighbor(struct lldpd_chassis *chassis, struct lldpd_port *port)
+{
+#ifdef ENABLE_DOT1
+	struct lldpd_vlan *vlan;
+#endif
+	if (chassis) {
+		intern_replace(&chassis->c_name);
+		intern_replace(&chassis->c_descr);
+#ifdef ENABLE_LLDPMED
+		intern_replace(&chassis->c_med_hw);
+		intern_replace(&chassis->c_med_sw);
+		intern_replace(&chassis->c_med_fw);
+		intern_replace(&chassis->c_med_manuf);
+		intern_replace(&chassis->c_med_model);
+#endif
+	}
+	if (port) {
+		intern_replace(&port->p_descr);
+#ifdef ENABLE_DOT1
+		TAILQ_FOREACH(vlan, &port->p_vlans, v_entries)
+			intern_replace(&vlan->v_name);
+#endif
+	}
+}
+
+/* Free-list allocators. Each time a frame differs from the previous one, the
+ * neighbor is decoded again in freshly allocated objects and the old ones are
+ * released. Released objects are kept on a per-type free list to be reused by
+ * the next decode. Cached objects are plain malloc() blocks of the exact size
+ * of the object: objects from the free lists can be released with free().
+ * Objects that were not allocated here (for example, unserialized ones or
+ * ones allocated by a detached thread) have to be adopted with
+ * lldpd_slab_adopt_neighbor() before being released with lldpd_slab_free().
+ *
+ * When running with AddressSanitizer or valgrind, nothing is cached to not
+ * hide use-after-free errors. */
+struct slab {
+	const char	*name;
+	size_t		 size;		/* Size of an object */
+	size_t		 max;		/* Maximum number of cached objects */
+	void		*free;		/* Free list */
+	size_t		 cached;	/* Number of objects on the free list */
+	size_t		 used;		/* Number of objects allocated or adopted */
+	u_int64_t	 allocs;	/* Number of allocations */
+	u_int64_t	 reused;	/* Number of allocations from the free list */
+};
+static struct slab slabs[] = {
+	[LLDPD_SLAB_CHASSIS] = { "chassis", sizeof(struct lldpd_chassis), 256 },
+	[LLDPD_SLAB_PORT]    = { "port",    sizeof(struct lldpd_port),    256 },
+#ifdef ENABLE_DOT1
+	[LLDPD_SLAB_VLAN]    = { "vlan",    sizeof(struct lldpd_vlan),   1024 },
+	[LLDPD_SLAB_PPVID]   = { "ppvid",   sizeof(struct lldpd_ppvid),   256 },
+	[LLDPD_SLAB_PI]      = { "pi",      sizeof(struct lldpd_pi),      256 },
+#endif
+	[LLDPD_SLAB_MGMT]    = { "mgmt",    sizeof(struct lldpd_mgmt),    512 },
+#ifdef ENABLE_CUSTOM
+	[LLDPD_SLAB_CUSTOM]  = { "custom",  sizeof(struct lldpd_custom),  256 },
+#endif
+	/* Frames are rounded up to a power of two, larger ones are not cached.
+	 * They should always be allocated with lldpd_frame_alloc(). */
+	[LLDPD_SLAB_LAST] = { "frame-128",  128,  256 },
+	{ "frame-256",  256,  256 },
+	{ "frame-512",  512,  256 },
+	{ "frame-1024", 1024, 256 },
+	{ "frame-2048", 2048, 256 },
+};
+#define SLAB_FRAME_FIRST LLDPD_SLAB_LAST
+#define SLAB_COUNT (sizeof(slabs)/sizeof(slabs[0]))
+
+static int
+slab_debug(void)
+{
+#if defined(HAVE_ADDRESS_SANITIZER) || defined(__SANITIZE_ADDRESS__)
+	return 1;
+#else
+	static int debug = -1;
+	if (debug == -1) debug = !!RUNNING_ON_VALGRIND;
+	return debug;
+#endif
+}
+
+static void *
+slab_get(struct slab *slab)
+{
+	void *obj;
+	if (detached) return malloc(slab->size);
+	slab->allocs++;
+	if ((obj = slab->free) != NULL) {
+		slab->free = *(void **)obj;
+		slab->cached--;
+		slab->reused++;
+	} else if ((obj = malloc(slab->size)) == NULL)
+		return NULL;
+	slab->used++;
+	return obj;
+}
+
+static void
+slab_put(struct slab *slab, void *obj)
+{
+	if (obj == NULL) return;
+	if (detached) {
+		free(obj);
+		return;
+	}
+	slab->used--;
+	if (slab->cached >= slab->max || slab_debug()) {
+		free(obj);
+		return;
+	}
+	*(void **)obj = slab->free;
+	slab->free = obj;
+	slab->cached++;
+}
+
+/**
+ * Allocate a zeroed object of the given type.
+ *
+ * @return The object or NULL if we run out of memory.
+ */
+void *
+lldpd_slab_alloc(enum lldpd_slab_type type)
+{
+	struct slab *slab = &slabs[type];
+	void *obj;
+	if ((obj = slab_get(slab)) != NULL)
+		memset(obj, 0, slab->size);
+	return obj;
+}
+
+void
+lldpd_slab_free(enum lldpd_slab_type type, void *obj)
+{
+	slab_put(&slabs[type], obj);
+}
+
+/* Account an object of the given type allocated by other means than
+ * lldpd_slab_alloc(). It can then be released with lldpd_slab_free(). */
+void
+lldpd_slab_adopt(enum lldpd_slab_type type, void *obj)
+{
+	if (obj == NULL || detached) return;
+	slabs[type].used++;
+}
+
+/* Free list for a frame of the given size, or NULL if it is too large. */
+static struct slab *
+slab_frame(size_t size)
+{
+	size_t i;
+	size += sizeof(struct lldpd_frame);
+	for (i = SLAB_FRAME_FIRST; i < SLAB_COUNT; i++)
+		if (size <= slabs[i].size) return &slabs[i];
+	return NULL;
+}
+
+/**
+ * Allocate a frame able to hold `size` bytes. Its size is already set.
+ * Such a frame should be released with lldpd_frame_free().
+ */
+struct lldpd_frame *
+lldpd_frame_alloc(size_t size)
+{
+	struct slab *slab = slab_frame(size);
+	struct lldpd_frame *frame;
+	if (slab)
+		frame = slab_get(slab);
+	else
+		frame = malloc(size + sizeof(struct lldpd_frame));
+	if (frame) frame->size = size;
+	return frame;
+}
+
+void
+lldpd_frame_free(struct lldpd_frame *frame)
+{
+	struct slab *slab;
+	if (frame == NULL) return;
+	if ((slab = slab_frame(frame->size)) != NULL)
+		slab_put(slab, frame);
+	else
+		free(frame);
+}
+
+/**
+ * Account the objects of a chassis and the objects owned by a port built by
+ * other means than lldpd_slab_alloc(). The port itself is not accounted as it
+ * may be embedded in another structure: use lldpd_slab_adopt() for it.
+ */
+void
+lldpd_slab_adopt_neighbor(struct lldpd_chassis *chassis, struct lldpd_port *port)
+{
+	struct lldpd_mgmt *mgmt;
+#ifdef ENABLE_DOT1
+	struct lldpd_vlan *vlan;
+	struct lldpd_ppvid *ppvid;
+	struct lldpd_pi *pi;
+#endif
+#ifdef ENABLE_CUSTOM
+	struct lldpd_custom *custom;
+#endif
+	struct slab *slab;
+
+	if (chassis) {
+		lldpd_slab_adopt(LLDPD_SLAB_CHASSIS, chassis);
+		TAILQ_FOREACH(mgmt, &chassis->c_mgmt, m_entries)
+			lldpd_slab_adopt(LLDPD_SLAB_MGMT, mgmt);
+	}
+	if (port) {
+#ifdef ENABLE_DOT1
+		TAILQ_FOREACH(vlan, &port->p_vlans, v_entries)
+			lldpd_slab_adopt(LLDPD_SLAB_VLAN, vlan);
+		TAILQ_FOREACH(ppvid, &port->p_ppvids, p_entries)
+			lldpd_slab_adopt(LLDPD_SLAB_PPVID, ppvid);
+		TAILQ_FOREACH(pi, &port->p_pids, p_entries)
+			lldpd_slab_adopt(LLDPD_SLAB_PI, pi);
+#endif
+#ifdef ENABLE_CUSTOM
+		TAILQ_FOREACH(custom, &port->p_custom_list, next)
+			lldpd_slab_adopt(LLDPD_SLAB_CUSTOM, custom);
+#endif
+		if (port->p_lastframe &&
+		    (slab = slab_frame(port->p_lastframe->size)) != NULL)
+			slab->used++;
+	}
+}
+
+/* Log the occupancy of each free list. */
+void
+lldpd_slab_dump(void)
+{
+	size_t i;
+	struct slab *slab;
+	for (i = 0; i < SLAB_COUNT; i++) {
+		slab = &slabs[i];
+		if (slab->name == NULL) continue;
+		log_info("alloc", "%s: %zu in use, %zu/%zu cached, "
+		    "%llu allocations, %llu reused",
+		    slab->name, slab->used, slab->cached, slab->max,
+		    (unsigned long long)slab->allocs,
+		    (unsigned long long)slab->reused);
+	}
+}
+
+/* Release all cached objects. */
+void
+lldpd_slab_cleanup(void)
+{
+	size_t i;
+	void *obj;
+	for (i = 0; i < SLAB_COUNT; i++) {
+		while ((obj = slabs[i].free) != NULL) {
+			slabs[i].free = *(void **)obj;
+			free(obj);
+		}
+		slabs[i].cached = 0;
+	}
+}
+
 void
 lldpd_chassis_mgmt_cleanup(struct lldpd_chassis *chassis)
 {
@@ -33,7 +462,7 @@ lldpd_chassis_mgmt_cleanup(struct lldpd_chassis *chassis)
 	     mgmt != NULL;
 	     mgmt = mgmt_next) {
 		mgmt_next = TAILQ_NEXT(mgmt, m_entries);
-		free(mgmt);
+		lldpd_slab_free(LLDPD_SLAB_MGMT, mgmt);
 	}
 	TAILQ_INIT(&chassis->c_mgmt);
 }
@@ -45,19 +474,19 @@ lldpd_chassis_cleanup(struct lldpd_chassis *chassis, int all)
 	log_debug("alloc", "cleanup chassis %s",
 	    chassis->c_name ? chassis->c_name : "(unknown)");
 #ifdef ENABLE_LLDPMED
-	free(chassis->c_med_hw);
-	free(chassis->c_med_sw);
-	free(chassis->c_med_fw);
-	free(chassis->c_med_sn);
-	free(chassis->c_med_manuf);
-	free(chassis->c_med_model);
-	free(chassis->c_med_asset);
+	lldpd_intern_release(chassis->c_med_hw);
+	lldpd_intern_release(chassis->c_med_sw);
+	lldpd_intern_release(chassis->c_med_fw);
+	lldpd_intern_release(chassis->c_med_sn);
+	lldpd_intern_release(chassis->c_med_manuf);
+	lldpd_intern_release(chassis->c_med_model);
+	lldpd_intern_release(chassis->c_med_asset);
 #endif
 	free(chassis->c_id);
-	free(chassis->c_name);
-	free(chassis->c_descr);
+	lldpd_intern_release(chassis->c_name);
+	lldpd_intern_release(chassis->c_descr);
 	if (all)
-		free(chassis);
+		lldpd_slab_free(LLDPD_SLAB_CHASSIS, chassis);
 }
 
 #ifdef ENABLE_DOT1
@@ -68,9 +497,9 @@ lldpd_vlan_cleanup(struct lldpd_port *port)
 	for (vlan = TAILQ_FIRST(&port->p_vlans);
 	    vlan != NULL;
 	    vlan = vlan_next) {
-		free(vlan->v_name);
+		lldpd_intern_release(vlan->v_name);
 		vlan_next = TAILQ_NEXT(vlan, v_entries);
-		free(vlan);
+		lldpd_slab_free(LLDPD_SLAB_VLAN, vlan);
 	}
 	TAILQ_INIT(&port->p_vlans);
 }
@@ -83,7 +512,7 @@ lldpd_ppvid_cleanup(struct lldpd_port *port)
 	    ppvid != NULL;
 	    ppvid = ppvid_next) {
 		ppvid_next = TAILQ_NEXT(ppvid, p_entries);
-		free(ppvid);
+		lldpd_slab_free(LLDPD_SLAB_PPVID, ppvid);
 	}
 	TAILQ_INIT(&port->p_ppvids);
 }
@@ -97,7 +526,7 @@ lldpd_pi_cleanup(struct lldpd_port *port)
 	    pi = pi_next) {
 		free(pi->p_pi);
 		pi_next = TAILQ_NEXT(pi, p_entries);
-		free(pi);
+		lldpd_slab_free(LLDPD_SLAB_PI, pi);
 	}
 	TAILQ_INIT(&port->p_pids);
 }
@@ -109,13 +538,13 @@ lldpd_custom_tlv_add(struct lldpd_port *port, struct lldpd_custom *curr)
 {
 	struct lldpd_custom *custom;
 
-	if ((custom = malloc(sizeof(struct lldpd_custom)))) {
+	if ((custom = lldpd_slab_alloc(LLDPD_SLAB_CUSTOM))) {
 		memcpy(custom, curr, sizeof(struct lldpd_custom));
 		if ((custom->oui_info = malloc(custom->oui_info_len))) {
 			memcpy(custom->oui_info, curr->oui_info, custom->oui_info_len);
 			TAILQ_INSERT_TAIL(&port->p_custom_list, custom, next);
 		} else {
-			free(custom);
+			lldpd_slab_free(LLDPD_SLAB_CUSTOM, custom);
 			log_warn("rpc", "could not allocate memory for custom TLV info");
 		}
 	}
@@ -133,7 +562,7 @@ lldpd_custom_tlv_cleanup(struct lldpd_port *port, struct lldpd_custom *curr)
 		    curr->subtype == custom->subtype) {
 			TAILQ_REMOVE(&port->p_custom_list, custom, next);
 			free(custom->oui_info);
-			free(custom);
+			lldpd_slab_free(LLDPD_SLAB_CUSTOM, custom);
 		}
 	}
 }
@@ -147,7 +576,7 @@ lldpd_custom_list_cleanup(struct lldpd_port *port)
 	    custom = custom_next) {
 		custom_next = TAILQ_NEXT(custom, next);
 		free(custom->oui_info);
-		free(custom);
+		lldpd_slab_free(LLDPD_SLAB_CUSTOM, custom);
 	}
 	TAILQ_INIT(&port->p_custom_list);
 }
@@ -190,25 +619,30 @@ lldpd_remote_cleanup(struct lldpd_hardware *hardware,
 			/* Register last removal to be able to report lldpStatsRemTablesLastChangeTime */
 			hardware->h_lport.p_lastremove = time(NULL);
 			lldpd_port_cleanup(port, 1);
-			free(port);
+			lldpd_slab_free(LLDPD_SLAB_PORT, port);
 		}
 	}
 	if (all) TAILQ_INIT(&hardware->h_rports);
 }
 
 /* If `all' is true, clear all information, including information that
-   are not refreshed periodically. Port should be freed manually. */
+   are not refreshed periodically. Port should be freed manually. VLANs of a
+   local port are refreshed by interfaces_helper_vlan() and only cleared if
+   `all' is true. */
 void
 lldpd_port_cleanup(struct lldpd_port *port, int all)
 {
 #ifdef ENABLE_LLDPMED
 	int i;
-	if (all)
+	if (all && port->p_med) {
 		for (i=0; i < LLDP_MED_LOCFORMAT_LAST; i++)
-			free(port->p_med_location[i].data);
+			free(port->p_med->location[i].data);
+		free(port->p_med);
+		port->p_med = NULL;
+	}
 #endif
 #ifdef ENABLE_DOT1
-	lldpd_vlan_cleanup(port);
+	if (all) lldpd_vlan_cleanup(port);
 	lldpd_ppvid_cleanup(port);
 	lldpd_pi_cleanup(port);
 #endif
@@ -217,15 +651,26 @@ lldpd_port_cleanup(struct lldpd_port *port, int all)
 	if (all) {
 		free(port->p_id);
 		port->p_id = NULL;
-		free(port->p_descr);
+		lldpd_intern_release(port->p_descr);
 		port->p_descr = NULL;
-		free(port->p_lastframe);
+		lldpd_frame_free(port->p_lastframe);
+		port->p_lastframe = NULL;
 		if (port->p_chassis) { /* chassis may not have been attributed, yet */
 			port->p_chassis->c_refcount--;
 			port->p_chassis = NULL;
 		}
 #ifdef ENABLE_CUSTOM
 		lldpd_custom_list_cleanup(port);
+#endif
+#ifdef ENABLE_DOT3
+		free(port->p_power);
+		port->p_power = NULL;
+		free(port->p_measurements);
+		port->p_measurements = NULL;
+#endif
+#if defined (ENABLE_CDP) || defined (ENABLE_FDP)
+		free(port->p_cdp_power);
+		port->p_cdp_power = NULL;
 #endif
 	}
 }
@@ -102,6 +102,18 @@ struct lldpd_med_power {
 	u_int16_t		 val;
 };
 MARSHAL(lldpd_med_power);
+
+/* LLDP-MED information received or configured on a port */
+struct lldpd_port_med {
+	struct lldpd_med_policy	 policy[LLDP_MED_APPTYPE_LAST];
+	struct lldpd_med_loc	 location[LLDP_MED_LOCFORMAT_LAST];
+	struct lldpd_med_power	 power;
+};
+MARSHAL_BEGIN(lldpd_port_med)
+MARSHAL_SUBSTRUCT(lldpd_port_med, lldpd_med_loc, location[0])
+MARSHAL_SUBSTRUCT(lldpd_port_med, lldpd_med_loc, location[1])
+MARSHAL_SUBSTRUCT(lldpd_port_med, lldpd_med_loc, location[2])
+MARSHAL_END(lldpd_port_med);
 #endif
 
 #ifdef ENABLE_DOT3
@@ -213,6 +225,7 @@ struct cdpv2_power {
 	u_int16_t request_id;
 	u_int16_t management_id;
 };
+MARSHAL(cdpv2_power);
 #endif
 
 enum {
@@ -338,23 +351,24 @@ struct lldpd_port {
 	u_int16_t		 p_mfs;
 	u_int16_t		 p_ttl; /* TTL for remote port */
 
+	/* Rarely present information is kept out of line. Those blocks are
+	 * NULL until the matching TLV is received or configured. Use
+	 * LLDPD_PORT_EXT() to allocate them. */
 #ifdef ENABLE_DOT3
 	/* Dot3 stuff */
 	u_int32_t			p_aggregid;
 	struct lldpd_dot3_macphy	p_macphy;
-	struct lldpd_dot3_power		p_power;
-	struct lldpd_dot3_measurements	p_measurements; /*802.3bt specific*/
+	struct lldpd_dot3_power		*p_power;
+	struct lldpd_dot3_measurements	*p_measurements; /*802.3bt specific*/
 #endif
 
 #ifdef ENABLE_LLDPMED
 	u_int16_t		 p_med_cap_enabled;
-	struct lldpd_med_policy	 p_med_policy[LLDP_MED_APPTYPE_LAST];
-	struct lldpd_med_loc	 p_med_location[LLDP_MED_LOCFORMAT_LAST];
-	struct lldpd_med_power	 p_med_power;
+	struct lldpd_port_med	*p_med;
 #endif
 
 #if defined (ENABLE_CDP) || defined (ENABLE_FDP)
-	struct cdpv2_power p_cdp_power;
+	struct cdpv2_power	*p_cdp_power;
 #endif
 
 #ifdef ENABLE_DOT1
@@ -373,10 +387,15 @@ MARSHAL_POINTER(lldpd_port, lldpd_chassis, p_chassis)
 MARSHAL_IGNORE(lldpd_port, p_lastframe)
 MARSHAL_FSTR(lldpd_port, p_id, p_id_len)
 MARSHAL_STR(lldpd_port, p_descr)
+#ifdef ENABLE_DOT3
+MARSHAL_POINTER(lldpd_port, lldpd_dot3_power, p_power)
+MARSHAL_POINTER(lldpd_port, lldpd_dot3_measurements, p_measurements)
+#endif
 #ifdef ENABLE_LLDPMED
-MARSHAL_SUBSTRUCT(lldpd_port, lldpd_med_loc, p_med_location[0])
-MARSHAL_SUBSTRUCT(lldpd_port, lldpd_med_loc, p_med_location[1])
-MARSHAL_SUBSTRUCT(lldpd_port, lldpd_med_loc, p_med_location[2])
+MARSHAL_POINTER(lldpd_port, lldpd_port_med, p_med)
+#endif
+#if defined (ENABLE_CDP) || defined (ENABLE_FDP)
+MARSHAL_POINTER(lldpd_port, cdpv2_power, p_cdp_power)
 #endif
 #ifdef ENABLE_DOT1
 MARSHAL_SUBTQ(lldpd_port, lldpd_vlan, p_vlans)
@@ -388,6 +407,12 @@ MARSHAL_SUBTQ(lldpd_port, lldpd_custom, p_custom_list)
 #endif
 MARSHAL_END(lldpd_port);
 
+/* Return the given extension block of a port, allocating it if needed. NULL
+ * is returned if allocation fails. */
+#define LLDPD_PORT_EXT(port, field)					\
+	((port)->field ? (port)->field :				\
+	    ((port)->field = calloc(1, sizeof(*(port)->field))))
+
 /* Used to modify some port related settings */
 #define LLDPD_RXTX_UNCHANGED 0
 #define LLDPD_RXTX_TXONLY 1
@@ -487,6 +512,23 @@ struct lldpd_config {
 					  slaves */
 	int c_lldp_portid_type; /* The PortID type */
 	int c_lldp_agent_type;	/* The agent type */
+	int c_notification_interval; /* Minimum interval between SNMP notifications */
+#define LLDPD_NOTIFICATION_INTERVAL_MIN 5
+#define LLDPD_NOTIFICATION_INTERVAL_MAX 3600
+	int c_snapshot;		/* Publish ports and neighbors in a snapshot file */
+	int c_warm_restart;	/* Keep neighbors across restarts */
+	int c_metrics;		/* Export metrics */
+	int c_metrics_port;	/* TCP port on loopback for metrics, 0 for a Unix socket */
+	int c_decode_workers;	/* Threads decoding received frames, 0 to disable */
+#define LLDPD_DECODE_MAX_WORKERS 64
+
+	/* Startup timeline: milliseconds elapsed since start when each phase
+	 * completed, 0 if not yet completed. */
+	int c_startup_privsep;	  /* Privilege separation ready */
+	int c_startup_interfaces; /* Interfaces initialized */
+	int c_startup_configured; /* Configuration applied */
+	int c_startup_first_pdu;  /* First PDU sent */
+	int c_startup_metadata;	  /* Slow chassis metadata collected */
 };
 MARSHAL_BEGIN(lldpd_config)
 MARSHAL_STR(lldpd_config, c_mgmt_pattern)
@@ -516,6 +558,9 @@ struct lldpd_ops {
 	int(*cleanup)(struct lldpd *, struct lldpd_hardware *); /* Cleanup function. */
 };
 
+/* Maximum length of the name of a network namespace, see lldpd(8) -N */
+#define LLDPD_NETNS_NAMESIZ 64
+
 /* An interface is uniquely identified by h_ifindex, h_ifname and h_ops. This
  * means if an interface becomes enslaved, it will be considered as a new
  * interface. The same applies for renaming and we include the index in case of
@@ -538,6 +583,8 @@ struct lldpd_hardware {
 					     to 0. */
 	int			 h_ifindex; /* Interface index, used by SNMP */
 	char			 h_ifname[IFNAMSIZ]; /* Should be unique */
+	char			 h_netns[LLDPD_NETNS_NAMESIZ]; /* Network namespace, empty
+								  for the one of lldpd */
 	u_int8_t		 h_lladdr[ETHER_ADDR_LEN];
 
 	u_int64_t		 h_tx_cnt;
@@ -565,6 +612,12 @@ struct lldpd_hardware {
 	u_int8_t		 h_lport_previous_id_subtype;
 	char			*h_lport_previous_id;
 	int			 h_lport_previous_id_len;
+#ifdef ENABLE_DOT1
+	/* Local VLANs, see interfaces_helper_vlan(). Not marshalled either. */
+	struct lldpd_vlan_map	*h_lvlans;
+	struct lldpd_vlan_map	*h_lvlans_next;
+	int			 h_lvlans_changed;
+#endif
 
 	struct lldpd_port	 h_lport;  /* Port attached to this hardware port */
 	TAILQ_HEAD(, lldpd_port) h_rports; /* Remote ports */
@@ -587,6 +640,11 @@ MARSHAL_IGNORE(lldpd_hardware, h_lchassis_previous_id_len)
 MARSHAL_IGNORE(lldpd_hardware, h_lport_previous_id_subtype)
 MARSHAL_IGNORE(lldpd_hardware, h_lport_previous_id)
 MARSHAL_IGNORE(lldpd_hardware, h_lport_previous_id_len)
+#ifdef ENABLE_DOT1
+MARSHAL_IGNORE(lldpd_hardware, h_lvlans)
+MARSHAL_IGNORE(lldpd_hardware, h_lvlans_next)
+MARSHAL_IGNORE(lldpd_hardware, h_lvlans_changed)
+#endif
 MARSHAL_SUBSTRUCT(lldpd_hardware, lldpd_port, h_lport)
 MARSHAL_SUBTQ(lldpd_hardware, lldpd_port, h_rports)
 MARSHAL_END(lldpd_hardware);
@@ -602,11 +660,69 @@ MARSHAL_END(lldpd_interface);
 TAILQ_HEAD(lldpd_interface_list, lldpd_interface);
 MARSHAL_TQ(lldpd_interface_list, lldpd_interface);
 
+/* State kept across restarts. For each local port, we keep the last frame
+ * received from each neighbor, in the same order as `h_rports`. */
+struct lldpd_state_frame {
+	TAILQ_ENTRY(lldpd_state_frame) s_entries;
+	int			 s_len;
+	char			*s_frame; /* NULL if unknown */
+};
+MARSHAL_BEGIN(lldpd_state_frame)
+MARSHAL_TQE(lldpd_state_frame, s_entries)
+MARSHAL_FSTR(lldpd_state_frame, s_frame, s_len)
+MARSHAL_END(lldpd_state_frame);
+struct lldpd_state_hardware {
+	TAILQ_ENTRY(lldpd_state_hardware) s_entries;
+	struct lldpd_hardware	*s_hardware;
+	TAILQ_HEAD(, lldpd_state_frame) s_frames;
+};
+MARSHAL_BEGIN(lldpd_state_hardware)
+MARSHAL_TQE(lldpd_state_hardware, s_entries)
+MARSHAL_POINTER(lldpd_state_hardware, lldpd_hardware, s_hardware)
+MARSHAL_SUBTQ(lldpd_state_hardware, lldpd_state_frame, s_frames)
+MARSHAL_END(lldpd_state_hardware);
+TAILQ_HEAD(lldpd_state, lldpd_state_hardware);
+MARSHAL_TQ(lldpd_state, lldpd_state_hardware);
+
+/* Latency histogram for one processing stage. Bucket i counts samples lower
+ * than 2^(10+i) ns (about 1 µs, 2 µs, 4 µs, ...). The last bucket counts
+ * everything else. */
+#define LLDPD_LATENCY_BUCKETS 24
+struct lldpd_latency {
+	TAILQ_ENTRY(lldpd_latency) l_entries;
+	char			*l_name;
+	u_int64_t		 l_count; /* Number of samples */
+	u_int64_t		 l_sum;	  /* Sum of all samples, in ns */
+	u_int64_t		 l_max;	  /* Largest sample, in ns */
+	u_int64_t		 l_buckets[LLDPD_LATENCY_BUCKETS];
+};
+MARSHAL_BEGIN(lldpd_latency)
+MARSHAL_TQE(lldpd_latency, l_entries)
+MARSHAL_STR(lldpd_latency, l_name)
+MARSHAL_END(lldpd_latency);
+TAILQ_HEAD(lldpd_latency_list, lldpd_latency);
+MARSHAL_TQ(lldpd_latency_list, lldpd_latency);
+
+/* A batch of local ports. The client asks for the ports starting at index
+ * `b_start` and gets as many of them as fit in `b_records`, using the layout of
+ * the snapshot file (see ctl.h). `b_next` is the index to ask for the next
+ * batch or 0 if there is none. */
+struct lldpd_ports_batch {
+	int			 b_start;
+	int			 b_next;
+	int			 b_len;
+	char			*b_records;
+};
+MARSHAL_BEGIN(lldpd_ports_batch)
+MARSHAL_FSTR(lldpd_ports_batch, b_records, b_len)
+MARSHAL_END(lldpd_ports_batch);
+
 struct lldpd_neighbor_change {
 	char *ifname;
 #define NEIGHBOR_CHANGE_DELETED -1
 #define NEIGHBOR_CHANGE_ADDED    1
 #define NEIGHBOR_CHANGE_UPDATED  0
+#define NEIGHBOR_CHANGE_RESYNC   2	/* Notifications lost, no neighbor */
 	int state;
 	struct lldpd_port *neighbor;
 };
@@ -615,6 +731,35 @@ MARSHAL_STR(lldpd_neighbor_change, ifname)
 MARSHAL_POINTER(lldpd_neighbor_change, lldpd_port, neighbor)
 MARSHAL_END(lldpd_neighbor_change);
 
+/* Interned strings */
+char	*lldpd_intern(const char *);
+char	*lldpd_intern_len(const char *, size_t);
+void	 lldpd_intern_release(char *);
+void	 lldpd_intern_neighbor(struct lldpd_chassis *, struct lldpd_port *);
+
+/* Free-list allocators for neighbor objects */
+enum lldpd_slab_type {
+	LLDPD_SLAB_CHASSIS,
+	LLDPD_SLAB_PORT,
+	LLDPD_SLAB_VLAN,
+	LLDPD_SLAB_PPVID,
+	LLDPD_SLAB_PI,
+	LLDPD_SLAB_MGMT,
+	LLDPD_SLAB_CUSTOM,
+	LLDPD_SLAB_LAST
+};
+void	*lldpd_slab_alloc(enum lldpd_slab_type);
+void	 lldpd_slab_free(enum lldpd_slab_type, void *);
+void	 lldpd_slab_adopt(enum lldpd_slab_type, void *);
+void	 lldpd_slab_adopt_neighbor(struct lldpd_chassis *, struct lldpd_port *);
+struct lldpd_frame *lldpd_frame_alloc(size_t);
+void	 lldpd_frame_free(struct lldpd_frame *);
+void	 lldpd_slab_dump(void);
+void	 lldpd_slab_cleanup(void);
+#ifdef HAVE_PTHREAD
+void	 lldpd_alloc_detach(void);
+#endif
+
 /* Cleanup functions */
 void	 lldpd_chassis_mgmt_cleanup(struct lldpd_chassis *);
 void	 lldpd_chassis_cleanup(struct lldpd_chassis *, int);
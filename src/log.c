@@ -17,6 +17,10 @@
  * OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  */
 
+#if HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
 #include <unistd.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -26,15 +30,51 @@
 #include <string.h>
 #include <errno.h>
 #include <time.h>
+#ifdef HAVE_PTHREAD
+# include <pthread.h>
+#endif
 
 /* By default, logging is done on stderr. */
 static int	 use_syslog = 0;
 /* Default debug level */
 static int	 debug = 0;
+/* Non-zero when debug messages may be used by someone */
+int		 log_debug_enabled = 0;
 
 /* Logging can be modified by providing an appropriate log handler. */
 static void (*logh)(int severity, const char *msg) = NULL;
 
+/* Debug messages can also be kept in memory to be dumped on request. Each
+ * record has a fixed size. The message is truncated if needed. */
+#define LOG_RING_MSG_SIZE 200
+struct log_ring_record {
+	time_t		 time;
+	const char	*token;
+	char		 msg[LOG_RING_MSG_SIZE];
+};
+static struct log_ring_record *ring = NULL;
+static size_t	 ring_size = 0;
+static size_t	 ring_next = 0;
+static int	 ring_full = 0;
+
+/* Frames may be decoded by other threads which may log too. Lock order is
+ * ring_lock, then output_lock. */
+#ifdef HAVE_PTHREAD
+static pthread_mutex_t ring_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t output_lock = PTHREAD_MUTEX_INITIALIZER;
+# define LOG_LOCK(l) pthread_mutex_lock(&l)
+# define LOG_UNLOCK(l) pthread_mutex_unlock(&l)
+#else
+# define LOG_LOCK(l)
+# define LOG_UNLOCK(l)
+#endif
+
+static void
+log_debug_update(void)
+{
+	log_debug_enabled = (debug > 1) || (ring != NULL);
+}
+
 static void	 vlog(int, const char *, const char *, va_list);
 static void	 logit(int, const char *, const char *, ...);
 
@@ -51,6 +91,7 @@ log_init(int n_syslog, int n_debug, const char *progname)
 		openlog(progname, LOG_PID | LOG_NDELAY, LOG_DAEMON);
 
 	tzset();
+	log_debug_update();
 }
 
 void
@@ -58,12 +99,53 @@ log_level(int n_debug)
 {
 	if (n_debug >= 0)
 		debug = n_debug;
+	log_debug_update();
 }
 
 void
 log_register(void (*cb)(int, const char*))
 {
 	logh = cb;
+	log_debug_update();
+}
+
+/* Keep the last `size` debug messages in memory. Use 0 to disable. */
+void
+log_ring_init(size_t size)
+{
+	LOG_LOCK(ring_lock);
+	free(ring);
+	ring = NULL;
+	ring_size = ring_next = 0;
+	ring_full = 0;
+	if (size > 0) {
+		if ((ring = calloc(size, sizeof(struct log_ring_record))) == NULL)
+			logit(LOG_WARNING, "log", "unable to allocate debug ring buffer");
+		else
+			ring_size = size;
+	}
+	LOG_UNLOCK(ring_lock);
+	log_debug_update();
+}
+
+static void
+log_ring_add(const char *token, const char *fmt, va_list ap)
+{
+	struct log_ring_record *record;
+	LOG_LOCK(ring_lock);
+	if (ring == NULL) {
+		LOG_UNLOCK(ring_lock);
+		return;
+	}
+	record = &ring[ring_next];
+	record->time = time(NULL);
+	record->token = token;
+	vsnprintf(record->msg, sizeof(record->msg), fmt, ap);
+	if (++ring_next == ring_size) {
+		ring_next = 0;
+		ring_full = 1;
+	}
+	LOG_UNLOCK(ring_lock);
 }
 
 void
@@ -94,9 +176,15 @@ date()
 {
 	/* Return the current date as incomplete ISO 8601 (2012-12-12T16:13:30) */
 	static char date[] = "2012-12-12T16:13:30";
+	static time_t last = (time_t)-1;
 	time_t t = time(NULL);
-	struct tm *tmp = localtime(&t);
-	strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", tmp);
+	if (t != last) {
+		/* Only convert the date once per second */
+		struct tm tm;
+		strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S",
+		    localtime_r(&t, &tm));
+		last = t;
+	}
 	return date;
 }
 
@@ -133,11 +221,56 @@ translate(int fd, int priority)
 	return "[UNKN]";
 }
 
+/* Write a line to standard error. The monitor and the unprivileged
+ * process share it, so the line is written with a single call to not be
+ * interleaved with a line from the other process. */
 static void
-vlog(int pri, const char *token, const char *fmt, va_list ap)
+log_stderr(int pri, const char *token, const char *fmt, va_list ap)
+{
+	/* Most messages are short, avoid an allocation for them. */
+	char buf[512];
+	char *line = buf;
+	int len, n;
+	va_list ap2;
+
+	len = snprintf(buf, sizeof(buf), "%s %s%s%s]%s ",
+	    date(),
+	    translate(STDERR_FILENO, pri),
+	    token ? "/" : "", token ? token : "",
+	    isatty(STDERR_FILENO) ? "\033[0m" : "");
+	if (len < 0 || (size_t)len >= sizeof(buf)) return;
+	va_copy(ap2, ap);
+	n = vsnprintf(buf + len, sizeof(buf) - len, fmt, ap2);
+	va_end(ap2);
+	if (n < 0) return;
+	if ((size_t)(len + n + 1) > sizeof(buf)) {
+		if ((line = malloc(len + n + 1)) == NULL) return;
+		memcpy(line, buf, len);
+		vsnprintf(line + len, n + 1, fmt, ap);
+	}
+	line[len + n] = '\n';
+	if (write(STDERR_FILENO, line, len + n + 1) == -1) {
+		/* Nowhere to report this. */
+	}
+	if (line != buf) free(line);
+}
+
+static void
+vlog_locked(int pri, const char *token, const char *fmt, va_list ap)
 {
 	if (logh) {
+		/* Most messages are short, avoid an allocation for them. */
+		char buf[256];
 		char *result;
+		int n;
+		va_list ap2;
+		va_copy(ap2, ap);
+		n = vsnprintf(buf, sizeof(buf), fmt, ap2);
+		va_end(ap2);
+		if (n >= 0 && (size_t)n < sizeof(buf)) {
+			logh(pri, buf);
+			return;
+		}
 		if (vasprintf(&result, fmt, ap) != -1) {
 			logh(pri, result);
 			free(result);
@@ -158,21 +291,15 @@ vlog(int pri, const char *token, const char *fmt, va_list ap)
 	}
 
 	/* Log to standard error in all cases */
-	char *nfmt;
-	/* best effort in out of mem situations */
-	if (asprintf(&nfmt, "%s %s%s%s]%s %s\n",
-		date(),
-		translate(STDERR_FILENO, pri),
-		token ? "/" : "", token ? token : "",
-		isatty(STDERR_FILENO) ? "\033[0m" : "",
-		fmt) == -1) {
-		vfprintf(stderr, fmt, ap);
-		fprintf(stderr, "\n");
-	} else {
-		vfprintf(stderr, nfmt, ap);
-		free(nfmt);
-	}
-	fflush(stderr);
+	log_stderr(pri, token, fmt, ap);
+}
+
+static void
+vlog(int pri, const char *token, const char *fmt, va_list ap)
+{
+	LOG_LOCK(output_lock);
+	vlog_locked(pri, token, fmt, ap);
+	LOG_UNLOCK(output_lock);
 }
 
 
@@ -236,18 +363,49 @@ log_debug_accept_token(const char *token)
 	return 0;
 }
 
+/* Use log_debug() instead. It checks if debug is enabled before calling this
+ * function. */
 void
-log_debug(const char *token, const char *emsg, ...)
+log_debug_(const char *token, const char *emsg, ...)
 {
 	va_list	 ap;
 
-	if ((debug > 1 && log_debug_accept_token(token)) || logh) {
+	if (ring && log_debug_accept_token(token)) {
+		va_start(ap, emsg);
+		log_ring_add(token, emsg, ap);
+		va_end(ap);
+	}
+	if (debug > 1 && log_debug_accept_token(token)) {
 		va_start(ap, emsg);
 		vlog(LOG_DEBUG, token, emsg, ap);
 		va_end(ap);
 	}
 }
 
+/* Log the content of the debug ring buffer, oldest messages first. */
+void
+log_ring_dump(void)
+{
+	size_t i, n, first;
+	struct log_ring_record *record;
+	struct tm tm;
+	char date[] = "2012-12-12T16:13:30";
+
+	if (!ring) return;
+	LOG_LOCK(ring_lock);
+	n = ring_full ? ring_size : ring_next;
+	first = ring_full ? ring_next : 0;
+	logit(LOG_INFO, "log", "dumping %zu debug messages", n);
+	for (i = 0; i < n; i++) {
+		record = &ring[(first + i) % ring_size];
+		strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S",
+		    localtime_r(&record->time, &tm));
+		logit(LOG_INFO, record->token, "[%s] %s", date, record->msg);
+	}
+	logit(LOG_INFO, "log", "end of debug messages");
+	LOG_UNLOCK(ring_lock);
+}
+
 void
 fatal(const char *token, const char *emsg)
 {
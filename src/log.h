@@ -25,13 +25,24 @@ void             log_init(int, int, const char *);
 void             log_warn(const char *, const char *, ...) __attribute__ ((format (printf, 2, 3)));
 void             log_warnx(const char *, const char *, ...) __attribute__ ((format (printf, 2, 3)));
 void             log_info(const char *, const char *, ...) __attribute__ ((format (printf, 2, 3)));
-void             log_debug(const char *, const char *, ...) __attribute__ ((format (printf, 2, 3)));
+void             log_debug_(const char *, const char *, ...) __attribute__ ((format (printf, 2, 3)));
 void             fatal(const char*, const char *) __attribute__((__noreturn__));
 void             fatalx(const char *, const char *) __attribute__((__noreturn__));
 
 void		 log_register(void (*cb)(int, const char*));
 void             log_accept(const char *);
 void		 log_level(int);
+void		 log_ring_init(size_t);
+void		 log_ring_dump(void);
+
+/* Debug messages are frequent on hot paths. Only call the logging function
+ * (and evaluate its arguments) when debug messages may be used. */
+extern int	 log_debug_enabled;
+#define log_debug(token, ...)						\
+	do {								\
+		if (__builtin_expect(log_debug_enabled, 0))		\
+			log_debug_(token, __VA_ARGS__);			\
+	} while (0)
 
 /* version.c */
 void		 version_display(FILE *, const char *, int);
@@ -36,9 +36,10 @@
 # define ALIGNOF(t) ((sizeof(t) > 1)?((char *)(&((struct { char c; t _h; } *)0)->_h) - (char *)0):1)
 #endif
 
-/* A serialized object */
+/* A serialized object. Pointers to other objects are replaced by the offset
+ * of the object content from the start of the serialized buffer. */
 struct marshal_serialized {
-	void         *orig;	/* Original reference. Also enforce alignment. */
+	void         *orig;	/* Offset of the object. Also enforce alignment. */
 	size_t        size;
 	unsigned char object[0];
 };
@@ -63,9 +64,14 @@ struct marshal_info marshal_info_ignore = {
 struct ref {
 	TAILQ_ENTRY(ref) next;
 	void *pointer;
-	uintptr_t dummy;	/* To renumerate pointers */
+	uintptr_t dummy;	/* Offset of the serialized object */
+};
+struct ref_l {
+	TAILQ_HEAD(, ref) refs;
+	/* Where the next object will be serialized */
+	size_t offset;		/* Offset in the final buffer */
+	unsigned char *copy;	/* Copy of a substructure in its parent */
 };
-TAILQ_HEAD(ref_l, ref);
 
 /* Serialize the given object. */
 ssize_t
@@ -74,11 +80,12 @@ marshal_serialize_(struct marshal_info *mi, void *unserialized, void **input,
 {
 	struct ref_l *refs = _refs;
 	struct ref *cref;
-	int size;
-	size_t len;
+	int size, copylen;
+	size_t len, offset = 0;
 	struct marshal_subinfo *current;
 	struct marshal_serialized *new = NULL, *serialized = NULL;
-	uintptr_t dummy = 1;
+	unsigned char *object = NULL;
+	uintptr_t dummy;
 
 	log_debug("marshal", "start serialization of %s", mi->name);
 
@@ -89,22 +96,27 @@ marshal_serialize_(struct marshal_info *mi, void *unserialized, void **input,
 			log_warnx("marshal", "unable to allocate memory for list of references");
 			return -1;
 		}
-		TAILQ_INIT(refs);
+		TAILQ_INIT(&refs->refs);
+	} else {
+		offset = refs->offset;
+		object = refs->copy;
 	}
-	TAILQ_FOREACH(cref, refs, next) {
+	dummy = offset + sizeof(struct marshal_serialized);
+	TAILQ_FOREACH(cref, &refs->refs, next) {
 		if (unserialized == cref->pointer)
 			return 0;
-		/* dummy should be higher than any existing dummy */
-		if (cref->dummy >= dummy) dummy = cref->dummy + 1;
 	}
 
 	/* Handle special cases. */
-	size = mi->size;
+	size = copylen = mi->size;
 	if (!strcmp(mi->name, "null string"))
 		/* We know we can't be called with NULL */
-		size = strlen((char *)unserialized) + 1;
-	else if (!strcmp(mi->name, "fixed string"))
-		size = osize;
+		size = copylen = strlen((char *)unserialized) + 1;
+	else if (!strcmp(mi->name, "fixed string")) {
+		/* Add a null byte to be able to use the string in place */
+		copylen = osize;
+		size = osize + 1;
+	}
 
 	/* Allocate serialized structure */
 	len = sizeof(struct marshal_serialized) + (skip?0:size);
@@ -115,7 +127,7 @@ marshal_serialize_(struct marshal_info *mi, void *unserialized, void **input,
 		len = -1;
 		goto marshal_error;
 	}
-	/* We don't use the original pointer but a dummy one. */
+	/* We don't use the original pointer but the offset of the object. */
 	serialized->orig = (unsigned char*)dummy;
 
 	/* Append the new reference */
@@ -127,11 +139,14 @@ marshal_serialize_(struct marshal_info *mi, void *unserialized, void **input,
 	}
 	cref->pointer = unserialized;
 	cref->dummy = dummy;
-	TAILQ_INSERT_TAIL(refs, cref, next);
+	TAILQ_INSERT_TAIL(&refs->refs, cref, next);
 
-	/* First, serialize the main structure */
-	if (!skip)
-		memcpy(serialized->object, unserialized, size);
+	/* First, serialize the main structure. When skipped, we still need
+	 * to update its copy inside the parent structure. */
+	if (!skip) {
+		memcpy(serialized->object, unserialized, copylen);
+		object = serialized->object;
+	}
 
 	/* Then, serialize inner structures */
 	for (current = mi->pointers; current->mi; current++) {
@@ -149,7 +164,11 @@ marshal_serialize_(struct marshal_info *mi, void *unserialized, void **input,
 			source = (void *)((unsigned char *)unserialized + current->offset);
 		if (current->offset2)
 			memcpy(&osize, (unsigned char*)unserialized + current->offset2, sizeof(int));
+		padlen = ALIGNOF(struct marshal_serialized);
+		padlen = (padlen - (len % padlen)) % padlen;
 		target = NULL;
+		refs->offset = offset + len + padlen;
+		refs->copy = object?(object + current->offset):NULL;
 		sublen = marshal_serialize_(current->mi,
 		    source, &target,
 		    current->kind == substruct, refs, osize);
@@ -160,11 +179,11 @@ marshal_serialize_(struct marshal_info *mi, void *unserialized, void **input,
 			return -1;
 		}
 		/* We want to put the renumerated pointer instead of the real one. */
-		if (current->kind == pointer && !skip) {
-			TAILQ_FOREACH(cref, refs, next) {
+		if (current->kind == pointer && object) {
+			TAILQ_FOREACH(cref, &refs->refs, next) {
 				if (source == cref->pointer) {
 					void *fakepointer = (unsigned char*)cref->dummy;
-					memcpy((unsigned char *)serialized->object + current->offset,
+					memcpy(object + current->offset,
 					    &fakepointer, sizeof(void *));
 					break;
 				}
@@ -172,8 +191,6 @@ marshal_serialize_(struct marshal_info *mi, void *unserialized, void **input,
 		}
 		if (sublen == 0) continue; /* This was already serialized */
 		/* Append the result, force alignment to be able to unserialize it */
-		padlen = ALIGNOF(struct marshal_serialized);
-		padlen = (padlen - (len % padlen)) % padlen;
 		new = realloc(serialized, len + padlen + sublen);
 		if (!new) {
 			log_warnx("marshal", "unable to allocate more memory to serialize structure %s",
@@ -188,6 +205,7 @@ marshal_serialize_(struct marshal_info *mi, void *unserialized, void **input,
 		free(target);
 		len += sublen + padlen;
 		serialized = (struct marshal_serialized *)new;
+		if (!skip) object = serialized->object;
 	}
 
 	serialized->size = len;
@@ -195,11 +213,11 @@ marshal_serialize_(struct marshal_info *mi, void *unserialized, void **input,
 marshal_error:
 	if (refs && !_refs) {
 		struct ref *cref, *cref_next;
-		for (cref = TAILQ_FIRST(refs);
+		for (cref = TAILQ_FIRST(&refs->refs);
 		     cref != NULL;
 		     cref = cref_next) {
 			cref_next = TAILQ_NEXT(cref, next);
-			TAILQ_REMOVE(refs, cref, next);
+			TAILQ_REMOVE(&refs->refs, cref, next);
 			free(cref);
 		}
 		free(refs);
@@ -207,46 +225,87 @@ marshal_error:
 	return len;
 }
 
-/* This structure is used to track memory allocation when serializing */
+/* This structure is used to track memory allocation when unserializing */
 struct gc {
-	TAILQ_ENTRY(gc) next;
 	void *pointer;
 	void *orig;		/* Original reference (not valid anymore !) */
 };
-TAILQ_HEAD(gc_l, gc);
+struct gc_l {
+	struct gc *gc;		/* Allocated pointers */
+	size_t count;
+	size_t size;
+	unsigned char *inplace;	/* When not NULL, unserialize in this buffer */
+	size_t inplace_len;
+};
 
 static void*
 marshal_alloc(struct gc_l *pointers, size_t len, void *orig)
 {
-	struct gc *gpointer = NULL;
+	struct gc *gpointer;
+	void *result;
 
-	void *result = calloc(1, len);
-	if (!result) return NULL;
-	if ((gpointer = (struct gc *)calloc(1,
-		    sizeof(struct gc))) == NULL) {
-		free(result);
-		return NULL;
+	if (pointers->count == pointers->size) {
+		size_t size = pointers->size?(pointers->size * 2):16;
+		if ((gpointer = realloc(pointers->gc,
+			    size * sizeof(struct gc))) == NULL)
+			return NULL;
+		pointers->gc = gpointer;
+		pointers->size = size;
 	}
+	if ((result = calloc(1, len)) == NULL)
+		return NULL;
+	gpointer = &pointers->gc[pointers->count++];
 	gpointer->pointer = result;
 	gpointer->orig = orig;
-	TAILQ_INSERT_TAIL(pointers, gpointer, next);
 	return result;
 }
-static void
-marshal_free(struct gc_l *pointers, int gconly)
+/* Find an already unserialized object. References are numbered in the order
+ * objects are serialized, which is also the order we allocate them. */
+static struct gc*
+marshal_lookup(struct gc_l *pointers, void *orig)
 {
-	struct gc *pointer, *pointer_next;
-	for (pointer = TAILQ_FIRST(pointers);
-	     pointer != NULL;
-	     pointer = pointer_next) {
-		pointer_next = TAILQ_NEXT(pointer, next);
-		TAILQ_REMOVE(pointers, pointer, next);
-		if (!gconly)
-			free(pointer->pointer);
-		free(pointer);
+	size_t lo = 0, hi = pointers->count, mid;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (pointers->gc[mid].orig == orig)
+			return &pointers->gc[mid];
+		if ((uintptr_t)pointers->gc[mid].orig < (uintptr_t)orig)
+			lo = mid + 1;
+		else
+			hi = mid;
 	}
+	return NULL;
+}
+/* Find an object already unserialized in place. It should appear before the
+ * next object to unserialize, which is guaranteed by the serialization
+ * order. */
+static void*
+marshal_lookup_inplace(struct gc_l *pointers, uintptr_t offset, uintptr_t next,
+    struct marshal_info *mi)
+{
+	struct marshal_serialized *serialized;
+	if (offset < sizeof(struct marshal_serialized) || offset >= next ||
+	    offset % ALIGNOF(struct marshal_serialized) ||
+	    offset + mi->size > pointers->inplace_len)
+		return NULL;
+	serialized = (struct marshal_serialized *)(pointers->inplace + offset -
+	    sizeof(struct marshal_serialized));
+	if ((uintptr_t)serialized->orig != offset)
+		return NULL;
+	return serialized->object;
 }
 
+static void
+marshal_free(struct gc_l *pointers, int gconly)
+{
+	size_t i;
+	if (!gconly)
+		for (i = 0; i < pointers->count; i++)
+			free(pointers->gc[i].pointer);
+	free(pointers->gc);
+	pointers->gc = NULL;
+	pointers->count = pointers->size = 0;
+}
 
 /* Unserialize the given object. */
 size_t
@@ -256,7 +315,7 @@ marshal_unserialize_(struct marshal_info *mi, void *buffer, size_t len, void **o
 	int    total_len = sizeof(struct marshal_serialized) + (skip?0:mi->size);
 	struct marshal_serialized *serialized = buffer;
 	struct gc_l *pointers = _pointers;
-	int size, already, extra = 0;
+	int size;
 	void *new;
 	struct marshal_subinfo *current;
 	struct gc *apointer;
@@ -276,7 +335,6 @@ marshal_unserialize_(struct marshal_info *mi, void *buffer, size_t len, void **o
 			log_warnx("marshal", "unable to allocate memory for garbage collection");
 			return 0;
 		}
-		TAILQ_INIT(pointers);
 	}
 
 	/* Special cases */
@@ -285,10 +343,9 @@ marshal_unserialize_(struct marshal_info *mi, void *buffer, size_t len, void **o
 		switch (mi->name[0]) {
 		case 'n': size = strnlen((char *)serialized->object,
 		    len - sizeof(struct marshal_serialized)) + 1; break;
-		case 'f': size = osize; extra=1; break; /* The extra byte is to ensure that
-							   the string is null terminated. */
+		case 'f': size = osize + 1; break; /* Including the null byte */
 		}
-		if (size > len - sizeof(struct marshal_serialized)) {
+		if (size <= 0 || size > len - sizeof(struct marshal_serialized)) {
 			log_warnx("marshal", "data to deserialize contains a string too long");
 			total_len = 0;
 			goto unmarshal_error;
@@ -297,8 +354,17 @@ marshal_unserialize_(struct marshal_info *mi, void *buffer, size_t len, void **o
 	}
 
 	/* First, the main structure */
-	if (!skip) {
-		if ((*output = marshal_alloc(pointers, size + extra, serialized->orig)) == NULL) {
+	if (!skip && pointers->inplace) {
+		if ((uintptr_t)serialized->orig !=
+		    serialized->object - pointers->inplace) {
+			log_warnx("marshal", "structure %s is not at the expected offset",
+			    mi->name);
+			total_len = 0;
+			goto unmarshal_error;
+		}
+		*output = serialized->object;
+	} else if (!skip) {
+		if ((*output = marshal_alloc(pointers, size, serialized->orig)) == NULL) {
 			log_warnx("marshal", "unable to allocate memory to unserialize structure %s",
 			    mi->name);
 			total_len = 0;
@@ -306,6 +372,8 @@ marshal_unserialize_(struct marshal_info *mi, void *buffer, size_t len, void **o
 		}
 		memcpy(*output, serialized->object, size);
 	}
+	if (!skip && mi->name[0] == 'f' && !strcmp(mi->name, "fixed string"))
+		((char *)*output)[size - 1] = '\0';
 
 	/* Then, each substructure */
 	for (current = mi->pointers; current->mi; current++) {
@@ -317,25 +385,39 @@ marshal_unserialize_(struct marshal_info *mi, void *buffer, size_t len, void **o
 			       0, sizeof(void *));
 			continue;
 		}
+		padlen = ALIGNOF(struct marshal_serialized);
+		padlen = (padlen - (total_len % padlen)) % padlen;
 		if (current->kind == pointer) {
 			if (*(void **)new == NULL) continue;
 
 			/* Did we already see this reference? */
-			already = 0;
-			TAILQ_FOREACH(apointer, pointers, next)
-				if (apointer->orig == *(void **)new) {
+			if (pointers->inplace) {
+				/* Unless this is the next object, this is a
+				 * reference to an object we already handled. */
+				uintptr_t offset = (uintptr_t)*(void **)new;
+				uintptr_t next = (unsigned char *)buffer - pointers->inplace +
+				    total_len + padlen + sizeof(struct marshal_serialized);
+				if (offset != next) {
+					if ((new = marshal_lookup_inplace(pointers,
+						    offset, next, current->mi)) == NULL) {
+						log_warnx("marshal", "invalid reference to %s in %s",
+						    current->mi->name, mi->name);
+						total_len = 0;
+						goto unmarshal_error;
+					}
 					memcpy((unsigned char *)*output + current->offset,
-					    &apointer->pointer, sizeof(void *));
-					already = 1;
-					break;
+					    &new, sizeof(void *));
+					continue;
 				}
-			if (already) continue;
+			} else if ((apointer = marshal_lookup(pointers, *(void **)new)) != NULL) {
+				memcpy((unsigned char *)*output + current->offset,
+				    &apointer->pointer, sizeof(void *));
+				continue;
+			}
 		}
 		/* Deserialize */
 		if (current->offset2)
 			memcpy(&osize, (unsigned char *)*output + current->offset2, sizeof(int));
-		padlen = ALIGNOF(struct marshal_serialized);
-		padlen = (padlen - (total_len % padlen)) % padlen;
 		if (len < total_len + padlen || ((sublen = marshal_unserialize_(current->mi,
 				(unsigned char *)buffer + total_len + padlen,
 				len - total_len - padlen, &new, pointers,
@@ -359,3 +441,31 @@ unmarshal_error:
 	}
 	return total_len;
 }
+
+/**
+ * Unserialize the given object without copying it.
+ *
+ * Pointers are resolved directly inside the provided buffer which should have
+ * been allocated with @c malloc() (to be correctly aligned). The returned
+ * object should be released with @c marshal_release().
+ */
+size_t
+marshal_unserialize_inplace_(struct marshal_info *mi, void *buffer, size_t len,
+    void **output)
+{
+	struct gc_l pointers = {
+		.inplace = buffer,
+		.inplace_len = len
+	};
+	return marshal_unserialize_(mi, buffer, len, output, &pointers, 0, 0);
+}
+
+/**
+ * Release an object unserialized with @c marshal_unserialize_inplace_().
+ */
+void
+marshal_release(void *object)
+{
+	if (object)
+		free((unsigned char *)object - sizeof(struct marshal_serialized));
+}
@@ -137,6 +137,9 @@ size_t  marshal_unserialize_(struct marshal_info *, void *, size_t, void **, voi
 	__attribute__((nonnull (1, 2, 4) ));
 #define marshal_unserialize(type, o, l, input) \
 	marshal_unserialize_(&MARSHAL_INFO(type), o, l, input, NULL, 0, 0)
+size_t  marshal_unserialize_inplace_(struct marshal_info *, void *, size_t, void **)
+	__attribute__((nonnull (1, 2, 4) ));
+void    marshal_release(void *);
 
 #define marshal_repair_tailq(type, head, field)				\
 	do {								\
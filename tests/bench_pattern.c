@@ -0,0 +1,187 @@
+/* -*- mode: c; c-file-style: "openbsd" -*- */
+/*
+ * Copyright (c) 2019 Vincent Bernat <vincent@bernat.im>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* Measure the throughput of interface pattern matching, with and without
+ * compiling the list of patterns first. Interface names are matched against
+ * a list of patterns of each class (exact, prefix and glob). */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include "../src/daemon/lldpd.h"
+#include "bench.h"
+
+#define BENCH_ROUNDS 5		/* Only the fastest round is kept */
+
+static struct {
+	const char *name;
+	const char *patterns;
+} lists[] = {
+	{ "exact",  "eth0,eth1,eth2,eth3,!eth4,!!eth5,swp1,swp2,swp3,swp4" },
+	{ "prefix", "eth*,swp*,!veth*,!docker*,!!vlan100" },
+	{ "glob",   "eth[0-3],swp?,!*.100,!!bond[0-9]*" },
+	{ "mixed",  "eth0,eth1,swp*,!veth*,en?s[0-9]*,!!vlan100,!lo" },
+	{ NULL, NULL }
+};
+
+#ifdef HAVE___PROGNAME
+extern const char	*__progname;
+#else
+# define __progname "bench_pattern"
+#endif
+
+static void
+usage(void)
+{
+	fprintf(stderr, "Usage:   %s [OPTIONS ...]\n", __progname);
+	fprintf(stderr, "Version: %s\n", PACKAGE_STRING);
+
+	fprintf(stderr, "\n");
+
+	fprintf(stderr, "-d         Enable debug messages (repeat for more).\n");
+	fprintf(stderr, "-n COUNT   Number of interfaces (default: 1000).\n");
+	fprintf(stderr, "-i COUNT   Number of iterations for each round (default: 100).\n");
+
+	fprintf(stderr, "\n");
+
+	fprintf(stderr, "Measure the throughput of pattern matching on interface names\n");
+	fprintf(stderr, "with pattern_match() and with a compiled list of patterns.\n");
+	exit(1);
+}
+
+static void
+bench_record(const char *list, const char *operation, u_int64_t elapsed,
+    long allocations, int count, int matches)
+{
+	printf("%-8s %-10s %10.1f %12.0f %8.2f %8d\n",
+	    list, operation,
+	    (double)elapsed / count,
+	    (elapsed > 0)?(double)count * 1000000000 / elapsed:0,
+	    (allocations == -1)?-1:(double)allocations / count,
+	    matches);
+}
+
+int
+main(int argc, char **argv)
+{
+	struct pattern *p;
+	const char *errstr;
+	char **names, *patterns;
+	u_int64_t start, elapsed, best;
+	long allocations;
+	int ch, debug = 1, count = 1000, iterations = 100;
+	int i, j, l, round, matches;
+
+	while ((ch = getopt(argc, argv, "hdn:i:")) != -1) {
+		switch (ch) {
+		case 'd':
+			debug++;
+			break;
+		case 'n':
+			count = strtonum(optarg, 1, 1000000, &errstr);
+			if (errstr) {
+				fprintf(stderr, "count is %s: %s\n", errstr, optarg);
+				usage();
+			}
+			break;
+		case 'i':
+			iterations = strtonum(optarg, 1, 100000000, &errstr);
+			if (errstr) {
+				fprintf(stderr, "iterations is %s: %s\n", errstr, optarg);
+				usage();
+			}
+			break;
+		default:
+			usage();
+		}
+	}
+	if (optind != argc) usage();
+	log_init(0, debug, __progname);
+
+	/* Build a set of interface names, similar to what is found on a
+	 * switch with containers */
+	if ((names = calloc(count, sizeof(char *))) == NULL) {
+		fprintf(stderr, "not enough memory\n");
+		exit(1);
+	}
+	for (i = 0; i < count; i++) {
+		static const char *prefixes[] = {
+			"eth", "swp", "veth", "docker", "vlan", "bond", "enp0s"
+		};
+		if (asprintf(&names[i], "%s%d%s",
+			prefixes[i % (sizeof(prefixes)/sizeof(prefixes[0]))],
+			i / 7, (i % 11 == 0)?".100":"") == -1) {
+			fprintf(stderr, "not enough memory\n");
+			exit(1);
+		}
+	}
+
+	printf("# %-6s %-10s %10s %12s %8s %8s\n",
+	    "list", "op", "ns/match", "matches/s", "allocs", "matched");
+	for (l = 0; lists[l].name != NULL; l++) {
+		if ((patterns = strdup(lists[l].patterns)) == NULL) {
+			fprintf(stderr, "not enough memory\n");
+			exit(1);
+		}
+
+		/* pattern_match() */
+		allocations = bench_allocations();
+		best = UINT64_MAX;
+		for (round = 0; round < BENCH_ROUNDS; round++) {
+			matches = 0;
+			start = bench_now();
+			for (j = 0; j < iterations; j++)
+				for (i = 0; i < count; i++)
+					matches += !!pattern_match(names[i],
+					    patterns, 0);
+			if ((elapsed = bench_now() - start) < best) best = elapsed;
+		}
+		bench_record(lists[l].name, "match", best,
+		    (allocations == -1)?-1:
+		    (bench_allocations() - allocations) / BENCH_ROUNDS,
+		    count * iterations, matches / iterations);
+
+		/* Compiled patterns, compilation included */
+		allocations = bench_allocations();
+		best = UINT64_MAX;
+		for (round = 0; round < BENCH_ROUNDS; round++) {
+			matches = 0;
+			start = bench_now();
+			for (j = 0; j < iterations; j++) {
+				if ((p = pattern_compile(patterns)) == NULL) {
+					fprintf(stderr, "not enough memory\n");
+					exit(1);
+				}
+				for (i = 0; i < count; i++)
+					matches += !!pattern_match_compiled(p,
+					    names[i], 0);
+				pattern_free(p);
+			}
+			if ((elapsed = bench_now() - start) < best) best = elapsed;
+		}
+		bench_record(lists[l].name, "compiled", best,
+		    (allocations == -1)?-1:
+		    (bench_allocations() - allocations) / BENCH_ROUNDS,
+		    count * iterations, matches / iterations);
+		free(patterns);
+	}
+
+	for (i = 0; i < count; i++) free(names[i]);
+	free(names);
+	exit(0);
+}
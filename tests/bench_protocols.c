@@ -0,0 +1,470 @@
+/* -*- mode: c; c-file-style: "openbsd" -*- */
+/*
+ * Copyright (c) 2019 Vincent Bernat <vincent@bernat.im>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* Measure the cost of encoding and decoding a frame for each protocol. Frames
+ * are built by the encoders from a minimal, a typical and a large local port.
+ * Results can be compared to a previous run to detect regressions. */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include "../src/daemon/lldpd.h"
+#include "bench.h"
+
+#define BENCH_MAX_FRAME 16384
+#define BENCH_ROUNDS 5		/* Only the fastest round is kept */
+#define BENCH_MAX_VLANS 200
+#define BENCH_MAX_PIS 16
+#define BENCH_MAX_CUSTOMS 32
+
+enum {
+	VARIANT_MINIMAL,
+	VARIANT_TYPICAL,
+	VARIANT_LARGE,
+	VARIANT_LAST
+};
+static const char *variants[] = { "minimal", "typical", "large" };
+
+static struct lldpd cfg = {
+	.g_config = {
+		.c_cap_advertise  = 1,
+		.c_mgmt_advertise = 1,
+		.c_tx_interval    = LLDPD_TX_INTERVAL,
+		.c_tx_hold        = LLDPD_TX_HOLD,
+		.c_ttl            = LLDPD_TTL,
+	}
+};
+static struct lldpd_hardware hardware;
+static struct lldpd_chassis chassis;
+#ifdef ENABLE_LLDPMED
+static struct lldpd_port_med med;
+#endif
+static char macaddress[ETHER_ADDR_LEN] = { 0x5e, 0x10, 0x8e, 0xe7, 0x84, 0xad };
+
+/* Only the first frame of each send operation is kept. */
+static char frame[BENCH_MAX_FRAME];
+static int frame_len;
+static int frames_sent;
+
+static int
+bench_send(struct lldpd *cfg, struct lldpd_hardware *hardware,
+    char *buffer, size_t size)
+{
+	if (frames_sent++ == 0 && size <= sizeof(frame)) {
+		memcpy(frame, buffer, size);
+		frame_len = size;
+	}
+	return 0;
+}
+
+static struct lldpd_ops bench_ops = {
+	.send = bench_send,
+	.recv = NULL,
+	.cleanup = NULL,
+};
+
+/* One measurement, also used for baselines. */
+struct result {
+	char protocol[16];
+	char variant[16];
+	char operation[16];
+	int size;
+	double ns;		/* Nanoseconds per operation */
+	double allocations;	/* Allocations per operation (-1 if unknown) */
+};
+
+#ifdef HAVE___PROGNAME
+extern const char	*__progname;
+#else
+# define __progname "bench_protocols"
+#endif
+
+static void
+usage(void)
+{
+	fprintf(stderr, "Usage:   %s [OPTIONS ...]\n", __progname);
+	fprintf(stderr, "Version: %s\n", PACKAGE_STRING);
+
+	fprintf(stderr, "\n");
+
+	fprintf(stderr, "-d         Enable debug messages (repeat for more).\n");
+	fprintf(stderr, "-n COUNT   Number of iterations for each round (default: 10000).\n");
+	fprintf(stderr, "-b FILE    Compare with results from a previous run.\n");
+	fprintf(stderr, "-t PERCENT Tolerated slowdown compared to the baseline (default: 20).\n");
+
+	fprintf(stderr, "\n");
+
+	fprintf(stderr, "Measure the cost of encoding and decoding frames for each\n");
+	fprintf(stderr, "protocol. With -b, exit with 2 when a measure is slower than\n");
+	fprintf(stderr, "the baseline or needs more allocations.\n");
+	exit(1);
+}
+
+/* Setup local port for the given variant. */
+static void
+bench_setup(int variant)
+{
+	static struct lldpd_mgmt mgmt4, mgmt6;
+#ifdef ENABLE_DOT1
+	static struct lldpd_vlan vlans[BENCH_MAX_VLANS];
+	static char vlan_names[BENCH_MAX_VLANS][20];
+	static struct lldpd_ppvid ppvid;
+	static struct lldpd_pi pis[BENCH_MAX_PIS];
+#endif
+#ifdef ENABLE_CUSTOM
+	static struct lldpd_custom customs[BENCH_MAX_CUSTOMS];
+	static u_int8_t custom_info[64];
+#endif
+	int i, count;
+
+	memset(&hardware, 0, sizeof(struct lldpd_hardware));
+	memset(&chassis, 0, sizeof(struct lldpd_chassis));
+#ifdef ENABLE_LLDPMED
+	memset(&med, 0, sizeof(struct lldpd_port_med));
+#endif
+	TAILQ_INIT(&hardware.h_rports);
+	TAILQ_INIT(&chassis.c_mgmt);
+#ifdef ENABLE_DOT1
+	TAILQ_INIT(&hardware.h_lport.p_vlans);
+	TAILQ_INIT(&hardware.h_lport.p_ppvids);
+	TAILQ_INIT(&hardware.h_lport.p_pids);
+#endif
+#ifdef ENABLE_CUSTOM
+	TAILQ_INIT(&hardware.h_lport.p_custom_list);
+#endif
+	hardware.h_cfg = &cfg;
+	hardware.h_mtu = 1500;
+	hardware.h_ifindex = 4;
+	strlcpy(hardware.h_ifname, "bench", sizeof(hardware.h_ifname));
+	memcpy(hardware.h_lladdr, macaddress, ETHER_ADDR_LEN);
+	hardware.h_ops = &bench_ops;
+	hardware.h_lport.p_chassis = &chassis;
+
+	/* Minimal: only mandatory information (and what lldpd always sets) */
+	chassis.c_name = "bench";
+	chassis.c_descr = "";
+	chassis.c_id_subtype = LLDP_CHASSISID_SUBTYPE_LLADDR;
+	chassis.c_id = macaddress;
+	chassis.c_id_len = ETHER_ADDR_LEN;
+	hardware.h_lport.p_id_subtype = LLDP_PORTID_SUBTYPE_LLADDR;
+	hardware.h_lport.p_id = macaddress;
+	hardware.h_lport.p_id_len = ETHER_ADDR_LEN;
+	hardware.h_lport.p_descr = hardware.h_ifname;	/* Needed by CDP */
+	hardware.h_lport.p_ttl = LLDPD_TTL;
+	if (variant == VARIANT_MINIMAL) return;
+
+	/* Typical: what lldpd sends on a Linux host */
+	chassis.c_name = "bench.example.com";
+	chassis.c_descr = "Debian GNU/Linux 10 (buster) Linux 4.19.0-5-amd64 "
+	    "#1 SMP Debian 4.19.37-5 (2019-06-19) x86_64";
+	chassis.c_cap_available = LLDP_CAP_BRIDGE | LLDP_CAP_ROUTER |
+	    LLDP_CAP_WLAN | LLDP_CAP_STATION;
+	chassis.c_cap_enabled = LLDP_CAP_ROUTER;
+	mgmt4.m_family = LLDPD_AF_IPV4;
+	mgmt4.m_addrsize = sizeof(struct in_addr);
+	mgmt4.m_iface = 4;
+	inet_pton(AF_INET, "192.0.2.15", &mgmt4.m_addr.inet);
+	TAILQ_INSERT_TAIL(&chassis.c_mgmt, &mgmt4, m_entries);
+	mgmt6.m_family = LLDPD_AF_IPV6;
+	mgmt6.m_addrsize = sizeof(struct in6_addr);
+	mgmt6.m_iface = 4;
+	inet_pton(AF_INET6, "2001:db8::15", &mgmt6.m_addr.inet6);
+	TAILQ_INSERT_TAIL(&chassis.c_mgmt, &mgmt6, m_entries);
+	hardware.h_lport.p_id_subtype = LLDP_PORTID_SUBTYPE_IFNAME;
+	hardware.h_lport.p_id = "eth0";
+	hardware.h_lport.p_id_len = strlen(hardware.h_lport.p_id);
+	hardware.h_lport.p_descr = "Uplink to core switch";
+#ifdef ENABLE_DOT3
+	hardware.h_lport.p_mfs = 1514;
+	hardware.h_lport.p_macphy.autoneg_support = 1;
+	hardware.h_lport.p_macphy.autoneg_enabled = 1;
+	hardware.h_lport.p_macphy.autoneg_advertised =
+	    LLDP_DOT3_LINK_AUTONEG_1000BASE_TFD |
+	    LLDP_DOT3_LINK_AUTONEG_100BASE_TXFD;
+	hardware.h_lport.p_macphy.mau_type = LLDP_DOT3_MAU_1000BASETFD;
+#endif
+#ifdef ENABLE_LLDPMED
+	chassis.c_med_cap_available = LLDP_MED_CAP_CAP | LLDP_MED_CAP_IV |
+	    LLDP_MED_CAP_POLICY | LLDP_MED_CAP_LOCATION;
+	chassis.c_med_type = LLDP_MED_CLASS_III;
+	chassis.c_med_hw = "1.0";
+	chassis.c_med_fw = "2.3.4";
+	chassis.c_med_sw = "4.19.0-5-amd64";
+	chassis.c_med_sn = "SN 47842";
+	chassis.c_med_manuf = "Bench Inc.";
+	chassis.c_med_model = "Bench 2000";
+	hardware.h_lport.p_med_cap_enabled = chassis.c_med_cap_available;
+	hardware.h_lport.p_med = &med;
+	med.policy[LLDP_MED_APPTYPE_VOICE-1].type =
+	    LLDP_MED_APPTYPE_VOICE;
+	med.policy[LLDP_MED_APPTYPE_VOICE-1].tagged = 1;
+	med.policy[LLDP_MED_APPTYPE_VOICE-1].vid = 51;
+	med.policy[LLDP_MED_APPTYPE_VOICE-1].priority = 6;
+	med.policy[LLDP_MED_APPTYPE_VOICE-1].dscp = 46;
+#endif
+	count = (variant == VARIANT_LARGE)?BENCH_MAX_VLANS:4;
+#ifdef ENABLE_DOT1
+	hardware.h_lport.p_pvid = 1;
+	for (i = 0; i < count; i++) {
+		snprintf(vlan_names[i], sizeof(vlan_names[i]),
+		    (variant == VARIANT_LARGE)?
+		    "vlan%04d-long-name":"vlan%d", 100 + i);
+		vlans[i].v_name = vlan_names[i];
+		vlans[i].v_vid = 100 + i;
+		TAILQ_INSERT_TAIL(&hardware.h_lport.p_vlans, &vlans[i], v_entries);
+	}
+	ppvid.p_cap_status = LLDP_PPVID_CAP_SUPPORTED | LLDP_PPVID_CAP_ENABLED;
+	ppvid.p_ppvid = 1;
+	TAILQ_INSERT_TAIL(&hardware.h_lport.p_ppvids, &ppvid, p_entries);
+	count = (variant == VARIANT_LARGE)?BENCH_MAX_PIS:1;
+	for (i = 0; i < count; i++) {
+		pis[i].p_pi = "IEEE Link Layer Discovery Protocol 802.1ab-2005";
+		pis[i].p_pi_len = strlen(pis[i].p_pi);
+		TAILQ_INSERT_TAIL(&hardware.h_lport.p_pids, &pis[i], p_entries);
+	}
+#endif
+	if (variant == VARIANT_TYPICAL) return;
+
+	/* Large: many VLANs and custom TLVs in a jumbo frame */
+	hardware.h_mtu = 9000;
+#ifdef ENABLE_CUSTOM
+	memset(custom_info, 'x', sizeof(custom_info));
+	for (i = 0; i < BENCH_MAX_CUSTOMS; i++) {
+		customs[i].oui[0] = 0x33;
+		customs[i].oui[1] = 0x44;
+		customs[i].oui[2] = 0x55;
+		customs[i].subtype = i + 1;
+		customs[i].oui_info = custom_info;
+		customs[i].oui_info_len = sizeof(custom_info);
+		TAILQ_INSERT_TAIL(&hardware.h_lport.p_custom_list, &customs[i], next);
+	}
+#endif
+}
+
+/* Release what a decoder returned. */
+static void
+bench_release(struct lldpd_chassis *nchassis, struct lldpd_port *nport)
+{
+	if (nport) {
+		lldpd_port_cleanup(nport, 1);
+		free(nport);
+	}
+	if (nchassis)
+		lldpd_chassis_cleanup(nchassis, 1);
+}
+
+static void
+bench_record(struct result *result, const char *protocol, int variant,
+    const char *operation, int size, u_int64_t elapsed, long allocations,
+    int count)
+{
+	strlcpy(result->protocol, protocol, sizeof(result->protocol));
+	strlcpy(result->variant, variants[variant], sizeof(result->variant));
+	strlcpy(result->operation, operation, sizeof(result->operation));
+	result->size = size;
+	result->ns = (double)elapsed / count;
+	result->allocations = (allocations == -1)?-1:
+	    (double)allocations / count;
+	printf("%-8s %-8s %-8s %6d %10.0f %8.2f\n",
+	    result->protocol, result->variant, result->operation,
+	    result->size, result->ns, result->allocations);
+}
+
+/* Run all measures for one protocol and one variant. Return the number of
+ * results. */
+static int
+bench_protocol(struct protocol *protocol, int variant, int count,
+    struct result *results)
+{
+	struct lldpd_chassis *nchassis;
+	struct lldpd_port *nport;
+	u_int64_t start, elapsed, best;
+	long allocations;
+	char *copy;
+	int i, round, len;
+
+	bench_setup(variant);
+	frames_sent = frame_len = 0;
+	if (protocol->send(&cfg, &hardware) != 0 || frame_len == 0) {
+		fprintf(stderr, "%s: unable to encode %s frame\n",
+		    protocol->name, variants[variant]);
+		return 0;
+	}
+	len = frame_len;
+	if ((copy = malloc(len)) == NULL) {
+		fprintf(stderr, "not enough memory\n");
+		exit(1);
+	}
+	memcpy(copy, frame, len);
+
+	/* Encode */
+	allocations = bench_allocations();
+	best = UINT64_MAX;
+	for (round = 0; round < BENCH_ROUNDS; round++) {
+		start = bench_now();
+		for (i = 0; i < count; i++) {
+			frames_sent = 0;
+			protocol->send(&cfg, &hardware);
+		}
+		if ((elapsed = bench_now() - start) < best) best = elapsed;
+	}
+	bench_record(&results[0], protocol->name, variant, "encode", len,
+	    best, (allocations == -1)?-1:
+	    (bench_allocations() - allocations) / BENCH_ROUNDS, count);
+
+	/* Decode (and release the result) */
+	nchassis = NULL; nport = NULL;
+	if (protocol->decode(&cfg, copy, len, &hardware,
+		&nchassis, &nport) == -1) {
+		fprintf(stderr, "%s: unable to decode %s frame\n",
+		    protocol->name, variants[variant]);
+		free(copy);
+		exit(1);
+	}
+	bench_release(nchassis, nport);
+	allocations = bench_allocations();
+	best = UINT64_MAX;
+	for (round = 0; round < BENCH_ROUNDS; round++) {
+		start = bench_now();
+		for (i = 0; i < count; i++) {
+			nchassis = NULL; nport = NULL;
+			protocol->decode(&cfg, copy, len, &hardware,
+			    &nchassis, &nport);
+			bench_release(nchassis, nport);
+		}
+		if ((elapsed = bench_now() - start) < best) best = elapsed;
+	}
+	bench_record(&results[1], protocol->name, variant, "decode", len,
+	    best, (allocations == -1)?-1:
+	    (bench_allocations() - allocations) / BENCH_ROUNDS, count);
+
+	free(copy);
+	free(hardware.h_lchassis_previous_id);
+	free(hardware.h_lport_previous_id);
+	lldpd_frame_free(hardware.h_lport.p_lastframe);
+	return 2;
+}
+
+/* Compare results with a baseline. Return the number of regressions. */
+static int
+bench_compare(const char *filename, struct result *results, int n,
+    int tolerance)
+{
+	struct result base;
+	char line[256];
+	FILE *f;
+	int i, regressions = 0;
+
+	if ((f = fopen(filename, "r")) == NULL) {
+		fprintf(stderr, "unable to open %s\n", filename);
+		exit(1);
+	}
+	while (fgets(line, sizeof(line), f) != NULL) {
+		if (line[0] == '#') continue;
+		if (sscanf(line, "%15s %15s %15s %d %lf %lf",
+			base.protocol, base.variant, base.operation,
+			&base.size, &base.ns, &base.allocations) != 6)
+			continue;
+		for (i = 0; i < n; i++) {
+			if (strcmp(results[i].protocol, base.protocol) ||
+			    strcmp(results[i].variant, base.variant) ||
+			    strcmp(results[i].operation, base.operation))
+				continue;
+			if (results[i].ns > base.ns * (100 + tolerance) / 100) {
+				fprintf(stderr, "regression: %s %s %s: "
+				    "%.0f ns instead of %.0f ns\n",
+				    base.protocol, base.variant, base.operation,
+				    results[i].ns, base.ns);
+				regressions++;
+			}
+			if (results[i].allocations >= 0 && base.allocations >= 0 &&
+			    results[i].allocations > base.allocations) {
+				fprintf(stderr, "regression: %s %s %s: "
+				    "%.2f allocations instead of %.2f\n",
+				    base.protocol, base.variant, base.operation,
+				    results[i].allocations, base.allocations);
+				regressions++;
+			}
+		}
+	}
+	fclose(f);
+	return regressions;
+}
+
+int
+main(int argc, char **argv)
+{
+	struct protocol *protocols;
+	struct result *results;
+	const char *errstr, *baseline = NULL;
+	int ch, debug = 1, count = 10000, tolerance = 20;
+	int i, variant, n = 0;
+
+	while ((ch = getopt(argc, argv, "hdn:b:t:")) != -1) {
+		switch (ch) {
+		case 'd':
+			debug++;
+			break;
+		case 'n':
+			count = strtonum(optarg, 1, 100000000, &errstr);
+			if (errstr) {
+				fprintf(stderr, "count is %s: %s\n", errstr, optarg);
+				usage();
+			}
+			break;
+		case 'b':
+			baseline = optarg;
+			break;
+		case 't':
+			tolerance = strtonum(optarg, 0, 1000, &errstr);
+			if (errstr) {
+				fprintf(stderr, "tolerance is %s: %s\n", errstr, optarg);
+				usage();
+			}
+			break;
+		default:
+			usage();
+		}
+	}
+	if (optind != argc) usage();
+	log_init(0, debug, __progname);
+
+	protocols = lldpd_protocols();
+	for (i = 0; protocols[i].mode != 0; i++);
+	if ((results = calloc(i * VARIANT_LAST * 2, sizeof(struct result))) == NULL) {
+		fprintf(stderr, "not enough memory\n");
+		exit(1);
+	}
+
+	printf("# %-6s %-8s %-8s %6s %10s %8s\n",
+	    "proto", "variant", "op", "bytes", "ns/op", "allocs");
+	for (i = 0; protocols[i].mode != 0; i++) {
+		if (!protocols[i].send || !protocols[i].decode) continue;
+		for (variant = 0; variant < VARIANT_LAST; variant++)
+			n += bench_protocol(&protocols[i], variant, count,
+			    &results[n]);
+	}
+
+	if (baseline && bench_compare(baseline, results, n, tolerance) > 0) {
+		free(results);
+		exit(2);
+	}
+	free(results);
+	exit(0);
+}
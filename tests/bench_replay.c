@@ -0,0 +1,327 @@
+/* -*- mode: c; c-file-style: "openbsd" -*- */
+/*
+ * Copyright (c) 2019 Vincent Bernat <vincent@bernat.im>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* Feed frames from a PCAP file through the receive path of lldpd (decoding,
+ * neighbor update, smart filter and notifications) as fast as possible. No
+ * network access or privileges are needed. */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <event2/event.h>
+#include "../src/daemon/lldpd.h"
+#include "pcap-hdr.h"
+#include "bench.h"
+
+#define SMART_DEFAULT (SMART_INCOMING_FILTER | SMART_INCOMING_ONE_PROTO | \
+	    SMART_OUTGOING_FILTER)
+
+struct frame {
+	char *data;
+	size_t size;
+};
+static struct frame *frames = NULL;
+static size_t nframes = 0;
+static size_t current = 0;	/* Frame to be received next */
+
+#ifdef HAVE___PROGNAME
+extern const char	*__progname;
+#else
+# define __progname "bench_replay"
+#endif
+
+static void
+usage(void)
+{
+	fprintf(stderr, "Usage:   %s [OPTIONS ...] PCAP\n", __progname);
+	fprintf(stderr, "Version: %s\n", PACKAGE_STRING);
+
+	fprintf(stderr, "\n");
+
+	fprintf(stderr, "-d       Enable debug messages (repeat for more).\n");
+	fprintf(stderr, "-n COUNT Replay the file COUNT times (default: 1).\n");
+	fprintf(stderr, "-i COUNT Number of interfaces to spread frames on (default: 1).\n");
+	fprintf(stderr, "-m COUNT Maximum number of neighbors per interface (default: %d).\n",
+	    LLDPD_MAX_NEIGHBORS);
+	fprintf(stderr, "-S       Disable smart filter.\n");
+	fprintf(stderr, "-r       Forget received frames between passes to decode them again.\n");
+
+	fprintf(stderr, "\n");
+
+	fprintf(stderr, "Replay the frames of a PCAP file through the receive path\n");
+	fprintf(stderr, "of lldpd and display frames/s, allocations/frame and peak RSS.\n");
+	exit(1);
+}
+
+static int
+replay_recv(struct lldpd *cfg, struct lldpd_hardware *hardware,
+    int fd, char *buffer, size_t size)
+{
+	struct frame *frame = &frames[current];
+	if (frame->size > size) return -1;
+	memcpy(buffer, frame->data, frame->size);
+	return frame->size;
+}
+
+static struct lldpd_ops replay_ops = {
+	.send = NULL,
+	.recv = replay_recv,
+	.cleanup = NULL,
+};
+
+/* Load all frames in memory. Return the buffer holding them. */
+static char *
+replay_load(const char *filename)
+{
+	struct pcap_hdr hdr;
+	struct pcaprec_hdr rechdr;
+	struct stat st;
+	char *buffer;
+	size_t offset;
+	ssize_t n;
+	int fd;
+
+	if ((fd = open(filename, O_RDONLY)) == -1 ||
+	    fstat(fd, &st) == -1) {
+		fprintf(stderr, "unable to open %s\n", filename);
+		exit(1);
+	}
+	if ((buffer = malloc(st.st_size)) == NULL ||
+	    (n = read(fd, buffer, st.st_size)) != st.st_size) {
+		fprintf(stderr, "unable to read %s\n", filename);
+		exit(1);
+	}
+	close(fd);
+
+	if (n < sizeof(hdr)) {
+		fprintf(stderr, "%s is too short\n", filename);
+		exit(1);
+	}
+	memcpy(&hdr, buffer, sizeof(hdr));
+	if (hdr.magic_number != 0xa1b2c3d4 || /* Assume the same byte order as us */
+	    hdr.version_major != 2 || hdr.version_minor != 4 ||
+	    hdr.network != 1) {
+		fprintf(stderr, "%s is not a supported PCAP file\n", filename);
+		exit(1);
+	}
+	for (offset = sizeof(hdr); offset + sizeof(rechdr) <= n;
+	     offset += sizeof(rechdr) + rechdr.incl_len) {
+		memcpy(&rechdr, buffer + offset, sizeof(rechdr));
+		if (rechdr.incl_len > n - offset - sizeof(rechdr)) {
+			fprintf(stderr, "%s is truncated\n", filename);
+			break;
+		}
+		if ((frames = realloc(frames,
+			    (nframes + 1) * sizeof(struct frame))) == NULL) {
+			fprintf(stderr, "not enough memory\n");
+			exit(1);
+		}
+		frames[nframes].data = buffer + offset + sizeof(rechdr);
+		frames[nframes].size = rechdr.incl_len;
+		nframes++;
+	}
+	if (nframes == 0) {
+		fprintf(stderr, "no frame in %s\n", filename);
+		exit(1);
+	}
+	return buffer;
+}
+
+/* Forget the last frame of each neighbor, as if they had all changed. */
+static void
+replay_forget(struct lldpd *cfg)
+{
+	struct lldpd_hardware *hardware;
+	struct lldpd_port *port;
+	TAILQ_FOREACH(hardware, &cfg->g_hardware, h_entries)
+		TAILQ_FOREACH(port, &hardware->h_rports, p_entries) {
+			lldpd_frame_free(port->p_lastframe);
+			port->p_lastframe = NULL;
+		}
+}
+
+int
+main(int argc, char **argv)
+{
+	struct lldpd *cfg;
+	struct lldpd_chassis *lchassis, *chassis, *chassis_next;
+	struct lldpd_hardware *hardware, *hardware_next, **hardwares;
+	struct protocol *protocols;
+	u_int64_t start, elapsed;
+	const char *errstr;
+	char *buffer;
+	unsigned long neighbors = 0;
+	long allocations;
+	size_t i, mtu = 1500, total;
+	int ch, debug = 1, count = 1, ifaces = 1, smart = SMART_DEFAULT;
+	int refresh = 0;
+	int max_neighbors = LLDPD_MAX_NEIGHBORS;
+
+	while ((ch = getopt(argc, argv, "hdn:i:m:Sr")) != -1) {
+		switch (ch) {
+		case 'd':
+			debug++;
+			break;
+		case 'n':
+			count = strtonum(optarg, 1, 1000000000, &errstr);
+			if (errstr) {
+				fprintf(stderr, "count is %s: %s\n", errstr, optarg);
+				usage();
+			}
+			break;
+		case 'i':
+			ifaces = strtonum(optarg, 1, 65535, &errstr);
+			if (errstr) {
+				fprintf(stderr, "interface count is %s: %s\n",
+				    errstr, optarg);
+				usage();
+			}
+			break;
+		case 'm':
+			max_neighbors = strtonum(optarg, 1, 1000000, &errstr);
+			if (errstr) {
+				fprintf(stderr, "maximum neighbors is %s: %s\n",
+				    errstr, optarg);
+				usage();
+			}
+			break;
+		case 'S':
+			smart = 0;
+			break;
+		case 'r':
+			refresh = 1;
+			break;
+		default:
+			usage();
+		}
+	}
+	if (optind != argc - 1) usage();
+
+	log_init(0, debug, __progname);
+	buffer = replay_load(argv[optind]);
+	for (i = 0; i < nframes; i++)
+		if (frames[i].size > mtu) mtu = frames[i].size;
+
+	/* Minimal configuration, as done in lldpd_main() */
+	if ((cfg = calloc(1, sizeof(struct lldpd))) == NULL ||
+	    (lchassis = calloc(1, sizeof(struct lldpd_chassis))) == NULL ||
+	    (hardwares = calloc(ifaces, sizeof(struct lldpd_hardware *))) == NULL) {
+		fprintf(stderr, "not enough memory\n");
+		exit(1);
+	}
+	if ((cfg->g_base = event_base_new()) == NULL) {
+		fprintf(stderr, "unable to create a new libevent base\n");
+		exit(1);
+	}
+	cfg->g_config.c_smart = smart;
+	cfg->g_config.c_max_neighbors = max_neighbors;
+	cfg->g_config.c_tx_interval = LLDPD_TX_INTERVAL;
+	cfg->g_config.c_tx_hold = LLDPD_TX_HOLD;
+	cfg->g_config.c_ttl = LLDPD_TTL;
+	cfg->g_protocols = protocols = lldpd_protocols();
+	for (i = 0; protocols[i].mode != 0; i++)
+		protocols[i].enabled = 1;
+	TAILQ_INIT(&cfg->g_hardware);
+	TAILQ_INIT(&cfg->g_chassis);
+	TAILQ_INIT(&lchassis->c_mgmt);
+	TAILQ_INSERT_TAIL(&cfg->g_chassis, lchassis, c_entries);
+	lchassis->c_refcount++;
+
+	for (i = 0; i < ifaces; i++) {
+		if ((hardware = calloc(1, sizeof(struct lldpd_hardware))) == NULL) {
+			fprintf(stderr, "not enough memory\n");
+			exit(1);
+		}
+		hardware->h_cfg = cfg;
+		snprintf(hardware->h_ifname, sizeof(hardware->h_ifname),
+		    "eth%d", (int)i);
+		hardware->h_ifindex = i + 1;
+		hardware->h_mtu = mtu;
+		hardware->h_ops = &replay_ops;
+		hardware->h_lport.p_chassis = lchassis;
+		lchassis->c_refcount++;
+		TAILQ_INIT(&hardware->h_rports);
+#ifdef ENABLE_DOT1
+		TAILQ_INIT(&hardware->h_lport.p_vlans);
+		TAILQ_INIT(&hardware->h_lport.p_ppvids);
+		TAILQ_INIT(&hardware->h_lport.p_pids);
+#endif
+#ifdef ENABLE_CUSTOM
+		TAILQ_INIT(&hardware->h_lport.p_custom_list);
+#endif
+		TAILQ_INSERT_TAIL(&cfg->g_hardware, hardware, h_entries);
+		hardwares[i] = hardware;
+	}
+
+	/* Replay */
+	total = nframes * count;
+	allocations = bench_allocations();
+	start = bench_now();
+	for (i = 0; i < total; i++) {
+		current = i % nframes;
+		if (refresh && current == 0 && i > 0)
+			replay_forget(cfg);
+		lldpd_recv(cfg, hardwares[i % ifaces], -1);
+	}
+	elapsed = bench_now() - start;
+	if (allocations != -1)
+		allocations = bench_allocations() - allocations;
+
+	TAILQ_FOREACH(hardware, &cfg->g_hardware, h_entries) {
+		struct lldpd_port *port;
+		TAILQ_FOREACH(port, &hardware->h_rports, p_entries)
+			neighbors++;
+	}
+
+	printf("Frames:            %zu (%zu in file, %d passes, %d interfaces)\n",
+	    total, nframes, count, ifaces);
+	printf("Neighbors:         %lu\n", neighbors);
+	printf("Elapsed:           %.3f s\n", elapsed / 1000000000.);
+	printf("Frames/s:          %.0f\n",
+	    (elapsed > 0)?total * 1000000000. / elapsed:0);
+	printf("Time/frame:        %.0f ns\n", (double)elapsed / total);
+	if (allocations != -1)
+		printf("Allocations/frame: %.2f\n", (double)allocations / total);
+	else
+		printf("Allocations/frame: not available\n");
+	printf("Peak RSS:          %ld kB\n", bench_maxrss());
+
+	/* Cleanup */
+	for (hardware = TAILQ_FIRST(&cfg->g_hardware); hardware != NULL;
+	     hardware = hardware_next) {
+		hardware_next = TAILQ_NEXT(hardware, h_entries);
+		lldpd_remote_cleanup(hardware, NULL, 1);
+		TAILQ_REMOVE(&cfg->g_hardware, hardware, h_entries);
+		lldpd_hardware_cleanup(cfg, hardware);
+	}
+	for (chassis = TAILQ_FIRST(&cfg->g_chassis); chassis != NULL;
+	     chassis = chassis_next) {
+		chassis_next = TAILQ_NEXT(chassis, c_entries);
+		TAILQ_REMOVE(&cfg->g_chassis, chassis, c_entries);
+		lldpd_chassis_cleanup(chassis, 1);
+	}
+	lldpd_slab_cleanup();
+	event_base_free(cfg->g_base);
+	free(hardwares);
+	free(cfg);
+	free(frames);
+	free(buffer);
+	exit(0);
+}
@@ -70,37 +70,38 @@ check_received_port_med(
 {
 	ck_assert_int_eq(rport->p_med_cap_enabled, sport->p_med_cap_enabled);
 	ck_assert_int_eq(rport->p_med_cap_enabled, sport->p_med_cap_enabled);
+	fail_unless(rport->p_med != NULL);
 	ck_assert_int_eq(
-		rport->p_med_location[LLDP_MED_LOCFORMAT_CIVIC-1].format,
-		sport->p_med_location[LLDP_MED_LOCFORMAT_CIVIC-1].format);
+		rport->p_med->location[LLDP_MED_LOCFORMAT_CIVIC-1].format,
+		sport->p_med->location[LLDP_MED_LOCFORMAT_CIVIC-1].format);
 	ck_assert_int_eq(
-		rport->p_med_location[LLDP_MED_LOCFORMAT_CIVIC-1].data_len,
-		sport->p_med_location[LLDP_MED_LOCFORMAT_CIVIC-1].data_len);
+		rport->p_med->location[LLDP_MED_LOCFORMAT_CIVIC-1].data_len,
+		sport->p_med->location[LLDP_MED_LOCFORMAT_CIVIC-1].data_len);
 	ck_assert_str_eq_n(
-		rport->p_med_location[LLDP_MED_LOCFORMAT_CIVIC-1].data,
-		sport->p_med_location[LLDP_MED_LOCFORMAT_CIVIC-1].data,
-		sport->p_med_location[LLDP_MED_LOCFORMAT_CIVIC-1].data_len);
+		rport->p_med->location[LLDP_MED_LOCFORMAT_CIVIC-1].data,
+		sport->p_med->location[LLDP_MED_LOCFORMAT_CIVIC-1].data,
+		sport->p_med->location[LLDP_MED_LOCFORMAT_CIVIC-1].data_len);
 	ck_assert_int_eq(
-		rport->p_med_policy[LLDP_MED_APPTYPE_SOFTPHONEVOICE-1].type,
-		sport->p_med_policy[LLDP_MED_APPTYPE_SOFTPHONEVOICE-1].type);
+		rport->p_med->policy[LLDP_MED_APPTYPE_SOFTPHONEVOICE-1].type,
+		sport->p_med->policy[LLDP_MED_APPTYPE_SOFTPHONEVOICE-1].type);
 	ck_assert_int_eq(
-		rport->p_med_policy[LLDP_MED_APPTYPE_SOFTPHONEVOICE-1].tagged,
-		sport->p_med_policy[LLDP_MED_APPTYPE_SOFTPHONEVOICE-1].tagged);
+		rport->p_med->policy[LLDP_MED_APPTYPE_SOFTPHONEVOICE-1].tagged,
+		sport->p_med->policy[LLDP_MED_APPTYPE_SOFTPHONEVOICE-1].tagged);
 	ck_assert_int_eq(
-		rport->p_med_policy[LLDP_MED_APPTYPE_SOFTPHONEVOICE-1].vid,
-		sport->p_med_policy[LLDP_MED_APPTYPE_SOFTPHONEVOICE-1].vid);
+		rport->p_med->policy[LLDP_MED_APPTYPE_SOFTPHONEVOICE-1].vid,
+		sport->p_med->policy[LLDP_MED_APPTYPE_SOFTPHONEVOICE-1].vid);
 	ck_assert_int_eq(
-		rport->p_med_policy[LLDP_MED_APPTYPE_SOFTPHONEVOICE-1].priority,
-		sport->p_med_policy[LLDP_MED_APPTYPE_SOFTPHONEVOICE-1].priority);
+		rport->p_med->policy[LLDP_MED_APPTYPE_SOFTPHONEVOICE-1].priority,
+		sport->p_med->policy[LLDP_MED_APPTYPE_SOFTPHONEVOICE-1].priority);
 	ck_assert_int_eq(
-		rport->p_med_policy[LLDP_MED_APPTYPE_SOFTPHONEVOICE-1].dscp,
-		sport->p_med_policy[LLDP_MED_APPTYPE_SOFTPHONEVOICE-1].dscp);
+		rport->p_med->policy[LLDP_MED_APPTYPE_SOFTPHONEVOICE-1].dscp,
+		sport->p_med->policy[LLDP_MED_APPTYPE_SOFTPHONEVOICE-1].dscp);
 	ck_assert_int_eq(
-		rport->p_med_power.devicetype, sport->p_med_power.devicetype);
-	ck_assert_int_eq(rport->p_med_power.source, sport->p_med_power.source);
-	ck_assert_int_eq(rport->p_med_power.priority,
-		sport->p_med_power.priority);
-	ck_assert_int_eq(rport->p_med_power.val, sport->p_med_power.val);
+		rport->p_med->power.devicetype, sport->p_med->power.devicetype);
+	ck_assert_int_eq(rport->p_med->power.source, sport->p_med->power.source);
+	ck_assert_int_eq(rport->p_med->power.priority,
+		sport->p_med->power.priority);
+	ck_assert_int_eq(rport->p_med->power.val, sport->p_med->power.val);
 }
 
 static void
@@ -135,69 +136,71 @@ check_received_port_dot3(
 	ck_assert_int_eq(rport->p_macphy.mau_type, sport->p_macphy.mau_type);
 	
 	/*check lldpd_dot3_power*/
-	ck_assert_int_eq(rport->p_power.devicetype,
-		sport->p_power.devicetype);
-	ck_assert_int_eq(rport->p_power.supported,
-		sport->p_power.supported);
-	ck_assert_int_eq(rport->p_power.enabled,
-		sport->p_power.enabled);
-	ck_assert_int_eq(rport->p_power.paircontrol,
-		sport->p_power.paircontrol);
-	ck_assert_int_eq(rport->p_power.pairs,
-		sport->p_power.pairs);
-	ck_assert_int_eq(rport->p_power.class,
-		sport->p_power.class);
-	ck_assert_int_eq(rport->p_power.powertype,
-		sport->p_power.powertype);
-	ck_assert_int_eq(rport->p_power.source,
-		sport->p_power.source);
-	ck_assert_int_eq(rport->p_power.pid4,
-		sport->p_power.pid4);
-	ck_assert_int_eq(rport->p_power.priority,
-		sport->p_power.priority);
-	ck_assert_int_eq(rport->p_power.requested,
-		sport->p_power.requested);
-	ck_assert_int_eq(rport->p_power.allocated,
-		sport->p_power.allocated);
+	fail_unless(rport->p_power != NULL);
+	ck_assert_int_eq(rport->p_power->devicetype,
+		sport->p_power->devicetype);
+	ck_assert_int_eq(rport->p_power->supported,
+		sport->p_power->supported);
+	ck_assert_int_eq(rport->p_power->enabled,
+		sport->p_power->enabled);
+	ck_assert_int_eq(rport->p_power->paircontrol,
+		sport->p_power->paircontrol);
+	ck_assert_int_eq(rport->p_power->pairs,
+		sport->p_power->pairs);
+	ck_assert_int_eq(rport->p_power->class,
+		sport->p_power->class);
+	ck_assert_int_eq(rport->p_power->powertype,
+		sport->p_power->powertype);
+	ck_assert_int_eq(rport->p_power->source,
+		sport->p_power->source);
+	ck_assert_int_eq(rport->p_power->pid4,
+		sport->p_power->pid4);
+	ck_assert_int_eq(rport->p_power->priority,
+		sport->p_power->priority);
+	ck_assert_int_eq(rport->p_power->requested,
+		sport->p_power->requested);
+	ck_assert_int_eq(rport->p_power->allocated,
+		sport->p_power->allocated);
 		/*802.3bt*/
-	ck_assert_int_eq(rport->p_power.requestedA,
-		sport->p_power.requestedA);
-	ck_assert_int_eq(rport->p_power.requestedB,
-		sport->p_power.requestedB);
-	ck_assert_int_eq(rport->p_power.allocatedA,
-		sport->p_power.allocatedA);
-	ck_assert_int_eq(rport->p_power.allocatedB,
-		sport->p_power.allocatedB);
-	ck_assert_int_eq(rport->p_power.powerStatus,
-		sport->p_power.powerStatus);
-	ck_assert_int_eq(rport->p_power.systemSetup,
-		sport->p_power.systemSetup);
-	ck_assert_int_eq(rport->p_power.pseMaxAvailPower,
-		sport->p_power.pseMaxAvailPower);
-	ck_assert_int_eq(rport->p_power.autoClass,
-		sport->p_power.autoClass);
-	ck_assert_int_eq(rport->p_power.powerDown,
-		sport->p_power.powerDown);
+	ck_assert_int_eq(rport->p_power->requestedA,
+		sport->p_power->requestedA);
+	ck_assert_int_eq(rport->p_power->requestedB,
+		sport->p_power->requestedB);
+	ck_assert_int_eq(rport->p_power->allocatedA,
+		sport->p_power->allocatedA);
+	ck_assert_int_eq(rport->p_power->allocatedB,
+		sport->p_power->allocatedB);
+	ck_assert_int_eq(rport->p_power->powerStatus,
+		sport->p_power->powerStatus);
+	ck_assert_int_eq(rport->p_power->systemSetup,
+		sport->p_power->systemSetup);
+	ck_assert_int_eq(rport->p_power->pseMaxAvailPower,
+		sport->p_power->pseMaxAvailPower);
+	ck_assert_int_eq(rport->p_power->autoClass,
+		sport->p_power->autoClass);
+	ck_assert_int_eq(rport->p_power->powerDown,
+		sport->p_power->powerDown);
 
 	/*check lldpd_dot3_measurements*/	
-	ck_assert_int_eq(rport->p_measurements.energyMeas,
-		sport->p_measurements.energyMeas);
-	ck_assert_int_eq(rport->p_measurements.powerMeas,
-		sport->p_measurements.powerMeas);
-	ck_assert_int_eq(rport->p_measurements.currentMeas,
-		sport->p_measurements.currentMeas);
-	ck_assert_int_eq(rport->p_measurements.voltMeas,
-		sport->p_measurements.voltMeas);
-	ck_assert_int_eq(rport->p_measurements.energyUncertainty,
-		sport->p_measurements.energyUncertainty);
-	ck_assert_int_eq(rport->p_measurements.powerUncertainty,
-		sport->p_measurements.powerUncertainty);
-	ck_assert_int_eq(rport->p_measurements.currentUncertainty,
-		sport->p_measurements.currentUncertainty);
-	ck_assert_int_eq(rport->p_measurements.voltUncertainty,
-		sport->p_measurements.voltUncertainty);
-	ck_assert_int_eq(rport->p_measurements.flags,
-		sport->p_measurements.flags);
+	fail_unless(rport->p_measurements != NULL);
+	ck_assert_int_eq(rport->p_measurements->energyMeas,
+		sport->p_measurements->energyMeas);
+	ck_assert_int_eq(rport->p_measurements->powerMeas,
+		sport->p_measurements->powerMeas);
+	ck_assert_int_eq(rport->p_measurements->currentMeas,
+		sport->p_measurements->currentMeas);
+	ck_assert_int_eq(rport->p_measurements->voltMeas,
+		sport->p_measurements->voltMeas);
+	ck_assert_int_eq(rport->p_measurements->energyUncertainty,
+		sport->p_measurements->energyUncertainty);
+	ck_assert_int_eq(rport->p_measurements->powerUncertainty,
+		sport->p_measurements->powerUncertainty);
+	ck_assert_int_eq(rport->p_measurements->currentUncertainty,
+		sport->p_measurements->currentUncertainty);
+	ck_assert_int_eq(rport->p_measurements->voltUncertainty,
+		sport->p_measurements->voltUncertainty);
+	ck_assert_int_eq(rport->p_measurements->flags,
+		sport->p_measurements->flags);
 }
 #endif
 
@@ -245,6 +248,14 @@ START_TEST (test_send_rcv_basic)
 	check_received_port(&hardware.h_lport, nport);
 	/* verify chassis values */
 	check_received_chassis(&chassis, nchassis);
+	/* no extension block for information not sent */
+#ifdef ENABLE_DOT3
+	fail_unless(nport->p_power == NULL);
+	fail_unless(nport->p_measurements == NULL);
+#endif
+#ifdef ENABLE_LLDPMED
+	fail_unless(nport->p_med == NULL);
+#endif
 }
 END_TEST
 
@@ -385,6 +396,7 @@ START_TEST (test_send_rcv_med)
 	struct packet *pkt;
 	struct lldpd_chassis *nchassis = NULL;
 	struct lldpd_port *nport = NULL;
+	struct lldpd_port_med med = {};
 
 	/* Populate port and chassis */
 	hardware.h_lport.p_id_subtype = LLDP_PORTID_SUBTYPE_LLADDR;
@@ -408,25 +420,26 @@ START_TEST (test_send_rcv_med)
 	chassis.c_med_sw = "2.6.22b5";
 	chassis.c_med_sn = "SN 47842";
 	hardware.h_lport.p_med_cap_enabled = chassis.c_med_cap_available;
-	hardware.h_lport.p_med_location[LLDP_MED_LOCFORMAT_CIVIC-1].format =
+	hardware.h_lport.p_med = &med;
+	med.location[LLDP_MED_LOCFORMAT_CIVIC-1].format =
 		LLDP_MED_LOCFORMAT_CIVIC;
-	hardware.h_lport.p_med_location[LLDP_MED_LOCFORMAT_CIVIC-1].data = "Your favorite city";
-	hardware.h_lport.p_med_location[LLDP_MED_LOCFORMAT_CIVIC-1].data_len = 
+	med.location[LLDP_MED_LOCFORMAT_CIVIC-1].data = "Your favorite city";
+	med.location[LLDP_MED_LOCFORMAT_CIVIC-1].data_len = 
 		sizeof("Your favorite city");
-	hardware.h_lport.p_med_policy[LLDP_MED_APPTYPE_SOFTPHONEVOICE-1].type =
+	med.policy[LLDP_MED_APPTYPE_SOFTPHONEVOICE-1].type =
 		LLDP_MED_APPTYPE_SOFTPHONEVOICE;
-	hardware.h_lport.p_med_policy[LLDP_MED_APPTYPE_SOFTPHONEVOICE-1].tagged =
+	med.policy[LLDP_MED_APPTYPE_SOFTPHONEVOICE-1].tagged =
 		1;
-	hardware.h_lport.p_med_policy[LLDP_MED_APPTYPE_SOFTPHONEVOICE-1].vid =
+	med.policy[LLDP_MED_APPTYPE_SOFTPHONEVOICE-1].vid =
 		51;
-	hardware.h_lport.p_med_policy[LLDP_MED_APPTYPE_SOFTPHONEVOICE-1].priority =
+	med.policy[LLDP_MED_APPTYPE_SOFTPHONEVOICE-1].priority =
 		6;
-	hardware.h_lport.p_med_policy[LLDP_MED_APPTYPE_SOFTPHONEVOICE-1].dscp =
+	med.policy[LLDP_MED_APPTYPE_SOFTPHONEVOICE-1].dscp =
 		46;
-	hardware.h_lport.p_med_power.devicetype = LLDP_MED_POW_TYPE_PSE;
-	hardware.h_lport.p_med_power.source = LLDP_MED_POW_SOURCE_PRIMARY;
-	hardware.h_lport.p_med_power.priority = LLDP_MED_POW_PRIO_HIGH;
-	hardware.h_lport.p_med_power.val = 65;
+	med.power.devicetype = LLDP_MED_POW_TYPE_PSE;
+	med.power.source = LLDP_MED_POW_SOURCE_PRIMARY;
+	med.power.priority = LLDP_MED_POW_PRIO_HIGH;
+	med.power.val = 65;
 
 	/* Build packet */
 	n = lldp_send(&test_lldpd, &hardware);
@@ -467,6 +480,8 @@ START_TEST (test_send_rcv_dot3)
 	struct lldpd_chassis *nchassis = NULL;
 	struct lldpd_port *nport = NULL;
 	struct packet *pkt;
+	struct lldpd_dot3_power power = {};
+	struct lldpd_dot3_measurements measurements = {};
 
 	/* Populate port */
 	hardware.h_lport.p_id_subtype = LLDP_PORTID_SUBTYPE_IFNAME;
@@ -482,41 +497,43 @@ START_TEST (test_send_rcv_dot3)
 		LLDP_DOT3_LINK_AUTONEG_100BASE_TXFD;
 	hardware.h_lport.p_macphy.mau_type = LLDP_DOT3_MAU_100BASETXFD;
 	
-	hardware.h_lport.p_power.devicetype = LLDP_DOT3_POWER_PD;
-	hardware.h_lport.p_power.supported = 0; /*undefined for pd*/
-	hardware.h_lport.p_power.enabled = 0; /*undefined for pd*/
-	hardware.h_lport.p_power.paircontrol = 0; /*undefined for pd*/
-	hardware.h_lport.p_power.pairs = 0; /*undefined for pd*/
-	hardware.h_lport.p_power.class = 0; /*undefined for pd*/
-	hardware.h_lport.p_power.powertype = LLDP_DOT3_POWER_8023AT_TYPE1;
-	hardware.h_lport.p_power.source = LLDP_DOT3_POWER_SOURCE_PRIMARY;
-	hardware.h_lport.p_power.pid4 = LLDP_DOT3_POWER_4PID_SUP;
-	hardware.h_lport.p_power.priority = LLDP_DOT3_POWER_PRIO_LOW;
-	hardware.h_lport.p_power.requested = 0x12;
-	hardware.h_lport.p_power.allocated = 0x34;
+	hardware.h_lport.p_power = &power;
+	hardware.h_lport.p_measurements = &measurements;
+	power.devicetype = LLDP_DOT3_POWER_PD;
+	power.supported = 0; /*undefined for pd*/
+	power.enabled = 0; /*undefined for pd*/
+	power.paircontrol = 0; /*undefined for pd*/
+	power.pairs = 0; /*undefined for pd*/
+	power.class = 0; /*undefined for pd*/
+	power.powertype = LLDP_DOT3_POWER_8023AT_TYPE1;
+	power.source = LLDP_DOT3_POWER_SOURCE_PRIMARY;
+	power.pid4 = LLDP_DOT3_POWER_4PID_SUP;
+	power.priority = LLDP_DOT3_POWER_PRIO_LOW;
+	power.requested = 0x12;
+	power.allocated = 0x34;
 		/*802.3bt extentsion*/
 
-	hardware.h_lport.p_power.requestedA = 0xabcd;
-	hardware.h_lport.p_power.requestedB = 0xabcd;
-	hardware.h_lport.p_power.allocatedA = 0xabcd;
-	hardware.h_lport.p_power.allocatedB = 0xabcd;
-	hardware.h_lport.p_power.powerStatus = 0xabcd;
-	hardware.h_lport.p_power.systemSetup = 0xef;
-	hardware.h_lport.p_power.pseMaxAvailPower = 0xaaaa; 
-	hardware.h_lport.p_power.autoClass =  0xee;
-	hardware.h_lport.p_power.powerDown =  0x123456;
+	power.requestedA = 0xabcd;
+	power.requestedB = 0xabcd;
+	power.allocatedA = 0xabcd;
+	power.allocatedB = 0xabcd;
+	power.powerStatus = 0xabcd;
+	power.systemSetup = 0xef;
+	power.pseMaxAvailPower = 0xaaaa; 
+	power.autoClass =  0xee;
+	power.powerDown =  0x123456;
 
 	/* Populate measurement*/
-	hardware.h_lport.p_measurements.energyMeas		= 0x01234567;
-	hardware.h_lport.p_measurements.powerMeas		= 0x89ab;
-	hardware.h_lport.p_measurements.currentMeas		= 0xcdef;
-	hardware.h_lport.p_measurements.voltMeas		= 0xfedc;
-	hardware.h_lport.p_measurements.energyUncertainty	= 0xba98;
-	hardware.h_lport.p_measurements.powerUncertainty	= 0x7654;
-	hardware.h_lport.p_measurements.currentUncertainty	= 0x3210;
-	hardware.h_lport.p_measurements.voltUncertainty		= 0x0011;
-	hardware.h_lport.p_measurements.flags			= 0x2233;
-	hardware.h_lport.p_measurements.powerPriceIndex		= 0x4455;
+	measurements.energyMeas		= 0x01234567;
+	measurements.powerMeas		= 0x89ab;
+	measurements.currentMeas		= 0xcdef;
+	measurements.voltMeas		= 0xfedc;
+	measurements.energyUncertainty	= 0xba98;
+	measurements.powerUncertainty	= 0x7654;
+	measurements.currentUncertainty	= 0x3210;
+	measurements.voltUncertainty		= 0x0011;
+	measurements.flags			= 0x2233;
+	measurements.powerPriceIndex		= 0x4455;
 	
 	/* Populate chassis */
 	chassis.c_id_subtype = LLDP_CHASSISID_SUBTYPE_LLADDR;
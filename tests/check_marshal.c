@@ -367,6 +367,70 @@ START_TEST(test_multiple_references) {
 }
 END_TEST
 
+START_TEST(test_inplace) {
+	struct struct_simple source_simple = {
+		.a1 = 451,
+		.a2 = 451424,
+		.a3 = 'o',
+		.a4 = 74,
+		.a5 = { 'a', 'b', 'c', 'd', 'e', 'f', 'g'},
+	};
+	struct struct_nestedpointers source_nested = {
+		.c3 = &source_simple,
+		.c4 = NULL,
+	};
+	struct struct_multipleref source = {
+		.f1 = 15,
+		.f2 = &source_simple,
+		.f3 = &source_simple,
+		.f4 = &source_nested,
+	};
+
+	struct struct_multipleref *destination;
+	void *buffer = NULL, *truncated = NULL;
+	size_t len, len2;
+
+	len = struct_multipleref_serialize(&source, &buffer);
+	fail_unless(len > 0, "Unable to serialize");
+	memset(&source_simple, 0, sizeof(struct struct_simple));
+	memset(&source_nested, 0, sizeof(struct struct_nestedpointers));
+	memset(&source, 0, sizeof(struct struct_multipleref));
+
+	/* A truncated buffer should not be accepted */
+	truncated = malloc(len - 1);
+	fail_unless(truncated != NULL, "Unable to allocate memory");
+	memcpy(truncated, buffer, len - 1);
+	len2 = marshal_unserialize_inplace_(&MARSHAL_INFO(struct_multipleref),
+	    truncated, len - 1, (void **)&destination);
+	ck_assert_int_eq(len2, 0);
+	free(truncated);
+
+	len2 = marshal_unserialize_inplace_(&MARSHAL_INFO(struct_multipleref),
+	    buffer, len, (void **)&destination);
+	fail_unless(len2 > 0, "Unable to deserialize");
+	ck_assert_int_eq(len, len2);
+	ck_assert_int_eq(destination->f1, 15);
+	ck_assert_ptr_eq(destination->f2, destination->f3);
+	ck_assert_ptr_eq(destination->f2, destination->f4->c3);
+	ck_assert_int_eq(destination->f2->a1, 451);
+	ck_assert_int_eq(destination->f2->a2, 451424);
+	ck_assert_int_eq(destination->f2->a3, 'o');
+	ck_assert_int_eq(destination->f2->a4, 74);
+	ck_assert_ptr_eq(destination->f4->c4, NULL);
+	/* Everything should be inside the original buffer */
+	fail_unless((char *)destination > (char *)buffer &&
+	    (char *)destination < (char *)buffer + len,
+	    "Structure outside of buffer");
+	fail_unless((char *)destination->f2 > (char *)buffer &&
+	    (char *)destination->f2 < (char *)buffer + len,
+	    "Substructure outside of buffer");
+	fail_unless((char *)destination->f4 > (char *)buffer &&
+	    (char *)destination->f4 < (char *)buffer + len,
+	    "Substructure outside of buffer");
+	marshal_release(destination);
+}
+END_TEST
+
 struct struct_circularref {
 	int g1;
 	struct struct_circularref* g2;
@@ -867,6 +931,7 @@ marshal_suite(void)
 	tcase_add_test(tc_marshal, test_several_pointers_structure);
 	tcase_add_test(tc_marshal, test_null_pointers);
 	tcase_add_test(tc_marshal, test_multiple_references);
+	tcase_add_test(tc_marshal, test_inplace);
 	tcase_add_test(tc_marshal, test_circular_references);
 	tcase_add_test(tc_marshal, test_too_small_unmarshal);
 	tcase_add_test(tc_marshal, test_simple_list);
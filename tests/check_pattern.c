@@ -106,6 +106,121 @@ START_TEST(test_whitelist) {
 }
 END_TEST
 
+static int
+compiled_match(char *string, char *patterns, int found)
+{
+	struct pattern *p = pattern_compile(patterns);
+	int result;
+	ck_assert_ptr_ne(p, NULL);
+	result = pattern_match_compiled(p, string, found);
+	pattern_free(p);
+	return result;
+}
+
+START_TEST(test_compiled_classes) {
+	/* Exact */
+	ck_assert_int_eq(compiled_match("eth0", "eth0", 0), 2);
+	ck_assert_int_eq(compiled_match("eth0", "eth1", 1), 1);
+	ck_assert_int_eq(compiled_match("eth1", "eth0,eth1,eth2,!eth1", 1), 0);
+	/* Prefix */
+	ck_assert_int_eq(compiled_match("eth0", "eth*", 0), 1);
+	ck_assert_int_eq(compiled_match("eth0", "*", 0), 1);
+	ck_assert_int_eq(compiled_match("eth*", "eth*", 0), 2);
+	ck_assert_int_eq(compiled_match("vlan0", "eth*", 0), 0);
+	ck_assert_int_eq(compiled_match("et", "eth*", 0), 0);
+	/* Glob */
+	ck_assert_int_eq(compiled_match("eth0", "e*0", 0), 1);
+	ck_assert_int_eq(compiled_match("eth0", "eth[0-3]", 0), 1);
+	ck_assert_int_eq(compiled_match("eth4", "eth[0-3]", 0), 0);
+	ck_assert_int_eq(compiled_match("eth4", "eth?,!*4", 1), 0);
+	ck_assert_int_eq(compiled_match("eth*", "eth\\*", 0), 1);
+	ck_assert_int_eq(compiled_match("eth0", "eth\\*", 0), 0);
+	/* Empty patterns are ignored */
+	ck_assert_int_eq(compiled_match("eth0", ",,eth0,", 0), 2);
+	ck_assert_int_eq(compiled_match("eth0", "", 1), 1);
+}
+END_TEST
+
+START_TEST(test_compiled_whitelist_order) {
+	/* The first matching whitelisted pattern decides of the result */
+	ck_assert_int_eq(compiled_match("eth0", "!!eth*,!!eth0", 0), 1);
+	ck_assert_int_eq(compiled_match("eth0", "!!eth0,!!eth*", 0), 2);
+	ck_assert_int_eq(compiled_match("eth0", "!eth0,!!e*,!!eth0", 0), 1);
+	ck_assert_int_eq(compiled_match("eth0", "!eth0,!!eth0,!!e*", 0), 2);
+}
+END_TEST
+
+START_TEST(test_compiled_many) {
+	char patterns[8192], name[IFNAMSIZ];
+	struct pattern *p;
+	int i, len = 0;
+
+	for (i = 0; i < 500; i++)
+		len += snprintf(patterns + len, sizeof(patterns) - len,
+		    "%seth%d,", (i % 2)?"!":"", i);
+	snprintf(patterns + len, sizeof(patterns) - len, "!!eth12,vlan*");
+	p = pattern_compile(patterns);
+	ck_assert_ptr_ne(p, NULL);
+	for (i = 0; i < 600; i++) {
+		snprintf(name, sizeof(name), "eth%d", i);
+		ck_assert_int_eq(pattern_match_compiled(p, name, 0),
+		    (i >= 500)?0:(i % 2)?0:2);
+		ck_assert_int_eq(pattern_match_compiled(p, name, 0),
+		    pattern_match(name, patterns, 0));
+	}
+	ck_assert_int_eq(pattern_match_compiled(p, "vlan12", 0), 1);
+	pattern_free(p);
+}
+END_TEST
+
+START_TEST(test_compiled_random) {
+	/* Compare the compiled matcher with pattern_match() on random
+	 * patterns and strings */
+	static const char *elements[] = {
+		"eth0", "eth1", "eth*", "e*", "*", "*0", "eth?", "eth[01]",
+		"vlan*", "vlan1", "1*", "", "[e]th1"
+	};
+	static const char *strings[] = {
+		"eth0", "eth1", "eth2", "vlan1", "vlan10", "e", "", "eth*",
+		"1.2.3.4"
+	};
+	static const char *negations[] = { "", "!", "!!" };
+	char patterns[256];
+	int i, j, n, len, found;
+
+	srandom(1);
+	for (i = 0; i < 10000; i++) {
+		n = 1 + random() % 5;
+		for (j = len = 0; j < n; j++)
+			len += snprintf(patterns + len, sizeof(patterns) - len,
+			    "%s%s%s", (j > 0)?",":"",
+			    negations[random() % 3],
+			    elements[random() % (sizeof(elements)/sizeof(elements[0]))]);
+		for (j = 0; j < sizeof(strings)/sizeof(strings[0]); j++)
+			for (found = 0; found < 2; found++)
+				ck_assert_msg(compiled_match((char *)strings[j],
+					patterns, found) ==
+				    pattern_match((char *)strings[j], patterns, found),
+				    "%s does not match %s (found=%d) the same way",
+				    strings[j], patterns, found);
+	}
+}
+END_TEST
+
+START_TEST(test_compiled_null) {
+	ck_assert_ptr_eq(pattern_compile(NULL), NULL);
+	ck_assert_int_eq(pattern_match_compiled(NULL, "eth0", 1), 0);
+}
+END_TEST
+
+START_TEST(test_compiled_fallback) {
+	/* Without a compiled matcher, the original patterns are used. */
+	ck_assert_int_eq(pattern_match_fast(NULL, "eth*,!eth1", "eth0", 0), 1);
+	ck_assert_int_eq(pattern_match_fast(NULL, "eth*,!eth1", "eth1", 0), 0);
+	ck_assert_int_eq(pattern_match_fast(NULL, "eth0", "eth0", 0), 2);
+}
+END_TEST
+
 Suite *
 pattern_suite(void)
 {
@@ -123,6 +238,15 @@ pattern_suite(void)
 	tcase_add_test(tc_pattern, test_whitelist);
 	suite_add_tcase(s, tc_pattern);
 
+	TCase *tc_compiled = tcase_create("Compiled pattern matching");
+	tcase_add_test(tc_compiled, test_compiled_classes);
+	tcase_add_test(tc_compiled, test_compiled_whitelist_order);
+	tcase_add_test(tc_compiled, test_compiled_many);
+	tcase_add_test(tc_compiled, test_compiled_random);
+	tcase_add_test(tc_compiled, test_compiled_null);
+	tcase_add_test(tc_compiled, test_compiled_fallback);
+	suite_add_tcase(s, tc_compiled);
+
 	return s;
 }
 
@@ -0,0 +1,312 @@
+/* -*- mode: c; c-file-style: "openbsd" -*- */
+/*
+ * Copyright (c) 2019 Vincent Bernat <vincent@bernat.im>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <check.h>
+#include <event2/event.h>
+
+#include "../src/daemon/lldpd.h"
+
+#define HARDWARES 4
+#define CHASSIS 4		/* Different chassis IDs received */
+#define PORTS 3			/* Different port IDs received */
+#define STEPS 500
+
+/* Frames are made of an Ethernet header whose destination tells the protocol,
+ * a chassis ID, a port ID and a version to change the content of a neighbor
+ * while keeping the same MSAP. */
+#define FRAME_CHASSIS	sizeof(struct ether_header)
+#define FRAME_PORT	(FRAME_CHASSIS + 1)
+#define FRAME_VERSION	(FRAME_CHASSIS + 2)
+#define FRAME_SIZE	(FRAME_CHASSIS + 4)
+
+static int
+fake_decode(struct lldpd *cfg, char *frame, int s,
+    struct lldpd_hardware *hardware,
+    struct lldpd_chassis **newchassis, struct lldpd_port **newport)
+{
+	struct lldpd_chassis *chassis;
+	struct lldpd_port *port;
+
+	ck_assert_ptr_ne(chassis = lldpd_slab_alloc(LLDPD_SLAB_CHASSIS), NULL);
+	ck_assert_ptr_ne(port = lldpd_slab_alloc(LLDPD_SLAB_PORT), NULL);
+	TAILQ_INIT(&chassis->c_mgmt);
+#ifdef ENABLE_DOT1
+	TAILQ_INIT(&port->p_vlans);
+	TAILQ_INIT(&port->p_ppvids);
+	TAILQ_INIT(&port->p_pids);
+#endif
+#ifdef ENABLE_CUSTOM
+	TAILQ_INIT(&port->p_custom_list);
+#endif
+	chassis->c_id_subtype = LLDP_CHASSISID_SUBTYPE_LOCAL;
+	chassis->c_id_len = 1;
+	ck_assert_ptr_ne(chassis->c_id = malloc(1), NULL);
+	chassis->c_id[0] = frame[FRAME_CHASSIS];
+	port->p_id_subtype = LLDP_PORTID_SUBTYPE_LOCAL;
+	port->p_id_len = 1;
+	ck_assert_ptr_ne(port->p_id = malloc(1), NULL);
+	port->p_id[0] = frame[FRAME_PORT];
+	port->p_ttl = 120;
+	*newchassis = chassis;
+	*newport = port;
+	return 1;
+}
+
+static struct protocol protocols[] = {
+	{ LLDPD_MODE_LLDP, 1, "LLDP", 'l', NULL, fake_decode, NULL,
+	  {0x01,0,0,0,0,1}, {0,0,0,0,0,0}, {0,0,0,0,0,0} },
+	{ LLDPD_MODE_CDPV2, 1, "CDPv2", 'c', NULL, fake_decode, NULL,
+	  {0x01,0,0,0,0,2}, {0,0,0,0,0,0}, {0,0,0,0,0,0} },
+	{ LLDPD_MODE_EDP, 1, "EDP", 'e', NULL, fake_decode, NULL,
+	  {0x01,0,0,0,0,3}, {0,0,0,0,0,0}, {0,0,0,0,0,0} },
+	{ 0, 0, "any", ' ', NULL, NULL, NULL,
+	  {0,0,0,0,0,0}, {0,0,0,0,0,0}, {0,0,0,0,0,0} }
+};
+#define PROTOCOLS (sizeof(protocols)/sizeof(protocols[0]) - 1)
+
+static struct lldpd cfg;
+static struct lldpd_hardware hardwares[HARDWARES];
+static char received[FRAME_SIZE];
+
+/* Hand the frame in `received` to lldpd_recv() */
+static int
+fake_recv(struct lldpd *cfg, struct lldpd_hardware *hardware,
+    int fd, char *buffer, size_t size)
+{
+	ck_assert(size >= sizeof(received));
+	memcpy(buffer, received, sizeof(received));
+	return sizeof(received);
+}
+
+static struct lldpd_ops fake_ops = {
+	.recv = fake_recv,
+};
+
+static void
+setup(void)
+{
+	int i;
+	memset(&cfg, 0, sizeof(cfg));
+	cfg.g_protocols = protocols;
+	cfg.g_config.c_ttl = 120;
+	ck_assert_ptr_ne(cfg.g_base = event_base_new(), NULL);
+	TAILQ_INIT(&cfg.g_hardware);
+	TAILQ_INIT(&cfg.g_chassis);
+	memset(hardwares, 0, sizeof(hardwares));
+	for (i = 0; i < HARDWARES; i++) {
+		snprintf(hardwares[i].h_ifname, sizeof(hardwares[i].h_ifname),
+		    "eth%d", i);
+		hardwares[i].h_cfg = &cfg;
+		hardwares[i].h_ops = &fake_ops;
+		hardwares[i].h_flags = IFF_RUNNING;
+		hardwares[i].h_mtu = 1500;
+		TAILQ_INIT(&hardwares[i].h_rports);
+		TAILQ_INSERT_TAIL(&cfg.g_hardware, &hardwares[i], h_entries);
+	}
+	srandom(42);
+}
+
+static void
+teardown(void)
+{
+	struct lldpd_chassis *chassis;
+	int i;
+	for (i = 0; i < HARDWARES; i++)
+		lldpd_remote_cleanup(&hardwares[i], NULL, 1);
+	while ((chassis = TAILQ_FIRST(&cfg.g_chassis)) != NULL) {
+		TAILQ_REMOVE(&cfg.g_chassis, chassis, c_entries);
+		lldpd_chassis_cleanup(chassis, 1);
+	}
+	if (cfg.g_cleanup_timer) event_free(cfg.g_cleanup_timer);
+	event_base_free(cfg.g_base);
+}
+
+/* Receive a frame through lldpd_decode(). Depending on the content, this is a
+ * new neighbor, an updated neighbor or a duplicate frame. */
+static void
+receive(struct lldpd_hardware *hardware)
+{
+	memset(received, 0, sizeof(received));
+	memcpy(received, protocols[random() % PROTOCOLS].mac1, ETHER_ADDR_LEN);
+	received[FRAME_CHASSIS] = random() % CHASSIS;
+	received[FRAME_PORT] = random() % PORTS;
+	received[FRAME_VERSION] = random() % 2;
+	lldpd_recv(&cfg, hardware, -1);
+}
+
+/* Expire a neighbor through lldpd_expire_neighbors() */
+static void
+expire(struct lldpd_hardware *hardware)
+{
+	struct lldpd_port *port;
+	int count = 0, n;
+
+	TAILQ_FOREACH(port, &hardware->h_rports, p_entries) count++;
+	if (count == 0) return;
+	n = random() % count;
+	TAILQ_FOREACH(port, &hardware->h_rports, p_entries)
+		if (n-- == 0) break;
+	port->p_lastupdate = 0;
+	lldpd_cleanup(&cfg);
+}
+
+/* Compute the hidden flags of the neighbors of an interface for one direction
+ * without the smart filter code. The protocols with the smallest non-zero
+ * number of neighbors are visible (only the one with the smallest mode with
+ * `one_proto`). With `one_neigh`, only the first visible neighbor stays
+ * visible. */
+static void
+reference(struct lldpd_hardware *hardware, int filter, int one_proto,
+    int one_neigh, int *hidden)
+{
+	struct lldpd_port *port;
+	int count[LLDPD_MODE_MAX + 1] = {};
+	int best = 0, visible, seen = 0, n = 0, mode;
+
+	TAILQ_FOREACH(port, &hardware->h_rports, p_entries)
+		count[port->p_protocol]++;
+	for (mode = 1; mode <= LLDPD_MODE_MAX; mode++)
+		if (count[mode] && (!best || count[mode] < count[best]))
+			best = mode;
+	TAILQ_FOREACH(port, &hardware->h_rports, p_entries) {
+		if (!(cfg.g_config.c_smart & filter)) {
+			hidden[n++] = 0;
+			continue;
+		}
+		visible = (count[port->p_protocol] == count[best]);
+		if (cfg.g_config.c_smart & one_proto)
+			visible = visible && (port->p_protocol == best);
+		if (cfg.g_config.c_smart & one_neigh) {
+			visible = visible && !seen;
+			if (visible) seen = 1;
+		}
+		hidden[n++] = !visible;
+	}
+}
+
+static void
+check_consistency(void)
+{
+	struct lldpd_hardware *hardware;
+	struct lldpd_port *port;
+	int n, hidden_in[PROTOCOLS * CHASSIS * PORTS],
+	    hidden_out[PROTOCOLS * CHASSIS * PORTS];
+
+	TAILQ_FOREACH(hardware, &cfg.g_hardware, h_entries) {
+		n = 0;
+		TAILQ_FOREACH(port, &hardware->h_rports, p_entries) n++;
+		ck_assert(n <= sizeof(hidden_in)/sizeof(hidden_in[0]));
+		reference(hardware, SMART_INCOMING_FILTER,
+		    SMART_INCOMING_ONE_PROTO, SMART_INCOMING_ONE_NEIGH,
+		    hidden_in);
+		reference(hardware, SMART_OUTGOING_FILTER,
+		    SMART_OUTGOING_ONE_PROTO, SMART_OUTGOING_ONE_NEIGH,
+		    hidden_out);
+		n = 0;
+		TAILQ_FOREACH(port, &hardware->h_rports, p_entries) {
+			ck_assert_int_eq(port->p_hidden_in, hidden_in[n]);
+			ck_assert_int_eq(port->p_hidden_out, hidden_out[n]);
+			n++;
+		}
+	}
+}
+
+static void
+run_incremental(int smart)
+{
+	struct lldpd_hardware *hardware;
+	int i;
+
+	cfg.g_config.c_smart = smart;
+	for (i = 0; i < STEPS; i++) {
+		hardware = &hardwares[random() % HARDWARES];
+		if (random() % 3 == 0)
+			expire(hardware);
+		else
+			receive(hardware);
+		check_consistency();
+	}
+}
+
+START_TEST(test_incoming) {
+	run_incremental(SMART_INCOMING_FILTER);
+}
+END_TEST
+
+START_TEST(test_incoming_one_proto) {
+	run_incremental(SMART_INCOMING_FILTER | SMART_INCOMING_ONE_PROTO);
+}
+END_TEST
+
+START_TEST(test_incoming_one_neigh) {
+	run_incremental(SMART_INCOMING_FILTER | SMART_INCOMING_ONE_PROTO |
+	    SMART_INCOMING_ONE_NEIGH);
+}
+END_TEST
+
+START_TEST(test_outgoing) {
+	run_incremental(SMART_OUTGOING_FILTER | SMART_OUTGOING_ONE_PROTO);
+}
+END_TEST
+
+START_TEST(test_both) {
+	run_incremental(SMART_INCOMING_FILTER | SMART_INCOMING_ONE_PROTO |
+	    SMART_OUTGOING_FILTER | SMART_OUTGOING_ONE_NEIGH);
+}
+END_TEST
+
+START_TEST(test_reconfigure) {
+	/* When the smart mode changes, a global recomputation is needed */
+	run_incremental(SMART_INCOMING_FILTER);
+	cfg.g_config.c_smart = SMART_INCOMING_FILTER |
+	    SMART_INCOMING_ONE_PROTO | SMART_INCOMING_ONE_NEIGH |
+	    SMART_OUTGOING_FILTER;
+	lldpd_hide_all(&cfg);
+	run_incremental(cfg.g_config.c_smart);
+}
+END_TEST
+
+Suite *
+smartfilter_suite(void)
+{
+	Suite *s = suite_create("Smart filter");
+
+	TCase *tc_smart = tcase_create("Incremental smart filter");
+	tcase_add_checked_fixture(tc_smart, setup, teardown);
+	tcase_add_test(tc_smart, test_incoming);
+	tcase_add_test(tc_smart, test_incoming_one_proto);
+	tcase_add_test(tc_smart, test_incoming_one_neigh);
+	tcase_add_test(tc_smart, test_outgoing);
+	tcase_add_test(tc_smart, test_both);
+	tcase_add_test(tc_smart, test_reconfigure);
+	suite_add_tcase(s, tc_smart);
+
+	return s;
+}
+
+int
+main()
+{
+	int number_failed;
+	Suite *s = smartfilter_suite();
+	SRunner *sr = srunner_create(s);
+	srunner_run_all(sr, CK_ENV);
+	number_failed = srunner_ntests_failed(sr);
+	srunner_free(sr);
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -16,6 +16,7 @@
  */
 
 #include <check.h>
+#include <time.h>
 
 #include "../src/daemon/lldpd.h"
 #include "../src/daemon/agent.h"
@@ -34,8 +35,13 @@ struct lldpd test_cfg = {
 	.g_config = {
 		.c_tx_interval = 30,
 		.c_ttl = 60,
-		.c_smart = 0
-	}
+		.c_smart = 0,
+		.c_notification_interval = 5
+	},
+	.g_insert_cnt = 1100,
+	.g_delete_cnt = 56,
+	.g_ageout_cnt = 230,
+	.g_drop_cnt = 2
 };
 struct timeval test_starttime = { .tv_sec = 100, .tv_usec = 0 };
 
@@ -135,7 +141,7 @@ struct lldpd_hardware hardware1 = {
 			.autoneg_advertised = LLDP_DOT3_LINK_AUTONEG_100BASE_TX | LLDP_DOT3_LINK_AUTONEG_100BASE_TXFD,
 			.mau_type = LLDP_DOT3_MAU_100BASETXFD,
 		},
-		.p_power = {
+		.p_power = &(struct lldpd_dot3_power){
 			.devicetype  = LLDP_DOT3_POWER_PD,
 			.supported   = 1,
 			.enabled     = 1,
@@ -152,36 +158,38 @@ struct lldpd_hardware hardware1 = {
 #ifdef ENABLE_LLDPMED
 		.p_med_cap_enabled = LLDP_MED_CAP_CAP | LLDP_MED_CAP_IV | LLDP_MED_CAP_MDI_PD |
 			LLDP_MED_CAP_POLICY | LLDP_MED_CAP_LOCATION,
-		.p_med_policy = {
-			{ .type = 0 }, { .type = 0 }, {
-				.type = LLDP_MED_APPTYPE_GUESTVOICE,
-				.unknown = 1,
-				.tagged = 1,
-				.vid = 475,
-				.priority = 3,
-				.dscp = 62
-			}, { .type = 0 }, { .type = 0 }, { .type = 0 }, {
-				.type = LLDP_MED_APPTYPE_VIDEOSTREAM,
-				.unknown = 0,
-				.tagged = 1,
-				.vid = 472,
-				.priority = 1,
-				.dscp = 60
-			}, { .type = 0 }
-		},
-		.p_med_location = {
-			{ .format = 0 }, {
-				.format = LLDP_MED_LOCFORMAT_CIVIC,
-				/* 2:FR:6:Commercial Rd:19:4 */
-				.data = "\x15" "\x02" "FR" "\x06" "\x0d" "Commercial Rd" "\x13" "\x01" "4",
-				.data_len = 22,
-			}, { .format = 0 }
-		},
-		.p_med_power = {
-			.devicetype = LLDP_MED_POW_TYPE_PD,
-			.source = LLDP_MED_POW_SOURCE_LOCAL,
-			.priority = LLDP_MED_POW_PRIO_HIGH,
-			.val = 100
+		.p_med = &(struct lldpd_port_med){
+			.policy = {
+				{ .type = 0 }, { .type = 0 }, {
+					.type = LLDP_MED_APPTYPE_GUESTVOICE,
+					.unknown = 1,
+					.tagged = 1,
+					.vid = 475,
+					.priority = 3,
+					.dscp = 62
+				}, { .type = 0 }, { .type = 0 }, { .type = 0 }, {
+					.type = LLDP_MED_APPTYPE_VIDEOSTREAM,
+					.unknown = 0,
+					.tagged = 1,
+					.vid = 472,
+					.priority = 1,
+					.dscp = 60
+				}, { .type = 0 }
+			},
+			.location = {
+				{ .format = 0 }, {
+					.format = LLDP_MED_LOCFORMAT_CIVIC,
+					/* 2:FR:6:Commercial Rd:19:4 */
+					.data = "\x15" "\x02" "FR" "\x06" "\x0d" "Commercial Rd" "\x13" "\x01" "4",
+					.data_len = 22,
+				}, { .format = 0 }
+			},
+			.power = {
+				.devicetype = LLDP_MED_POW_TYPE_PD,
+				.source = LLDP_MED_POW_SOURCE_LOCAL,
+				.priority = LLDP_MED_POW_PRIO_HIGH,
+				.val = 100
+			},
 		},
 #endif		
 #ifdef ENABLE_DOT1
@@ -222,29 +230,31 @@ struct lldpd_hardware hardware2 = {
 #ifdef ENABLE_LLDPMED
 		.p_med_cap_enabled = LLDP_MED_CAP_CAP | LLDP_MED_CAP_IV | LLDP_MED_CAP_MDI_PD |
 			LLDP_MED_CAP_MDI_PSE | LLDP_MED_CAP_POLICY | LLDP_MED_CAP_LOCATION,
-		.p_med_policy = {
-			{ .type = 0 }, { .type = 0 }, {
-				.type = LLDP_MED_APPTYPE_GUESTVOICE,
-				.unknown = 1,
-				.tagged = 1,
-				.vid = 475,
-				.priority = 3,
-				.dscp = 62
-			}, { .type = 0 }, { .type = 0 }, {
-				.type = LLDP_MED_APPTYPE_VIDEOCONFERENCE,
-				.unknown = 0,
-				.tagged = 0,
-				.vid = 1007,
-				.priority = 1,
-				.dscp = 49
-			}, { .type = 0 }, { .type = 0 }
-		},
-		.p_med_location = {
-			{
-				.format = LLDP_MED_LOCFORMAT_COORD,
-				.data = "Not interpreted",
-				.data_len = 15,
-			}, { .format = 0 }, { .format = 0 },
+		.p_med = &(struct lldpd_port_med){
+			.policy = {
+				{ .type = 0 }, { .type = 0 }, {
+					.type = LLDP_MED_APPTYPE_GUESTVOICE,
+					.unknown = 1,
+					.tagged = 1,
+					.vid = 475,
+					.priority = 3,
+					.dscp = 62
+				}, { .type = 0 }, { .type = 0 }, {
+					.type = LLDP_MED_APPTYPE_VIDEOCONFERENCE,
+					.unknown = 0,
+					.tagged = 0,
+					.vid = 1007,
+					.priority = 1,
+					.dscp = 49
+				}, { .type = 0 }, { .type = 0 }
+			},
+			.location = {
+				{
+					.format = LLDP_MED_LOCFORMAT_COORD,
+					.data = "Not interpreted",
+					.data_len = 15,
+				}, { .format = 0 }, { .format = 0 },
+			},
 		},
 #endif
 	}
@@ -1085,6 +1095,136 @@ START_TEST (test_getnext)
 }
 END_TEST
 
+/* Walk lldpRemSysName with many remote ports. Each GETNEXT should not need to
+ * go through all neighbors. */
+#define BENCH_NEIGHBORS 5000
+START_TEST (test_getnext_many_neighbors)
+{
+	struct lldpd_chassis *chassis;
+	struct lldpd_port *port;
+	struct tree_node column = { { 1, 4, 1, 1, 9 }, 5 };
+	struct variable vp;
+	oid target[MAX_OID_LEN];
+	size_t targetlen, varlen, i;
+	u_char *result;
+	WriteMethod *wmethod;
+	struct timespec start, end;
+	long long elapsed;
+	size_t count = 0;
+
+	chassis = calloc(BENCH_NEIGHBORS, sizeof(struct lldpd_chassis));
+	port = calloc(BENCH_NEIGHBORS, sizeof(struct lldpd_port));
+	fail_unless(chassis != NULL && port != NULL, "Not enough memory?");
+	for (i = 0; i < BENCH_NEIGHBORS; i++) {
+		chassis[i].c_index = 100 + i;
+		chassis[i].c_protocol = LLDPD_MODE_LLDP;
+		chassis[i].c_id_subtype = LLDP_CHASSISID_SUBTYPE_LOCAL;
+		chassis[i].c_id = "bench";
+		chassis[i].c_id_len = 5;
+		chassis[i].c_name = "bench.example.com";
+		TAILQ_INIT(&chassis[i].c_mgmt);
+		port[i].p_chassis = &chassis[i];
+		port[i].p_lastchange = 200 + i % 50;
+		port[i].p_protocol = LLDPD_MODE_LLDP;
+		port[i].p_id_subtype = LLDP_PORTID_SUBTYPE_IFNAME;
+		port[i].p_id = "eth0";
+		port[i].p_id_len = 4;
+		TAILQ_INSERT_TAIL(&hardware2.h_rports, &port[i], p_entries);
+	}
+	test_cfg.g_generation++;
+
+	for (i = 0; i < agent_lldp_vars_size(); i++) {
+		if (agent_lldp_vars[i].namelen == column.namelen &&
+		    !memcmp(agent_lldp_vars[i].name, column.name,
+			column.namelen * sizeof(oid)))
+			break;
+	}
+	fail_unless(i < agent_lldp_vars_size(), "lldpRemSysName not found");
+	snmp_merge(&agent_lldp_vars[i], &column, &vp, target, &targetlen);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	while ((result = vp.findVar(&vp, target, &targetlen, 0,
+		    &varlen, &wmethod)) != NULL)
+		count++;
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	elapsed = (end.tv_sec - start.tv_sec) * 1000000000LL +
+	    (end.tv_nsec - start.tv_nsec);
+
+	/* Three neighbors are already present in the test configuration */
+	fail_unless(count == BENCH_NEIGHBORS + 3,
+	    "Expected %d rows, got %zu", BENCH_NEIGHBORS + 3, count);
+	fprintf(stderr, "lldpRemSysName walk: %zu rows in %lld ms (%lld ns/row)\n",
+	    count, elapsed / 1000000, elapsed / (long long)count);
+
+	free(port);
+	free(chassis);
+}
+END_TEST
+
+/* Walk lldpLocManAddrIfId, rebuild the local management addresses like an
+ * interface update does, then walk it again. The second walk should not use
+ * the freed addresses. */
+START_TEST (test_getnext_after_mgmt_update)
+{
+	struct tree_node column = { { 1, 3, 8, 1, 5 }, 5 };
+	struct interfaces_address_list addrs;
+	struct interfaces_address addr = { .index = 7 };
+	struct sockaddr_in *sin = (struct sockaddr_in *)&addr.address;
+	struct lldpd_mgmt *mgmt;
+	struct variable vp;
+	oid target[MAX_OID_LEN];
+	size_t targetlen, varlen, i, count;
+	u_char *result;
+	WriteMethod *wmethod;
+	u_int8_t old[] = { 0xc0, 0, 0x2, 0xf };	/* 192.0.2.15 */
+
+	/* The local addresses are freed on update: allocate them */
+	TAILQ_INIT(&chassis1.c_mgmt);
+	mgmt = lldpd_alloc_mgmt(LLDPD_AF_IPV4, old, sizeof(old), 3);
+	fail_unless(mgmt != NULL, "Not enough memory?");
+	TAILQ_INSERT_TAIL(&chassis1.c_mgmt, mgmt, m_entries);
+
+	for (i = 0; i < agent_lldp_vars_size(); i++) {
+		if (agent_lldp_vars[i].namelen == column.namelen &&
+		    !memcmp(agent_lldp_vars[i].name, column.name,
+			column.namelen * sizeof(oid)))
+			break;
+	}
+	fail_unless(i < agent_lldp_vars_size(), "lldpLocManAddrIfId not found");
+
+	snmp_merge(&agent_lldp_vars[i], &column, &vp, target, &targetlen);
+	for (count = 0; (result = vp.findVar(&vp, target, &targetlen, 0,
+		    &varlen, &wmethod)) != NULL; count++) {
+		fail_unless(*(long *)result == 3,
+		    "Expected interface 3, got %ld", *(long *)result);
+		fail_unless(target[targetlen - 1] == 15,
+		    "Expected 192.0.2.15, got %s", snmp_oidrepr(target, targetlen));
+	}
+	fail_unless(count == 1, "Expected 1 row, got %zu", count);
+
+	/* Interface update with another address */
+	TAILQ_INIT(&addrs);
+	sin->sin_family = AF_INET;
+	sin->sin_addr.s_addr = htonl(0xc0000210); /* 192.0.2.16 */
+	TAILQ_INSERT_TAIL(&addrs, &addr, next);
+	test_cfg.g_config.c_mgmt_advertise = 1;
+	interfaces_helper_mgmt(&test_cfg, &addrs);
+
+	snmp_merge(&agent_lldp_vars[i], &column, &vp, target, &targetlen);
+	for (count = 0; (result = vp.findVar(&vp, target, &targetlen, 0,
+		    &varlen, &wmethod)) != NULL; count++) {
+		fail_unless(*(long *)result == 7,
+		    "Expected interface 7, got %ld", *(long *)result);
+		fail_unless(target[targetlen - 1] == 16,
+		    "Expected 192.0.2.16, got %s", snmp_oidrepr(target, targetlen));
+	}
+	fail_unless(count == 1, "Expected 1 row, got %zu", count);
+
+	lldpd_chassis_mgmt_cleanup(&chassis1);
+	test_cfg.g_config.c_mgmt_advertise = 0;
+}
+END_TEST
+
 Suite *
 snmp_suite(void)
 {
@@ -1095,8 +1235,15 @@ snmp_suite(void)
 	tcase_add_test(tc_snmp, test_variable_order);
 	tcase_add_test(tc_snmp, test_get);
 	tcase_add_test(tc_snmp, test_getnext);
+	tcase_add_test(tc_snmp, test_getnext_after_mgmt_update);
 	suite_add_tcase(s, tc_snmp);
 
+	TCase *tc_bench = tcase_create("SNMP benchmark");
+	tcase_add_checked_fixture(tc_bench, snmp_config, NULL);
+	tcase_set_timeout(tc_bench, 120);
+	tcase_add_test(tc_bench, test_getnext_many_neighbors);
+	suite_add_tcase(s, tc_bench);
+
 	return s;
 }
 
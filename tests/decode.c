@@ -184,39 +184,43 @@ main(int argc, char **argv)
 	printf(" Dot3 MAC/phy autoneg enabled: %" PRIu8 "\n", nport->p_macphy.autoneg_enabled);
 	printf(" Dot3 MAC/phy autoneg advertised: %" PRIu16 "\n", nport->p_macphy.autoneg_advertised);
 	printf(" Dot3 MAC/phy MAU type: %" PRIu16 "\n", nport->p_macphy.mau_type);
-	printf(" Dot3 power device type: %" PRIu8 "\n", nport->p_power.devicetype);
-	printf(" Dot3 power supported: %" PRIu8 "\n", nport->p_power.supported);
-	printf(" Dot3 power enabled: %" PRIu8 "\n", nport->p_power.enabled);
-	printf(" Dot3 power pair control: %" PRIu8 "\n", nport->p_power.paircontrol);
-	printf(" Dot3 power pairs: %" PRIu8 "\n", nport->p_power.pairs);
-	printf(" Dot3 power class: %" PRIu8 "\n", nport->p_power.class);
-	printf(" Dot3 power type: %" PRIu8 "\n", nport->p_power.powertype);
-	printf(" Dot3 power source: %" PRIu8 "\n", nport->p_power.source);
-	printf(" Dot3 power priority: %" PRIu8 "\n", nport->p_power.priority);
-	printf(" Dot3 power requested: %" PRIu16 "\n", nport->p_power.requested);
-	printf(" Dot3 power allocated: %" PRIu16 "\n", nport->p_power.allocated);
+	if (nport->p_power) {
+		printf(" Dot3 power device type: %" PRIu8 "\n", nport->p_power->devicetype);
+		printf(" Dot3 power supported: %" PRIu8 "\n", nport->p_power->supported);
+		printf(" Dot3 power enabled: %" PRIu8 "\n", nport->p_power->enabled);
+		printf(" Dot3 power pair control: %" PRIu8 "\n", nport->p_power->paircontrol);
+		printf(" Dot3 power pairs: %" PRIu8 "\n", nport->p_power->pairs);
+		printf(" Dot3 power class: %" PRIu8 "\n", nport->p_power->class);
+		printf(" Dot3 power type: %" PRIu8 "\n", nport->p_power->powertype);
+		printf(" Dot3 power source: %" PRIu8 "\n", nport->p_power->source);
+		printf(" Dot3 power priority: %" PRIu8 "\n", nport->p_power->priority);
+		printf(" Dot3 power requested: %" PRIu16 "\n", nport->p_power->requested);
+		printf(" Dot3 power allocated: %" PRIu16 "\n", nport->p_power->allocated);
+	}
 #endif
 #ifdef ENABLE_LLDPMED
 	printf(" MED cap: %" PRIu16 "\n", nport->p_med_cap_enabled);
-	for (int i = 0; i < LLDP_MED_APPTYPE_LAST; i++) {
-		if (nport->p_med_policy[i].type == 0) continue;
-		printf(" MED policy type: %" PRIu8 "\n", nport->p_med_policy[i].type);
-		printf(" MED policy unknown: %" PRIu8 "\n", nport->p_med_policy[i].unknown);
-		printf(" MED policy tagged: %" PRIu8 "\n", nport->p_med_policy[i].tagged);
-		printf(" MED policy vid: %" PRIu16 "\n", nport->p_med_policy[i].vid);
-		printf(" MED policy priority: %" PRIu8 "\n", nport->p_med_policy[i].priority);
-		printf(" MED policy dscp: %" PRIu8 "\n", nport->p_med_policy[i].dscp);
-	}
-	for (int i = 0; i < LLDP_MED_LOCFORMAT_LAST; i++) {
-		if (nport->p_med_location[i].format == 0) continue;
-		printf(" MED location format: %" PRIu8 "\n", nport->p_med_location[i].format);
-		printf(" MED location: %s\n", tohex(nport->p_med_location[i].data,
-			nport->p_med_location[i].data_len));
+	if (nport->p_med) {
+		for (int i = 0; i < LLDP_MED_APPTYPE_LAST; i++) {
+			if (nport->p_med->policy[i].type == 0) continue;
+			printf(" MED policy type: %" PRIu8 "\n", nport->p_med->policy[i].type);
+			printf(" MED policy unknown: %" PRIu8 "\n", nport->p_med->policy[i].unknown);
+			printf(" MED policy tagged: %" PRIu8 "\n", nport->p_med->policy[i].tagged);
+			printf(" MED policy vid: %" PRIu16 "\n", nport->p_med->policy[i].vid);
+			printf(" MED policy priority: %" PRIu8 "\n", nport->p_med->policy[i].priority);
+			printf(" MED policy dscp: %" PRIu8 "\n", nport->p_med->policy[i].dscp);
+		}
+		for (int i = 0; i < LLDP_MED_LOCFORMAT_LAST; i++) {
+			if (nport->p_med->location[i].format == 0) continue;
+			printf(" MED location format: %" PRIu8 "\n", nport->p_med->location[i].format);
+			printf(" MED location: %s\n", tohex(nport->p_med->location[i].data,
+				nport->p_med->location[i].data_len));
+		}
+		printf(" MED power device type: %" PRIu8 "\n", nport->p_med->power.devicetype);
+		printf(" MED power source: %" PRIu8 "\n", nport->p_med->power.source);
+		printf(" MED power priority: %" PRIu8 "\n", nport->p_med->power.priority);
+		printf(" MED power value: %" PRIu16 "\n", nport->p_med->power.val);
 	}
-	printf(" MED power device type: %" PRIu8 "\n", nport->p_med_power.devicetype);
-	printf(" MED power source: %" PRIu8 "\n", nport->p_med_power.source);
-	printf(" MED power priority: %" PRIu8 "\n", nport->p_med_power.priority);
-	printf(" MED power value: %" PRIu16 "\n", nport->p_med_power.val);
 #endif
 #ifdef ENABLE_DOT1
 	printf(" Dot1 PVID: %" PRIu16 "\n", nport->p_pvid);
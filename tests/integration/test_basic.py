@@ -46,6 +46,42 @@ def test_several_neighbors(lldpd, lldpcli, links, namespaces, neighbors):
                 'ns-{}.example.com'.format(i)
 
 
+def test_decode_workers(lldpd, lldpcli, links, namespaces):
+    links(namespaces(1), namespaces(2))
+    links(namespaces(1), namespaces(3))
+    with namespaces(1):
+        lldpd("-r")
+        result = lldpcli("configure", "system", "decode-workers", "2")
+        assert result.returncode == 0
+    for i in (2, 3):
+        with namespaces(i):
+            lldpd()
+            lldpcli("configure", "lldp", "tx-hold", "2")
+            lldpcli("configure", "lldp", "tx-interval", "1")
+    time.sleep(3)
+    with namespaces(1):
+        # Added
+        out = lldpcli("-f", "keyvalue", "show", "neighbors")
+        assert out['lldp.eth0.chassis.name'] == 'ns-2.example.com'
+        assert out['lldp.eth2.chassis.name'] == 'ns-3.example.com'
+    with namespaces(2):
+        lldpcli("configure", "system", "hostname", "new.example.com")
+    time.sleep(3)
+    with namespaces(1):
+        # Updated
+        out = lldpcli("-f", "keyvalue", "show", "neighbors")
+        assert out['lldp.eth0.chassis.name'] == 'new.example.com'
+        assert out['lldp.eth2.chassis.name'] == 'ns-3.example.com'
+    with namespaces(3):
+        lldpcli("pause")
+    time.sleep(5)
+    with namespaces(1):
+        # Expired
+        out = lldpcli("-f", "keyvalue", "show", "neighbors")
+        assert out['lldp.eth0.chassis.name'] == 'new.example.com'
+        assert 'lldp.eth2.chassis.name' not in out
+
+
 def test_one_interface(lldpd1, lldpd, lldpcli, namespaces):
     with namespaces(2):
         lldpd()
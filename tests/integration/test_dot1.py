@@ -27,4 +27,17 @@ class TestLldpDot1(object):
             assert out['lldp.eth0.vlan.vlan-id'] == \
                 ['100', '200', '300', '4000']
 
+    def test_vlans_ordered_by_id(self, lldpd1, lldpd, lldpcli,
+                                 namespaces, links):
+        with namespaces(2):
+            for v in [300, 100, 4000, 200]:
+                links.vlan('vlan{}'.format(v), v, 'eth1')
+            lldpd()
+        with namespaces(1):
+            out = lldpcli("-f", "keyvalue", "show", "neighbors", "details")
+            assert out['lldp.eth0.vlan'] == \
+                ['vlan100', 'vlan200', 'vlan300', 'vlan4000']
+            assert out['lldp.eth0.vlan.vlan-id'] == \
+                ['100', '200', '300', '4000']
+
     # TODO: PI and PPVID (but lldpd doesn't know how to generate them)
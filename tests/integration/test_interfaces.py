@@ -1,5 +1,6 @@
 import pytest
 import pyroute2
+import subprocess
 import time
 
 
@@ -259,3 +260,37 @@ def test_new_interface(lldpd1, lldpd, lldpcli, namespaces, links):
         assert out['lldp.eth0.port.descr'] == 'eth1'
         assert out['lldp.eth2.port.descr'] == 'eth3'
         assert out['lldp.eth0.rid'] == out['lldp.eth2.rid']  # Same chassis
+
+
+def test_named_netns(lldpd, lldpcli, namespaces, links):
+    links(namespaces(1), namespaces(2))
+    with namespaces(1):
+        subprocess.check_call(["ip", "netns", "add", "c1"])
+        subprocess.check_call(["ip", "link", "set", "eth0", "netns", "c1"])
+        subprocess.check_call(["ip", "-n", "c1", "link", "set", "eth0", "up"])
+        lldpd("-r", "-N", "c1")
+        lldpcli("configure", "lldp", "tx-interval", "2")
+    with namespaces(2):
+        lldpd()
+        lldpcli("configure", "lldp", "tx-interval", "2")
+    time.sleep(3)
+    with namespaces(1):
+        out = lldpcli("-f", "keyvalue", "show", "neighbors")
+        assert out['lldp.c1/eth0.port.descr'] == 'eth1'
+
+        # Once deleted, the namespace should not be kept alive by lldpd
+        subprocess.check_call(["ip", "netns", "del", "c1"])
+        time.sleep(6)
+        out = lldpcli("-f", "keyvalue", "show", "neighbors")
+        assert not [k for k in out if k.startswith('lldp.c1/')]
+
+        # A namespace created again with the same name is picked up
+        subprocess.check_call(["ip", "netns", "add", "c1"])
+    links(namespaces(1), namespaces(2))
+    with namespaces(1):
+        subprocess.check_call(["ip", "link", "set", "eth2", "netns", "c1"])
+        subprocess.check_call(["ip", "-n", "c1", "link", "set", "eth2", "up"])
+        time.sleep(6)
+        out = lldpcli("-f", "keyvalue", "show", "neighbors")
+        assert out['lldp.c1/eth2.port.descr'] == 'eth3'
+        subprocess.check_call(["ip", "netns", "del", "c1"])
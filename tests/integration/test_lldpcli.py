@@ -557,10 +557,28 @@ def test_return_code(lldpd1, lldpcli, namespaces):
         assert result.returncode == 1
 
 
+@pytest.mark.parametrize("command, requests", [
+    ("show neighbors", 2),
+    ("show interfaces", 3),
+    ("show statistics", 2)])
+@pytest.mark.parametrize("count", [2, 20])
+def test_requests_do_not_depend_on_ports(lldpd, lldpcli, namespaces, links,
+                                         command, requests, count):
+    for i in range(count):
+        links(namespaces(1), namespaces(2))
+    with namespaces(1):
+        lldpd()
+        result = lldpcli("-d", *shlex.split(command))
+        assert result.returncode == 0
+        assert "command used {} request(s)".format(requests) in \
+            result.stderr.decode('ascii')
+
+
 @pytest.mark.parametrize("command, name, expected", [
     ("configure system max-neighbors 10", "max-neighbors", 10),
     ("configure lldp tx-interval 20", "tx-delay", 20),
     ("configure lldp tx-hold 5", "tx-hold", 5),
+    ("configure lldp notification-interval 30", "notification-interval", 30),
     ("configure lldp portidsubtype ifname", "lldp-portid-type", "ifname"),
     pytest.param("unconfigure med fast-start",
                  "lldpmed-faststart", "no",
@@ -582,6 +600,10 @@ def test_return_code(lldpd1, lldpcli, namespaces):
     ("configure system hostname squid", "hostname", "squid"),
     ("configure system interface description", "ifdescr-update", "yes"),
     ("configure system interface promiscuous", "iface-promisc", "yes"),
+    ("configure system snapshot", "snapshot", "yes"),
+    ("configure system warm-restart", "warm-restart", "yes"),
+    ("configure system metrics port 9777", "metrics", "127.0.0.1:9777"),
+    ("configure system decode-workers 2", "decode-workers", "2"),
     ("configure system bond-slave-src-mac-type fixed",
      "bond-slave-src-mac-type", "fixed"),
     ("configure lldp agent-type nearest-customer-bridge",
@@ -596,3 +618,26 @@ def test_config_change(lldpd1, lldpcli, namespaces, command, name, expected):
         assert result.returncode == 0
         out = lldpcli("-f", "keyvalue", "show", "configuration")
         assert out['configuration.config.{}'.format(name)] == str(expected)
+
+
+def test_startup_timeline(lldpd1, lldpcli, namespaces):
+    with namespaces(1):
+        out = lldpcli("-f", "keyvalue", "show", "configuration")
+        phases = ["privsep", "interfaces", "configured"]
+        for phase in phases:
+            assert int(out['configuration.startup.{}'.format(phase)]) > 0
+        assert int(out['configuration.startup.privsep']) <= \
+            int(out['configuration.startup.interfaces'])
+
+
+def test_latency(lldpd1, lldpcli, namespaces):
+    with namespaces(1):
+        out = lldpcli("-f", "keyvalue", "show", "statistics", "latency")
+        assert int(out['latency.interfaces.count']) > 0
+        assert int(out['latency.send.count']) > 0
+        assert float(out['latency.send.max']) >= \
+            float(out['latency.send.p50'])
+        result = lldpcli("show", "statistics", "latency", "reset")
+        assert result.returncode == 0
+        out = lldpcli("-f", "keyvalue", "show", "statistics", "latency")
+        assert int(out['latency.send.count']) == 0